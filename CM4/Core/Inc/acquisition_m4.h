@@ -0,0 +1,23 @@
+#ifndef __ACQUISITION_M4_H
+#define __ACQUISITION_M4_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Sensor output data rate after msa301_configure() */
+#define ACQ_DEFAULT_ODR_HZ      125u
+
+/* Live acquisition counters */
+typedef struct {
+    uint32_t frames;            /* frames pushed to CM7 */
+    uint32_t ring_drops;        /* frames lost because the shared ring was full */
+    uint32_t read_errors;       /* failed sensor reads (previous values reused) */
+} acquisition_stats_t;
+
+/* Function prototypes */
+void AcquisitionTask(void *argument);
+uint32_t acquisition_request_odr(uint32_t hz);
+uint32_t acquisition_get_odr(void);
+void acquisition_get_stats(acquisition_stats_t *stats);
+
+#endif /* __ACQUISITION_M4_H */
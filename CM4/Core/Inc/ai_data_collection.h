@@ -11,6 +11,17 @@
 #define AI_SAMPLES_PER_COLLECTION   (AI_SAMPLE_RATE_HZ * AI_SAMPLE_DURATION_SEC)
 #define AI_BUFFER_SIZE              (AI_SAMPLES_PER_COLLECTION * 3)  /* 3 axes */
 
+/* Runtime capture limits (CAPTURE command): rate * duration must fit the buffer */
+#define AI_MAX_SAMPLE_RATE_HZ       1000    /* TIM6 ISR reads the sensor over I2C */
+#define AI_MAX_DURATION_SEC         65      /* duration_ms is a uint16_t */
+
+/* Transfer chunking: each chunk carries a sequence number and a CRC-16 */
+#define AI_CHUNK_SAMPLES            100
+#define AI_NUM_CHUNKS(n)            (((n) + AI_CHUNK_SAMPLES - 1) / AI_CHUNK_SAMPLES)
+
+/* Capture buffers in the sample pool (one is held until the host ACKs it) */
+#define AI_SAMPLE_POOL_BLOCKS       1
+
 /* Motor fault types for labeling */
 typedef enum {
     MOTOR_NORMAL = 0,
@@ -42,14 +53,17 @@ typedef enum {
 /* Function prototypes */
 void ai_data_collection_init(void);
 bool ai_start_collection(motor_fault_type_t fault_type);
+bool ai_start_collection_ex(motor_fault_type_t fault_type, uint32_t duration_sec, uint32_t rate_hz);
+bool ai_capture_params_valid(uint32_t duration_sec, uint32_t rate_hz);
+void ai_get_capture_params(uint32_t *duration_sec, uint32_t *rate_hz);
 bool ai_stop_collection(void);
 ai_collection_status_t ai_get_collection_status(void);
-bool ai_get_sample_data(ai_training_sample_t *sample);
 void ai_reset_collection(void);
 
 /* USB communication functions */
 void ai_send_sample_via_usb(const ai_training_sample_t *sample);
-void ai_process_usb_commands(void);
+bool ai_send_chunks_via_usb(uint32_t first_chunk, uint32_t last_chunk);
+bool ai_release_sample(void);
 
 /* High-speed acquisition task */
 void AIDataCollectionTask(void *argument);
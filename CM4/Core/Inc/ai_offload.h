@@ -0,0 +1,16 @@
+#ifndef __AI_OFFLOAD_H
+#define __AI_OFFLOAD_H
+
+#include "shared_mem.h"
+
+/* CM4 side of the CM7 inference offload (shared_offload_t): runs the windows CM7 hands
+ * over with the preprocessing and open int8 engine both cores build from Common/
+ * (ai_engine.c, ai_preproc.c), so scores match the CM7 engine's bit for bit. The task
+ * runs below acquisition, USB and streaming: CM4 lends CM7 the time it would otherwise
+ * spend idle. */
+#define AI_OFFLOAD_POLL_MS   1u
+
+/* Function prototypes */
+void AiOffloadTask(void *argument);
+
+#endif /* __AI_OFFLOAD_H */
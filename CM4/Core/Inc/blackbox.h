@@ -0,0 +1,54 @@
+#ifndef __BLACKBOX_H
+#define __BLACKBOX_H
+
+#include "shared_mem.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Black box configuration: frames arrive at 1000 / SHARED_FRAME_PERIOD_MS Hz */
+#define BLACKBOX_FRAME_RATE_HZ        (1000u / SHARED_FRAME_PERIOD_MS)
+#define BLACKBOX_PRE_TRIGGER_SEC      10u
+#define BLACKBOX_POST_TRIGGER_SEC     5u
+#define BLACKBOX_PRE_TRIGGER_FRAMES   (BLACKBOX_PRE_TRIGGER_SEC * BLACKBOX_FRAME_RATE_HZ)
+#define BLACKBOX_POST_TRIGGER_FRAMES  (BLACKBOX_POST_TRIGGER_SEC * BLACKBOX_FRAME_RATE_HZ)
+#define BLACKBOX_EVENT_FRAMES         (BLACKBOX_PRE_TRIGGER_FRAMES + BLACKBOX_POST_TRIGGER_FRAMES)
+#define BLACKBOX_MAX_EVENTS           4u
+
+/* Event record state */
+typedef enum {
+    BLACKBOX_EVENT_EMPTY = 0,
+    BLACKBOX_EVENT_CAPTURING = 1,
+    BLACKBOX_EVENT_COMPLETE = 2
+} blackbox_event_state_t;
+
+/* Frozen capture around one fault decision */
+typedef struct {
+    volatile uint32_t state;    /* blackbox_event_state_t */
+    uint32_t event_id;
+    uint32_t trigger_ts;        /* CM4 tick when the decision was seen */
+    uint32_t window_end_ts;     /* timestamp of the newest frame in the triggering window */
+    uint8_t  class_id;
+    int8_t   scores[SHARED_AI_NUM_CLASSES];
+    uint8_t  channel;           /* input channel (motor) that raised the decision */
+    uint16_t num_pre;           /* frames before the trigger */
+    uint16_t num_post;          /* frames after the trigger */
+    sensor_frame_t frames[BLACKBOX_EVENT_FRAMES];
+} blackbox_event_t;
+
+/* Recorder counters */
+typedef struct {
+    uint32_t triggers;          /* events frozen */
+    uint32_t dropped;           /* triggers lost because a capture was running or the slot was busy */
+} blackbox_stats_t;
+
+/* Function prototypes */
+void blackbox_init(void);
+void blackbox_feed(const sensor_frame_t *frame);
+uint32_t blackbox_event_count(void);
+bool blackbox_clear(void);
+void blackbox_get_stats(blackbox_stats_t *stats);
+
+/* Send all complete event records via USB */
+void blackbox_send_events_via_usb(void);
+
+#endif /* __BLACKBOX_H */
@@ -0,0 +1,11 @@
+#ifndef __CRC16_H
+#define __CRC16_H
+
+#include <stdint.h>
+
+/* CRC-16/CCITT-FALSE (poly 0x1021), start with CRC16_INIT */
+#define CRC16_INIT  0xFFFFu
+
+uint16_t crc16_ccitt_update(uint16_t crc, const void *data, uint32_t len);
+
+#endif /* __CRC16_H */
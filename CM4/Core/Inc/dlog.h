@@ -0,0 +1,39 @@
+#ifndef __DLOG_H
+#define __DLOG_H
+
+#include "dlog_msgs.h"
+#include <stdint.h>
+
+/* Deferred logging: call sites store a message ID plus raw integer args in a
+ * lock-free RAM ring; DLogTask formats nothing and ships the records as
+ * "#D:" hex lines that python_ai_pipeline/dlog_decode.py turns back into text. */
+#define DLOG_RING_SIZE      64u     /* records, power of two */
+#define DLOG_MAX_ARGS       3u
+
+/* Message IDs generated from the table */
+typedef enum {
+#define DLOG_ENUM(id, fmt, nargs) id,
+    DLOG_MESSAGES(DLOG_ENUM)
+#undef DLOG_ENUM
+    DLOG_NUM_MESSAGES
+} dlog_id_t;
+
+/* Logger counters */
+typedef struct {
+    uint32_t written;
+    uint32_t dropped;           /* ring full */
+} dlog_stats_t;
+
+/* Function prototypes */
+void dlog_init(void);
+void dlog_write(dlog_id_t id, uint32_t nargs, uint32_t a0, uint32_t a1, uint32_t a2);
+void dlog_get_stats(dlog_stats_t *stats);
+void DLogTask(void *argument);
+
+/* Call-site helpers, safe from tasks and ISRs */
+#define DLOG0(id)               dlog_write((id), 0u, 0u, 0u, 0u)
+#define DLOG1(id, a)            dlog_write((id), 1u, (uint32_t)(a), 0u, 0u)
+#define DLOG2(id, a, b)         dlog_write((id), 2u, (uint32_t)(a), (uint32_t)(b), 0u)
+#define DLOG3(id, a, b, c)      dlog_write((id), 3u, (uint32_t)(a), (uint32_t)(b), (uint32_t)(c))
+
+#endif /* __DLOG_H */
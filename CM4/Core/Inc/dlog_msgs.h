@@ -0,0 +1,15 @@
+#ifndef __DLOG_MSGS_H
+#define __DLOG_MSGS_H
+
+/* Deferred log message table: X(id, "format", number of args).
+ * Only integer arguments (%d, %u, %lu, %X ...), at most DLOG_MAX_ARGS.
+ * Append new entries at the end: the host decoder (python_ai_pipeline/dlog_decode.py)
+ * parses this file and relies on the position of each entry as its ID. */
+#define DLOG_MESSAGES(X) \
+    X(DLOG_AI_TASK_STARTED,    "AI: Data collection task started", 0) \
+    X(DLOG_AI_COLLECT_STARTED, "AI: Started collection for fault type %d, Sample ID: %lu", 2) \
+    X(DLOG_AI_COLLECT_STOPPED, "AI: Collection stopped. Samples collected: %lu", 1) \
+    X(DLOG_AI_SENDING_SAMPLE,  "AI: Sending sample data via USB", 0) \
+    X(DLOG_OVERFLOW,           "DLOG: %lu record(s) dropped", 1)
+
+#endif /* __DLOG_MSGS_H */
@@ -0,0 +1,47 @@
+#ifndef __ENERGY_GATE_H
+#define __ENERGY_GATE_H
+
+#include "shared_mem.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Quiet-window gate run by AcquisitionTask on every frame, over the last
+ * SHARED_GATE_WINDOW_FRAMES frames (the CM7 inference window).
+ *
+ * Per axis, in raw sensor LSB, integer only:
+ *   rms   RMS around the window mean (gravity and offsets removed)
+ *   peak  largest |sample - mean|
+ *   band  RMS of the first difference x[n] - x[n-1], i.e. the energy above the
+ *         slow drift where imbalance and bearing tones live
+ * A window is quiet when every enabled metric is below its threshold on all three
+ * axes; the newest frame then carries SHARED_FRAME_QUIET and CM7 reuses its last
+ * decision instead of running the network. A threshold of 0 disables that metric,
+ * all three 0 disables the gate. */
+#define ENERGY_GATE_DEFAULT_RMS     0u     /* gate off until SET GATE */
+#define ENERGY_GATE_DEFAULT_PEAK    0u
+#define ENERGY_GATE_DEFAULT_BAND    0u
+
+typedef struct {
+    uint16_t rms_max;
+    uint16_t peak_max;
+    uint16_t band_max;
+} energy_gate_config_t;
+
+/* Live gate state (metrics are the largest over the three axes) */
+typedef struct {
+    uint32_t frames;            /* frames evaluated */
+    uint32_t quiet_frames;      /* frames that went out with SHARED_FRAME_QUIET */
+    uint16_t rms;
+    uint16_t peak;
+    uint16_t band;
+    bool quiet;
+} energy_gate_stats_t;
+
+/* Function prototypes */
+void energy_gate_reset(void);
+bool energy_gate_feed(const sensor_frame_t *frame);
+void energy_gate_set_config(const energy_gate_config_t *cfg);
+void energy_gate_get_config(energy_gate_config_t *cfg);
+void energy_gate_get_stats(energy_gate_stats_t *stats);
+
+#endif /* __ENERGY_GATE_H */
@@ -0,0 +1,54 @@
+#ifndef __MEM_POOL_H
+#define __MEM_POOL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Pool storage goes into the dedicated .pool_ram section (D2 SRAM, see linker scripts) */
+#if defined(__GNUC__)
+#define MEM_POOL_SECTION __attribute__((section(".pool_ram"), aligned(32)))
+#else
+#define MEM_POOL_SECTION
+#endif
+
+#define MEM_POOL_MAX_POOLS      4u
+#define MEM_POOL_MAX_BLOCKS     64u     /* per pool, bits in alloc_map */
+
+/* Fixed-block pool: O(1) alloc/free, callable from tasks and ISRs.
+ * Free blocks are chained through their first word; alloc_map has a bit set
+ * per allocated block so a double free is refused instead of corrupting the list. */
+typedef struct {
+    const char *name;
+    uint8_t *base;
+    uint32_t block_size;
+    uint32_t num_blocks;
+    void *free_list;
+    uint32_t alloc_map[MEM_POOL_MAX_BLOCKS / 32u];
+    uint32_t in_use;
+    uint32_t peak;
+    uint32_t alloc_failures;
+} mem_pool_t;
+
+/* Occupancy snapshot */
+typedef struct {
+    const char *name;
+    uint32_t block_size;
+    uint32_t num_blocks;
+    uint32_t in_use;
+    uint32_t peak;
+    uint32_t alloc_failures;
+} mem_pool_stats_t;
+
+/* Function prototypes */
+bool mem_pool_init(mem_pool_t *pool, const char *name, void *storage,
+                   uint32_t block_size, uint32_t num_blocks);
+void *mem_pool_alloc(mem_pool_t *pool);
+bool mem_pool_free(mem_pool_t *pool, void *block);
+void mem_pool_get_stats(const mem_pool_t *pool, mem_pool_stats_t *stats);
+
+/* Registered pools, for reporting */
+uint32_t mem_pool_count(void);
+const mem_pool_t *mem_pool_get(uint32_t index);
+void mem_pool_send_stats_via_usb(void);
+
+#endif /* __MEM_POOL_H */
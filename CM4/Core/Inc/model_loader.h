@@ -0,0 +1,40 @@
+#ifndef __MODEL_LOADER_H
+#define __MODEL_LOADER_H
+
+#include "shared_mem.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Model bundle upload (MODEL commands): bytes go straight into shared_model_stage, CM7
+ * loads them once the transfer CRC matches. The bundle itself is checked by CM7. */
+#define MODEL_LOADER_CHUNK_MAX   80u   /* bytes per MODEL DATA line, hex fits USB_CMD_BUFFER_SIZE */
+
+typedef enum {
+    MODEL_LOADER_OK = 0,
+    MODEL_LOADER_BUSY,             /* CM7 has not handled the previous request yet */
+    MODEL_LOADER_NO_TRANSFER,      /* MODEL DATA / COMMIT without MODEL BEGIN */
+    MODEL_LOADER_RANGE,            /* size or offset out of the stage, gap in the data */
+    MODEL_LOADER_HEX,              /* odd length or non hex digit */
+    MODEL_LOADER_INCOMPLETE,       /* COMMIT before every byte arrived */
+    MODEL_LOADER_CRC               /* transfer CRC differs, nothing handed to CM7 */
+} model_loader_result_t;
+
+/* Upload progress */
+typedef struct {
+    bool     active;               /* between MODEL BEGIN and MODEL COMMIT */
+    uint32_t size;
+    uint32_t received;             /* contiguous bytes from offset 0 */
+    uint32_t request;              /* last request handed to CM7 */
+} model_loader_state_t;
+
+/* Function prototypes */
+model_loader_result_t model_loader_begin(uint32_t size, uint32_t crc32);
+model_loader_result_t model_loader_data(uint32_t offset, const char *hex, uint32_t *bytes);
+model_loader_result_t model_loader_commit(void);
+model_loader_result_t model_loader_load_flash(void);
+bool model_loader_pending(void);
+void model_loader_get_state(model_loader_state_t *state);
+const char *model_loader_result_name(model_loader_result_t r);
+const char *model_loader_status_name(uint8_t status);
+
+#endif /* __MODEL_LOADER_H */
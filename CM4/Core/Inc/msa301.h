@@ -27,4 +27,8 @@ bool msa301_probe(I2C_HandleTypeDef *hi2c);
 bool msa301_configure(I2C_HandleTypeDef *hi2c);
 bool msa301_read_raw(I2C_HandleTypeDef *hi2c, int16_t *x, int16_t *y, int16_t *z);
 
+/* ODR helpers: map a requested rate to the nearest supported one (>= hz, capped at 1000 Hz) */
+uint32_t msa301_odr_supported_hz(uint32_t hz);
+bool msa301_set_odr(I2C_HandleTypeDef *hi2c, uint32_t hz);
+
 #endif /* __MSA301_H */
@@ -3,31 +3,22 @@
 
 #include <stdint.h>
 #include <stdbool.h>
-
-#define SHARED_FRAMES_COUNT 256u
-
-typedef struct {
-    int16_t x;
-    int16_t y;
-    int16_t z;
-    uint32_t ts; /* timestamp ms */
-} sensor_frame_t;
-
-/* Simple shared ring buffer declaration.
-   If you plan to share between CM4/CM7 place this variable into a shared linker
-   section (.shared_ram) mapped to D2 SRAM. For now a plain declaration works. */
-
-typedef struct {
-    volatile uint32_t head;
-    volatile uint32_t tail;
-    sensor_frame_t frames[SHARED_FRAMES_COUNT];
-} shared_ring_t;
-
-/* single instance, defined in shared_mem.c (placed in .shared_ram) */
-extern volatile shared_ring_t shared_ring;
+#include "shared_layout.h"   /* types and the shared_d2 block, same header as CM7 */
 
 /* helper prototypes (optional) */
 bool shared_push_frame(const sensor_frame_t *f);
 bool shared_pop_frame(sensor_frame_t *out);
+bool shared_read_ai_result(uint32_t channel, shared_ai_result_t *out);
+void shared_write_ai_config(const shared_ai_config_t *cfg);
+void shared_get_ai_config(shared_ai_config_t *out);
+bool shared_read_ai_perf(shared_ai_perf_t *out);
+bool shared_read_ai_bench(shared_ai_bench_t *out);
+bool shared_read_ai_profile(shared_ai_profile_t *out);
+bool shared_read_ai_engine_bench(shared_ai_engine_bench_t *out);
+bool shared_read_ai_sched(shared_ai_sched_t *out);
+bool shared_read_model_status(shared_model_status_t *out);
+bool shared_read_ai_offload_bench(shared_ai_offload_bench_t *out);
+uint32_t shared_ai_event_count(void);
+bool shared_read_ai_event(uint32_t *cursor, shared_ai_event_t *out, uint32_t *lost);
 
 #endif /* __SHARED_MEM_H */
@@ -0,0 +1,57 @@
+#ifndef __STREAM_H
+#define __STREAM_H
+
+#include "shared_mem.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Live streaming (STREAM ON/OFF): binary packets interleaved with text replies.
+ *
+ * Packet: 0xA5 0x5A | type u8 | seq u16 | len u16 | payload[len] | crc16 u16
+ * All fields little-endian, CRC-16/CCITT-FALSE over type..payload.
+ * Every packet consumes one credit; the host grants credits with
+ * STREAM ON <n> / STREAM CREDIT <n>. Without credits frames queue up,
+ * and are dropped (and counted) once the queue is full. */
+#define STREAM_SYNC0                0xA5u
+#define STREAM_SYNC1                0x5Au
+#define STREAM_HEADER_SIZE          7u
+#define STREAM_FRAMES_PER_PACKET    16u
+#define STREAM_QUEUE_FRAMES         256u    /* power of two */
+#define STREAM_MAX_LATENCY_MS       100u    /* flush a partial samples packet after this */
+#define STREAM_STATS_PERIOD_MS      1000u
+#define STREAM_DEFAULT_CREDITS      32u
+#define STREAM_MAX_CREDITS          1024u
+
+/* What a stream carries (STREAM ON [<credits>] [ALL|DECISIONS]) */
+#define STREAM_CONTENT_ALL          0u      /* samples, per-window results, decisions, stats */
+#define STREAM_CONTENT_DECISIONS    1u      /* decisions and stats only */
+
+/* Packet types */
+typedef enum {
+    STREAM_PKT_SAMPLES = 1,     /* first_index u32, count u16, rsvd u16, count * (ts u32, x/y/z i16) */
+    STREAM_PKT_RESULT = 2,      /* result_seq u32, window_end_ts u32, class u8, scores i8[4], channel u8, state u8, rsvd u8 */
+    STREAM_PKT_STATS = 3,       /* queued u32, dropped u32, packets u32, credit_stalls u32 */
+    STREAM_PKT_DECISION = 4     /* event_id u32, ts u32, onset_ts u32, channel u8, from u8, to u8, confidence_pct u8 */
+} stream_packet_type_t;
+
+/* Streaming counters */
+typedef struct {
+    uint32_t frames_queued;
+    uint32_t frames_dropped;    /* queue full while out of credits */
+    uint32_t packets_sent;
+    uint32_t credit_stalls;     /* loops that had data but no credit */
+    uint32_t tx_drops;          /* packets lost because the USB TX queue stayed full */
+    uint32_t decisions_lost;    /* decision events CM7 overwrote before they were sent */
+} stream_stats_t;
+
+/* Function prototypes */
+void stream_start(uint32_t credits, uint32_t content);
+void stream_stop(void);
+void stream_add_credits(uint32_t credits);
+bool stream_is_active(void);
+uint32_t stream_get_credits(void);
+void stream_get_stats(stream_stats_t *stats);
+void stream_feed_frame(const sensor_frame_t *frame);
+void StreamTask(void *argument);
+
+#endif /* __STREAM_H */
@@ -6,26 +6,43 @@
 #include <stdbool.h>
 
 /* USB Command buffer size */
-#define USB_CMD_BUFFER_SIZE     64
-#define USB_RESPONSE_BUFFER_SIZE 128
-
-/* USB Command types */
-typedef enum {
-    CMD_UNKNOWN = 0,
-    CMD_START_NORMAL,
-    CMD_START_IMBALANCE,
-    CMD_START_BEARING,
-    CMD_START_MISALIGN,
-    CMD_STOP_COLLECTION,
-    CMD_GET_DATA,
-    CMD_GET_STATUS,
-    CMD_RESET_SYSTEM
-} usb_command_type_t;
+#define USB_CMD_BUFFER_SIZE     192     /* longest line: MODEL DATA <offset> <hex> */
+#define USB_RESPONSE_BUFFER_SIZE 384
+#define USB_RX_RING_SIZE        256     /* bytes, power of two */
+#define USB_CMD_MAX_TOKENS      6
+#define USB_CMD_MAX_ARGS        4
 
-/* USB Command structure */
+/* Runtime tuning limits */
+#define USB_MAX_HOP_FRAMES      60      /* model window length */
+#define USB_MAX_PERIOD_MS       1000
+#define USB_MAX_EMA_SHIFT       7       /* CM7 AI_DECISION_MAX_SHIFT */
+#define USB_MAX_DWELL_MS        60000
+
+/* Typed command argument: s is the token, u its value for 'u' arguments */
+typedef struct {
+    const char *s;
+    uint32_t u;
+} usb_arg_t;
+
+struct usb_command;
+typedef void (*usb_cmd_handler_t)(const struct usb_command *cmd);
+
+/* Command table entry */
 typedef struct {
-    usb_command_type_t type;
+    const char *keyword;        /* one or more words, e.g. "SET ODR" */
+    const char *args;           /* 'u' unsigned, 'w' word, optional after '|' */
+    const char *usage;
+    usb_cmd_handler_t handler;
+    uint32_t param;             /* handler specific (fault type for START_*) */
+} usb_cmd_entry_t;
+
+/* USB Command structure */
+typedef struct usb_command {
+    const usb_cmd_entry_t *entry;   /* NULL if the keyword is unknown */
+    uint32_t argc;
+    usb_arg_t args[USB_CMD_MAX_ARGS];
     char raw_command[USB_CMD_BUFFER_SIZE];
+    char arg_text[USB_CMD_BUFFER_SIZE];    /* tokenized copy, args[].s point here */
     bool is_valid;
 } usb_command_t;
 
@@ -36,7 +53,11 @@ void usb_execute_command(const usb_command_t* cmd);
 void usb_send_response(const char* response);
 void usb_process_input_buffer(void);
 
-/* USB CDC callback functions */
+/* USB CDC callback functions (call from CDC_Receive_FS) */
 void usb_cdc_receive_callback(uint8_t* buffer, uint32_t length);
+uint32_t usb_get_rx_overflows(void);
+
+/* Command dispatch task */
+void UsbCommandTask(void *argument);
 
 #endif /* __USB_COMMANDS_H */
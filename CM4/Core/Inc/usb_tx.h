@@ -0,0 +1,38 @@
+#ifndef __USB_TX_H
+#define __USB_TX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* CDC transmit queue: printf/_write copy into preallocated packet buffers and
+ * return immediately; the CDC TX-complete callback starts the next buffer.
+ * Writes are all or nothing: a packet or line that does not fit is dropped
+ * (and counted) whole, never cut or interleaved with another writer's bytes.
+ * Bulk senders call usb_tx_wait_free() first to get backpressure instead. */
+#define USB_TX_PACKET_SIZE      512u    /* bytes per CDC transfer */
+#define USB_TX_NUM_BUFFERS      8u
+#define USB_TX_LINE_MAX         128u    /* usb_tx_printf() line and stdout buffer */
+
+/* Transmit counters */
+typedef struct {
+    uint32_t bytes_queued;
+    uint32_t bytes_sent;
+    uint32_t bytes_dropped;     /* queue full */
+    uint32_t transfers;
+    uint32_t start_failures;    /* CDC busy or not connected, retried later */
+} usb_tx_stats_t;
+
+/* Function prototypes */
+void usb_tx_init(void);
+bool usb_tx_write_all(const uint8_t *data, uint32_t len);
+bool usb_tx_write_line(const char *line);
+bool usb_tx_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+uint32_t usb_tx_free(void);
+bool usb_tx_wait_free(uint32_t bytes, uint32_t timeout_ms);
+void usb_tx_poll(void);
+void usb_tx_get_stats(usb_tx_stats_t *stats);
+
+/* Call from CDC_TransmitCplt_FS (USB IRQ) */
+void usb_tx_complete_callback(void);
+
+#endif /* __USB_TX_H */
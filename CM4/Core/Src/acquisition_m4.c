@@ -6,6 +6,10 @@
 #include "shared_mem.h"
 #include "stm32h745xx.h"
 #include "ai_data_collection.h"
+#include "blackbox.h"
+#include "acquisition_m4.h"
+#include "stream.h"
+#include "energy_gate.h"
 
 /* HSEM ID definition */
 #ifndef HSEM_ID_0
@@ -17,10 +21,44 @@ extern I2C_HandleTypeDef hi2c1;
 /* Local variables to store sensor data */
 static int16_t sensor_x, sensor_y, sensor_z;
 
+/* Sensor ODR: requested by the USB command task, applied by AcquisitionTask
+ * (the only task that talks to the sensor in live mode) */
+static volatile uint32_t odr_current_hz = ACQ_DEFAULT_ODR_HZ;
+static volatile uint32_t odr_requested_hz = 0;
+
+static acquisition_stats_t acq_stats;
+
+/* Queue an ODR change; returns the rate that will actually be used */
+uint32_t acquisition_request_odr(uint32_t hz)
+{
+    uint32_t actual = msa301_odr_supported_hz(hz);
+    odr_requested_hz = actual;
+    return actual;
+}
+
+uint32_t acquisition_get_odr(void)
+{
+    return odr_current_hz;
+}
+
+void acquisition_get_stats(acquisition_stats_t *stats)
+{
+    if (stats) *stats = acq_stats;
+}
+
 /* Acquisition task prototype (create this task in CubeMX-generated RTOS init or add here) */
 void AcquisitionTask(void *argument)
 {
-    sensor_frame_t frame;
+    sensor_frame_t frame = {0};
+
+    blackbox_init();
+    energy_gate_reset();
+
+    /* Publish the default CM7 inference tuning */
+    shared_ai_config_t ai_cfg;
+    shared_get_ai_config(&ai_cfg);
+    shared_write_ai_config(&ai_cfg);
+
     /* Initialize sensor */
     if (!msa301_probe(&hi2c1)) {
         /* Sensor not present: blink an LED or log via SWO/USB if available. */
@@ -34,8 +72,17 @@ void AcquisitionTask(void *argument)
     }
 
     for (;;) {
-        /* Wait for periodic sensor reading (e.g., every 100ms) */
-        vTaskDelay(pdMS_TO_TICKS(100));
+        /* Wait for periodic sensor reading (every SHARED_FRAME_PERIOD_MS) */
+        vTaskDelay(pdMS_TO_TICKS(SHARED_FRAME_PERIOD_MS));
+
+        /* Apply a pending SET ODR between reads */
+        uint32_t odr = odr_requested_hz;
+        if (odr != 0u) {
+            odr_requested_hz = 0;
+            if (msa301_set_odr(&hi2c1, odr)) {
+                odr_current_hz = odr;
+            }
+        }
 
         /* Read sensor data */
         if (msa301_read_raw(&hi2c1, &sensor_x, &sensor_y, &sensor_z)) {
@@ -44,17 +91,32 @@ void AcquisitionTask(void *argument)
             frame.z = sensor_z;
         } else {
             /* Use previous values on error */
+            acq_stats.read_errors++;
         }
         frame.ts = HAL_GetTick();
 
+        /* Let CM7 skip inference on a quiet window */
+        frame.flags = (energy_gate_feed(&frame) ? SHARED_FRAME_QUIET : 0u) | SHARED_FRAME_FLAGS_CHANNEL(0u);
+
         /* Protect shared buffer update:
            - Option A: Use HSEM to protect both cores (recommended if you use HSEM)
            - Option B: set shared area non-cacheable / then use simple push
            Here we disable IRQs briefly to make update atomic on this core
            (still need cache maintenance if region is cacheable). */
         taskENTER_CRITICAL();
-        shared_push_frame(&frame);
+        bool pushed = shared_push_frame(&frame);
         taskEXIT_CRITICAL();
+        if (pushed) {
+            acq_stats.frames++;
+        } else {
+            acq_stats.ring_drops++;
+        }
+
+        /* Keep the pre-trigger history and watch for CM7 fault decisions */
+        blackbox_feed(&frame);
+
+        /* Live stream (no-op unless STREAM ON) */
+        stream_feed_frame(&frame);
 
         /* Notify CM7: release HSEM (example). On CM7 side you must enable HSEM notification */
         HAL_HSEM_FastTake(HSEM_ID_0);
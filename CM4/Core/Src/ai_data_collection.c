@@ -1,21 +1,42 @@
 #include "ai_data_collection.h"
 #include "msa301.h"
+#include "crc16.h"
+#include "dlog.h"
+#include "mem_pool.h"
+#include "usb_tx.h"
 #include "cmsis_os.h"
 #include "stm32h7xx_hal.h"
 #include "stm32h7xx_hal_tim.h"
 #include "stm32h7xx_it.h"
 #include <string.h>
-#include <stdio.h>
 
 /* External I2C handle */
 extern I2C_HandleTypeDef hi2c1;
 
+/* Capture buffers come from a fixed-block pool and change owner instead of
+ * being copied: the TIM6 ISR fills current_sample while ACTIVE, the USB
+ * transfer path reads it while COMPLETE, and the block goes back to the
+ * pool on ACK or RESET. */
+MEM_POOL_SECTION static ai_training_sample_t ai_sample_storage[AI_SAMPLE_POOL_BLOCKS];
+static mem_pool_t ai_sample_pool;
+static ai_training_sample_t * volatile current_sample = NULL;
+
 /* Static variables for data collection */
-static ai_training_sample_t current_sample;
 static volatile ai_collection_status_t collection_status = AI_COLLECTION_IDLE;
 static volatile uint32_t sample_counter = 0;
 static volatile uint32_t sample_id_counter = 0;
 static volatile bool data_ready = false;
+static volatile uint32_t target_samples = AI_SAMPLES_PER_COLLECTION;
+
+/* Rate and duration of the last capture started (CAPTURE), the defaults before that */
+static volatile uint32_t capture_rate_hz = AI_SAMPLE_RATE_HZ;
+static volatile uint32_t capture_duration_sec = AI_SAMPLE_DURATION_SEC;
+
+/* Longest sample line ("-32768,-32768,-32768\r\n" or a CHUNK header) and
+ * how long to wait for TX queue space before trying anyway (a line that still
+ * does not fit is dropped whole and the CRC makes the host NACK its chunk) */
+#define AI_TX_LINE_MAX      32u
+#define AI_TX_WAIT_MS       100u
 
 /* Timer for precise timing */
 static TIM_HandleTypeDef htim_ai;
@@ -51,14 +72,41 @@ void ai_data_collection_init(void)
     HAL_NVIC_SetPriority(TIM6_DAC_IRQn, 5, 0);
     HAL_NVIC_EnableIRQ(TIM6_DAC_IRQn);
     
-    /* Initialize sample structure */
-    memset(&current_sample, 0, sizeof(ai_training_sample_t));
+    /* Initialize sample buffer pool */
+    mem_pool_init(&ai_sample_pool, "ai_sample", ai_sample_storage,
+                  sizeof(ai_training_sample_t), AI_SAMPLE_POOL_BLOCKS);
+    current_sample = NULL;
     collection_status = AI_COLLECTION_IDLE;
 }
 
-/* Start data collection for specified fault type */
+/* Start data collection for specified fault type with the default rate and duration */
 bool ai_start_collection(motor_fault_type_t fault_type)
 {
+    return ai_start_collection_ex(fault_type, AI_SAMPLE_DURATION_SEC, AI_SAMPLE_RATE_HZ);
+}
+
+/* Check a capture request against the sample buffer and header field limits */
+bool ai_capture_params_valid(uint32_t duration_sec, uint32_t rate_hz)
+{
+    return rate_hz >= 1u && rate_hz <= AI_MAX_SAMPLE_RATE_HZ &&
+           duration_sec >= 1u && duration_sec <= AI_MAX_DURATION_SEC &&
+           duration_sec * rate_hz <= AI_SAMPLES_PER_COLLECTION;
+}
+
+/* Rate and duration of the last capture started */
+void ai_get_capture_params(uint32_t *duration_sec, uint32_t *rate_hz)
+{
+    if (duration_sec) *duration_sec = capture_duration_sec;
+    if (rate_hz) *rate_hz = capture_rate_hz;
+}
+
+/* Start data collection with a runtime rate and duration */
+bool ai_start_collection_ex(motor_fault_type_t fault_type, uint32_t duration_sec, uint32_t rate_hz)
+{
+    if (!ai_capture_params_valid(duration_sec, rate_hz)) {
+        return false;
+    }
+
     if (osMutexAcquire(ai_collection_mutex, 100) != osOK) {
         return false;
     }
@@ -68,26 +116,39 @@ bool ai_start_collection(motor_fault_type_t fault_type)
         return false;
     }
     
+    ai_training_sample_t *sample = mem_pool_alloc(&ai_sample_pool);
+    if (!sample) {
+        osMutexRelease(ai_collection_mutex);
+        return false;
+    }
+
     /* Initialize sample data */
-    current_sample.sample_id = ++sample_id_counter;
-    current_sample.timestamp = HAL_GetTick();
-    current_sample.fault_type = fault_type;
-    current_sample.sample_rate = AI_SAMPLE_RATE_HZ;
-    current_sample.duration_ms = AI_SAMPLE_DURATION_SEC * 1000;
-    current_sample.num_samples = AI_SAMPLES_PER_COLLECTION;
+    sample->sample_id = ++sample_id_counter;
+    sample->timestamp = HAL_GetTick();
+    sample->fault_type = fault_type;
+    sample->sample_rate = (uint16_t)rate_hz;
+    sample->duration_ms = (uint16_t)(duration_sec * 1000u);
+    sample->num_samples = duration_sec * rate_hz;
+    current_sample = sample;
     
     /* Reset counters */
     sample_counter = 0;
+    target_samples = sample->num_samples;
+    capture_rate_hz = rate_hz;
+    capture_duration_sec = duration_sec;
     data_ready = false;
     
+    /* Timer runs at 1 MHz: reload for the requested rate */
+    __HAL_TIM_SET_AUTORELOAD(&htim_ai, (1000000u / rate_hz) - 1u);
+    __HAL_TIM_SET_COUNTER(&htim_ai, 0);
+
     /* Start timer */
     collection_status = AI_COLLECTION_ACTIVE;
     HAL_TIM_Base_Start_IT(&htim_ai);
     
     osMutexRelease(ai_collection_mutex);
     
-    printf("AI: Started collection for fault type %d, Sample ID: %lu\r\n", 
-           fault_type, current_sample.sample_id);
+    DLOG2(DLOG_AI_COLLECT_STARTED, fault_type, sample->sample_id);
     
     return true;
 }
@@ -102,13 +163,14 @@ bool ai_stop_collection(void)
     HAL_TIM_Base_Stop_IT(&htim_ai);
     
     if (collection_status == AI_COLLECTION_ACTIVE) {
+        current_sample->num_samples = sample_counter;
         collection_status = AI_COLLECTION_COMPLETE;
         data_ready = true;
     }
     
     osMutexRelease(ai_collection_mutex);
     
-    printf("AI: Collection stopped. Samples collected: %lu\r\n", sample_counter);
+    DLOG1(DLOG_AI_COLLECT_STOPPED, sample_counter);
     return true;
 }
 
@@ -118,25 +180,6 @@ ai_collection_status_t ai_get_collection_status(void)
     return collection_status;
 }
 
-/* Get sample data (non-blocking) */
-bool ai_get_sample_data(ai_training_sample_t *sample)
-{
-    if (!sample || !data_ready) {
-        return false;
-    }
-    
-    if (osMutexAcquire(ai_collection_mutex, 100) != osOK) {
-        return false;
-    }
-    
-    memcpy(sample, &current_sample, sizeof(ai_training_sample_t));
-    data_ready = false;
-    
-    osMutexRelease(ai_collection_mutex);
-    
-    return true;
-}
-
 /* Reset collection system */
 void ai_reset_collection(void)
 {
@@ -148,7 +191,10 @@ void ai_reset_collection(void)
     collection_status = AI_COLLECTION_IDLE;
     sample_counter = 0;
     data_ready = false;
-    memset(&current_sample, 0, sizeof(ai_training_sample_t));
+    if (current_sample) {
+        mem_pool_free(&ai_sample_pool, current_sample);
+        current_sample = NULL;
+    }
     
     osMutexRelease(ai_collection_mutex);
 }
@@ -159,20 +205,21 @@ void TIM6_DAC_IRQHandler(void)
     if (__HAL_TIM_GET_FLAG(&htim_ai, TIM_FLAG_UPDATE) != RESET && __HAL_TIM_GET_IT_SOURCE(&htim_ai, TIM_IT_UPDATE) != RESET) {
         __HAL_TIM_CLEAR_IT(&htim_ai, TIM_IT_UPDATE);
         
-        if (collection_status == AI_COLLECTION_ACTIVE && sample_counter < AI_SAMPLES_PER_COLLECTION) {
+        ai_training_sample_t *sample = current_sample;
+        if (collection_status == AI_COLLECTION_ACTIVE && sample && sample_counter < target_samples) {
             int16_t x, y, z;
             
             /* Fast I2C read - this should be optimized for speed */
             if (msa301_read_raw(&hi2c1, &x, &y, &z)) {
                 uint32_t index = sample_counter * 3;
-                current_sample.data[index] = x;
-                current_sample.data[index + 1] = y;
-                current_sample.data[index + 2] = z;
+                sample->data[index] = x;
+                sample->data[index + 1] = y;
+                sample->data[index + 2] = z;
                 
                 sample_counter++;
                 
                 /* Check if collection is complete */
-                if (sample_counter >= AI_SAMPLES_PER_COLLECTION) {
+                if (sample_counter >= target_samples) {
                     HAL_TIM_Base_Stop_IT(&htim_ai);
                     collection_status = AI_COLLECTION_COMPLETE;
                     data_ready = true;
@@ -186,79 +233,121 @@ void TIM6_DAC_IRQHandler(void)
     }
 }
 
+/* Send one chunk: "CHUNK:<seq>,<count>,<crc>" followed by <count> data lines.
+ * The CRC covers the raw little-endian int16 X,Y,Z values of the chunk. */
+static void ai_send_chunk(const ai_training_sample_t *sample, uint32_t seq)
+{
+    uint32_t first = seq * AI_CHUNK_SAMPLES;
+    uint32_t count = sample->num_samples - first;
+    if (count > AI_CHUNK_SAMPLES) count = AI_CHUNK_SAMPLES;
+
+    const int16_t *data = &sample->data[first * 3];
+    uint16_t crc = crc16_ccitt_update(CRC16_INIT, data, count * 3 * sizeof(int16_t));
+
+    usb_tx_wait_free(AI_TX_LINE_MAX, AI_TX_WAIT_MS);
+    usb_tx_printf("CHUNK:%lu,%lu,%04X\r\n", seq, count, crc);
+    for (uint32_t i = 0; i < count; i++) {
+        /* Backpressure from the TX queue instead of fixed delays */
+        usb_tx_wait_free(AI_TX_LINE_MAX, AI_TX_WAIT_MS);
+        usb_tx_printf("%d,%d,%d\r\n", data[i * 3], data[i * 3 + 1], data[i * 3 + 2]);
+    }
+}
+
+/* Send header plus chunks [first_chunk, last_chunk] of a sample */
+static void ai_send_sample_range(const ai_training_sample_t *sample,
+                                 uint32_t first_chunk, uint32_t last_chunk)
+{
+    uint32_t num_chunks = AI_NUM_CHUNKS(sample->num_samples);
+
+    /* Send header information, with the same backpressure as the data lines */
+    usb_tx_wait_free(AI_TX_LINE_MAX, AI_TX_WAIT_MS);
+    usb_tx_printf("AI_SAMPLE_START\r\n");
+    usb_tx_wait_free(AI_TX_LINE_MAX, AI_TX_WAIT_MS);
+    usb_tx_printf("ID:%lu\r\n", sample->sample_id);
+    usb_tx_wait_free(AI_TX_LINE_MAX, AI_TX_WAIT_MS);
+    usb_tx_printf("TIMESTAMP:%lu\r\n", sample->timestamp);
+    usb_tx_wait_free(AI_TX_LINE_MAX, AI_TX_WAIT_MS);
+    usb_tx_printf("FAULT_TYPE:%d\r\n", sample->fault_type);
+    usb_tx_wait_free(AI_TX_LINE_MAX, AI_TX_WAIT_MS);
+    usb_tx_printf("SAMPLE_RATE:%d\r\n", sample->sample_rate);
+    usb_tx_wait_free(AI_TX_LINE_MAX, AI_TX_WAIT_MS);
+    usb_tx_printf("DURATION:%d\r\n", sample->duration_ms);
+    usb_tx_wait_free(AI_TX_LINE_MAX, AI_TX_WAIT_MS);
+    usb_tx_printf("NUM_SAMPLES:%lu\r\n", sample->num_samples);
+    usb_tx_wait_free(AI_TX_LINE_MAX, AI_TX_WAIT_MS);
+    usb_tx_printf("CHUNK_SAMPLES:%d\r\n", AI_CHUNK_SAMPLES);
+    usb_tx_wait_free(AI_TX_LINE_MAX, AI_TX_WAIT_MS);
+    usb_tx_printf("NUM_CHUNKS:%lu\r\n", num_chunks);
+    usb_tx_wait_free(AI_TX_LINE_MAX, AI_TX_WAIT_MS);
+    usb_tx_printf("DATA_START\r\n");
+
+    for (uint32_t seq = first_chunk; seq <= last_chunk && seq < num_chunks; seq++) {
+        ai_send_chunk(sample, seq);
+    }
+
+    usb_tx_wait_free(AI_TX_LINE_MAX, AI_TX_WAIT_MS);
+    usb_tx_printf("DATA_END\r\n");
+    usb_tx_wait_free(AI_TX_LINE_MAX, AI_TX_WAIT_MS);
+    usb_tx_printf("AI_SAMPLE_END\r\n");
+}
+
 /* Send sample data via USB (CDC) */
 void ai_send_sample_via_usb(const ai_training_sample_t *sample)
 {
     if (!sample) return;
-    
-    /* Send header information */
-    printf("AI_SAMPLE_START\r\n");
-    printf("ID:%lu\r\n", sample->sample_id);
-    printf("TIMESTAMP:%lu\r\n", sample->timestamp);
-    printf("FAULT_TYPE:%d\r\n", sample->fault_type);
-    printf("SAMPLE_RATE:%d\r\n", sample->sample_rate);
-    printf("DURATION:%d\r\n", sample->duration_ms);
-    printf("NUM_SAMPLES:%lu\r\n", sample->num_samples);
-    printf("DATA_START\r\n");
-    
-    /* Send data in chunks to avoid buffer overflow */
-    const uint32_t chunk_size = 100;  /* Send 100 samples at a time */
-    
-    for (uint32_t i = 0; i < sample->num_samples; i++) {
-        uint32_t index = i * 3;
-        printf("%d,%d,%d\r\n", 
-               sample->data[index], 
-               sample->data[index + 1], 
-               sample->data[index + 2]);
-        
-        /* Small delay every chunk to prevent USB buffer overflow */
-        if ((i + 1) % chunk_size == 0) {
-            HAL_Delay(10);
-        }
+
+    ai_send_sample_range(sample, 0, AI_NUM_CHUNKS(sample->num_samples) - 1);
+}
+
+/* (Re)send a chunk range of the retained sample. Used for the first
+ * transfer, for NACK retransmits and to resume an interrupted offload. */
+bool ai_send_chunks_via_usb(uint32_t first_chunk, uint32_t last_chunk)
+{
+    if (collection_status != AI_COLLECTION_COMPLETE || !current_sample) {
+        return false;
     }
-    
-    printf("DATA_END\r\n");
-    printf("AI_SAMPLE_END\r\n");
+
+    if (osMutexAcquire(ai_collection_mutex, 100) != osOK) {
+        return false;
+    }
+
+    uint32_t num_chunks = AI_NUM_CHUNKS(current_sample->num_samples);
+    if (num_chunks > 0 && (first_chunk >= num_chunks || first_chunk > last_chunk)) {
+        osMutexRelease(ai_collection_mutex);
+        return false;
+    }
+
+    ai_send_sample_range(current_sample, first_chunk, last_chunk);
+    data_ready = false;
+
+    osMutexRelease(ai_collection_mutex);
+    return true;
 }
 
-/* Process USB commands for data collection control */
-void ai_process_usb_commands(void)
+/* Host acknowledged the whole sample: free it for the next collection */
+bool ai_release_sample(void)
 {
-    /* This function should be called from main loop to process incoming commands */
-    /* Implementation depends on your USB CDC setup */
-    /* Commands format:
-     * "START_NORMAL" - Start collection for normal motor
-     * "START_IMBALANCE" - Start collection for imbalanced motor
-     * "START_BEARING" - Start collection for bearing fault
-     * "START_MISALIGN" - Start collection for misalignment
-     * "STOP" - Stop current collection
-     * "GET_DATA" - Send collected data via USB
-     * "RESET" - Reset collection system
-     * "STATUS" - Get current status
-     */
+    if (collection_status != AI_COLLECTION_COMPLETE) {
+        return false;
+    }
+
+    ai_reset_collection();
+    return true;
 }
 
 /* High-speed data collection task */
 void AIDataCollectionTask(void *argument)
 {
-    ai_training_sample_t sample_buffer;
-    
     /* Initialize AI data collection system */
     ai_data_collection_init();
     
-    printf("AI: Data collection task started\r\n");
+    DLOG0(DLOG_AI_TASK_STARTED);
     
     for (;;) {
-        /* Process USB commands */
-        ai_process_usb_commands();
-        
-        /* Check if data is ready to send */
-        if (ai_get_collection_status() == AI_COLLECTION_COMPLETE) {
-            if (ai_get_sample_data(&sample_buffer)) {
-                printf("AI: Sending sample data via USB\r\n");
-                ai_send_sample_via_usb(&sample_buffer);
-                ai_reset_collection();
-            }
+        /* Send a new sample once; it stays retained until the host ACKs it */
+        if (ai_get_collection_status() == AI_COLLECTION_COMPLETE && data_ready) {
+            DLOG0(DLOG_AI_SENDING_SAMPLE);
+            ai_send_chunks_via_usb(0, UINT32_MAX);
         }
         
         /* Small delay to prevent excessive CPU usage */
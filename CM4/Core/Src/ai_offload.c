@@ -0,0 +1,87 @@
+#include "ai_offload.h"
+#include "ai_engine.h"
+#include "ai_preproc.h"
+#include "cmsis_os.h"
+#include "main.h"
+#include <string.h>
+
+#if MODEL_ENGINE_SUPPORTED
+_Static_assert(sizeof(ai_preproc_t) == sizeof(shared_offload.job[0].preproc), "shared preprocessing != ai_preproc_t");
+_Static_assert(MODEL_WINDOW_FRAMES <= SHARED_OFFLOAD_FRAMES, "window longer than an offload job");
+_Static_assert(MODEL_NUM_AXES == AI_PREPROC_AXES, "model_params.h axes != preprocessing axes");
+
+static ai_engine_t s_engine;
+static int8_t s_input[MODEL_WINDOW_FRAMES * MODEL_NUM_AXES];
+#endif
+
+/* Normalize and classify one window; false if it does not fit the network built in */
+static bool ai_offload_run(volatile shared_offload_job_t *job, volatile shared_offload_result_t *res)
+{
+#if MODEL_ENGINE_SUPPORTED
+    ai_preproc_t pp;
+
+    if (job->frames != MODEL_WINDOW_FRAMES || job->weights == 0u) return false;
+    memcpy(&pp, (const void *)job->preproc, sizeof(pp));
+    const int16_t *const axes[AI_PREPROC_AXES] = {
+        (const int16_t *)job->axis[0],
+        (const int16_t *)job->axis[1],
+        (const int16_t *)job->axis[2],
+    };
+    ai_preproc_window(&pp, axes, MODEL_WINDOW_FRAMES, s_input);
+
+    /* A full window every time: CM7 keeps the streaming state of its channels */
+    ai_engine_init(&s_engine, (const void *)(uintptr_t)job->weights);
+    if (!ai_engine_run(&s_engine, s_input, MODEL_WINDOW_FRAMES)) return false;
+    for (uint32_t k = 0; k < SHARED_AI_NUM_CLASSES; k++) {
+        res->scores[k] = s_engine.out[k];
+    }
+    return true;
+#else
+    (void)job;
+    (void)res;
+    return false;
+#endif
+}
+
+void AiOffloadTask(void *argument)
+{
+    (void)argument;
+
+    /* Cycle counter for the per-job time CM7 turns into cm4_util_permille */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    for (;;) {
+        /* CM7 (re)booted: whatever the slots held is not for this session */
+        uint32_t session = shared_offload.session;
+        if (shared_offload.cm4_session != session) {
+            for (uint32_t i = 0; i < SHARED_OFFLOAD_SLOTS; i++) {
+                shared_offload.result[i].done = shared_offload.job[i].request;
+            }
+            shared_offload.cm4_hz = SystemCoreClock;
+            __DMB();
+            shared_offload.cm4_session = session;
+        }
+
+        bool idle = true;
+        for (uint32_t i = 0; i < SHARED_OFFLOAD_SLOTS; i++) {
+            volatile shared_offload_job_t *job = &shared_offload.job[i];
+            volatile shared_offload_result_t *res = &shared_offload.result[i];
+            uint32_t request = job->request;
+            if (request == res->done) continue;
+            __DMB();
+
+            uint32_t t0 = DWT->CYCCNT;
+            res->ok = ai_offload_run(job, res) ? 1u : 0u;
+            res->cycles = DWT->CYCCNT - t0;
+            __DMB();
+            res->done = request;
+            idle = false;
+        }
+        if (idle) {
+            osDelay(AI_OFFLOAD_POLL_MS);
+        } else {
+            osThreadYield();
+        }
+    }
+}
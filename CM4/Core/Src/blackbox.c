@@ -0,0 +1,205 @@
+#include "blackbox.h"
+#include "ai_data_collection.h"
+#include "main.h"
+#include "cmsis_os.h"
+#include "usb_tx.h"
+#include <string.h>
+
+#if defined(__GNUC__)
+#define NOINIT_LINK __attribute__((section(".noinit")))
+#else
+#define NOINIT_LINK
+#endif
+
+#define BLACKBOX_MAGIC  0x424C4B42u  /* "BLKB" */
+#define BB_TX_WAIT_MS   100u         /* per-line wait for TX queue room */
+
+/* Event table survives warm resets (.noinit is not cleared by the startup code) */
+typedef struct {
+    uint32_t magic;
+    uint32_t next_event_id;
+    uint32_t next_slot;
+    blackbox_event_t events[BLACKBOX_MAX_EVENTS];
+} blackbox_store_t;
+
+NOINIT_LINK static blackbox_store_t bb_store;
+
+/* Pre-trigger ring, only touched from AcquisitionTask */
+static sensor_frame_t pre_ring[BLACKBOX_PRE_TRIGGER_FRAMES];
+static uint32_t pre_head = 0;
+static uint32_t pre_count = 0;
+
+static blackbox_event_t *capturing = NULL;
+static shared_ai_result_t last_result[SHARED_AI_MAX_CHANNELS];
+static uint32_t event_cursor = 0;   /* next CM7 decision event to look at */
+static blackbox_stats_t bb_stats;
+
+/* Slot currently being sent over USB, never reused for a new capture */
+static volatile int32_t reading_slot = -1;
+
+void blackbox_init(void)
+{
+    if (bb_store.magic != BLACKBOX_MAGIC || bb_store.next_slot >= BLACKBOX_MAX_EVENTS) {
+        memset(&bb_store, 0, sizeof(bb_store));
+        bb_store.magic = BLACKBOX_MAGIC;
+    }
+    /* A capture interrupted by reset has no post-trigger data: drop it */
+    for (uint32_t i = 0; i < BLACKBOX_MAX_EVENTS; i++) {
+        if (bb_store.events[i].state == BLACKBOX_EVENT_CAPTURING) {
+            bb_store.events[i].state = BLACKBOX_EVENT_EMPTY;
+        }
+    }
+    pre_head = 0;
+    pre_count = 0;
+    capturing = NULL;
+    memset(last_result, 0, sizeof(last_result));
+    event_cursor = shared_ai_event_count();
+    memset(&bb_stats, 0, sizeof(bb_stats));
+}
+
+/* Freeze the pre-trigger ring into a free slot, with the scores of the channel's latest window */
+static void blackbox_trigger(const shared_ai_event_t *decision, const shared_ai_result_t *result)
+{
+    uint32_t slot = bb_store.next_slot;
+    if ((int32_t)slot == reading_slot) {
+        bb_stats.dropped++;
+        return;
+    }
+
+    blackbox_event_t *ev = &bb_store.events[slot];
+    ev->state = BLACKBOX_EVENT_CAPTURING;
+    ev->event_id = ++bb_store.next_event_id;
+    ev->trigger_ts = HAL_GetTick();
+    ev->window_end_ts = decision->ts;
+    ev->class_id = decision->to_class;
+    memcpy(ev->scores, result->scores, sizeof(ev->scores));
+    ev->channel = decision->channel;
+
+    /* Oldest frame first */
+    uint32_t start = (pre_head + BLACKBOX_PRE_TRIGGER_FRAMES - pre_count) % BLACKBOX_PRE_TRIGGER_FRAMES;
+    for (uint32_t i = 0; i < pre_count; i++) {
+        ev->frames[i] = pre_ring[(start + i) % BLACKBOX_PRE_TRIGGER_FRAMES];
+    }
+    ev->num_pre = (uint16_t)pre_count;
+    ev->num_post = 0;
+
+    bb_store.next_slot = (slot + 1u) % BLACKBOX_MAX_EVENTS;
+    bb_stats.triggers++;
+    capturing = ev;
+}
+
+/* Called for every acquired frame (AcquisitionTask context) */
+void blackbox_feed(const sensor_frame_t *frame)
+{
+    if (!frame) return;
+
+    if (capturing) {
+        capturing->frames[capturing->num_pre + capturing->num_post] = *frame;
+        capturing->num_post++;
+        if (capturing->num_post >= BLACKBOX_POST_TRIGGER_FRAMES) {
+            __DMB();
+            capturing->state = BLACKBOX_EVENT_COMPLETE;
+            capturing = NULL;
+        }
+    }
+
+    pre_ring[pre_head] = *frame;
+    pre_head = (pre_head + 1u) % BLACKBOX_PRE_TRIGGER_FRAMES;
+    if (pre_count < BLACKBOX_PRE_TRIGGER_FRAMES) pre_count++;
+
+    for (uint32_t ch = 0; ch < SHARED_AI_MAX_CHANNELS; ch++) {
+        shared_ai_result_t result;
+        if (shared_read_ai_result(ch, &result)) last_result[ch] = result;
+    }
+
+    /* Trigger when a channel's reported state goes from normal to a fault (CM7 decision
+     * stage: averaged, thresholded and debounced, see shared_ai_event_t) */
+    while (event_cursor != shared_ai_event_count()) {
+        shared_ai_event_t decision;
+        if (!shared_read_ai_event(&event_cursor, &decision, NULL)) continue;
+        if (decision.from_class != MOTOR_NORMAL || decision.to_class == MOTOR_NORMAL ||
+            decision.channel >= SHARED_AI_MAX_CHANNELS) {
+            continue;
+        }
+        if (capturing) {
+            bb_stats.dropped++;
+        } else {
+            blackbox_trigger(&decision, &last_result[decision.channel]);
+        }
+    }
+}
+
+uint32_t blackbox_event_count(void)
+{
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < BLACKBOX_MAX_EVENTS; i++) {
+        if (bb_store.events[i].state == BLACKBOX_EVENT_COMPLETE) n++;
+    }
+    return n;
+}
+
+/* Discard all complete records; a capture in progress is kept */
+bool blackbox_clear(void)
+{
+    if (reading_slot >= 0) return false;
+    for (uint32_t i = 0; i < BLACKBOX_MAX_EVENTS; i++) {
+        if (bb_store.events[i].state == BLACKBOX_EVENT_COMPLETE) {
+            bb_store.events[i].state = BLACKBOX_EVENT_EMPTY;
+        }
+    }
+    return true;
+}
+
+void blackbox_get_stats(blackbox_stats_t *stats)
+{
+    if (stats) *stats = bb_stats;
+}
+
+/* Send complete records, oldest first, in the same framing as AI samples.
+ * Each line waits for queue room first: usb_tx_printf() drops a line that does not fit. */
+void blackbox_send_events_via_usb(void)
+{
+    usb_tx_wait_free(USB_TX_LINE_MAX, BB_TX_WAIT_MS);
+    usb_tx_printf("BB_EVENTS:%lu\r\n", blackbox_event_count());
+
+    for (uint32_t n = 0; n < BLACKBOX_MAX_EVENTS; n++) {
+        uint32_t slot = (bb_store.next_slot + n) % BLACKBOX_MAX_EVENTS;
+        const blackbox_event_t *ev = &bb_store.events[slot];
+
+        reading_slot = (int32_t)slot;
+        __DMB();
+        if (ev->state != BLACKBOX_EVENT_COMPLETE) {
+            reading_slot = -1;
+            continue;
+        }
+        usb_tx_wait_free(USB_TX_LINE_MAX, BB_TX_WAIT_MS);
+        usb_tx_printf("BB_EVENT_START\r\n");
+        usb_tx_wait_free(USB_TX_LINE_MAX, BB_TX_WAIT_MS);
+        usb_tx_printf("ID:%lu\r\n", ev->event_id);
+        usb_tx_wait_free(USB_TX_LINE_MAX, BB_TX_WAIT_MS);
+        usb_tx_printf("TRIGGER_TS:%lu\r\n", ev->trigger_ts);
+        usb_tx_wait_free(USB_TX_LINE_MAX, BB_TX_WAIT_MS);
+        usb_tx_printf("WINDOW_END_TS:%lu\r\n", ev->window_end_ts);
+        usb_tx_wait_free(USB_TX_LINE_MAX, BB_TX_WAIT_MS);
+        usb_tx_printf("CHANNEL:%u\r\n", ev->channel);
+        usb_tx_wait_free(USB_TX_LINE_MAX, BB_TX_WAIT_MS);
+        usb_tx_printf("CLASS:%d\r\n", ev->class_id);
+        usb_tx_wait_free(USB_TX_LINE_MAX, BB_TX_WAIT_MS);
+        usb_tx_printf("SCORES:%d,%d,%d,%d\r\n", ev->scores[0], ev->scores[1], ev->scores[2], ev->scores[3]);
+        usb_tx_wait_free(USB_TX_LINE_MAX, BB_TX_WAIT_MS);
+        usb_tx_printf("PRE:%u\r\n", ev->num_pre);
+        usb_tx_wait_free(USB_TX_LINE_MAX, BB_TX_WAIT_MS);
+        usb_tx_printf("POST:%u\r\n", ev->num_post);
+        usb_tx_wait_free(USB_TX_LINE_MAX, BB_TX_WAIT_MS);
+        usb_tx_printf("DATA_START\r\n");
+        for (uint32_t i = 0; i < (uint32_t)ev->num_pre + ev->num_post; i++) {
+            usb_tx_wait_free(USB_TX_LINE_MAX, BB_TX_WAIT_MS);
+            usb_tx_printf("%lu,%d,%d,%d\r\n", ev->frames[i].ts, ev->frames[i].x, ev->frames[i].y, ev->frames[i].z);
+        }
+        usb_tx_wait_free(USB_TX_LINE_MAX, BB_TX_WAIT_MS);
+        usb_tx_printf("DATA_END\r\n");
+        usb_tx_wait_free(USB_TX_LINE_MAX, BB_TX_WAIT_MS);
+        usb_tx_printf("BB_EVENT_END\r\n");
+        reading_slot = -1;
+    }
+}
@@ -0,0 +1,15 @@
+#include "crc16.h"
+
+/* Bitwise CRC-16/CCITT-FALSE: no table, cheap enough for transfer chunks */
+uint16_t crc16_ccitt_update(uint16_t crc, const void *data, uint32_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    while (len--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (uint32_t i = 0; i < 8; i++) {
+            crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
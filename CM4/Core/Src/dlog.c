@@ -0,0 +1,129 @@
+#include "dlog.h"
+#include "main.h"
+#include "cmsis_os.h"
+#include "usb_tx.h"
+#include <string.h>
+#include <stdio.h>
+
+#define DLOG_DRAIN_PERIOD_MS    10u
+#define DLOG_LINE_MAX           (16u + DLOG_MAX_ARGS * 9u + 3u)    /* "#D:ts,id", ",arg" each, CRLF, NUL */
+
+/* One ring record; seq is written last and marks the slot as committed */
+typedef struct {
+    volatile uint32_t seq;      /* reserve index + 1 once the record is complete */
+    uint32_t ts;
+    uint16_t id;
+    uint8_t  nargs;
+    uint8_t  reserved;
+    uint32_t args[DLOG_MAX_ARGS];
+} dlog_record_t;
+
+static dlog_record_t dlog_ring[DLOG_RING_SIZE];
+static volatile uint32_t dlog_head = 0;     /* next index to reserve (producers) */
+static volatile uint32_t dlog_tail = 0;     /* next index to drain (DLogTask) */
+static volatile uint32_t dlog_written = 0;
+static volatile uint32_t dlog_dropped = 0;
+
+/* Lock-free increment usable from any context */
+static inline void dlog_atomic_inc(volatile uint32_t *v)
+{
+    uint32_t x;
+    do {
+        x = __LDREXW(v) + 1u;
+    } while (__STREXW(x, v) != 0u);
+}
+
+void dlog_init(void)
+{
+    memset(dlog_ring, 0, sizeof(dlog_ring));
+    dlog_head = 0;
+    dlog_tail = 0;
+    dlog_written = 0;
+    dlog_dropped = 0;
+}
+
+/* Reserve a slot with LDREX/STREX, fill it, then publish it through seq.
+ * Multiple producers (tasks and ISRs) may write concurrently. */
+void dlog_write(dlog_id_t id, uint32_t nargs, uint32_t a0, uint32_t a1, uint32_t a2)
+{
+    uint32_t h;
+
+    do {
+        h = __LDREXW(&dlog_head);
+        if (h - dlog_tail >= DLOG_RING_SIZE) {
+            __CLREX();
+            dlog_atomic_inc(&dlog_dropped);
+            return;
+        }
+    } while (__STREXW(h + 1u, &dlog_head) != 0u);
+
+    dlog_record_t *rec = &dlog_ring[h & (DLOG_RING_SIZE - 1u)];
+    rec->ts = HAL_GetTick();
+    rec->id = (uint16_t)id;
+    rec->nargs = (uint8_t)(nargs > DLOG_MAX_ARGS ? DLOG_MAX_ARGS : nargs);
+    rec->args[0] = a0;
+    rec->args[1] = a1;
+    rec->args[2] = a2;
+    __DMB();
+    rec->seq = h + 1u;
+
+    dlog_atomic_inc(&dlog_written);
+}
+
+void dlog_get_stats(dlog_stats_t *stats)
+{
+    if (stats) {
+        stats->written = dlog_written;
+        stats->dropped = dlog_dropped;
+    }
+}
+
+/* "#D:<ts>,<id>[,<arg>...]" in hex, one line per record, formatted whole and queued
+ * in one write so output from other tasks cannot land inside it */
+static void dlog_emit(uint32_t ts, uint32_t id, uint32_t nargs, const uint32_t *args)
+{
+    char line[DLOG_LINE_MAX];
+    int n = snprintf(line, sizeof(line), "#D:%08lX,%04lX", ts, id);
+
+    for (uint32_t i = 0; i < nargs; i++) {
+        n += snprintf(&line[n], sizeof(line) - (size_t)n, ",%08lX", args[i]);
+    }
+    n += snprintf(&line[n], sizeof(line) - (size_t)n, "\r\n");
+    usb_tx_write_all((const uint8_t *)line, (uint32_t)n);
+}
+
+/* Low-priority drain task: the only place log output is written */
+void DLogTask(void *argument)
+{
+    uint32_t reported_drops = 0;
+
+    for (;;) {
+        while (dlog_tail != dlog_head) {
+            dlog_record_t *rec = &dlog_ring[dlog_tail & (DLOG_RING_SIZE - 1u)];
+
+            /* Slot reserved but its producer has not committed it yet */
+            if (rec->seq != dlog_tail + 1u) {
+                break;
+            }
+            __DMB();
+
+            dlog_record_t copy = *rec;
+            __DMB();
+            dlog_tail++;
+
+            dlog_emit(copy.ts, copy.id, copy.nargs, copy.args);
+        }
+
+        uint32_t drops = dlog_dropped;
+        if (drops != reported_drops) {
+            uint32_t lost = drops - reported_drops;
+            dlog_emit(HAL_GetTick(), DLOG_OVERFLOW, 1u, &lost);
+            reported_drops = drops;
+        }
+
+        /* Also restart a CDC transfer that found the endpoint busy */
+        usb_tx_poll();
+
+        osDelay(DLOG_DRAIN_PERIOD_MS);
+    }
+}
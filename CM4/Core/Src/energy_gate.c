@@ -0,0 +1,150 @@
+#include "energy_gate.h"
+#include "main.h"
+#include "cmsis_os.h"
+#include <string.h>
+
+#define GATE_AXES    3u
+#define GATE_FRAMES  SHARED_GATE_WINDOW_FRAMES
+
+/* Running window: samples and squared first differences per axis, with their sums
+ * updated as frames enter and leave, so a frame costs O(1) plus the peak scan */
+static int16_t gate_hist[GATE_AXES][GATE_FRAMES];
+static uint32_t gate_diff2[GATE_AXES][GATE_FRAMES];
+static int32_t gate_sum[GATE_AXES];
+static uint64_t gate_sum2[GATE_AXES];
+static uint64_t gate_diff2_sum[GATE_AXES];
+static int16_t gate_prev[GATE_AXES];
+static uint32_t gate_head = 0;
+static uint32_t gate_filled = 0;
+
+/* Written by the USB command task, read by AcquisitionTask */
+static energy_gate_config_t gate_cfg = {
+    .rms_max = ENERGY_GATE_DEFAULT_RMS,
+    .peak_max = ENERGY_GATE_DEFAULT_PEAK,
+    .band_max = ENERGY_GATE_DEFAULT_BAND,
+};
+static energy_gate_stats_t gate_stats;
+
+static uint32_t gate_isqrt(uint64_t v)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ull << 62;
+
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+static uint16_t gate_sat16(uint32_t v)
+{
+    return (v > 0xFFFFu) ? 0xFFFFu : (uint16_t)v;
+}
+
+void energy_gate_reset(void)
+{
+    taskENTER_CRITICAL();
+    memset(gate_sum, 0, sizeof(gate_sum));
+    memset(gate_sum2, 0, sizeof(gate_sum2));
+    memset(gate_diff2_sum, 0, sizeof(gate_diff2_sum));
+    gate_head = 0;
+    gate_filled = 0;
+    memset(&gate_stats, 0, sizeof(gate_stats));
+    taskEXIT_CRITICAL();
+}
+
+/* Add one frame; true if the window ending with it is quiet */
+bool energy_gate_feed(const sensor_frame_t *frame)
+{
+    const int16_t v[GATE_AXES] = { frame->x, frame->y, frame->z };
+    energy_gate_config_t cfg;
+    uint32_t rms = 0, peak = 0, band = 0;
+
+    taskENTER_CRITICAL();
+    cfg = gate_cfg;
+    taskEXIT_CRITICAL();
+
+    for (uint32_t a = 0; a < GATE_AXES; a++) {
+        if (gate_filled == GATE_FRAMES) {
+            int32_t old = gate_hist[a][gate_head];
+            gate_sum[a] -= old;
+            gate_sum2[a] -= (uint64_t)(old * old);
+            gate_diff2_sum[a] -= gate_diff2[a][gate_head];
+        }
+        int32_t d = gate_filled ? (int32_t)v[a] - gate_prev[a] : 0;
+        uint32_t ad = (uint32_t)(d < 0 ? -d : d);
+        gate_hist[a][gate_head] = v[a];
+        gate_diff2[a][gate_head] = ad * ad;   /* |d| <= 65535 fits squared */
+        gate_sum[a] += v[a];
+        gate_sum2[a] += (uint64_t)((int32_t)v[a] * v[a]);
+        gate_diff2_sum[a] += ad * ad;
+        gate_prev[a] = v[a];
+    }
+    gate_head = (gate_head + 1u) % GATE_FRAMES;
+    if (gate_filled < GATE_FRAMES) gate_filled++;
+
+    bool full = (gate_filled == GATE_FRAMES);
+    if (full) {
+        for (uint32_t a = 0; a < GATE_AXES; a++) {
+            /* N^2 * variance = N * sum(x^2) - sum(x)^2, never negative */
+            uint64_t var_n2 = (uint64_t)GATE_FRAMES * gate_sum2[a] -
+                              (uint64_t)((int64_t)gate_sum[a] * gate_sum[a]);
+            uint32_t r = gate_isqrt(var_n2) / GATE_FRAMES;
+            uint32_t b = gate_isqrt(gate_diff2_sum[a] / GATE_FRAMES);
+            int32_t mean = gate_sum[a] / (int32_t)GATE_FRAMES;
+            uint32_t p = 0;
+            for (uint32_t i = 0; i < GATE_FRAMES; i++) {
+                int32_t dev = gate_hist[a][i] - mean;
+                uint32_t ad = (uint32_t)(dev < 0 ? -dev : dev);
+                if (ad > p) p = ad;
+            }
+            if (r > rms) rms = r;
+            if (p > peak) peak = p;
+            if (b > band) band = b;
+        }
+    }
+
+    bool enabled = cfg.rms_max || cfg.peak_max || cfg.band_max;
+    bool quiet = enabled && full &&
+                 (!cfg.rms_max || rms < cfg.rms_max) &&
+                 (!cfg.peak_max || peak < cfg.peak_max) &&
+                 (!cfg.band_max || band < cfg.band_max);
+
+    taskENTER_CRITICAL();
+    gate_stats.frames++;
+    if (quiet) gate_stats.quiet_frames++;
+    gate_stats.rms = gate_sat16(rms);
+    gate_stats.peak = gate_sat16(peak);
+    gate_stats.band = gate_sat16(band);
+    gate_stats.quiet = quiet;
+    taskEXIT_CRITICAL();
+    return quiet;
+}
+
+void energy_gate_set_config(const energy_gate_config_t *cfg)
+{
+    taskENTER_CRITICAL();
+    gate_cfg = *cfg;
+    taskEXIT_CRITICAL();
+}
+
+void energy_gate_get_config(energy_gate_config_t *cfg)
+{
+    taskENTER_CRITICAL();
+    *cfg = gate_cfg;
+    taskEXIT_CRITICAL();
+}
+
+void energy_gate_get_stats(energy_gate_stats_t *stats)
+{
+    taskENTER_CRITICAL();
+    *stats = gate_stats;
+    taskEXIT_CRITICAL();
+}
@@ -24,6 +24,14 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "cmsis_os.h"
+#include "dlog.h"
+#include "usb_commands.h"
+#include "ai_data_collection.h"
+#include "acquisition_m4.h"
+#include "stream.h"
+#include "usb_tx.h"
+#include "ai_offload.h"
 
 /* USER CODE END Includes */
 
@@ -44,7 +52,12 @@
 
 /* Private variables ---------------------------------------------------------*/
 /* USER CODE BEGIN Variables */
-
+static osThreadId_t acquisitionTaskHandle;
+static osThreadId_t dlogTaskHandle;
+static osThreadId_t usbCommandTaskHandle;
+static osThreadId_t aiDataCollectionTaskHandle;
+static osThreadId_t streamTaskHandle;
+static osThreadId_t aiOffloadTaskHandle;
 /* USER CODE END Variables */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -54,6 +67,58 @@
 
 /* Private application code --------------------------------------------------*/
 /* USER CODE BEGIN Application */
-
+void MX_FREERTOS_Init(void)
+{
+  /* Non-blocking CDC transmit path behind printf */
+  usb_tx_init();
+
+  const osThreadAttr_t acquisitionTask_attributes = {
+    .name = "AcqTask",
+    .stack_size = 256 * 4,
+    .priority = osPriorityAboveNormal,
+  };
+  acquisitionTaskHandle = osThreadNew(AcquisitionTask, NULL, &acquisitionTask_attributes);
+
+  /* Deferred log drain runs below every producer */
+  const osThreadAttr_t dlogTask_attributes = {
+    .name = "DLogTask",
+    .stack_size = 256 * 4,
+    .priority = osPriorityLow,
+  };
+  dlog_init();
+  dlogTaskHandle = osThreadNew(DLogTask, NULL, &dlogTask_attributes);
+
+  /* Training capture and its USB transfer path */
+  const osThreadAttr_t aiDataCollectionTask_attributes = {
+    .name = "AIDataTask",
+    .stack_size = 512 * 4,
+    .priority = osPriorityNormal,
+  };
+  aiDataCollectionTaskHandle = osThreadNew(AIDataCollectionTask, NULL, &aiDataCollectionTask_attributes);
+
+  /* Woken by the CDC receive callback for every complete command line */
+  const osThreadAttr_t usbCommandTask_attributes = {
+    .name = "UsbCmdTask",
+    .stack_size = 512 * 4,
+    .priority = osPriorityNormal1,
+  };
+  usbCommandTaskHandle = osThreadNew(UsbCommandTask, NULL, &usbCommandTask_attributes);
+
+  /* Live binary stream (idle until STREAM ON) */
+  const osThreadAttr_t streamTask_attributes = {
+    .name = "StreamTask",
+    .stack_size = 256 * 4,
+    .priority = osPriorityBelowNormal,
+  };
+  streamTaskHandle = osThreadNew(StreamTask, NULL, &streamTask_attributes);
+
+  /* Windows CM7 hands over when it is saturated, in CM4's spare time (above the log drain) */
+  const osThreadAttr_t aiOffloadTask_attributes = {
+    .name = "AiOffloadTask",
+    .stack_size = 256 * 4,
+    .priority = osPriorityLow1,
+  };
+  aiOffloadTaskHandle = osThreadNew(AiOffloadTask, NULL, &aiOffloadTask_attributes);
+}
 /* USER CODE END Application */
 
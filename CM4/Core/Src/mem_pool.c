@@ -0,0 +1,143 @@
+#include "mem_pool.h"
+#include "stm32h7xx.h"
+#include "usb_tx.h"
+#include <stddef.h>
+#include <string.h>
+
+static mem_pool_t *pool_registry[MEM_POOL_MAX_POOLS];
+static uint32_t pool_registry_count = 0;
+
+/* Short critical section: a handful of instructions, safe at any priority */
+static inline uint32_t mem_pool_lock(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+static inline void mem_pool_unlock(uint32_t primask)
+{
+    __set_PRIMASK(primask);
+}
+
+/* Carve storage into num_blocks blocks and register the pool */
+bool mem_pool_init(mem_pool_t *pool, const char *name, void *storage,
+                   uint32_t block_size, uint32_t num_blocks)
+{
+    if (!pool || !storage || num_blocks == 0 || num_blocks > MEM_POOL_MAX_BLOCKS ||
+        block_size < sizeof(void *)) {
+        return false;
+    }
+
+    /* Keep every block word aligned so the free-list link is valid */
+    block_size = (block_size + 3u) & ~3u;
+
+    pool->name = name;
+    pool->base = (uint8_t *)storage;
+    pool->block_size = block_size;
+    pool->num_blocks = num_blocks;
+    pool->in_use = 0;
+    pool->peak = 0;
+    pool->alloc_failures = 0;
+    memset(pool->alloc_map, 0, sizeof(pool->alloc_map));
+
+    pool->free_list = NULL;
+    for (uint32_t i = num_blocks; i > 0; i--) {
+        void **block = (void **)(pool->base + (i - 1u) * block_size);
+        *block = pool->free_list;
+        pool->free_list = block;
+    }
+
+    for (uint32_t i = 0; i < pool_registry_count; i++) {
+        if (pool_registry[i] == pool) return true;
+    }
+    if (pool_registry_count < MEM_POOL_MAX_POOLS) {
+        pool_registry[pool_registry_count++] = pool;
+    }
+    return true;
+}
+
+void *mem_pool_alloc(mem_pool_t *pool)
+{
+    if (!pool) return NULL;
+
+    uint32_t primask = mem_pool_lock();
+    void **block = (void **)pool->free_list;
+    if (block) {
+        uint32_t index = (uint32_t)((uint8_t *)block - pool->base) / pool->block_size;
+        pool->free_list = *block;
+        pool->alloc_map[index / 32u] |= 1u << (index % 32u);
+        pool->in_use++;
+        if (pool->in_use > pool->peak) pool->peak = pool->in_use;
+    } else {
+        pool->alloc_failures++;
+    }
+    mem_pool_unlock(primask);
+
+    return block;
+}
+
+/* Return a block; rejects pointers that are not a block of this pool and
+ * blocks that are not allocated (double free) */
+bool mem_pool_free(mem_pool_t *pool, void *block)
+{
+    if (!pool || !block) return false;
+
+    uint8_t *p = (uint8_t *)block;
+    if (p < pool->base || p >= pool->base + (size_t)pool->block_size * pool->num_blocks) {
+        return false;
+    }
+    uint32_t offset = (uint32_t)(p - pool->base);
+    if ((offset % pool->block_size) != 0u) {
+        return false;
+    }
+    uint32_t index = offset / pool->block_size;
+    uint32_t bit = 1u << (index % 32u);
+
+    uint32_t primask = mem_pool_lock();
+    bool allocated = (pool->alloc_map[index / 32u] & bit) != 0u;
+    if (allocated) {
+        pool->alloc_map[index / 32u] &= ~bit;
+        *(void **)block = pool->free_list;
+        pool->free_list = block;
+        pool->in_use--;
+    }
+    mem_pool_unlock(primask);
+
+    return allocated;
+}
+
+void mem_pool_get_stats(const mem_pool_t *pool, mem_pool_stats_t *stats)
+{
+    if (!pool || !stats) return;
+
+    uint32_t primask = mem_pool_lock();
+    stats->name = pool->name;
+    stats->block_size = pool->block_size;
+    stats->num_blocks = pool->num_blocks;
+    stats->in_use = pool->in_use;
+    stats->peak = pool->peak;
+    stats->alloc_failures = pool->alloc_failures;
+    mem_pool_unlock(primask);
+}
+
+uint32_t mem_pool_count(void)
+{
+    return pool_registry_count;
+}
+
+const mem_pool_t *mem_pool_get(uint32_t index)
+{
+    return (index < pool_registry_count) ? pool_registry[index] : NULL;
+}
+
+/* "POOL:<name>,<block_size>,<blocks>,<in_use>,<peak>,<failures>" per pool */
+void mem_pool_send_stats_via_usb(void)
+{
+    for (uint32_t i = 0; i < pool_registry_count; i++) {
+        mem_pool_stats_t st = {0};
+        mem_pool_get_stats(pool_registry[i], &st);
+        usb_tx_printf("POOL:%s,%lu,%lu,%lu,%lu,%lu\r\n", st.name ? st.name : "?",
+               st.block_size, st.num_blocks, st.in_use, st.peak, st.alloc_failures);
+    }
+}
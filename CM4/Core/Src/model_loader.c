@@ -0,0 +1,121 @@
+#include "model_loader.h"
+#include "main.h"
+#include <string.h>
+
+/* Only touched from the USB command handler */
+static model_loader_state_t ld;
+static uint32_t ld_crc;
+
+/* CRC-32 (IEEE 802.3, reflected, as zlib.crc32), bitwise like crc16.c */
+static uint32_t model_loader_crc32(const volatile uint8_t *data, uint32_t len)
+{
+    uint32_t crc = 0xFFFFFFFFu;
+
+    while (len--) {
+        crc ^= *data++;
+        for (uint32_t i = 0; i < 8; i++) {
+            crc = (crc & 1u) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+static int model_loader_nibble(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/* True while CM7 has not answered the last request: the stage is its to read */
+bool model_loader_pending(void)
+{
+    shared_model_status_t st;
+
+    if (!shared_read_model_status(&st)) return true;
+    return shared_model_stage.request != st.request;
+}
+
+/* Hand the stage (or the flash bundle) to CM7 */
+static void model_loader_request(uint32_t source, uint32_t size)
+{
+    shared_model_stage.source = source;
+    shared_model_stage.size = size;
+    __DMB();
+    shared_model_stage.request = shared_model_stage.request + 1u;
+    ld.request = shared_model_stage.request;
+}
+
+model_loader_result_t model_loader_begin(uint32_t size, uint32_t crc32)
+{
+    if (model_loader_pending()) return MODEL_LOADER_BUSY;
+    if (size == 0u || size > SHARED_MODEL_STAGE_SIZE) return MODEL_LOADER_RANGE;
+    ld.active = true;
+    ld.size = size;
+    ld.received = 0;
+    ld_crc = crc32;
+    return MODEL_LOADER_OK;
+}
+
+/* Chunks land in order; a chunk resent after a lost reply overwrites its own bytes */
+model_loader_result_t model_loader_data(uint32_t offset, const char *hex, uint32_t *bytes)
+{
+    size_t len = strlen(hex);
+
+    *bytes = 0;
+    if (!ld.active) return MODEL_LOADER_NO_TRANSFER;
+    if ((len & 1u) || len == 0u || len / 2u > MODEL_LOADER_CHUNK_MAX) return MODEL_LOADER_HEX;
+    uint32_t n = (uint32_t)(len / 2u);
+    if (offset > ld.received || offset + n > ld.size) return MODEL_LOADER_RANGE;
+    for (uint32_t i = 0; i < n; i++) {
+        int hi = model_loader_nibble(hex[2u * i]);
+        int lo = model_loader_nibble(hex[2u * i + 1u]);
+        if (hi < 0 || lo < 0) return MODEL_LOADER_HEX;
+    }
+    for (uint32_t i = 0; i < n; i++) {
+        shared_model_stage.data[offset + i] =
+            (uint8_t)((model_loader_nibble(hex[2u * i]) << 4) | model_loader_nibble(hex[2u * i + 1u]));
+    }
+    if (offset + n > ld.received) ld.received = offset + n;
+    *bytes = n;
+    return MODEL_LOADER_OK;
+}
+
+model_loader_result_t model_loader_commit(void)
+{
+    if (!ld.active) return MODEL_LOADER_NO_TRANSFER;
+    if (ld.received != ld.size) return MODEL_LOADER_INCOMPLETE;
+    ld.active = false;
+    if (model_loader_crc32(shared_model_stage.data, ld.size) != ld_crc) return MODEL_LOADER_CRC;
+    model_loader_request(SHARED_MODEL_SRC_STAGE, ld.size);
+    return MODEL_LOADER_OK;
+}
+
+/* Reload the bundle programmed into CM7's MODEL_BUNDLE flash region */
+model_loader_result_t model_loader_load_flash(void)
+{
+    if (model_loader_pending()) return MODEL_LOADER_BUSY;
+    ld.active = false;
+    model_loader_request(SHARED_MODEL_SRC_FLASH, 0u);
+    return MODEL_LOADER_OK;
+}
+
+void model_loader_get_state(model_loader_state_t *state)
+{
+    *state = ld;
+}
+
+const char *model_loader_result_name(model_loader_result_t r)
+{
+    static const char *const names[] = {
+        "ok", "busy", "no transfer", "out of range", "bad hex", "incomplete", "crc mismatch",
+    };
+    return ((uint32_t)r < sizeof(names) / sizeof(names[0])) ? names[r] : "unknown";
+}
+
+const char *model_loader_status_name(uint8_t status)
+{
+    static const char *const names[] = { "ok", "format", "crc", "network", "quant", "open" };
+    return (status < sizeof(names) / sizeof(names[0])) ? names[status] : "unknown";
+}
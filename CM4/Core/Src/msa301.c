@@ -60,3 +60,29 @@ bool msa301_read_raw(I2C_HandleTypeDef *hi2c, int16_t *x, int16_t *y, int16_t *z
     *z = (int16_t)((buf[5] << 8) | buf[4]);
     return true;
 }
+
+/* ODR register codes 0x00..0x0A; rates rounded to whole Hz */
+static const uint16_t msa301_odr_table_hz[] = { 1, 2, 4, 8, 16, 31, 62, 125, 250, 500, 1000 };
+#define MSA301_ODR_CODES (sizeof(msa301_odr_table_hz) / sizeof(msa301_odr_table_hz[0]))
+
+static uint8_t msa301_odr_code(uint32_t hz)
+{
+    uint8_t code = 0;
+    while (code < MSA301_ODR_CODES - 1u && msa301_odr_table_hz[code] < hz) {
+        code++;
+    }
+    return code;
+}
+
+uint32_t msa301_odr_supported_hz(uint32_t hz)
+{
+    return msa301_odr_table_hz[msa301_odr_code(hz)];
+}
+
+/* Change the output data rate; all axes stay enabled */
+bool msa301_set_odr(I2C_HandleTypeDef *hi2c, uint32_t hz)
+{
+    uint8_t v = msa301_odr_code(hz);
+    return HAL_I2C_Mem_Write(hi2c, MSA301_ADDR, MSA301_REG_ODR,
+                             I2C_MEMADD_SIZE_8BIT, &v, 1, 200) == HAL_OK;
+}
@@ -2,14 +2,21 @@
 #include "main.h"
 #include "cmsis_os.h"
 
-#if defined(__GNUC__)
-#define SHARED_LINK __attribute__((section(".shared_ram"), aligned(32)))
-#else
-#define SHARED_LINK
-#endif
+/* The shared objects live in shared_d2 (shared_layout.h), placed by the linker script */
 
-/* Shared ring buffer placed in D2 shared RAM */
-SHARED_LINK volatile shared_ring_t shared_ring;
+/* CM4 copy of the last published configuration (CM4 is the only writer) */
+static shared_ai_config_t ai_config_local = {
+    .seq = 0,
+    .hop_frames = SHARED_AI_DEFAULT_HOP,
+    .period_ms = SHARED_AI_DEFAULT_PERIOD_MS,
+    .fault_thresh_pct = SHARED_AI_DEFAULT_THRESH_PCT,
+    .channel_hop = { 0 },
+    .ema_shift = 0,
+    .enter_pct = { 0 },
+    .exit_pct = { 0 },
+    .enter_dwell_ms = 0,
+    .exit_dwell_ms = 0,
+};
 
 bool shared_push_frame(const sensor_frame_t *f)
 {
@@ -29,3 +36,254 @@ bool shared_pop_frame(sensor_frame_t *out)
     shared_ring.tail = (shared_ring.tail + 1) % SHARED_FRAMES_COUNT;
     return true;
 }
+
+/* Snapshot a channel's latest CM7 result; false if none was published yet or CM7 was mid-write */
+bool shared_read_ai_result(uint32_t channel, shared_ai_result_t *out)
+{
+    if (channel >= SHARED_AI_MAX_CHANNELS) return false;
+    volatile shared_ai_result_t *r = &shared_ai_result[channel];
+    uint32_t seq = r->seq;
+    if (seq == 0u || (seq & 1u)) return false;
+    __DMB();
+    out->window_end_ts = r->window_end_ts;
+    out->class_id = r->class_id;
+    out->channel = r->channel;
+    for (uint32_t i = 0; i < SHARED_AI_NUM_CLASSES; i++) {
+        out->scores[i] = r->scores[i];
+    }
+    out->state = r->state;
+    __DMB();
+    if (r->seq != seq) return false;
+    out->seq = seq;
+    return true;
+}
+
+/* Publish a new CM7 inference configuration (seq odd while writing) */
+void shared_write_ai_config(const shared_ai_config_t *cfg)
+{
+    uint32_t seq = shared_ai_config.seq;
+    shared_ai_config.seq = seq + 1u;
+    __DMB();
+    shared_ai_config.hop_frames = cfg->hop_frames;
+    shared_ai_config.period_ms = cfg->period_ms;
+    shared_ai_config.fault_thresh_pct = cfg->fault_thresh_pct;
+    for (uint32_t i = 0; i < SHARED_AI_MAX_CHANNELS; i++) {
+        shared_ai_config.channel_hop[i] = cfg->channel_hop[i];
+    }
+    shared_ai_config.ema_shift = cfg->ema_shift;
+    for (uint32_t i = 0; i < SHARED_AI_NUM_CLASSES; i++) {
+        shared_ai_config.enter_pct[i] = cfg->enter_pct[i];
+        shared_ai_config.exit_pct[i] = cfg->exit_pct[i];
+    }
+    shared_ai_config.enter_dwell_ms = cfg->enter_dwell_ms;
+    shared_ai_config.exit_dwell_ms = cfg->exit_dwell_ms;
+    __DMB();
+    shared_ai_config.seq = seq + 2u;
+    __DSB();
+
+    ai_config_local = *cfg;
+    ai_config_local.seq = seq + 2u;
+}
+
+void shared_get_ai_config(shared_ai_config_t *out)
+{
+    if (out) *out = ai_config_local;
+}
+
+/* Snapshot CM7 inference timing; false if nothing was published yet or CM7 was mid-write */
+bool shared_read_ai_perf(shared_ai_perf_t *out)
+{
+    uint32_t seq = shared_ai_perf.seq;
+    if (seq == 0u || (seq & 1u)) return false;
+    __DMB();
+    out->infer_count = shared_ai_perf.infer_count;
+    out->last_us = shared_ai_perf.last_us;
+    out->max_us = shared_ai_perf.max_us;
+    out->avg_us = shared_ai_perf.avg_us;
+    out->gated_count = shared_ai_perf.gated_count;
+    __DMB();
+    if (shared_ai_perf.seq != seq) return false;
+    out->seq = seq;
+    return true;
+}
+
+/* Snapshot the CM7 placement benchmark; false if none was published or CM7 was mid-write */
+bool shared_read_ai_bench(shared_ai_bench_t *out)
+{
+    uint32_t seq = shared_ai_bench.seq;
+    if (seq == 0u || (seq & 1u)) return false;
+    __DMB();
+    out->core_hz = shared_ai_bench.core_hz;
+    out->count = shared_ai_bench.count;
+    if (out->count > SHARED_AI_BENCH_MAX) out->count = SHARED_AI_BENCH_MAX;
+    for (uint32_t i = 0; i < out->count; i++) {
+        out->entry[i].acts_place = shared_ai_bench.entry[i].acts_place;
+        out->entry[i].weights_place = shared_ai_bench.entry[i].weights_place;
+        out->entry[i].runs = shared_ai_bench.entry[i].runs;
+        out->entry[i].min_cycles = shared_ai_bench.entry[i].min_cycles;
+        out->entry[i].avg_cycles = shared_ai_bench.entry[i].avg_cycles;
+        out->entry[i].max_cycles = shared_ai_bench.entry[i].max_cycles;
+    }
+    __DMB();
+    if (shared_ai_bench.seq != seq) return false;
+    out->seq = seq;
+    return true;
+}
+
+/* Snapshot the CM7 per-layer profile; false if none was published or CM7 was mid-write */
+bool shared_read_ai_profile(shared_ai_profile_t *out)
+{
+    uint32_t seq = shared_ai_profile.seq;
+    if (seq == 0u || (seq & 1u)) return false;
+    __DMB();
+    out->core_hz = shared_ai_profile.core_hz;
+    out->runs = shared_ai_profile.runs;
+    out->count = shared_ai_profile.count;
+    if (out->count > SHARED_AI_PROFILE_MAX_LAYERS) out->count = SHARED_AI_PROFILE_MAX_LAYERS;
+    for (uint32_t i = 0; i < out->count; i++) {
+        out->layer[i].c_id = shared_ai_profile.layer[i].c_id;
+        out->layer[i].m_id = shared_ai_profile.layer[i].m_id;
+        out->layer[i].type = shared_ai_profile.layer[i].type;
+        out->layer[i].min_cycles = shared_ai_profile.layer[i].min_cycles;
+        out->layer[i].avg_cycles = shared_ai_profile.layer[i].avg_cycles;
+        out->layer[i].max_cycles = shared_ai_profile.layer[i].max_cycles;
+    }
+    __DMB();
+    if (shared_ai_profile.seq != seq) return false;
+    out->seq = seq;
+    return true;
+}
+
+static void shared_copy_cycles(shared_ai_cycles_t *out, const volatile shared_ai_cycles_t *in)
+{
+    out->min_cycles = in->min_cycles;
+    out->avg_cycles = in->avg_cycles;
+    out->max_cycles = in->max_cycles;
+}
+
+/* Snapshot the CM7 engine benchmark; false if none was published or CM7 was mid-write */
+bool shared_read_ai_engine_bench(shared_ai_engine_bench_t *out)
+{
+    uint32_t seq = shared_ai_engine_bench.seq;
+    if (seq == 0u || (seq & 1u)) return false;
+    __DMB();
+    out->core_hz = shared_ai_engine_bench.core_hz;
+    out->windows = shared_ai_engine_bench.windows;
+    out->hop = shared_ai_engine_bench.hop;
+    out->mismatches = shared_ai_engine_bench.mismatches;
+    out->max_diff = shared_ai_engine_bench.max_diff;
+    shared_copy_cycles(&out->runtime, &shared_ai_engine_bench.runtime);
+    shared_copy_cycles(&out->engine, &shared_ai_engine_bench.engine);
+    shared_copy_cycles(&out->streaming, &shared_ai_engine_bench.streaming);
+    shared_copy_cycles(&out->stall, &shared_ai_engine_bench.stall);
+    __DMB();
+    if (shared_ai_engine_bench.seq != seq) return false;
+    out->seq = seq;
+    return true;
+}
+
+/* Snapshot the CM7 scheduler counters; false if none were published or CM7 was mid-write */
+bool shared_read_ai_sched(shared_ai_sched_t *out)
+{
+    uint32_t seq = shared_ai_sched.seq;
+    if (seq == 0u || (seq & 1u)) return false;
+    __DMB();
+    out->policy = shared_ai_sched.policy;
+    out->channels = shared_ai_sched.channels;
+    out->util_permille = shared_ai_sched.util_permille;
+    out->dropped_frames = shared_ai_sched.dropped_frames;
+    out->offloaded = shared_ai_sched.offloaded;
+    out->cm4_util_permille = shared_ai_sched.cm4_util_permille;
+    for (uint32_t i = 0; i < SHARED_AI_MAX_CHANNELS; i++) {
+        out->ch[i].windows = shared_ai_sched.ch[i].windows;
+        out->ch[i].gated = shared_ai_sched.ch[i].gated;
+        out->ch[i].late = shared_ai_sched.ch[i].late;
+        out->ch[i].hop = shared_ai_sched.ch[i].hop;
+        out->ch[i].wps_x100 = shared_ai_sched.ch[i].wps_x100;
+        out->ch[i].last_class = shared_ai_sched.ch[i].last_class;
+        out->ch[i].state = shared_ai_sched.ch[i].state;
+    }
+    __DMB();
+    if (shared_ai_sched.seq != seq) return false;
+    out->seq = seq;
+    return true;
+}
+
+/* Snapshot the model CM7 runs and its last load outcome; false if none was published or
+ * CM7 was mid-write */
+bool shared_read_model_status(shared_model_status_t *out)
+{
+    uint32_t seq = shared_model_status.seq;
+    if (seq == 0u || (seq & 1u)) return false;
+    __DMB();
+    out->request = shared_model_status.request;
+    out->status = shared_model_status.status;
+    out->slot = shared_model_status.slot;
+    out->swaps = shared_model_status.swaps;
+    out->swap_us = shared_model_status.swap_us;
+    for (uint32_t i = 0; i <= SHARED_MODEL_HASH_LEN; i++) {
+        out->hash[i] = shared_model_status.hash[i];
+    }
+    for (uint32_t c = 0; c < SHARED_AI_NUM_CLASSES; c++) {
+        for (uint32_t i = 0; i < SHARED_MODEL_LABEL_LEN; i++) {
+            out->labels[c][i] = shared_model_status.labels[c][i];
+        }
+    }
+    __DMB();
+    if (shared_model_status.seq != seq) return false;
+    out->hash[SHARED_MODEL_HASH_LEN] = '\0';
+    out->seq = seq;
+    return true;
+}
+
+/* Snapshot the one- vs two-core benchmark; false if none was published or CM7 was mid-write */
+bool shared_read_ai_offload_bench(shared_ai_offload_bench_t *out)
+{
+    uint32_t seq = shared_ai_offload_bench.seq;
+    if (seq == 0u || (seq & 1u)) return false;
+    __DMB();
+    out->core_hz = shared_ai_offload_bench.core_hz;
+    out->windows = shared_ai_offload_bench.windows;
+    out->cm4_windows = shared_ai_offload_bench.cm4_windows;
+    out->mismatches = shared_ai_offload_bench.mismatches;
+    out->one_core_wps_x100 = shared_ai_offload_bench.one_core_wps_x100;
+    out->two_core_wps_x100 = shared_ai_offload_bench.two_core_wps_x100;
+    __DMB();
+    if (shared_ai_offload_bench.seq != seq) return false;
+    out->seq = seq;
+    return true;
+}
+
+/* Events CM7 has published so far: a new reader starts its cursor here */
+uint32_t shared_ai_event_count(void)
+{
+    return shared_ai_events.count;
+}
+
+/* Next CM7 decision event after *cursor; false if there is none yet. Events CM7 overwrote
+ * before they were read are skipped and added to *lost. */
+bool shared_read_ai_event(uint32_t *cursor, shared_ai_event_t *out, uint32_t *lost)
+{
+    uint32_t count = shared_ai_events.count;
+    if (count == *cursor) return false;
+    /* The slot of event count - SHARED_AI_EVENTS may be being rewritten */
+    if (count - *cursor >= SHARED_AI_EVENTS) {
+        uint32_t first = count - SHARED_AI_EVENTS + 1u;
+        if (lost) *lost += first - *cursor;
+        *cursor = first;
+    }
+    __DMB();
+    volatile shared_ai_event_t *e = &shared_ai_events.event[*cursor % SHARED_AI_EVENTS];
+    out->event_id = e->event_id;
+    out->ts = e->ts;
+    out->onset_ts = e->onset_ts;
+    out->channel = e->channel;
+    out->from_class = e->from_class;
+    out->to_class = e->to_class;
+    out->confidence_pct = e->confidence_pct;
+    __DMB();
+    bool ok = (shared_ai_events.count - *cursor) < SHARED_AI_EVENTS;
+    if (!ok && lost) (*lost)++;
+    (*cursor)++;
+    return ok;
+}
@@ -0,0 +1,256 @@
+#include "stream.h"
+#include "crc16.h"
+#include "usb_tx.h"
+#include "main.h"
+#include "cmsis_os.h"
+#include <string.h>
+
+#define STREAM_LOOP_PERIOD_MS       10u
+#define STREAM_MAX_PAYLOAD          (8u + STREAM_FRAMES_PER_PACKET * 10u)
+
+/* Queued frame with its running index (dropped frames leave gaps) */
+typedef struct {
+    sensor_frame_t frame;
+    uint32_t index;
+} stream_entry_t;
+
+/* Frame queue: AcquisitionTask produces, StreamTask consumes */
+static stream_entry_t stream_queue[STREAM_QUEUE_FRAMES];
+static volatile uint32_t queue_head = 0;
+static volatile uint32_t queue_tail = 0;
+static uint32_t next_frame_index = 0;   /* index of the next frame seen, dropped or not */
+
+static volatile bool stream_active = false;
+static volatile uint32_t stream_content = STREAM_CONTENT_ALL;
+static volatile uint32_t stream_credits = 0;
+static uint32_t event_cursor = 0;       /* next CM7 decision event to send */
+static stream_stats_t st_stats;
+static uint16_t packet_seq = 0;
+
+void stream_start(uint32_t credits, uint32_t content)
+{
+    taskENTER_CRITICAL();
+    queue_tail = queue_head;
+    stream_content = content;
+    event_cursor = shared_ai_event_count();
+    stream_credits = (credits > STREAM_MAX_CREDITS) ? STREAM_MAX_CREDITS : credits;
+    memset(&st_stats, 0, sizeof(st_stats));
+    packet_seq = 0;
+    stream_active = true;
+    taskEXIT_CRITICAL();
+}
+
+void stream_stop(void)
+{
+    stream_active = false;
+}
+
+void stream_add_credits(uint32_t credits)
+{
+    taskENTER_CRITICAL();
+    uint32_t c = stream_credits + credits;
+    stream_credits = (c > STREAM_MAX_CREDITS) ? STREAM_MAX_CREDITS : c;
+    taskEXIT_CRITICAL();
+}
+
+bool stream_is_active(void)
+{
+    return stream_active;
+}
+
+uint32_t stream_get_credits(void)
+{
+    return stream_credits;
+}
+
+void stream_get_stats(stream_stats_t *stats)
+{
+    if (stats) *stats = st_stats;
+}
+
+/* Called for every acquired frame (AcquisitionTask context) */
+void stream_feed_frame(const sensor_frame_t *frame)
+{
+    if (!stream_active || stream_content != STREAM_CONTENT_ALL || !frame) return;
+
+    uint32_t head = queue_head;
+    if (head - queue_tail >= STREAM_QUEUE_FRAMES) {
+        st_stats.frames_dropped++;
+    } else {
+        stream_entry_t *e = &stream_queue[head & (STREAM_QUEUE_FRAMES - 1u)];
+        e->frame = *frame;
+        e->index = next_frame_index;
+        __DMB();
+        queue_head = head + 1u;
+        st_stats.frames_queued++;
+    }
+    next_frame_index++;
+}
+
+/* Take one credit; false if the host has not granted any */
+static bool stream_take_credit(void)
+{
+    bool ok = false;
+    taskENTER_CRITICAL();
+    if (stream_credits > 0u) {
+        stream_credits--;
+        ok = true;
+    }
+    taskEXIT_CRITICAL();
+    return ok;
+}
+
+static inline uint8_t *put_u16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static inline uint8_t *put_u32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+/* Frame header/CRC around payload[] (already at offset STREAM_HEADER_SIZE) and send it */
+static void stream_send_packet(uint8_t *pkt, stream_packet_type_t type, uint16_t len)
+{
+    pkt[0] = STREAM_SYNC0;
+    pkt[1] = STREAM_SYNC1;
+    pkt[2] = (uint8_t)type;
+    put_u16(&pkt[3], packet_seq++);
+    put_u16(&pkt[5], len);
+    uint16_t crc = crc16_ccitt_update(CRC16_INIT, &pkt[2], 5u + len);
+    put_u16(&pkt[STREAM_HEADER_SIZE + len], crc);
+
+    /* Whole packets only: wait for TX queue space, then queue it in one piece; a
+     * text line can still take the space in between, which drops the packet */
+    uint32_t total = STREAM_HEADER_SIZE + len + 2u;
+    if (!usb_tx_wait_free(total, STREAM_LOOP_PERIOD_MS * 10u) || !usb_tx_write_all(pkt, total)) {
+        st_stats.tx_drops++;
+        return;
+    }
+    st_stats.packets_sent++;
+}
+
+/* Drains the frame queue and CM7 results into packets while credits last */
+void StreamTask(void *argument)
+{
+    static uint8_t pkt[STREAM_HEADER_SIZE + STREAM_MAX_PAYLOAD + 2u];
+    uint32_t last_result_seq[SHARED_AI_MAX_CHANNELS] = { 0 };
+    uint32_t last_samples_tick = HAL_GetTick();
+    uint32_t last_stats_tick = HAL_GetTick();
+
+    for (;;) {
+        osDelay(STREAM_LOOP_PERIOD_MS);
+        if (!stream_active) {
+            continue;
+        }
+
+        uint32_t now = HAL_GetTick();
+        bool stalled = false;
+
+        /* Changes of the reported state, every one of them while credits last */
+        while (!stalled) {
+            shared_ai_event_t ev;
+            uint32_t cursor = event_cursor;
+            if (!shared_read_ai_event(&cursor, &ev, &st_stats.decisions_lost)) {
+                if (cursor == event_cursor) break;      /* nothing new */
+                event_cursor = cursor;                  /* overwritten while read: skipped */
+                continue;
+            }
+            if (!stream_take_credit()) {
+                event_cursor = cursor - 1u;             /* this one goes out next time */
+                stalled = true;
+                break;
+            }
+            event_cursor = cursor;
+            uint8_t *p = &pkt[STREAM_HEADER_SIZE];
+            p = put_u32(p, ev.event_id);
+            p = put_u32(p, ev.ts);
+            p = put_u32(p, ev.onset_ts);
+            *p++ = ev.channel;
+            *p++ = ev.from_class;
+            *p++ = ev.to_class;
+            *p++ = ev.confidence_pct;
+            stream_send_packet(pkt, STREAM_PKT_DECISION, 16u);
+        }
+
+        /* Per-window inference result of each channel, as soon as CM7 publishes it */
+        for (uint32_t ch = 0; ch < SHARED_AI_MAX_CHANNELS && !stalled && stream_content == STREAM_CONTENT_ALL; ch++) {
+            shared_ai_result_t result;
+            if (!shared_read_ai_result(ch, &result) || result.seq == last_result_seq[ch]) continue;
+            if (stream_take_credit()) {
+                uint8_t *p = &pkt[STREAM_HEADER_SIZE];
+                p = put_u32(p, result.seq);
+                p = put_u32(p, result.window_end_ts);
+                *p++ = result.class_id;
+                for (uint32_t i = 0; i < SHARED_AI_NUM_CLASSES; i++) {
+                    *p++ = (uint8_t)result.scores[i];
+                }
+                *p++ = result.channel;
+                *p++ = result.state;
+                *p++ = 0;
+                stream_send_packet(pkt, STREAM_PKT_RESULT, 16u);
+                last_result_seq[ch] = result.seq;
+            } else {
+                stalled = true;
+            }
+        }
+
+        /* Raw samples: full packets, or whatever is queued once the latency bound is hit */
+        for (;;) {
+            uint32_t queued = queue_head - queue_tail;
+            if (queued == 0u) break;
+            if (queued < STREAM_FRAMES_PER_PACKET && (now - last_samples_tick) < STREAM_MAX_LATENCY_MS) break;
+            if (!stream_take_credit()) {
+                stalled = true;
+                break;
+            }
+
+            /* A packet holds consecutive frame indices only */
+            const stream_entry_t *first = &stream_queue[queue_tail & (STREAM_QUEUE_FRAMES - 1u)];
+            uint32_t limit = (queued > STREAM_FRAMES_PER_PACKET) ? STREAM_FRAMES_PER_PACKET : queued;
+            uint32_t count = 1;
+            while (count < limit &&
+                   stream_queue[(queue_tail + count) & (STREAM_QUEUE_FRAMES - 1u)].index == first->index + count) {
+                count++;
+            }
+
+            uint8_t *p = &pkt[STREAM_HEADER_SIZE];
+            p = put_u32(p, first->index);
+            p = put_u16(p, (uint16_t)count);
+            p = put_u16(p, 0);
+            for (uint32_t i = 0; i < count; i++) {
+                const sensor_frame_t *f = &stream_queue[(queue_tail + i) & (STREAM_QUEUE_FRAMES - 1u)].frame;
+                p = put_u32(p, f->ts);
+                p = put_u16(p, (uint16_t)f->x);
+                p = put_u16(p, (uint16_t)f->y);
+                p = put_u16(p, (uint16_t)f->z);
+            }
+            __DMB();
+            queue_tail += count;
+            stream_send_packet(pkt, STREAM_PKT_SAMPLES, (uint16_t)(8u + count * 10u));
+            last_samples_tick = now;
+        }
+
+        if (stalled) {
+            st_stats.credit_stalls++;
+        }
+
+        /* Periodic counters so the host can account for drops */
+        if ((now - last_stats_tick) >= STREAM_STATS_PERIOD_MS && stream_take_credit()) {
+            uint8_t *p = &pkt[STREAM_HEADER_SIZE];
+            p = put_u32(p, st_stats.frames_queued);
+            p = put_u32(p, st_stats.frames_dropped);
+            p = put_u32(p, st_stats.packets_sent);
+            p = put_u32(p, st_stats.credit_stalls);
+            stream_send_packet(pkt, STREAM_PKT_STATS, 16u);
+            last_stats_tick = now;
+        }
+    }
+}
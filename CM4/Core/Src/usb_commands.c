@@ -1,19 +1,185 @@
 #include "usb_commands.h"
 #include "ai_data_collection.h"
+#include "blackbox.h"
+#include "mem_pool.h"
+#include "acquisition_m4.h"
+#include "shared_mem.h"
+#include "dlog.h"
+#include "stream.h"
+#include "energy_gate.h"
+#include "model_loader.h"
+#include "usb_tx.h"
+#include "FreeRTOS.h"
+#include "task.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 
-/* Static variables for USB command processing */
+_Static_assert(sizeof("MODEL DATA 65535 ") + 2u * MODEL_LOADER_CHUNK_MAX <= USB_CMD_BUFFER_SIZE,
+               "a full MODEL DATA line does not fit USB_CMD_BUFFER_SIZE");
+_Static_assert(SHARED_MODEL_STAGE_SIZE <= 65536u, "MODEL DATA offsets need more than 5 digits");
+
+/* RX byte ring: single producer (usb_cdc_receive_callback, USB IRQ),
+ * single consumer (UsbCommandTask). Indices run free, size is a power of two. */
+static uint8_t usb_rx_ring[USB_RX_RING_SIZE];
+static volatile uint32_t rx_head = 0;
+static volatile uint32_t rx_tail = 0;
+static volatile uint32_t rx_overflows = 0;
+
+/* Task woken when a line terminator arrives */
+static TaskHandle_t usb_command_task = NULL;
+
+/* Line being assembled by the command task */
 static char usb_input_buffer[USB_CMD_BUFFER_SIZE];
-static volatile uint32_t buffer_index = 0;
-static volatile bool command_ready = false;
+static uint32_t buffer_index = 0;
+
+/* Reply being formatted; handlers only run on UsbCommandTask, so one buffer serves
+ * them all instead of a USB_RESPONSE_BUFFER_SIZE array in every handler's frame */
+static char response[USB_RESPONSE_BUFFER_SIZE];
+
+/* Next CM7 decision event GET DECISIONS reports */
+static uint32_t decision_cursor = 0;
 
 /* Initialize USB command system */
 void usb_commands_init(void)
 {
     memset(usb_input_buffer, 0, sizeof(usb_input_buffer));
     buffer_index = 0;
-    command_ready = false;
+    rx_tail = rx_head;
+    decision_cursor = shared_ai_event_count();
+}
+
+/* Command handlers */
+static void cmd_start(const usb_command_t* cmd);
+static void cmd_capture(const usb_command_t* cmd);
+static void cmd_stop(const usb_command_t* cmd);
+static void cmd_get_data(const usb_command_t* cmd);
+static void cmd_nack(const usb_command_t* cmd);
+static void cmd_ack(const usb_command_t* cmd);
+static void cmd_status(const usb_command_t* cmd);
+static void cmd_reset(const usb_command_t* cmd);
+static void cmd_get_events(const usb_command_t* cmd);
+static void cmd_clear_events(const usb_command_t* cmd);
+static void cmd_get_pools(const usb_command_t* cmd);
+static void cmd_set_odr(const usb_command_t* cmd);
+static void cmd_set_hop(const usb_command_t* cmd);
+static void cmd_set_period(const usb_command_t* cmd);
+static void cmd_set_thresh(const usb_command_t* cmd);
+static void cmd_set_gate(const usb_command_t* cmd);
+static void cmd_set_decision(const usb_command_t* cmd);
+static void cmd_set_class(const usb_command_t* cmd);
+static void cmd_get_config(const usb_command_t* cmd);
+static void cmd_get_perf(const usb_command_t* cmd);
+static void cmd_get_gate(const usb_command_t* cmd);
+static void cmd_get_bench(const usb_command_t* cmd);
+static void cmd_get_engine(const usb_command_t* cmd);
+static void cmd_get_profile(const usb_command_t* cmd);
+static void cmd_get_channels(const usb_command_t* cmd);
+static void cmd_get_offload(const usb_command_t* cmd);
+static void cmd_get_decisions(const usb_command_t* cmd);
+static void cmd_model_begin(const usb_command_t* cmd);
+static void cmd_model_data(const usb_command_t* cmd);
+static void cmd_model_commit(const usb_command_t* cmd);
+static void cmd_model_flash(const usb_command_t* cmd);
+static void cmd_get_model(const usb_command_t* cmd);
+static void cmd_stream_on(const usb_command_t* cmd);
+static void cmd_stream_off(const usb_command_t* cmd);
+static void cmd_stream_credit(const usb_command_t* cmd);
+static void cmd_help(const usb_command_t* cmd);
+
+/* Command table. Argument spec: 'u' unsigned decimal, 'w' word;
+ * arguments after '|' are optional. */
+static const usb_cmd_entry_t usb_cmd_table[] = {
+    { "START_NORMAL",    "",     "START_NORMAL",                    cmd_start,        MOTOR_NORMAL },
+    { "START_IMBALANCE", "",     "START_IMBALANCE",                 cmd_start,        MOTOR_IMBALANCE },
+    { "START_BEARING",   "",     "START_BEARING",                   cmd_start,        MOTOR_BEARING_FAULT },
+    { "START_MISALIGN",  "",     "START_MISALIGN",                  cmd_start,        MOTOR_MISALIGNMENT },
+    { "CAPTURE",         "w|uu", "CAPTURE <class> [<seconds>] [<hz>]", cmd_capture,   0 },
+    { "STOP",            "",     "STOP",                            cmd_stop,         0 },
+    { "GET_DATA",        "|u",   "GET_DATA [<first_chunk>]",        cmd_get_data,     0 },
+    { "NACK",            "u|u",  "NACK <first> [<last>]",           cmd_nack,         0 },
+    { "ACK",             "",     "ACK",                             cmd_ack,          0 },
+    { "STATUS",          "",     "STATUS",                          cmd_status,       0 },
+    { "RESET",           "",     "RESET",                           cmd_reset,        0 },
+    { "GET_EVENTS",      "",     "GET_EVENTS",                      cmd_get_events,   0 },
+    { "CLEAR_EVENTS",    "",     "CLEAR_EVENTS",                    cmd_clear_events, 0 },
+    { "GET_POOLS",       "",     "GET_POOLS",                       cmd_get_pools,    0 },
+    { "SET ODR",         "u",    "SET ODR <hz>",                    cmd_set_odr,      0 },
+    { "SET HOP",         "u|u",  "SET HOP <frames> [<channel>]",    cmd_set_hop,      0 },
+    { "SET PERIOD",      "u",    "SET PERIOD <ms>",                 cmd_set_period,   0 },
+    { "SET THRESH",      "u",    "SET THRESH <percent>",            cmd_set_thresh,   0 },
+    { "SET GATE",        "uuu",  "SET GATE <rms> <peak> <band>",    cmd_set_gate,     0 },
+    { "SET DECISION",    "uuu",  "SET DECISION <ema_shift> <enter_dwell_ms> <exit_dwell_ms>", cmd_set_decision, 0 },
+    { "SET CLASS",       "wuu",  "SET CLASS <class> <enter_pct> <exit_pct>", cmd_set_class, 0 },
+    { "GET CONFIG",      "",     "GET CONFIG",                      cmd_get_config,   0 },
+    { "GET PERF",        "",     "GET PERF",                        cmd_get_perf,     0 },
+    { "GET GATE",        "",     "GET GATE",                        cmd_get_gate,     0 },
+    { "GET BENCH",       "",     "GET BENCH",                       cmd_get_bench,    0 },
+    { "GET ENGINE",      "",     "GET ENGINE",                      cmd_get_engine,   0 },
+    { "GET PROFILE",     "",     "GET PROFILE",                     cmd_get_profile,  0 },
+    { "GET CHANNELS",    "",     "GET CHANNELS",                    cmd_get_channels, 0 },
+    { "GET OFFLOAD",     "",     "GET OFFLOAD",                     cmd_get_offload,  0 },
+    { "GET DECISIONS",   "",     "GET DECISIONS",                   cmd_get_decisions, 0 },
+    { "MODEL BEGIN",     "uu",   "MODEL BEGIN <size> <crc32>",      cmd_model_begin,  0 },
+    { "MODEL DATA",      "uw",   "MODEL DATA <offset> <hex>",       cmd_model_data,   0 },
+    { "MODEL COMMIT",    "",     "MODEL COMMIT",                    cmd_model_commit, 0 },
+    { "MODEL FLASH",     "",     "MODEL FLASH",                     cmd_model_flash,  0 },
+    { "GET MODEL",       "",     "GET MODEL",                       cmd_get_model,    0 },
+    { "STREAM ON",       "|uw",  "STREAM ON [<credits>] [ALL|DECISIONS]", cmd_stream_on, 0 },
+    { "STREAM OFF",      "",     "STREAM OFF",                      cmd_stream_off,   0 },
+    { "STREAM CREDIT",   "u",    "STREAM CREDIT <n>",               cmd_stream_credit, 0 },
+    { "HELP",            "",     "HELP",                            cmd_help,         0 },
+};
+#define USB_CMD_TABLE_SIZE (sizeof(usb_cmd_table) / sizeof(usb_cmd_table[0]))
+
+/* Number of tokens the keyword consumes, 0 if it does not match */
+static uint32_t usb_match_keyword(const char* keyword, char* const* tokens, uint32_t ntokens)
+{
+    uint32_t n = 0;
+
+    while (*keyword) {
+        const char* end = strchr(keyword, ' ');
+        size_t len = end ? (size_t)(end - keyword) : strlen(keyword);
+        if (n >= ntokens || strlen(tokens[n]) != len || strncmp(tokens[n], keyword, len) != 0) {
+            return 0;
+        }
+        n++;
+        keyword += len;
+        while (*keyword == ' ') keyword++;
+    }
+    return n;
+}
+
+/* Convert the remaining tokens according to the entry's argument spec */
+static bool usb_parse_args(const usb_cmd_entry_t* entry, char* const* tokens, uint32_t ntokens,
+                           usb_command_t* cmd)
+{
+    const char* spec = entry->args;
+    bool optional = false;
+
+    cmd->argc = 0;
+    for (; *spec; spec++) {
+        if (*spec == '|') {
+            optional = true;
+            continue;
+        }
+        if (cmd->argc >= ntokens) {
+            return optional;
+        }
+        const char* tok = tokens[cmd->argc];
+        usb_arg_t* arg = &cmd->args[cmd->argc];
+        arg->s = tok;
+        arg->u = 0;
+        if (*spec == 'u') {
+            char* end;
+            arg->u = (uint32_t)strtoul(tok, &end, 10);
+            if (end == tok || *end != '\0') {
+                return false;
+            }
+        }
+        cmd->argc++;
+    }
+    return cmd->argc == ntokens;
 }
 
 /* Parse incoming command string */
@@ -25,35 +191,30 @@ bool usb_parse_command(const char* input, usb_command_t* cmd)
     
     memset(cmd, 0, sizeof(usb_command_t));
     strncpy(cmd->raw_command, input, USB_CMD_BUFFER_SIZE - 1);
+    strncpy(cmd->arg_text, input, USB_CMD_BUFFER_SIZE - 1);
     
-    /* Parse command type */
-    if (strncmp(input, "START_NORMAL", 12) == 0) {
-        cmd->type = CMD_START_NORMAL;
-        cmd->is_valid = true;
-    } else if (strncmp(input, "START_IMBALANCE", 15) == 0) {
-        cmd->type = CMD_START_IMBALANCE;
-        cmd->is_valid = true;
-    } else if (strncmp(input, "START_BEARING", 13) == 0) {
-        cmd->type = CMD_START_BEARING;
-        cmd->is_valid = true;
-    } else if (strncmp(input, "START_MISALIGN", 14) == 0) {
-        cmd->type = CMD_START_MISALIGN;
-        cmd->is_valid = true;
-    } else if (strncmp(input, "STOP", 4) == 0) {
-        cmd->type = CMD_STOP_COLLECTION;
-        cmd->is_valid = true;
-    } else if (strncmp(input, "GET_DATA", 8) == 0) {
-        cmd->type = CMD_GET_DATA;
-        cmd->is_valid = true;
-    } else if (strncmp(input, "STATUS", 6) == 0) {
-        cmd->type = CMD_GET_STATUS;
-        cmd->is_valid = true;
-    } else if (strncmp(input, "RESET", 5) == 0) {
-        cmd->type = CMD_RESET_SYSTEM;
-        cmd->is_valid = true;
-    } else {
-        cmd->type = CMD_UNKNOWN;
-        cmd->is_valid = false;
+    /* Split into space separated tokens (in arg_text) */
+    char* tokens[USB_CMD_MAX_TOKENS];
+    uint32_t ntokens = 0;
+    char* p = cmd->arg_text;
+    while (*p) {
+        while (*p == ' ') *p++ = '\0';
+        if (!*p) break;
+        if (ntokens == USB_CMD_MAX_TOKENS) {
+            return false;
+        }
+        tokens[ntokens++] = p;
+        while (*p && *p != ' ') p++;
+    }
+    
+    /* Look the keyword up and type-check its arguments */
+    for (uint32_t i = 0; i < USB_CMD_TABLE_SIZE; i++) {
+        uint32_t used = usb_match_keyword(usb_cmd_table[i].keyword, tokens, ntokens);
+        if (used) {
+            cmd->entry = &usb_cmd_table[i];
+            cmd->is_valid = usb_parse_args(cmd->entry, tokens + used, ntokens - used, cmd);
+            break;
+        }
     }
     
     return cmd->is_valid;
@@ -62,124 +223,632 @@ bool usb_parse_command(const char* input, usb_command_t* cmd)
 /* Execute parsed command */
 void usb_execute_command(const usb_command_t* cmd)
 {
-    if (!cmd || !cmd->is_valid) {
-        usb_send_response("ERROR: Invalid command");
+    if (!cmd || !cmd->entry) {
+        usb_send_response("ERROR: Unknown command");
+        return;
+    }
+    if (!cmd->is_valid) {
+        snprintf(response, sizeof(response), "ERROR: Usage: %s", cmd->entry->usage);
+        usb_send_response(response);
         return;
     }
     
-    switch (cmd->type) {
-        case CMD_START_NORMAL:
-            if (ai_start_collection(MOTOR_NORMAL)) {
-                usb_send_response("OK: Started normal motor data collection");
-            } else {
-                usb_send_response("ERROR: Failed to start collection");
-            }
-            break;
-            
-        case CMD_START_IMBALANCE:
-            if (ai_start_collection(MOTOR_IMBALANCE)) {
-                usb_send_response("OK: Started imbalance motor data collection");
-            } else {
-                usb_send_response("ERROR: Failed to start collection");
-            }
-            break;
-            
-        case CMD_START_BEARING:
-            if (ai_start_collection(MOTOR_BEARING_FAULT)) {
-                usb_send_response("OK: Started bearing fault data collection");
-            } else {
-                usb_send_response("ERROR: Failed to start collection");
-            }
-            break;
-            
-        case CMD_START_MISALIGN:
-            if (ai_start_collection(MOTOR_MISALIGNMENT)) {
-                usb_send_response("OK: Started misalignment data collection");
-            } else {
-                usb_send_response("ERROR: Failed to start collection");
-            }
-            break;
-            
-        case CMD_STOP_COLLECTION:
-            if (ai_stop_collection()) {
-                usb_send_response("OK: Collection stopped");
-            } else {
-                usb_send_response("ERROR: Failed to stop collection");
-            }
-            break;
-            
-        case CMD_GET_DATA:
-            {
-                ai_training_sample_t sample;
-                if (ai_get_sample_data(&sample)) {
-                    ai_send_sample_via_usb(&sample);
-                } else {
-                    usb_send_response("ERROR: No data available");
-                }
-            }
-            break;
-            
-        case CMD_GET_STATUS:
-            {
-                ai_collection_status_t status = ai_get_collection_status();
-                char response[64];
-                snprintf(response, sizeof(response), "STATUS: %d", (int)status);
-                usb_send_response(response);
-            }
-            break;
-            
-        case CMD_RESET_SYSTEM:
-            ai_reset_collection();
-            usb_send_response("OK: System reset");
-            break;
-            
-        default:
-            usb_send_response("ERROR: Unknown command");
-            break;
+    cmd->entry->handler(cmd);
+}
+
+/* Map a CAPTURE class argument (name or number) to a fault type */
+static bool usb_parse_fault_class(const char* s, motor_fault_type_t* fault)
+{
+    static const char* const names[] = { "NORMAL", "IMBALANCE", "BEARING", "MISALIGN" };
+
+    for (uint32_t i = 0; i < 4; i++) {
+        char digit[2] = { (char)('0' + i), '\0' };
+        if (strcmp(s, names[i]) == 0 || strcmp(s, digit) == 0) {
+            *fault = (motor_fault_type_t)i;
+            return true;
+        }
     }
+    return false;
 }
 
-/* Send response via USB */
-void usb_send_response(const char* response)
+static void cmd_start(const usb_command_t* cmd)
 {
-    if (response) {
-        printf("%s\r\n", response);
+    static const char* const names[] = {
+        "normal motor", "imbalance motor", "bearing fault", "misalignment"
+    };
+    motor_fault_type_t fault = (motor_fault_type_t)cmd->entry->param;
+
+    if (ai_start_collection(fault)) {
+        snprintf(response, sizeof(response), "OK: Started %s data collection", names[fault]);
+        usb_send_response(response);
+    } else {
+        usb_send_response("ERROR: Failed to start collection");
     }
 }
 
-/* Process input buffer for complete commands */
-void usb_process_input_buffer(void)
+static void cmd_capture(const usb_command_t* cmd)
 {
-    if (command_ready) {
-        usb_command_t cmd;
-        
-        /* Null-terminate the command */
-        usb_input_buffer[buffer_index] = '\0';
-        
-        /* Parse and execute command */
-        if (usb_parse_command(usb_input_buffer, &cmd)) {
-            usb_execute_command(&cmd);
-        } else {
-            usb_send_response("ERROR: Invalid command format");
+    motor_fault_type_t fault;
+    uint32_t seconds = (cmd->argc > 1) ? cmd->args[1].u : AI_SAMPLE_DURATION_SEC;
+    uint32_t hz = (cmd->argc > 2) ? cmd->args[2].u : AI_SAMPLE_RATE_HZ;
+
+    if (!usb_parse_fault_class(cmd->args[0].s, &fault)) {
+        usb_send_response("ERROR: Unknown class (NORMAL|IMBALANCE|BEARING|MISALIGN|0-3)");
+    } else if (!ai_capture_params_valid(seconds, hz)) {
+        snprintf(response, sizeof(response),
+                 "ERROR: Out of range (hz 1-%d, seconds 1-%d, hz*seconds <= %d)",
+                 AI_MAX_SAMPLE_RATE_HZ, AI_MAX_DURATION_SEC, AI_SAMPLES_PER_COLLECTION);
+        usb_send_response(response);
+    } else if (!ai_start_collection_ex(fault, seconds, hz)) {
+        usb_send_response("ERROR: Failed to start collection");
+    } else {
+        snprintf(response, sizeof(response), "OK: CAPTURE class=%d seconds=%lu hz=%lu samples=%lu",
+                 (int)fault, seconds, hz, seconds * hz);
+        usb_send_response(response);
+    }
+}
+
+static void cmd_stop(const usb_command_t* cmd)
+{
+    if (ai_stop_collection()) {
+        usb_send_response("OK: Collection stopped");
+    } else {
+        usb_send_response("ERROR: Failed to stop collection");
+    }
+}
+
+/* Optional argument resumes an interrupted offload at that chunk */
+static void cmd_get_data(const usb_command_t* cmd)
+{
+    uint32_t first = (cmd->argc > 0) ? cmd->args[0].u : 0;
+
+    if (!ai_send_chunks_via_usb(first, UINT32_MAX)) {
+        usb_send_response("ERROR: No data available");
+    }
+}
+
+static void cmd_nack(const usb_command_t* cmd)
+{
+    uint32_t first = cmd->args[0].u;
+    uint32_t last = (cmd->argc > 1) ? cmd->args[1].u : first;
+
+    if (!ai_send_chunks_via_usb(first, last)) {
+        usb_send_response("ERROR: Invalid chunk range");
+    }
+}
+
+static void cmd_ack(const usb_command_t* cmd)
+{
+    if (ai_release_sample()) {
+        usb_send_response("OK: Sample released");
+    } else {
+        usb_send_response("ERROR: No data to acknowledge");
+    }
+}
+
+static void cmd_status(const usb_command_t* cmd)
+{
+    snprintf(response, sizeof(response), "STATUS: %d", (int)ai_get_collection_status());
+    usb_send_response(response);
+}
+
+static void cmd_reset(const usb_command_t* cmd)
+{
+    ai_reset_collection();
+    usb_send_response("OK: System reset");
+}
+
+static void cmd_get_events(const usb_command_t* cmd)
+{
+    blackbox_send_events_via_usb();
+    usb_send_response("OK: Events sent");
+}
+
+static void cmd_clear_events(const usb_command_t* cmd)
+{
+    if (blackbox_clear()) {
+        usb_send_response("OK: Events cleared");
+    } else {
+        usb_send_response("ERROR: Event transfer in progress");
+    }
+}
+
+static void cmd_get_pools(const usb_command_t* cmd)
+{
+    mem_pool_send_stats_via_usb();
+    /* Least free stack UsbCmdTask has had, after every command it ran so far */
+    snprintf(response, sizeof(response), "STACK:%s,%lu", pcTaskGetName(NULL),
+             (uint32_t)(uxTaskGetStackHighWaterMark(NULL) * sizeof(StackType_t)));
+    usb_send_response(response);
+    usb_send_response("OK: Pool stats sent");
+}
+
+/* Applied by AcquisitionTask before its next read; the sensor rounds up to a supported rate */
+static void cmd_set_odr(const usb_command_t* cmd)
+{
+    if (cmd->args[0].u == 0u) {
+        usb_send_response("ERROR: Out of range (hz >= 1)");
+        return;
+    }
+    snprintf(response, sizeof(response), "OK: ODR odr_hz=%lu",
+             acquisition_request_odr(cmd->args[0].u));
+    usb_send_response(response);
+}
+
+static void cmd_set_hop(const usb_command_t* cmd)
+{
+    shared_ai_config_t cfg;
+
+    if (cmd->args[0].u < 1u || cmd->args[0].u > USB_MAX_HOP_FRAMES) {
+        snprintf(response, sizeof(response), "ERROR: Out of range (frames 1-%d)", USB_MAX_HOP_FRAMES);
+        usb_send_response(response);
+        return;
+    }
+    if (cmd->argc > 1 && cmd->args[1].u >= SHARED_AI_MAX_CHANNELS) {
+        snprintf(response, sizeof(response), "ERROR: Out of range (channel 0-%u)", SHARED_AI_MAX_CHANNELS - 1u);
+        usb_send_response(response);
+        return;
+    }
+    shared_get_ai_config(&cfg);
+    if (cmd->argc > 1) {
+        /* Per-channel override of the default hop */
+        cfg.channel_hop[cmd->args[1].u] = (uint16_t)cmd->args[0].u;
+        shared_write_ai_config(&cfg);
+        snprintf(response, sizeof(response), "OK: HOP hop=%u channel=%lu",
+                 cfg.channel_hop[cmd->args[1].u], cmd->args[1].u);
+    } else {
+        cfg.hop_frames = (uint16_t)cmd->args[0].u;
+        shared_write_ai_config(&cfg);
+        snprintf(response, sizeof(response), "OK: HOP hop=%u", cfg.hop_frames);
+    }
+    usb_send_response(response);
+}
+
+static void cmd_set_period(const usb_command_t* cmd)
+{
+    shared_ai_config_t cfg;
+
+    if (cmd->args[0].u < 1u || cmd->args[0].u > USB_MAX_PERIOD_MS) {
+        snprintf(response, sizeof(response), "ERROR: Out of range (ms 1-%d)", USB_MAX_PERIOD_MS);
+        usb_send_response(response);
+        return;
+    }
+    shared_get_ai_config(&cfg);
+    cfg.period_ms = (uint16_t)cmd->args[0].u;
+    shared_write_ai_config(&cfg);
+    snprintf(response, sizeof(response), "OK: PERIOD period_ms=%u", cfg.period_ms);
+    usb_send_response(response);
+}
+
+static void cmd_set_thresh(const usb_command_t* cmd)
+{
+    shared_ai_config_t cfg;
+
+    if (cmd->args[0].u > 100u) {
+        usb_send_response("ERROR: Out of range (percent 0-100)");
+        return;
+    }
+    shared_get_ai_config(&cfg);
+    cfg.fault_thresh_pct = (uint8_t)cmd->args[0].u;
+    shared_write_ai_config(&cfg);
+    snprintf(response, sizeof(response), "OK: THRESH thresh_pct=%u", cfg.fault_thresh_pct);
+    usb_send_response(response);
+}
+
+static void cmd_set_gate(const usb_command_t* cmd)
+{
+    energy_gate_config_t gate;
+
+    for (uint32_t i = 0; i < 3u; i++) {
+        if (cmd->args[i].u > 0xFFFFu) {
+            usb_send_response("ERROR: Out of range (lsb 0-65535, 0 = metric off)");
+            return;
         }
-        
-        /* Reset buffer */
-        memset(usb_input_buffer, 0, sizeof(usb_input_buffer));
-        buffer_index = 0;
-        command_ready = false;
     }
+    gate.rms_max = (uint16_t)cmd->args[0].u;
+    gate.peak_max = (uint16_t)cmd->args[1].u;
+    gate.band_max = (uint16_t)cmd->args[2].u;
+    energy_gate_set_config(&gate);
+    snprintf(response, sizeof(response), "OK: GATE rms_max=%u peak_max=%u band_max=%u",
+             gate.rms_max, gate.peak_max, gate.band_max);
+    usb_send_response(response);
 }
 
-/* USB CDC receive callback */
-void usb_cdc_receive_callback(uint8_t* buffer, uint32_t length)
+static void cmd_set_decision(const usb_command_t* cmd)
 {
-    for (uint32_t i = 0; i < length; i++) {
-        char c = (char)buffer[i];
-        
+    shared_ai_config_t cfg;
+
+    if (cmd->args[0].u > USB_MAX_EMA_SHIFT || cmd->args[1].u > USB_MAX_DWELL_MS ||
+        cmd->args[2].u > USB_MAX_DWELL_MS) {
+        snprintf(response, sizeof(response), "ERROR: Out of range (ema_shift 0-%d, dwell ms 0-%d)",
+                 USB_MAX_EMA_SHIFT, USB_MAX_DWELL_MS);
+        usb_send_response(response);
+        return;
+    }
+    shared_get_ai_config(&cfg);
+    cfg.ema_shift = (uint8_t)cmd->args[0].u;
+    cfg.enter_dwell_ms = (uint16_t)cmd->args[1].u;
+    cfg.exit_dwell_ms = (uint16_t)cmd->args[2].u;
+    shared_write_ai_config(&cfg);
+    snprintf(response, sizeof(response), "OK: DECISION ema_shift=%u enter_dwell_ms=%u exit_dwell_ms=%u",
+             cfg.ema_shift, cfg.enter_dwell_ms, cfg.exit_dwell_ms);
+    usb_send_response(response);
+}
+
+/* Per fault class hysteresis: 0 falls back to SET THRESH (enter) or the enter threshold (exit) */
+static void cmd_set_class(const usb_command_t* cmd)
+{
+    shared_ai_config_t cfg;
+    motor_fault_type_t fault;
+
+    if (!usb_parse_fault_class(cmd->args[0].s, &fault) || fault == MOTOR_NORMAL) {
+        usb_send_response("ERROR: Unknown fault class (IMBALANCE, BEARING, MISALIGN or 1-3)");
+        return;
+    }
+    if (cmd->args[1].u > 100u || cmd->args[2].u > 100u ||
+        (cmd->args[1].u && cmd->args[2].u > cmd->args[1].u)) {
+        usb_send_response("ERROR: Out of range (percent 0-100, exit <= enter)");
+        return;
+    }
+    shared_get_ai_config(&cfg);
+    cfg.enter_pct[fault] = (uint8_t)cmd->args[1].u;
+    cfg.exit_pct[fault] = (uint8_t)cmd->args[2].u;
+    shared_write_ai_config(&cfg);
+    snprintf(response, sizeof(response), "OK: CLASS class=%u enter_pct=%u exit_pct=%u",
+             (unsigned)fault, cfg.enter_pct[fault], cfg.exit_pct[fault]);
+    usb_send_response(response);
+}
+
+static void cmd_get_config(const usb_command_t* cmd)
+{
+    shared_ai_config_t cfg;
+    uint32_t capture_sec, capture_hz;
+
+    /* Live values: last CAPTURE, sensor ODR and what the SET commands wrote for CM7 */
+    ai_get_capture_params(&capture_sec, &capture_hz);
+    shared_get_ai_config(&cfg);
+    snprintf(response, sizeof(response),
+             "OK: CONFIG capture_hz=%lu capture_sec=%lu capture_max_samples=%d odr_hz=%lu "
+             "hop=%u channel_hop=%u,%u,%u,%u period_ms=%u thresh_pct=%u ema_shift=%u enter_dwell_ms=%u "
+             "exit_dwell_ms=%u enter_pct=%u,%u,%u exit_pct=%u,%u,%u",
+             capture_hz, capture_sec, AI_SAMPLES_PER_COLLECTION,
+             acquisition_get_odr(), cfg.hop_frames,
+             cfg.channel_hop[0], cfg.channel_hop[1], cfg.channel_hop[2], cfg.channel_hop[3],
+             cfg.period_ms, cfg.fault_thresh_pct,
+             cfg.ema_shift, cfg.enter_dwell_ms, cfg.exit_dwell_ms,
+             cfg.enter_pct[1], cfg.enter_pct[2], cfg.enter_pct[3],
+             cfg.exit_pct[1], cfg.exit_pct[2], cfg.exit_pct[3]);
+    usb_send_response(response);
+}
+
+static void cmd_get_perf(const usb_command_t* cmd)
+{
+    acquisition_stats_t acq;
+    shared_ai_perf_t perf = {0};
+    dlog_stats_t dl;
+    usb_tx_stats_t tx;
+
+    acquisition_get_stats(&acq);
+    shared_read_ai_perf(&perf);
+    dlog_get_stats(&dl);
+    usb_tx_get_stats(&tx);
+    snprintf(response, sizeof(response),
+             "OK: PERF frames=%lu ring_drops=%lu read_errors=%lu infer_count=%lu gated=%lu "
+             "infer_last_us=%lu infer_max_us=%lu infer_avg_us=%lu dlog_dropped=%lu rx_overflows=%lu "
+             "tx_sent=%lu tx_dropped=%lu tx_transfers=%lu",
+             acq.frames, acq.ring_drops, acq.read_errors, perf.infer_count, perf.gated_count,
+             perf.last_us, perf.max_us, perf.avg_us, dl.dropped, usb_get_rx_overflows(),
+             tx.bytes_sent, tx.bytes_dropped, tx.transfers);
+    usb_send_response(response);
+}
+
+static void cmd_get_gate(const usb_command_t* cmd)
+{
+    energy_gate_config_t gate;
+    energy_gate_stats_t gs;
+    shared_ai_perf_t perf = {0};
+
+    energy_gate_get_config(&gate);
+    energy_gate_get_stats(&gs);
+    shared_read_ai_perf(&perf);
+    snprintf(response, sizeof(response),
+             "OK: GATE rms_max=%u peak_max=%u band_max=%u window=%u rms=%u peak=%u band=%u quiet=%u "
+             "frames=%lu quiet_frames=%lu gated=%lu infer_count=%lu",
+             gate.rms_max, gate.peak_max, gate.band_max, SHARED_GATE_WINDOW_FRAMES,
+             gs.rms, gs.peak, gs.band, gs.quiet ? 1u : 0u,
+             gs.frames, gs.quiet_frames, perf.gated_count, perf.infer_count);
+    usb_send_response(response);
+}
+
+static const char* placement_name(uint8_t place)
+{
+    switch (place) {
+    case SHARED_AI_PLACE_FLASH: return "FLASH";
+    case SHARED_AI_PLACE_AXI:   return "AXI";
+    case SHARED_AI_PLACE_DTCM:  return "DTCM";
+    case SHARED_AI_PLACE_QSPI:  return "QSPI";
+    default:                    return "?";
+    }
+}
+
+/* One BENCH line per placement measured by CM7 at boot (AI_PLACEMENT_BENCH builds) */
+static void cmd_get_bench(const usb_command_t* cmd)
+{
+    shared_ai_bench_t bench;
+
+    if (!shared_read_ai_bench(&bench)) {
+        usb_send_response("ERROR: No placement benchmark (build CM7 with AI_PLACEMENT_BENCH=1)");
+        return;
+    }
+    for (uint32_t i = 0; i < bench.count; i++) {
+        const shared_ai_bench_entry_t* e = &bench.entry[i];
+        snprintf(response, sizeof(response), "BENCH:%s,%s,%u,%lu,%lu,%lu",
+                 placement_name(e->acts_place), placement_name(e->weights_place), e->runs,
+                 e->min_cycles, e->avg_cycles, e->max_cycles);
+        usb_send_response(response);
+    }
+    snprintf(response, sizeof(response), "OK: BENCH entries=%lu core_hz=%lu", bench.count, bench.core_hz);
+    usb_send_response(response);
+}
+
+/* Open engine vs X-CUBE-AI runtime, measured by CM7 at boot (AI_ENGINE_BENCH builds) */
+static void cmd_get_engine(const usb_command_t* cmd)
+{
+    shared_ai_engine_bench_t bench;
+
+    if (!shared_read_ai_engine_bench(&bench)) {
+        usb_send_response("ERROR: No engine benchmark (build CM7 with AI_ENGINE_BENCH=1)");
+        return;
+    }
+    const struct { const char* name; const shared_ai_cycles_t* c; } runs[] = {
+        { "runtime", &bench.runtime }, { "engine", &bench.engine }, { "streaming", &bench.streaming },
+        { "stall", &bench.stall },
+    };
+    for (uint32_t i = 0; i < sizeof(runs) / sizeof(runs[0]); i++) {
+        snprintf(response, sizeof(response), "ENGINE:%s,%lu,%lu,%lu",
+                 runs[i].name, runs[i].c->min_cycles, runs[i].c->avg_cycles, runs[i].c->max_cycles);
+        usb_send_response(response);
+    }
+    snprintf(response, sizeof(response), "OK: ENGINE windows=%u hop=%u mismatches=%u max_diff=%u core_hz=%lu",
+             bench.windows, bench.hop, bench.mismatches, bench.max_diff, bench.core_hz);
+    usb_send_response(response);
+}
+
+/* One LAYER line per CM7 c-layer (AI_PROFILING builds); layer_profile.py renders them.
+ * The snapshot is static like response: it is the largest one a handler takes. */
+static void cmd_get_profile(const usb_command_t* cmd)
+{
+    static shared_ai_profile_t prof;
+
+    if (!shared_read_ai_profile(&prof)) {
+        usb_send_response("ERROR: No layer profile (build CM7 with AI_PROFILING=1)");
+        return;
+    }
+    for (uint32_t i = 0; i < prof.count; i++) {
+        const shared_ai_layer_prof_t* l = &prof.layer[i];
+        snprintf(response, sizeof(response), "LAYER:%u,%u,%u,%lu,%lu,%lu",
+                 l->c_id, l->m_id, l->type, l->min_cycles, l->avg_cycles, l->max_cycles);
+        usb_send_response(response);
+    }
+    snprintf(response, sizeof(response), "OK: PROFILE layers=%lu runs=%lu core_hz=%lu",
+             prof.count, prof.runs, prof.core_hz);
+    usb_send_response(response);
+}
+
+static void cmd_get_channels(const usb_command_t* cmd)
+{
+    shared_ai_sched_t sched;
+
+    if (!shared_read_ai_sched(&sched)) {
+        usb_send_response("ERROR: No scheduler counters yet");
+        return;
+    }
+    for (uint32_t i = 0; i < sched.channels && i < SHARED_AI_MAX_CHANNELS; i++) {
+        const shared_ai_channel_stats_t* c = &sched.ch[i];
+        snprintf(response, sizeof(response), "CHANNEL:%lu,%u,%lu,%lu,%lu,%u,%u,%u",
+                 i, c->hop, c->windows, c->gated, c->late, c->wps_x100, c->last_class, c->state);
+        usb_send_response(response);
+    }
+    snprintf(response, sizeof(response),
+             "OK: CHANNELS channels=%u policy=%s util_permille=%u dropped_frames=%lu offloaded=%lu cm4_util_permille=%u",
+             sched.channels, (sched.policy == SHARED_AI_SCHED_DEADLINE) ? "deadline" : "round_robin",
+             sched.util_permille, sched.dropped_frames, sched.offloaded, sched.cm4_util_permille);
+    usb_send_response(response);
+}
+
+/* CM7 alone vs CM7 with CM4 offload, measured by CM7 at boot (AI_OFFLOAD_BENCH builds) */
+static void cmd_get_offload(const usb_command_t* cmd)
+{
+    shared_ai_offload_bench_t bench;
+
+    if (!shared_read_ai_offload_bench(&bench)) {
+        usb_send_response("ERROR: No offload benchmark (build CM7 with AI_OFFLOAD_BENCH=1)");
+        return;
+    }
+    snprintf(response, sizeof(response),
+             "OK: OFFLOAD windows=%u one_core_wps_x100=%lu two_core_wps_x100=%lu cm4_windows=%u mismatches=%u core_hz=%lu",
+             bench.windows, bench.one_core_wps_x100, bench.two_core_wps_x100, bench.cm4_windows,
+             bench.mismatches, bench.core_hz);
+    usb_send_response(response);
+}
+
+/* Decision events since the last GET DECISIONS (or boot), oldest first */
+static void cmd_get_decisions(const usb_command_t* cmd)
+{
+    shared_ai_event_t ev;
+    uint32_t n = 0, lost = 0;
+
+    while (decision_cursor != shared_ai_event_count()) {
+        if (!shared_read_ai_event(&decision_cursor, &ev, &lost)) continue;
+        snprintf(response, sizeof(response), "DECISION:%lu,%u,%u,%u,%u,%lu,%lu",
+                 ev.event_id, ev.channel, ev.from_class, ev.to_class, ev.confidence_pct,
+                 ev.onset_ts, ev.ts);
+        usb_send_response(response);
+        n++;
+    }
+    snprintf(response, sizeof(response), "OK: DECISIONS events=%lu lost=%lu", n, lost);
+    usb_send_response(response);
+}
+
+static void cmd_model_error(model_loader_result_t r)
+{
+    snprintf(response, sizeof(response), "ERROR: Model %s", model_loader_result_name(r));
+    usb_send_response(response);
+}
+
+static void cmd_model_begin(const usb_command_t* cmd)
+{
+    model_loader_result_t r = model_loader_begin(cmd->args[0].u, cmd->args[1].u);
+
+    if (r != MODEL_LOADER_OK) {
+        cmd_model_error(r);
+        return;
+    }
+    snprintf(response, sizeof(response), "OK: MODEL size=%lu chunk=%u", cmd->args[0].u, MODEL_LOADER_CHUNK_MAX);
+    usb_send_response(response);
+}
+
+static void cmd_model_data(const usb_command_t* cmd)
+{
+    model_loader_state_t st;
+    uint32_t bytes;
+    model_loader_result_t r = model_loader_data(cmd->args[0].u, cmd->args[1].s, &bytes);
+
+    if (r != MODEL_LOADER_OK) {
+        cmd_model_error(r);
+        return;
+    }
+    model_loader_get_state(&st);
+    snprintf(response, sizeof(response), "OK: MODEL received=%lu", st.received);
+    usb_send_response(response);
+}
+
+/* CM7 answers asynchronously: GET MODEL shows the outcome once request is handled */
+static void cmd_model_commit(const usb_command_t* cmd)
+{
+    model_loader_state_t st;
+    model_loader_result_t r = model_loader_commit();
+
+    if (r != MODEL_LOADER_OK) {
+        cmd_model_error(r);
+        return;
+    }
+    model_loader_get_state(&st);
+    snprintf(response, sizeof(response), "OK: MODEL request=%lu source=stage", st.request);
+    usb_send_response(response);
+}
+
+static void cmd_model_flash(const usb_command_t* cmd)
+{
+    model_loader_state_t st;
+    model_loader_result_t r = model_loader_load_flash();
+
+    if (r != MODEL_LOADER_OK) {
+        cmd_model_error(r);
+        return;
+    }
+    model_loader_get_state(&st);
+    snprintf(response, sizeof(response), "OK: MODEL request=%lu source=flash", st.request);
+    usb_send_response(response);
+}
+
+static void cmd_get_model(const usb_command_t* cmd)
+{
+    shared_model_status_t m;
+
+    if (!shared_read_model_status(&m)) {
+        usb_send_response("ERROR: No model status yet");
+        return;
+    }
+    for (uint32_t c = 0; c < SHARED_AI_NUM_CLASSES; c++) {
+        snprintf(response, sizeof(response), "LABEL:%lu,%.*s", c, (int)SHARED_MODEL_LABEL_LEN, m.labels[c]);
+        usb_send_response(response);
+    }
+    snprintf(response, sizeof(response),
+             "OK: MODEL hash=%s slot=%u status=%s swaps=%lu swap_us=%lu request=%lu pending=%u",
+             m.hash, m.slot, model_loader_status_name(m.status), m.swaps, m.swap_us, m.request,
+             model_loader_pending() ? 1u : 0u);
+    usb_send_response(response);
+}
+
+static void cmd_stream_on(const usb_command_t* cmd)
+{
+    uint32_t content = STREAM_CONTENT_ALL;
+
+    if (cmd->argc > 1) {
+        if (strcmp(cmd->args[1].s, "DECISIONS") == 0) {
+            content = STREAM_CONTENT_DECISIONS;
+        } else if (strcmp(cmd->args[1].s, "ALL") != 0) {
+            snprintf(response, sizeof(response), "ERROR: Usage: %s", cmd->entry->usage);
+            usb_send_response(response);
+            return;
+        }
+    }
+    stream_start((cmd->argc > 0) ? cmd->args[0].u : STREAM_DEFAULT_CREDITS, content);
+    snprintf(response, sizeof(response), "OK: STREAM state=on credits=%lu content=%s", stream_get_credits(),
+             (content == STREAM_CONTENT_DECISIONS) ? "decisions" : "all");
+    usb_send_response(response);
+}
+
+static void cmd_stream_off(const usb_command_t* cmd)
+{
+    stream_stats_t st;
+
+    stream_stop();
+    stream_get_stats(&st);
+    snprintf(response, sizeof(response),
+             "OK: STREAM state=off frames=%lu dropped=%lu packets=%lu credit_stalls=%lu decisions_lost=%lu "
+             "tx_drops=%lu",
+             st.frames_queued, st.frames_dropped, st.packets_sent, st.credit_stalls, st.decisions_lost,
+             st.tx_drops);
+    usb_send_response(response);
+}
+
+/* No reply: credits arrive continuously and a text line per grant would waste bandwidth */
+static void cmd_stream_credit(const usb_command_t* cmd)
+{
+    stream_add_credits(cmd->args[0].u);
+}
+
+static void cmd_help(const usb_command_t* cmd)
+{
+    for (uint32_t i = 0; i < USB_CMD_TABLE_SIZE; i++) {
+        usb_send_response(usb_cmd_table[i].usage);
+    }
+    usb_send_response("OK: Help sent");
+}
+
+/* Send response via USB */
+void usb_send_response(const char* response)
+{
+    if (response) {
+        usb_tx_write_line(response);
+    }
+}
+
+/* Drain the RX ring and dispatch every complete line */
+void usb_process_input_buffer(void)
+{
+    while (rx_tail != rx_head) {
+        char c = (char)usb_rx_ring[rx_tail & (USB_RX_RING_SIZE - 1u)];
+        __DMB();
+        rx_tail++;
+
         /* Check for command terminator */
         if (c == '\r' || c == '\n') {
             if (buffer_index > 0) {
-                command_ready = true;
+                static usb_command_t cmd;   /* 2 x USB_CMD_BUFFER_SIZE, kept off the task stack */
+
+                /* Null-terminate the command */
+                usb_input_buffer[buffer_index] = '\0';
+
+                /* Parse and execute command (reports unknown keywords and bad arguments) */
+                usb_parse_command(usb_input_buffer, &cmd);
+                usb_execute_command(&cmd);
+
+                /* Reset buffer */
+                memset(usb_input_buffer, 0, sizeof(usb_input_buffer));
+                buffer_index = 0;
             }
         } else if (c >= ' ' && c <= '~') {  /* Printable ASCII */
             if (buffer_index < (USB_CMD_BUFFER_SIZE - 1)) {
@@ -188,3 +857,51 @@ void usb_cdc_receive_callback(uint8_t* buffer, uint32_t length)
         }
     }
 }
+
+/* USB CDC receive callback: only queues bytes, parsing happens in UsbCommandTask */
+void usb_cdc_receive_callback(uint8_t* buffer, uint32_t length)
+{
+    bool line_complete = false;
+
+    for (uint32_t i = 0; i < length; i++) {
+        uint32_t head = rx_head;
+        if (head - rx_tail >= USB_RX_RING_SIZE) {
+            rx_overflows++;
+            break;
+        }
+        usb_rx_ring[head & (USB_RX_RING_SIZE - 1u)] = buffer[i];
+        __DMB();
+        rx_head = head + 1u;
+
+        if (buffer[i] == '\r' || buffer[i] == '\n') {
+            line_complete = true;
+        }
+    }
+
+    if (line_complete && usb_command_task) {
+        if (xPortIsInsideInterrupt()) {
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(usb_command_task, &woken);
+            portYIELD_FROM_ISR(woken);
+        } else {
+            xTaskNotifyGive(usb_command_task);
+        }
+    }
+}
+
+uint32_t usb_get_rx_overflows(void)
+{
+    return rx_overflows;
+}
+
+/* Command task: sleeps until a full line is queued, then dispatches it */
+void UsbCommandTask(void *argument)
+{
+    usb_commands_init();
+    usb_command_task = xTaskGetCurrentTaskHandle();
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        usb_process_input_buffer();
+    }
+}
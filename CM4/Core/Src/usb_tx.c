@@ -0,0 +1,223 @@
+#include "usb_tx.h"
+#include "main.h"
+#include "cmsis_os.h"
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+
+#define USBD_OK_STATUS  0u
+
+/* Generated CDC interface (usbd_cdc_if.c); weak so the image links without the USB stack */
+extern uint8_t CDC_Transmit_FS(uint8_t *Buf, uint16_t Len) __attribute__((weak));
+
+typedef struct {
+    uint8_t data[USB_TX_PACKET_SIZE];
+    uint32_t len;
+} usb_tx_buf_t;
+
+/* Buffers [tx_tail, tx_head) are sealed and wait for (or are in) transfer,
+ * tx_head is being filled. Indices run free. */
+static usb_tx_buf_t tx_bufs[USB_TX_NUM_BUFFERS];
+static volatile uint32_t tx_head = 0;
+static volatile uint32_t tx_tail = 0;
+static volatile bool tx_in_flight = false;
+static usb_tx_stats_t tx_stats;
+
+/* stdout line buffer: whatever still goes through printf reaches _write a line at a time */
+static char stdout_line[USB_TX_LINE_MAX];
+
+static inline uint32_t usb_tx_lock(void)
+{
+    uint32_t primask = __get_PRIMASK();
+    __disable_irq();
+    return primask;
+}
+
+static inline void usb_tx_unlock(uint32_t primask)
+{
+    __set_PRIMASK(primask);
+}
+
+void usb_tx_init(void)
+{
+    memset(tx_bufs, 0, sizeof(tx_bufs));
+    tx_head = 0;
+    tx_tail = 0;
+    tx_in_flight = false;
+    memset(&tx_stats, 0, sizeof(tx_stats));
+
+    /* Unbuffered, newlib hands _write a printf in pieces and concurrent tasks interleave
+     * them; protocol output uses usb_tx_printf()/usb_tx_write_line() instead */
+    setvbuf(stdout, stdout_line, _IOLBF, sizeof(stdout_line));
+}
+
+/* Start the oldest sealed buffer, or seal and start a partial one if nothing
+ * else is queued (so single lines go out without waiting for a full packet).
+ * Caller holds the lock. */
+static void usb_tx_kick_locked(void)
+{
+    if (tx_in_flight) return;
+
+    if (tx_head == tx_tail) {
+        if (tx_bufs[tx_head % USB_TX_NUM_BUFFERS].len == 0u) return;
+        tx_head++;
+        tx_bufs[tx_head % USB_TX_NUM_BUFFERS].len = 0;
+    }
+
+    usb_tx_buf_t *buf = &tx_bufs[tx_tail % USB_TX_NUM_BUFFERS];
+    if (!CDC_Transmit_FS) {
+        /* No USB stack linked in: discard so the queue keeps moving */
+        tx_stats.bytes_dropped += buf->len;
+        buf->len = 0;
+        tx_tail++;
+        return;
+    }
+
+    tx_in_flight = true;
+    if (CDC_Transmit_FS(buf->data, (uint16_t)buf->len) != USBD_OK_STATUS) {
+        tx_in_flight = false;
+        tx_stats.start_failures++;
+    }
+}
+
+/* Bytes that fit behind tx_head without sealing a buffer in use. Caller holds the lock. */
+static uint32_t usb_tx_free_locked(void)
+{
+    uint32_t free_bufs = USB_TX_NUM_BUFFERS - 1u - (tx_head - tx_tail);
+    return free_bufs * USB_TX_PACKET_SIZE + (USB_TX_PACKET_SIZE - tx_bufs[tx_head % USB_TX_NUM_BUFFERS].len);
+}
+
+/* Append bytes that are known to fit, sealing buffers as they fill. Caller holds the lock. */
+static void usb_tx_copy_locked(const uint8_t *data, uint32_t len)
+{
+    while (len > 0u) {
+        usb_tx_buf_t *buf = &tx_bufs[tx_head % USB_TX_NUM_BUFFERS];
+        uint32_t space = USB_TX_PACKET_SIZE - buf->len;
+
+        if (space == 0u) {
+            tx_head++;
+            tx_bufs[tx_head % USB_TX_NUM_BUFFERS].len = 0;
+            continue;
+        }
+        uint32_t n = (len < space) ? len : space;
+        memcpy(&buf->data[buf->len], data, n);
+        buf->len += n;
+        data += n;
+        len -= n;
+        tx_stats.bytes_queued += n;
+    }
+}
+
+/* Queue head and tail back to back, all or nothing, under one lock so no other
+ * writer lands in between. Bytes that do not fit are counted as dropped. */
+static bool usb_tx_write_parts(const uint8_t *head, uint32_t head_len, const uint8_t *tail, uint32_t tail_len)
+{
+    uint32_t primask = usb_tx_lock();
+    bool ok = (head_len + tail_len <= usb_tx_free_locked());
+
+    if (ok) {
+        usb_tx_copy_locked(head, head_len);
+        usb_tx_copy_locked(tail, tail_len);
+    } else {
+        tx_stats.bytes_dropped += head_len + tail_len;
+    }
+    usb_tx_kick_locked();
+    usb_tx_unlock(primask);
+    return ok;
+}
+
+/* Queue a whole packet or nothing, without blocking */
+bool usb_tx_write_all(const uint8_t *data, uint32_t len)
+{
+    return usb_tx_write_parts(data, len, NULL, 0u);
+}
+
+/* Queue "<line>\r\n" whole or not at all */
+bool usb_tx_write_line(const char *line)
+{
+    static const uint8_t crlf[2] = { '\r', '\n' };
+    return usb_tx_write_parts((const uint8_t *)line, (uint32_t)strlen(line), crlf, sizeof(crlf));
+}
+
+/* printf for protocol output: formats into one buffer (truncated to USB_TX_LINE_MAX - 1
+ * bytes) and queues it whole */
+bool usb_tx_printf(const char *fmt, ...)
+{
+    char line[USB_TX_LINE_MAX];
+    va_list ap;
+
+    va_start(ap, fmt);
+    int n = vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+    if (n < 0) return false;
+    if ((uint32_t)n >= sizeof(line)) n = (int)sizeof(line) - 1;
+    return usb_tx_write_all((const uint8_t *)line, (uint32_t)n);
+}
+
+/* Bytes that can be queued right now without dropping */
+uint32_t usb_tx_free(void)
+{
+    uint32_t primask = usb_tx_lock();
+    uint32_t free_bytes = usb_tx_free_locked();
+    usb_tx_unlock(primask);
+    return free_bytes;
+}
+
+/* Backpressure for bulk senders: wait (sleeping) until bytes fit */
+bool usb_tx_wait_free(uint32_t bytes, uint32_t timeout_ms)
+{
+    uint32_t start = HAL_GetTick();
+
+    while (usb_tx_free() < bytes) {
+        usb_tx_poll();
+        if ((HAL_GetTick() - start) >= timeout_ms) {
+            return false;
+        }
+        osDelay(1);
+    }
+    return true;
+}
+
+/* Retry a transfer start that failed because the endpoint was busy */
+void usb_tx_poll(void)
+{
+    uint32_t primask = usb_tx_lock();
+    usb_tx_kick_locked();
+    usb_tx_unlock(primask);
+}
+
+void usb_tx_get_stats(usb_tx_stats_t *stats)
+{
+    if (!stats) return;
+    uint32_t primask = usb_tx_lock();
+    *stats = tx_stats;
+    usb_tx_unlock(primask);
+}
+
+/* Transfer finished: release its buffer and start the next one */
+void usb_tx_complete_callback(void)
+{
+    uint32_t primask = usb_tx_lock();
+    if (tx_in_flight) {
+        usb_tx_buf_t *buf = &tx_bufs[tx_tail % USB_TX_NUM_BUFFERS];
+        tx_stats.bytes_sent += buf->len;
+        tx_stats.transfers++;
+        buf->len = 0;
+        tx_tail++;
+        tx_in_flight = false;
+    }
+    usb_tx_kick_locked();
+    usb_tx_unlock(primask);
+}
+
+/* newlib output hook: stdout/stderr go to the CDC queue */
+int _write(int file, char *ptr, int len)
+{
+    (void)file;
+    if (len <= 0) return 0;
+    usb_tx_write_all((const uint8_t *)ptr, (uint32_t)len);
+
+    /* Report everything as written: dropped bytes are counted, and a short
+     * count would make newlib retry in a busy loop */
+    return len;
+}
@@ -0,0 +1,48 @@
+#ifndef __AI_DECISION_H
+#define __AI_DECISION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "model_params.h"
+
+/* Per-channel decision stage between the per-window scores and what is reported:
+ *   1. class probabilities averaged in fixed point: avg += (p - avg) / 2^ema_shift
+ *   2. target = argmax of the averages, unless it is a fault below its threshold:
+ *      enter_pct to become the state, exit_pct (<= enter_pct) to stay it
+ *   3. the state changes once the target has held for enter_dwell_ms (to a fault) or
+ *      exit_dwell_ms (back to normal), measured on window timestamps
+ * Class 0 is normal. With ema_shift 0, no dwell and exit == enter this is the plain
+ * per-window thresholded argmax. A zeroed ai_decision_t starts normal. */
+#define AI_DECISION_Q           16u     /* averages: 1.0 = 1 << AI_DECISION_Q */
+#define AI_DECISION_MAX_SHIFT   7u
+
+typedef struct {
+    uint8_t  ema_shift;
+    uint8_t  enter_pct[MODEL_NUM_CLASSES];
+    uint8_t  exit_pct[MODEL_NUM_CLASSES];
+    uint32_t enter_dwell_ms;
+    uint32_t exit_dwell_ms;
+} ai_decision_params_t;
+
+typedef struct {
+    uint32_t avg[MODEL_NUM_CLASSES];    /* Q16 probabilities */
+    bool primed;                        /* avg holds at least one window */
+    uint8_t state;                      /* class reported */
+    uint8_t candidate;                  /* target the dwell is running for */
+    uint32_t candidate_ts;              /* first window that pointed at candidate */
+} ai_decision_t;
+
+/* A state change */
+typedef struct {
+    uint8_t from;
+    uint8_t to;
+    uint8_t confidence_pct;             /* averaged probability of `to` */
+    uint32_t onset_ts;                  /* first window that pointed at `to` */
+} ai_decision_event_t;
+
+/* Function prototypes */
+bool ai_decision_update(ai_decision_t *d, const ai_decision_params_t *p, const uint16_t prob_q8[MODEL_NUM_CLASSES],
+                        uint32_t ts, ai_decision_event_t *ev);
+uint8_t ai_decision_pct(const ai_decision_t *d, uint32_t cls);
+
+#endif /* __AI_DECISION_H */
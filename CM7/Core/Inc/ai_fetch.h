@@ -0,0 +1,30 @@
+#ifndef __AI_FETCH_H
+#define __AI_FETCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ai_engine.h"
+
+#if MODEL_ENGINE_SUPPORTED
+
+/* MDMA weight fetcher for the open engine (ai_engine_fetch_t): copies the next layer's
+ * weights from slow memory (memory-mapped QSPI) into two DTCM staging buffers while the
+ * current layer runs. Polled, channel AI_FETCH_MDMA_CHANNEL, software request. */
+#define AI_FETCH_MDMA_CHANNEL   MDMA_Channel0
+
+/* Time the engine spent waiting for a copy */
+typedef struct {
+    uint32_t copies;
+    uint32_t bytes;
+    uint32_t stall_cycles;
+    uint32_t errors;            /* copies that failed or timed out (that run dropped) */
+} ai_fetch_stats_t;
+
+/* Function prototypes */
+bool ai_fetch_init(void);
+const ai_engine_fetch_t *ai_fetch_engine(void);
+void ai_fetch_get_stats(ai_fetch_stats_t *stats);
+
+#endif /* MODEL_ENGINE_SUPPORTED */
+
+#endif /* __AI_FETCH_H */
@@ -3,10 +3,138 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "ai_preproc.h"
+#include "shared_mem.h"
 
-void AI_Init(void);
+/* Where the network buffers live (build options, e.g. -DAI_WEIGHTS_PLACEMENT=AI_PLACE_AXI):
+ *   AI_PLACE_FLASH  weights read in place from flash (ART + D-cache), activations not allowed
+ *   AI_PLACE_AXI    AXI SRAM (RAM_D1, D-cached); weights copied from flash by AI_Init()
+ *   AI_PLACE_DTCM   zero-wait-state DTCM (.dtcm_ai); weights copied from flash by AI_Init()
+ *   AI_PLACE_QSPI   weights only: a model bundle programmed in the external QSPI flash at
+ *                   AI_QSPI_BUNDLE_ADDR, checked by AI_Init() and read memory-mapped. The
+ *                   runtime reads it through the D-cache; the open engine (AI_STREAMING)
+ *                   copies each layer into DTCM with MDMA while the previous one runs. */
+#define AI_PLACE_FLASH  SHARED_AI_PLACE_FLASH
+#define AI_PLACE_AXI    SHARED_AI_PLACE_AXI
+#define AI_PLACE_DTCM   SHARED_AI_PLACE_DTCM
+#define AI_PLACE_QSPI   SHARED_AI_PLACE_QSPI
+
+#ifndef AI_ACTIVATIONS_PLACEMENT
+#define AI_ACTIVATIONS_PLACEMENT  AI_PLACE_DTCM
+#endif
+/* The float32 weights (about 160 KB) do not fit the 128 KB DTCM */
+#define AI_WEIGHTS_DTCM_FITS      (MODEL_PRECISION != MODEL_PRECISION_FLOAT32)
+#ifndef AI_WEIGHTS_PLACEMENT
+#if AI_WEIGHTS_DTCM_FITS
+#define AI_WEIGHTS_PLACEMENT      AI_PLACE_DTCM
+#else
+#define AI_WEIGHTS_PLACEMENT      AI_PLACE_AXI
+#endif
+#endif
+
+/* 1: time ai_motor_anomalie_run() for every placement at boot and publish it for GET BENCH */
+#ifndef AI_PLACEMENT_BENCH
+#define AI_PLACEMENT_BENCH        0
+#endif
+#define AI_PLACEMENT_BENCH_RUNS   100u
+
+/* Bundle read by AI_PLACE_QSPI (python_ai_pipeline/model_bundle.py build, then programmed
+ * with the W25Q256JV external loader): the QSPI linker region of the CM7 scripts */
+#define AI_QSPI_BUNDLE_ADDR       0x90000000u
+#define AI_QSPI_BUNDLE_SIZE       (32u * 1024u * 1024u)
+
+/* 1: time every c-layer through the runtime observer and publish min/avg/max for GET PROFILE
+ * (the callbacks add a little to the GET PERF inference time) */
+#ifndef AI_PROFILING
+#define AI_PROFILING              0
+#endif
+
+/* 1: run the open int8 engine (ai_engine.c) instead of ai_motor_anomalie_run(), reusing
+ * the conv columns a window shares with the previous one (bit-identical scores; pays
+ * off for even hops, most at multiples of 4 frames) */
+#ifndef AI_STREAMING
+#define AI_STREAMING              0
+#endif
+
+/* 1: at boot, run ai_motor_anomalie_run() and the open engine on the same synthetic
+ * windows, compare their scores and publish the cycles of both for GET ENGINE */
+#ifndef AI_ENGINE_BENCH
+#define AI_ENGINE_BENCH           0
+#endif
+#define AI_ENGINE_BENCH_WINDOWS   64u
+#define AI_ENGINE_BENCH_HOP       4u
+
+/* Input channels (motors) AiTask serves, routed by SHARED_FRAME_CHANNEL() of each frame.
+ * Every channel keeps its own window, normalization, hop (SET HOP <frames> <channel>),
+ * energy-gate state and last decision; they share the network and its arena. */
+#ifndef AI_CHANNELS
+#define AI_CHANNELS               1u
+#endif
+_Static_assert(AI_CHANNELS >= 1u && AI_CHANNELS <= SHARED_AI_MAX_CHANNELS, "AI_CHANNELS out of range");
+
+/* Order in which the channels with a complete window are served on each pass:
+ *   SHARED_AI_SCHED_ROUND_ROBIN  rotating start, so no channel always goes last
+ *   SHARED_AI_SCHED_DEADLINE     earliest deadline first; a window is due when the
+ *                                channel's next one would be complete */
+#ifndef AI_SCHED_POLICY
+#define AI_SCHED_POLICY           SHARED_AI_SCHED_ROUND_ROBIN
+#endif
+
+/* 1: on every scheduler pass CM7 serves the most urgent complete window itself and hands
+ * the others, while a slot is free, to CM4 (ai_offload.h), which runs the preprocessing
+ * and the open engine on a full window. Scores are the same whichever core ran them.
+ * Off by default for a network the engine does not implement (int16x8, float32). */
+#ifndef AI_OFFLOAD
+#define AI_OFFLOAD                (AI_CHANNELS > 1u && MODEL_ENGINE_SUPPORTED)
+#endif
+
+/* 1: at boot, run AI_OFFLOAD_BENCH_WINDOWS synthetic windows on CM7 alone, then on both
+ * cores, and publish windows per second for GET OFFLOAD */
+#ifndef AI_OFFLOAD_BENCH
+#define AI_OFFLOAD_BENCH          0
+#endif
+#define AI_OFFLOAD_BENCH_WINDOWS  64u
+#define AI_OFFLOAD_BENCH_WAIT_MS  2000u   /* for CM4 to sync its side after boot */
+
+/* 1: load model bundles (model_bundle.h) staged by CM4 over USB or flashed at
+ * AI_MODEL_FLASH_ADDR, between two inferences. Their weights alternate between two
+ * AXI SRAM slots, so the slot the network reads is never the one being written.
+ * Bundles hold int8 weights: on by default for MODEL_PRECISION_INT8 only. */
+#ifndef AI_MODEL_HOTSWAP
+#define AI_MODEL_HOTSWAP          (MODEL_PRECISION == MODEL_PRECISION_INT8)
+#endif
+#define AI_MODEL_FLASH_ADDR       0x080E0000u   /* MODEL_BUNDLE region of the CM7 linker scripts */
+#define AI_MODEL_FLASH_SIZE       (128u * 1024u)
+
+/* Scores of AI_GetOutput() and shared_ai_result_t: int8 softmax, prob = (q - AI_SCORE_ZERO_POINT)
+ * * AI_SCORE_SCALE. The int8 network outputs them as they are; the int16x8 and float32
+ * outputs are requantized onto the same grid. */
+#if MODEL_PRECISION == MODEL_PRECISION_INT8
+#define AI_SCORE_SCALE            MODEL_OUT_SCALE
+#define AI_SCORE_ZERO_POINT       MODEL_OUT_ZERO_POINT
+#else
+#define AI_SCORE_SCALE            (1.0f / 256.0f)
+#define AI_SCORE_ZERO_POINT       (-128)
+#endif
+
+bool AI_Init(void);
 void AI_DeInit(void);
-bool AI_RunOnce(const int8_t *input_s8_60x3, int8_t *out_s8_4);
+ai_input_t *AI_GetInput(void);      /* 60x3 of the MODEL_PRECISION input type, valid after AI_Init() */
+const int8_t *AI_GetOutput(void);   /* 4 int8 scores (AI_SCORE_*), valid after AI_RunOnce() */
+bool AI_RunOnce(void);
+bool AI_SetChannelPreproc(uint32_t channel, const float mean[3], const float std[3]);
+#if AI_STREAMING
+bool AI_RunStreaming(uint32_t channel, uint32_t shift);
+#endif
+#if AI_PLACEMENT_BENCH
+bool AI_BenchPlacements(uint32_t runs);
+#endif
+#if AI_ENGINE_BENCH
+bool AI_BenchEngine(uint32_t windows);
+#endif
+#if AI_OFFLOAD_BENCH
+bool AI_BenchOffload(uint32_t windows);
+#endif
 void AiTask(void *argument);
 
 #endif /* __AI_INFER_H */
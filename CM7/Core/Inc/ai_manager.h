@@ -0,0 +1,68 @@
+#ifndef __AI_MANAGER_H
+#define __AI_MANAGER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ai_networks.h"
+
+/* Inference manager: every network in AI_NETWORK_LIST, one activation arena.
+ *
+ * X-CUBE-AI networks keep no state in their activations between runs, and with
+ * allocate-inputs/outputs their I/O tensors live there too. So the networks share one
+ * arena of the largest activations size, and a network owns it from ai_mgr_acquire()
+ * (before writing its input) to ai_mgr_release() (after reading its output). Waiting
+ * networks are granted the arena by priority. Each network has one client task. */
+#define AI_NET_ENUM_(name_, NAME_, prio_, sig_)  AI_NET_##NAME_,
+typedef enum {
+    AI_NETWORK_LIST(AI_NET_ENUM_)
+    AI_NET_COUNT
+} ai_net_id_t;
+
+#define AI_NET_ARENA_SIZE_(name_, NAME_, prio_, sig_)  uint8_t name_[AI_##NAME_##_DATA_ACTIVATIONS_SIZE];
+typedef union {
+    AI_NETWORK_LIST(AI_NET_ARENA_SIZE_)
+} ai_mgr_arena_sizes_t;
+#define AI_MGR_ARENA_SIZE  sizeof(ai_mgr_arena_sizes_t)
+
+/* Registry entry, built from the generated API by AI_NETWORK_LIST */
+typedef struct {
+    const char *name;
+    ai_error (*create_and_init)(ai_handle *network, const ai_handle activations[], const ai_handle weights[]);
+    ai_buffer *(*inputs_get)(ai_handle network, ai_u16 *n_buffer);
+    ai_buffer *(*outputs_get)(ai_handle network, ai_u16 *n_buffer);
+    ai_i32 (*run)(ai_handle network, const ai_buffer *input, ai_buffer *output);
+    ai_handle (*destroy)(ai_handle network);
+    ai_bool (*get_report)(ai_handle network, ai_network_report *report);
+    const void *weights;            /* generated flash array */
+    uint32_t activations_size;
+    uint32_t in_size;               /* elements of input 1 / output 1 */
+    uint32_t out_size;
+    uint8_t priority;
+    const char *signature;
+} ai_net_desc_t;
+
+/* An open network: its I/O tensors and their int quantization (from the runtime) */
+typedef struct {
+    ai_handle handle;
+    ai_buffer *input;
+    ai_buffer *output;
+    float in_scale;
+    int32_t in_zero_point;
+    float out_scale;
+    int32_t out_zero_point;
+    uint32_t runs;
+    uint32_t waits;                 /* acquisitions that had to wait for the arena */
+} ai_net_t;
+
+bool ai_mgr_init(void *arena, uint32_t size);
+bool ai_mgr_open(ai_net_id_t id, void *activations, const void *weights);
+void ai_mgr_close(ai_net_id_t id);
+const ai_net_desc_t *ai_mgr_desc(ai_net_id_t id);
+const ai_net_t *ai_mgr_net(ai_net_id_t id);
+bool ai_mgr_acquire(ai_net_id_t id, uint32_t timeout);
+void ai_mgr_release(ai_net_id_t id);
+bool ai_mgr_run(ai_net_id_t id);
+int8_t *ai_mgr_input(ai_net_id_t id);
+const int8_t *ai_mgr_output(ai_net_id_t id);
+
+#endif /* __AI_MANAGER_H */
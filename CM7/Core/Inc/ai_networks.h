@@ -0,0 +1,17 @@
+#ifndef __AI_NETWORKS_H
+#define __AI_NETWORKS_H
+
+#include "model_params.h"
+#include "motor_anomalie.h"
+#include "motor_anomalie_data.h"
+
+/* Generated networks linked into CM7, one X(name, NAME, priority, signature) each:
+ *   name, NAME  prefix of the X-CUBE-AI API (ai_<name>_run) and macros (AI_<NAME>_IN_1_SIZE)
+ *   priority    higher is granted the activation arena first when several networks wait
+ *   signature   expected model signature without "0x", NULL to skip the check
+ * To add a network, generate it into X-CUBE-AI/App with its own name, include its
+ * <name>.h / <name>_data.h above and list it here; ai_manager.c needs no change. */
+#define AI_NETWORK_LIST(X) \
+    X(motor_anomalie, MOTOR_ANOMALIE, 2u, MODEL_PARAMS_HASH)
+
+#endif /* __AI_NETWORKS_H */
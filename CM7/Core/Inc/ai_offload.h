@@ -0,0 +1,33 @@
+#ifndef __AI_OFFLOAD_H
+#define __AI_OFFLOAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ai_preproc.h"
+#include "shared_mem.h"
+
+/* CM7 side of the inference offload (shared_offload_t): hands raw windows to CM4, which
+ * runs the same preprocessing and the open engine on a full window (CM4 ai_offload.c),
+ * and collects the scores. SHARED_OFFLOAD_SLOTS windows at most are with CM4. A job CM4
+ * has not finished after AI_OFFLOAD_TIMEOUT_MS comes back failed; its slot stays taken
+ * until CM4 does finish it. */
+#define AI_OFFLOAD_TIMEOUT_MS  250u
+
+/* A window CM4 finished (or gave up on) */
+typedef struct {
+    uint32_t channel;
+    uint32_t tag;                       /* as given to ai_offload_submit() */
+    uint32_t cycles;                    /* CM4 cycles for it */
+    bool ok;
+    int8_t scores[SHARED_AI_NUM_CLASSES];
+} ai_offload_result_t;
+
+/* Function prototypes */
+void ai_offload_init(void);
+uint32_t ai_offload_cm4_hz(void);
+bool ai_offload_submit(uint32_t channel, uint32_t tag, const void *weights, const ai_preproc_t *pp,
+                       const int16_t *const axis[AI_PREPROC_AXES], uint32_t frames);
+bool ai_offload_collect(ai_offload_result_t *out);
+uint32_t ai_offload_in_flight(void);
+
+#endif /* __AI_OFFLOAD_H */
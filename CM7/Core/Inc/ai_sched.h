@@ -0,0 +1,39 @@
+#ifndef __AI_SCHED_H
+#define __AI_SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "shared_layout.h"
+
+/* Which channel windows AiTask serves on a pass, and in what order. A channel is
+ * pending once its window is complete: full and at least `hop` frames newer than the
+ * one last served. Its deadline is the tick its next window will be complete; served
+ * after that, the channel falls behind. A channel with a window on CM4 is blocked: it
+ * keeps collecting frames but is not ordered until the result is back.
+ *   SHARED_AI_SCHED_ROUND_ROBIN  pending channels from a start that rotates every pass
+ *   SHARED_AI_SCHED_DEADLINE     earliest deadline first, ties in the rotating order
+ * No HAL or RTOS: ticks are passed in, so the host tests drive it directly. */
+typedef struct {
+    bool pending;               /* window complete, waiting to be served */
+    bool offloaded;             /* a window with CM4: the next one waits for its result */
+    uint32_t deadline;          /* tick the channel's next window is complete */
+} ai_sched_channel_t;
+
+typedef struct {
+    uint8_t policy;             /* SHARED_AI_SCHED_* */
+    uint32_t channels;
+    uint32_t rr_next;           /* first channel looked at on the next pass */
+    ai_sched_channel_t ch[SHARED_AI_MAX_CHANNELS];
+} ai_sched_t;
+
+/* Function prototypes */
+void ai_sched_init(ai_sched_t *s, uint8_t policy, uint32_t channels);
+void ai_sched_frames(ai_sched_t *s, uint32_t ch, bool full, uint32_t fresh, uint32_t hop, uint32_t now);
+uint32_t ai_sched_order(ai_sched_t *s, uint32_t order[SHARED_AI_MAX_CHANNELS]);
+bool ai_sched_late(const ai_sched_t *s, uint32_t ch, uint32_t now);
+void ai_sched_take(ai_sched_t *s, uint32_t ch);
+void ai_sched_retry(ai_sched_t *s, uint32_t ch);
+void ai_sched_offload(ai_sched_t *s, uint32_t ch);
+void ai_sched_done(ai_sched_t *s, uint32_t ch);
+
+#endif /* __AI_SCHED_H */
@@ -0,0 +1,61 @@
+#ifndef __MODEL_BUNDLE_H
+#define __MODEL_BUNDLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "shared_mem.h"
+
+/* Model bundle: a retrained model for the network already linked into CM7, loaded at
+ * run time instead of rebuilding and reflashing (python_ai_pipeline/model_bundle.py).
+ *
+ *   model_bundle_header_t   little endian, crc32 over the whole bundle with crc32 = 0
+ *   weights                 weights_size bytes in the X-CUBE-AI blob layout
+ *
+ * The network code keeps the quantization of every tensor, so the bundle's weights are
+ * quantized on the compiled network's grid (model_bundle.py requantizes them) and its
+ * I/O quantization must be the compiled one. The normalization stats and the labels
+ * are free: they are what a retrain on new data usually changes with the weights. */
+#define MODEL_BUNDLE_MAGIC          0x4E424D4Du  /* "MMBN" */
+#define MODEL_BUNDLE_VERSION        1u
+#define MODEL_BUNDLE_AXES           3u
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_size;           /* sizeof(model_bundle_header_t), weights follow */
+    uint32_t total_size;            /* header + weights */
+    uint32_t crc32;
+    char     model_hash[SHARED_MODEL_HASH_LEN];         /* md5 of the .tflite, hex */
+    char     network_signature[SHARED_MODEL_HASH_LEN];  /* X-CUBE-AI signature the weights fit */
+    uint32_t weights_size;
+    uint16_t window_frames;
+    uint8_t  num_axes;
+    uint8_t  num_classes;
+    float    mean[MODEL_BUNDLE_AXES];                   /* z-score normalization per axis */
+    float    std[MODEL_BUNDLE_AXES];
+    float    in_scale;
+    int32_t  in_zero_point;
+    float    out_scale;
+    int32_t  out_zero_point;
+    char     labels[SHARED_AI_NUM_CLASSES][SHARED_MODEL_LABEL_LEN];
+} model_bundle_header_t;
+
+/* What a bundle must match to run on the linked network */
+typedef struct {
+    const char *network_signature;  /* without "0x" */
+    uint32_t weights_size;
+    uint16_t window_frames;
+    uint8_t  num_axes;
+    uint8_t  num_classes;
+    float    in_scale;
+    int32_t  in_zero_point;
+    float    out_scale;
+    int32_t  out_zero_point;
+} model_bundle_target_t;
+
+/* Function prototypes */
+uint32_t model_bundle_crc32(uint32_t crc, const uint8_t *data, uint32_t len);
+uint8_t model_bundle_check(const void *bundle, uint32_t size, const model_bundle_target_t *target);
+const uint8_t *model_bundle_weights(const void *bundle);
+
+#endif /* __MODEL_BUNDLE_H */
@@ -0,0 +1,36 @@
+#ifndef __QSPI_FLASH_H
+#define __QSPI_FLASH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* W25Q256JV (32 MB quad SPI NOR) on QUADSPI bank 1, read memory-mapped at
+ * QSPI_FLASH_BASE through the CM7 cache. CM7 owns the peripheral; the flash is
+ * programmed from outside (STM32CubeProgrammer with the W25Q256JV external loader). */
+#define QSPI_FLASH_BASE         0x90000000u
+#define QSPI_FLASH_SIZE         (32u * 1024u * 1024u)
+#define QSPI_FLASH_PRESCALER    2u      /* QUADSPI kernel clock (HCLK3, 240 MHz) / 3 = 80 MHz */
+#define QSPI_FLASH_MPU_REGION   MPU_REGION_NUMBER1  /* above the MPU_Config() background region */
+
+/* Pins (board wiring), all at very high speed */
+#define QSPI_FLASH_CLK_PORT     GPIOB
+#define QSPI_FLASH_CLK_PIN      GPIO_PIN_2
+#define QSPI_FLASH_CLK_AF       GPIO_AF9_QUADSPI
+#define QSPI_FLASH_NCS_PORT     GPIOB
+#define QSPI_FLASH_NCS_PIN      GPIO_PIN_6
+#define QSPI_FLASH_NCS_AF       GPIO_AF10_QUADSPI
+#define QSPI_FLASH_IO0_PORT     GPIOD
+#define QSPI_FLASH_IO0_PIN      GPIO_PIN_11
+#define QSPI_FLASH_IO1_PORT     GPIOD
+#define QSPI_FLASH_IO1_PIN      GPIO_PIN_12
+#define QSPI_FLASH_IO2_PORT     GPIOE
+#define QSPI_FLASH_IO2_PIN      GPIO_PIN_2
+#define QSPI_FLASH_IO3_PORT     GPIOD
+#define QSPI_FLASH_IO3_PIN      GPIO_PIN_13
+#define QSPI_FLASH_IO_AF        GPIO_AF9_QUADSPI
+
+/* Function prototypes */
+bool qspi_flash_init(void);
+bool qspi_flash_mapped(void);
+
+#endif /* __QSPI_FLASH_H */
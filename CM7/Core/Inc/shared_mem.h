@@ -4,24 +4,55 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "stm32h745xx.h"
+#include "shared_layout.h"   /* types and the shared_d2 block, same header as CM4 */
 
-#define SHARED_FRAMES_COUNT 256u
-
-typedef struct {
-    int16_t x;
-    int16_t y;
-    int16_t z;
-    uint32_t ts;
-} sensor_frame_t;
-
-typedef struct {
-    volatile uint32_t head;
-    volatile uint32_t tail;
-    sensor_frame_t frames[SHARED_FRAMES_COUNT];
-} shared_ring_t;
+/* Frames waiting in the ring */
+static inline uint32_t shared_ring_count_cm7(void)
+{
+    uint32_t head = shared_ring.head;
+    uint32_t tail = shared_ring.tail;
+    return (head + SHARED_FRAMES_COUNT - tail) % SHARED_FRAMES_COUNT;
+}
 
-/* Instance is defined by CM4 in .shared_ram, we just extern it here */
-extern volatile shared_ring_t shared_ring;
+/* Read the CM4 tuning into *cfg; leaves *cfg untouched if none is published or CM4 is mid-write */
+static inline bool shared_read_ai_config(shared_ai_config_t *cfg)
+{
+    uint32_t seq = shared_ai_config.seq;
+    if (seq == 0u || (seq & 1u)) return false;
+    __DMB();
+    uint16_t hop = shared_ai_config.hop_frames;
+    uint16_t period = shared_ai_config.period_ms;
+    uint8_t thresh = shared_ai_config.fault_thresh_pct;
+    uint16_t channel_hop[SHARED_AI_MAX_CHANNELS];
+    for (uint32_t i = 0; i < SHARED_AI_MAX_CHANNELS; i++) {
+        channel_hop[i] = shared_ai_config.channel_hop[i];
+    }
+    uint8_t ema_shift = shared_ai_config.ema_shift;
+    uint8_t enter_pct[SHARED_AI_NUM_CLASSES], exit_pct[SHARED_AI_NUM_CLASSES];
+    for (uint32_t i = 0; i < SHARED_AI_NUM_CLASSES; i++) {
+        enter_pct[i] = shared_ai_config.enter_pct[i];
+        exit_pct[i] = shared_ai_config.exit_pct[i];
+    }
+    uint16_t enter_dwell = shared_ai_config.enter_dwell_ms;
+    uint16_t exit_dwell = shared_ai_config.exit_dwell_ms;
+    __DMB();
+    if (shared_ai_config.seq != seq) return false;
+    cfg->seq = seq;
+    cfg->hop_frames = hop;
+    cfg->period_ms = period;
+    cfg->fault_thresh_pct = thresh;
+    for (uint32_t i = 0; i < SHARED_AI_MAX_CHANNELS; i++) {
+        cfg->channel_hop[i] = channel_hop[i];
+    }
+    cfg->ema_shift = ema_shift;
+    for (uint32_t i = 0; i < SHARED_AI_NUM_CLASSES; i++) {
+        cfg->enter_pct[i] = enter_pct[i];
+        cfg->exit_pct[i] = exit_pct[i];
+    }
+    cfg->enter_dwell_ms = enter_dwell;
+    cfg->exit_dwell_ms = exit_dwell;
+    return true;
+}
 
 static inline bool shared_pop_frame_cm7(sensor_frame_t *out)
 {
@@ -35,6 +66,192 @@ static inline bool shared_pop_frame_cm7(sensor_frame_t *out)
     return true;
 }
 
-#endif /* __SHARED_MEM_CM7_H */
+/* Publish a channel's inference result to CM4 (seq odd while writing) */
+static inline void shared_publish_ai_result(uint32_t channel, uint8_t class_id, uint8_t state, const int8_t *scores,
+                                            uint32_t window_end_ts)
+{
+    if (channel >= SHARED_AI_MAX_CHANNELS) return;
+    volatile shared_ai_result_t *r = &shared_ai_result[channel];
+    uint32_t seq = r->seq;
+    r->seq = seq + 1u;
+    __DMB();
+    r->window_end_ts = window_end_ts;
+    r->class_id = class_id;
+    r->channel = (uint8_t)channel;
+    for (uint32_t i = 0; i < SHARED_AI_NUM_CLASSES; i++) {
+        r->scores[i] = scores[i];
+    }
+    r->state = state;
+    __DMB();
+    r->seq = seq + 2u;
+    __DSB();
+}
 
+/* Publish inference timing to CM4 (seq odd while writing) */
+static inline void shared_publish_ai_perf(uint32_t infer_count, uint32_t last_us, uint32_t max_us, uint32_t avg_us,
+                                          uint32_t gated_count)
+{
+    uint32_t seq = shared_ai_perf.seq;
+    shared_ai_perf.seq = seq + 1u;
+    __DMB();
+    shared_ai_perf.infer_count = infer_count;
+    shared_ai_perf.last_us = last_us;
+    shared_ai_perf.max_us = max_us;
+    shared_ai_perf.avg_us = avg_us;
+    shared_ai_perf.gated_count = gated_count;
+    __DMB();
+    shared_ai_perf.seq = seq + 2u;
+    __DSB();
+}
 
+/* Publish the placement benchmark to CM4 (seq odd while writing) */
+static inline void shared_publish_ai_bench(const shared_ai_bench_entry_t *entry, uint32_t count, uint32_t core_hz)
+{
+    if (count > SHARED_AI_BENCH_MAX) count = SHARED_AI_BENCH_MAX;
+    uint32_t seq = shared_ai_bench.seq;
+    shared_ai_bench.seq = seq + 1u;
+    __DMB();
+    shared_ai_bench.core_hz = core_hz;
+    shared_ai_bench.count = count;
+    for (uint32_t i = 0; i < count; i++) {
+        shared_ai_bench.entry[i].acts_place = entry[i].acts_place;
+        shared_ai_bench.entry[i].weights_place = entry[i].weights_place;
+        shared_ai_bench.entry[i].runs = entry[i].runs;
+        shared_ai_bench.entry[i].min_cycles = entry[i].min_cycles;
+        shared_ai_bench.entry[i].avg_cycles = entry[i].avg_cycles;
+        shared_ai_bench.entry[i].max_cycles = entry[i].max_cycles;
+    }
+    __DMB();
+    shared_ai_bench.seq = seq + 2u;
+    __DSB();
+}
+
+/* Publish the per-layer profile to CM4 (seq odd while writing) */
+static inline void shared_publish_ai_profile(const shared_ai_layer_prof_t *layer, uint32_t count,
+                                             uint32_t runs, uint32_t core_hz)
+{
+    if (count > SHARED_AI_PROFILE_MAX_LAYERS) count = SHARED_AI_PROFILE_MAX_LAYERS;
+    uint32_t seq = shared_ai_profile.seq;
+    shared_ai_profile.seq = seq + 1u;
+    __DMB();
+    shared_ai_profile.core_hz = core_hz;
+    shared_ai_profile.runs = runs;
+    shared_ai_profile.count = count;
+    for (uint32_t i = 0; i < count; i++) {
+        shared_ai_profile.layer[i].c_id = layer[i].c_id;
+        shared_ai_profile.layer[i].m_id = layer[i].m_id;
+        shared_ai_profile.layer[i].type = layer[i].type;
+        shared_ai_profile.layer[i].min_cycles = layer[i].min_cycles;
+        shared_ai_profile.layer[i].avg_cycles = layer[i].avg_cycles;
+        shared_ai_profile.layer[i].max_cycles = layer[i].max_cycles;
+    }
+    __DMB();
+    shared_ai_profile.seq = seq + 2u;
+    __DSB();
+}
+
+/* Publish the engine benchmark to CM4 (seq odd while writing) */
+static inline void shared_publish_ai_engine_bench(const shared_ai_engine_bench_t *b)
+{
+    uint32_t seq = shared_ai_engine_bench.seq;
+    shared_ai_engine_bench.seq = seq + 1u;
+    __DMB();
+    shared_ai_engine_bench.core_hz = b->core_hz;
+    shared_ai_engine_bench.windows = b->windows;
+    shared_ai_engine_bench.hop = b->hop;
+    shared_ai_engine_bench.mismatches = b->mismatches;
+    shared_ai_engine_bench.max_diff = b->max_diff;
+    shared_ai_engine_bench.runtime = b->runtime;
+    shared_ai_engine_bench.engine = b->engine;
+    shared_ai_engine_bench.streaming = b->streaming;
+    shared_ai_engine_bench.stall = b->stall;
+    __DMB();
+    shared_ai_engine_bench.seq = seq + 2u;
+    __DSB();
+}
+
+/* Publish the scheduler counters to CM4 (seq odd while writing) */
+static inline void shared_publish_ai_sched(const shared_ai_sched_t *s)
+{
+    uint32_t seq = shared_ai_sched.seq;
+    shared_ai_sched.seq = seq + 1u;
+    __DMB();
+    shared_ai_sched.policy = s->policy;
+    shared_ai_sched.channels = s->channels;
+    shared_ai_sched.util_permille = s->util_permille;
+    shared_ai_sched.dropped_frames = s->dropped_frames;
+    shared_ai_sched.offloaded = s->offloaded;
+    shared_ai_sched.cm4_util_permille = s->cm4_util_permille;
+    for (uint32_t i = 0; i < SHARED_AI_MAX_CHANNELS; i++) {
+        shared_ai_sched.ch[i].windows = s->ch[i].windows;
+        shared_ai_sched.ch[i].gated = s->ch[i].gated;
+        shared_ai_sched.ch[i].late = s->ch[i].late;
+        shared_ai_sched.ch[i].hop = s->ch[i].hop;
+        shared_ai_sched.ch[i].wps_x100 = s->ch[i].wps_x100;
+        shared_ai_sched.ch[i].last_class = s->ch[i].last_class;
+        shared_ai_sched.ch[i].state = s->ch[i].state;
+    }
+    __DMB();
+    shared_ai_sched.seq = seq + 2u;
+    __DSB();
+}
+
+/* Publish the model in use and the outcome of the last request to CM4 (seq odd while writing) */
+static inline void shared_publish_model_status(const shared_model_status_t *m)
+{
+    uint32_t seq = shared_model_status.seq;
+    shared_model_status.seq = seq + 1u;
+    __DMB();
+    shared_model_status.request = m->request;
+    shared_model_status.status = m->status;
+    shared_model_status.slot = m->slot;
+    shared_model_status.swaps = m->swaps;
+    shared_model_status.swap_us = m->swap_us;
+    for (uint32_t i = 0; i <= SHARED_MODEL_HASH_LEN; i++) {
+        shared_model_status.hash[i] = m->hash[i];
+    }
+    for (uint32_t c = 0; c < SHARED_AI_NUM_CLASSES; c++) {
+        for (uint32_t i = 0; i < SHARED_MODEL_LABEL_LEN; i++) {
+            shared_model_status.labels[c][i] = m->labels[c][i];
+        }
+    }
+    __DMB();
+    shared_model_status.seq = seq + 2u;
+    __DSB();
+}
+
+/* Publish the one- vs two-core benchmark to CM4 (seq odd while writing) */
+static inline void shared_publish_ai_offload_bench(const shared_ai_offload_bench_t *b)
+{
+    uint32_t seq = shared_ai_offload_bench.seq;
+    shared_ai_offload_bench.seq = seq + 1u;
+    __DMB();
+    shared_ai_offload_bench.core_hz = b->core_hz;
+    shared_ai_offload_bench.windows = b->windows;
+    shared_ai_offload_bench.cm4_windows = b->cm4_windows;
+    shared_ai_offload_bench.mismatches = b->mismatches;
+    shared_ai_offload_bench.one_core_wps_x100 = b->one_core_wps_x100;
+    shared_ai_offload_bench.two_core_wps_x100 = b->two_core_wps_x100;
+    __DMB();
+    shared_ai_offload_bench.seq = seq + 2u;
+    __DSB();
+}
+
+/* Append a state change to the event ring: the slot first, then the count CM4 polls */
+static inline void shared_publish_ai_event(const shared_ai_event_t *ev)
+{
+    uint32_t count = shared_ai_events.count;
+    volatile shared_ai_event_t *e = &shared_ai_events.event[count % SHARED_AI_EVENTS];
+    e->event_id = count + 1u;
+    e->ts = ev->ts;
+    e->onset_ts = ev->onset_ts;
+    e->channel = ev->channel;
+    e->from_class = ev->from_class;
+    e->to_class = ev->to_class;
+    e->confidence_pct = ev->confidence_pct;
+    __DMB();
+    shared_ai_events.count = count + 1u;
+    __DSB();
+}
+
+#endif /* __SHARED_MEM_CM7_H */
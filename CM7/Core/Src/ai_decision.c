@@ -0,0 +1,58 @@
+#include "ai_decision.h"
+
+/* Averaged probability of a class in percent, rounded */
+uint8_t ai_decision_pct(const ai_decision_t *d, uint32_t cls)
+{
+    return (uint8_t)(((uint64_t)d->avg[cls] * 100u + (1u << (AI_DECISION_Q - 1u))) >> AI_DECISION_Q);
+}
+
+/* Class the averages point at: the most probable one, normal if that is a fault below its
+ * threshold (the exit threshold for the current state, the enter one otherwise) */
+static uint8_t ai_decision_target(const ai_decision_t *d, const ai_decision_params_t *p)
+{
+    uint32_t best = 0;
+    for (uint32_t k = 1; k < MODEL_NUM_CLASSES; k++) {
+        if (d->avg[k] > d->avg[best]) best = k;
+    }
+    if (best == 0u) return 0u;
+
+    uint32_t pct = (best == d->state) ? p->exit_pct[best] : p->enter_pct[best];
+    return ((uint64_t)d->avg[best] * 100u < ((uint64_t)pct << AI_DECISION_Q)) ? 0u : (uint8_t)best;
+}
+
+/* Fold one window's probabilities (Q8, 256 = 1.0) ending at `ts` into the channel's state.
+ * True if the state changed, with the change in *ev. */
+bool ai_decision_update(ai_decision_t *d, const ai_decision_params_t *p, const uint16_t prob_q8[MODEL_NUM_CLASSES],
+                        uint32_t ts, ai_decision_event_t *ev)
+{
+    uint32_t shift = (p->ema_shift > AI_DECISION_MAX_SHIFT) ? AI_DECISION_MAX_SHIFT : p->ema_shift;
+
+    for (uint32_t k = 0; k < MODEL_NUM_CLASSES; k++) {
+        int32_t x = (int32_t)prob_q8[k] << (AI_DECISION_Q - 8u);
+        if (!d->primed) {
+            d->avg[k] = (uint32_t)x;
+        } else {
+            d->avg[k] = (uint32_t)((int32_t)d->avg[k] + ((x - (int32_t)d->avg[k]) >> shift));
+        }
+    }
+    d->primed = true;
+
+    uint8_t target = ai_decision_target(d, p);
+    if (target == d->state) {
+        d->candidate = d->state;
+        return false;
+    }
+    if (target != d->candidate) {
+        d->candidate = target;
+        d->candidate_ts = ts;
+    }
+    uint32_t dwell = (target != 0u) ? p->enter_dwell_ms : p->exit_dwell_ms;
+    if (ts - d->candidate_ts < dwell) return false;
+
+    ev->from = d->state;
+    ev->to = target;
+    ev->onset_ts = d->candidate_ts;
+    d->state = target;
+    ev->confidence_pct = ai_decision_pct(d, target);
+    return true;
+}
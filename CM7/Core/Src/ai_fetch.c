@@ -0,0 +1,89 @@
+#include "ai_fetch.h"
+#include "ai_infer.h"
+#include "stm32h7xx_hal.h"
+
+/* The staging buffers take DTCM: linked in only for builds running the engine on QSPI weights */
+#if MODEL_ENGINE_SUPPORTED && AI_WEIGHTS_PLACEMENT == AI_PLACE_QSPI && (AI_STREAMING || AI_ENGINE_BENCH)
+
+_Static_assert(AI_ENGINE_STAGE_BYTES <= 65536u, "an engine layer exceeds one MDMA block");
+
+#if defined(__GNUC__)
+#define AI_FETCH_DTCM_LINK __attribute__((section(".dtcm_ai"), aligned(32)))
+#else
+#define AI_FETCH_DTCM_LINK
+#endif
+
+#define AI_FETCH_TIMEOUT_MS  10u
+
+/* DTCM is not cached: what MDMA writes there is what the engine reads */
+AI_FETCH_DTCM_LINK static uint8_t s_stage[2][AI_ENGINE_STAGE_BYTES];
+static MDMA_HandleTypeDef s_mdma;
+static ai_fetch_stats_t s_stats;
+static bool s_busy;
+
+static bool ai_fetch_start(void *ctx, void *dst, const void *src, uint32_t len)
+{
+    (void)ctx;
+    if (HAL_MDMA_Start(&s_mdma, (uint32_t)(uintptr_t)src, (uint32_t)(uintptr_t)dst, len, 1u) != HAL_OK) {
+        s_stats.errors++;
+        return false;
+    }
+    s_busy = true;
+    s_stats.copies++;
+    s_stats.bytes += len;
+    return true;
+}
+
+static bool ai_fetch_wait(void *ctx)
+{
+    (void)ctx;
+    if (!s_busy) return true;
+    bool ok = true;
+    uint32_t t0 = DWT->CYCCNT;
+    if (HAL_MDMA_PollForTransfer(&s_mdma, HAL_MDMA_FULL_TRANSFER, AI_FETCH_TIMEOUT_MS) != HAL_OK) {
+        (void)HAL_MDMA_Abort(&s_mdma);
+        s_stats.errors++;
+        ok = false;
+    }
+    s_stats.stall_cycles += DWT->CYCCNT - t0;
+    s_busy = false;
+    return ok;
+}
+
+static const ai_engine_fetch_t s_fetch = {
+    ai_fetch_start, ai_fetch_wait, NULL, { s_stage[0], s_stage[1] },
+};
+
+/* Byte granularity on both sides: layer blocks start at any offset of the blob */
+bool ai_fetch_init(void)
+{
+    __HAL_RCC_MDMA_CLK_ENABLE();
+    s_mdma.Instance = AI_FETCH_MDMA_CHANNEL;
+    s_mdma.Init.Request = MDMA_REQUEST_SW;
+    s_mdma.Init.TransferTriggerMode = MDMA_BLOCK_TRANSFER;
+    s_mdma.Init.Priority = MDMA_PRIORITY_HIGH;
+    s_mdma.Init.Endianness = MDMA_LITTLE_ENDIANNESS_PRESERVE;
+    s_mdma.Init.SourceInc = MDMA_SRC_INC_BYTE;
+    s_mdma.Init.DestinationInc = MDMA_DEST_INC_BYTE;
+    s_mdma.Init.SourceDataSize = MDMA_SRC_DATASIZE_BYTE;
+    s_mdma.Init.DestDataSize = MDMA_DEST_DATASIZE_BYTE;
+    s_mdma.Init.DataAlignment = MDMA_DATAALIGN_PACKENABLE;
+    s_mdma.Init.BufferTransferLength = 128u;
+    s_mdma.Init.SourceBurst = MDMA_SOURCE_BURST_SINGLE;
+    s_mdma.Init.DestBurst = MDMA_DEST_BURST_SINGLE;
+    s_mdma.Init.SourceBlockAddressOffset = 0;
+    s_mdma.Init.DestBlockAddressOffset = 0;
+    return HAL_MDMA_Init(&s_mdma) == HAL_OK;
+}
+
+const ai_engine_fetch_t *ai_fetch_engine(void)
+{
+    return &s_fetch;
+}
+
+void ai_fetch_get_stats(ai_fetch_stats_t *stats)
+{
+    *stats = s_stats;
+}
+
+#endif /* AI_WEIGHTS_PLACEMENT == AI_PLACE_QSPI */
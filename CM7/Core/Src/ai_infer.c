@@ -1,62 +1,1118 @@
 #include "ai_infer.h"
-#include "motor_anomalie.h"
-#include "motor_anomalie_data.h"
+#include "ai_preproc.h"
+#include "ai_decision.h"
+#include "ai_sched.h"
+#if AI_STREAMING || AI_ENGINE_BENCH
+#include "ai_engine.h"
+#endif
+#include "ai_manager.h"
+#include "model_params.h"
+#if AI_MODEL_HOTSWAP || AI_WEIGHTS_PLACEMENT == AI_PLACE_QSPI
+#include "model_bundle.h"
+#endif
+#if AI_WEIGHTS_PLACEMENT == AI_PLACE_QSPI
+#include "qspi_flash.h"
+#if AI_STREAMING || AI_ENGINE_BENCH
+#include "ai_fetch.h"
+#endif
+#endif
+#if AI_OFFLOAD || AI_OFFLOAD_BENCH
+#include "ai_offload.h"
+#endif
+#if AI_PROFILING
+#include "ai_platform_interface.h"
+#endif
 #include "cmsis_os.h"
 #include "shared_mem.h"
 #include "stm32h7xx_hal.h"
 #include "stm32h7xx_hal_gpio.h"
+#include <math.h>
 #include <string.h>
 
-static ai_handle s_network = AI_HANDLE_NULL;
-static AI_ALIGNED(4) uint8_t s_activations[10000];
+/* The generated constants must describe the network they are linked with */
+_Static_assert(MODEL_WINDOW_FRAMES == AI_MOTOR_ANOMALIE_IN_1_HEIGHT, "model_params.h window length != network input");
+_Static_assert(MODEL_NUM_AXES == AI_MOTOR_ANOMALIE_IN_1_CHANNEL, "model_params.h axes != network input channels");
+_Static_assert(MODEL_NUM_AXES == AI_PREPROC_AXES, "model_params.h axes != preprocessing axes");
+_Static_assert(MODEL_NUM_CLASSES == AI_MOTOR_ANOMALIE_OUT_1_SIZE, "model_params.h classes != network output");
+_Static_assert(MODEL_NUM_CLASSES == SHARED_AI_NUM_CLASSES, "model_params.h classes != shared result scores");
+_Static_assert(SHARED_GATE_WINDOW_FRAMES >= MODEL_WINDOW_FRAMES, "CM4 energy gate must cover the whole window");
+_Static_assert(AI_MOTOR_ANOMALIE_IN_1_SIZE_BYTES == AI_MOTOR_ANOMALIE_IN_1_SIZE * sizeof(ai_input_t) &&
+               AI_MOTOR_ANOMALIE_OUT_1_SIZE_BYTES == AI_MOTOR_ANOMALIE_OUT_1_SIZE * sizeof(ai_input_t),
+               "network I/O type != MODEL_PRECISION (generate X-CUBE-AI/App from that variant's .tflite)");
 
-void AI_Init(void)
+#if (AI_STREAMING || AI_ENGINE_BENCH) && !MODEL_ENGINE_SUPPORTED
+#error "AI_STREAMING/AI_ENGINE_BENCH: model_params.h reports a topology ai_engine.c does not implement"
+#endif
+#if (AI_OFFLOAD || AI_OFFLOAD_BENCH) && !MODEL_ENGINE_SUPPORTED
+#error "AI_OFFLOAD/AI_OFFLOAD_BENCH: CM4 runs ai_engine.c, which does not implement this topology (build with AI_OFFLOAD=0)"
+#endif
+#if (AI_MODEL_HOTSWAP || AI_WEIGHTS_PLACEMENT == AI_PLACE_QSPI) && MODEL_PRECISION != MODEL_PRECISION_INT8
+#error "AI_MODEL_HOTSWAP/AI_PLACE_QSPI: model bundles hold int8 weights (MODEL_PRECISION_INT8 only)"
+#endif
+
+_Static_assert(AI_ACTIVATIONS_PLACEMENT == AI_PLACE_AXI || AI_ACTIVATIONS_PLACEMENT == AI_PLACE_DTCM,
+               "activations must be placed in AXI SRAM or DTCM");
+_Static_assert(AI_WEIGHTS_DTCM_FITS || AI_WEIGHTS_PLACEMENT != AI_PLACE_DTCM,
+               "the float32 weights do not fit DTCM: place them in flash or AXI SRAM");
+
+/* The classifier in the inference manager's registry (ai_networks.h) */
+#define AI_NET  AI_NET_MOTOR_ANOMALIE
+
+#if defined(__GNUC__)
+#define AI_DTCM_LINK __attribute__((section(".dtcm_ai"), aligned(32)))
+#define AI_AXI_LINK  __attribute__((section(".axi_weights"), aligned(32)))
+#else
+#define AI_DTCM_LINK
+#define AI_AXI_LINK
+#endif
+
+#define AI_WEIGHTS_WORDS (sizeof(s_motor_anomalie_weights_array_u64) / sizeof(s_motor_anomalie_weights_array_u64[0]))
+
+/* Only the configured placements are linked in, all of them for the benchmark */
+#define AI_PLACED(cfg_, place_) (AI_PLACEMENT_BENCH || (cfg_) == (place_))
+
+#if AI_PLACED(AI_ACTIVATIONS_PLACEMENT, AI_PLACE_AXI)
+static AI_ALIGNED(32) uint8_t s_activations_axi[AI_MGR_ARENA_SIZE];   /* .bss, RAM_D1 */
+#endif
+#if AI_PLACED(AI_ACTIVATIONS_PLACEMENT, AI_PLACE_DTCM)
+AI_DTCM_LINK static uint8_t s_activations_dtcm[AI_MGR_ARENA_SIZE];
+#endif
+#if AI_PLACED(AI_WEIGHTS_PLACEMENT, AI_PLACE_AXI)
+AI_AXI_LINK static uint64_t s_weights_axi[AI_WEIGHTS_WORDS];
+#endif
+#if AI_WEIGHTS_DTCM_FITS && AI_PLACED(AI_WEIGHTS_PLACEMENT, AI_PLACE_DTCM)
+AI_DTCM_LINK static uint64_t s_weights_dtcm[AI_WEIGHTS_WORDS];
+#endif
+#if AI_WEIGHTS_PLACEMENT == AI_PLACE_QSPI
+/* Weights of the QSPI bundle, once AI_Init() has checked it */
+static const void *s_weights_qspi;
+#endif
+#if AI_MODEL_HOTSWAP
+/* Hot-swapped weights, alternating so the network never reads the slot being filled */
+#define AI_MODEL_SLOTS  2u
+AI_AXI_LINK static uint64_t s_weights_slot[AI_MODEL_SLOTS][AI_WEIGHTS_WORDS];
+#endif
+/* Weights the network runs on */
+static const void *s_weights;
+
+#if AI_STREAMING || AI_ENGINE_BENCH
+/* Per-layer activations of each channel's previous window, next to the weights they read
+ * (the engine benchmark uses channel 0's) */
+#if AI_STREAMING
+#define AI_ENGINES  AI_CHANNELS
+#else
+#define AI_ENGINES  1u
+#endif
+AI_DTCM_LINK static ai_engine_t s_engine[AI_ENGINES];
+static uint32_t s_engine_last;      /* engine of the last AI_RunStreaming() */
+#endif
+
+static void *ai_activations_at(uint32_t place)
+{
+    switch (place) {
+#if AI_PLACED(AI_ACTIVATIONS_PLACEMENT, AI_PLACE_AXI)
+    case AI_PLACE_AXI:  return s_activations_axi;
+#endif
+#if AI_PLACED(AI_ACTIVATIONS_PLACEMENT, AI_PLACE_DTCM)
+    case AI_PLACE_DTCM: return s_activations_dtcm;
+#endif
+    default:            return NULL;
+    }
+}
+
+static const void *ai_weights_at(uint32_t place)
+{
+    switch (place) {
+    case AI_PLACE_FLASH: return s_motor_anomalie_weights_array_u64;
+#if AI_PLACED(AI_WEIGHTS_PLACEMENT, AI_PLACE_AXI)
+    case AI_PLACE_AXI:   return s_weights_axi;
+#endif
+#if AI_WEIGHTS_DTCM_FITS && AI_PLACED(AI_WEIGHTS_PLACEMENT, AI_PLACE_DTCM)
+    case AI_PLACE_DTCM:  return s_weights_dtcm;
+#endif
+#if AI_WEIGHTS_PLACEMENT == AI_PLACE_QSPI
+    case AI_PLACE_QSPI:  return s_weights_qspi;
+#endif
+    default:             return NULL;
+    }
+}
+
+/* Fill the RAM copies of the weights from the generated flash array */
+static void ai_weights_load(void)
+{
+#if AI_PLACED(AI_WEIGHTS_PLACEMENT, AI_PLACE_AXI)
+    memcpy(s_weights_axi, s_motor_anomalie_weights_array_u64, sizeof(s_weights_axi));
+#if AI_OFFLOAD || AI_OFFLOAD_BENCH
+    /* Out of the D-cache for CM4 */
+    SCB_CleanDCache_by_Addr((uint32_t *)s_weights_axi, sizeof(s_weights_axi));
+#endif
+#endif
+#if AI_WEIGHTS_DTCM_FITS && AI_PLACED(AI_WEIGHTS_PLACEMENT, AI_PLACE_DTCM)
+    memcpy(s_weights_dtcm, s_motor_anomalie_weights_array_u64, sizeof(s_weights_dtcm));
+#endif
+}
+
+#if AI_OFFLOAD || AI_OFFLOAD_BENCH
+/* s_weights at an address CM4 can read: DTCM is private to CM7, the flash array is not */
+static const void *ai_weights_cm4(void)
+{
+#if AI_WEIGHTS_DTCM_FITS && AI_PLACED(AI_WEIGHTS_PLACEMENT, AI_PLACE_DTCM)
+    if (s_weights == s_weights_dtcm) return s_motor_anomalie_weights_array_u64;
+#endif
+    return s_weights;
+}
+#endif
+
+/* Sliding window: the last AI_WINDOW_FRAMES frames, one circular history per axis.
+ * Consecutive windows overlap by (AI_WINDOW_FRAMES - hop) frames. Every sample is
+ * written twice (slot and slot + AI_WINDOW_FRAMES) so the window starting at head is
+ * always contiguous for the preprocessing kernel. */
+#define AI_WINDOW_FRAMES   AI_MOTOR_ANOMALIE_IN_1_HEIGHT
+
+typedef struct {
+    int16_t axis[AI_MOTOR_ANOMALIE_IN_1_CHANNEL][2 * AI_WINDOW_FRAMES];
+    uint32_t head;      /* next slot to write == oldest frame once full */
+    uint32_t filled;
+    uint32_t fresh;     /* frames pushed since the last inference */
+    uint32_t last_ts;
+    uint16_t last_flags;    /* SHARED_FRAME_* of the newest frame */
+} ai_window_t;
+
+static void ai_window_push(ai_window_t *w, const sensor_frame_t *f)
+{
+    w->axis[0][w->head] = w->axis[0][w->head + AI_WINDOW_FRAMES] = f->x;
+    w->axis[1][w->head] = w->axis[1][w->head + AI_WINDOW_FRAMES] = f->y;
+    w->axis[2][w->head] = w->axis[2][w->head + AI_WINDOW_FRAMES] = f->z;
+    w->head = (w->head + 1u) % AI_WINDOW_FRAMES;
+    if (w->filled < AI_WINDOW_FRAMES) w->filled++;
+    w->fresh++;
+    w->last_ts = f->ts;
+    w->last_flags = f->flags;
+}
+
+/* Normalize + quantize constants of the running model: folded at generation time (see
+ * ai_preproc.h), replaced by those of a hot-swapped bundle */
+static ai_preproc_t s_preproc = MODEL_PREPROC_INIT;
+
+/* One monitored motor: its window, input normalization and decision; when it is
+ * served is s_sched's (ai_sched.h) */
+typedef struct {
+    ai_window_t window;
+    ai_preproc_t preproc;
+    bool own_preproc;           /* set by AI_SetChannelPreproc(), else s_preproc */
+    uint32_t gated_frames;      /* frames advanced by gated windows since the last run */
+    int8_t last_scores[MODEL_NUM_CLASSES];
+    uint8_t last_class;         /* most probable class of the last window */
+    bool have_decision;
+    ai_decision_t decision;     /* averaged scores and reported state */
+    uint32_t windows;           /* inferences run */
+    uint32_t gated;             /* windows answered with the last decision */
+    uint32_t late;              /* inferences started after the deadline */
+    uint32_t period_start;      /* windows + gated at the start of the sched period */
+} ai_channel_t;
+
+static ai_channel_t s_channel[AI_CHANNELS];
+static ai_sched_t s_sched;
+
+/* Clear the stream state of a channel, keeping its normalization */
+static void ai_channel_reset(ai_channel_t *c)
+{
+    ai_preproc_t pp = c->own_preproc ? c->preproc : s_preproc;
+    bool own = c->own_preproc;
+
+    memset(c, 0, sizeof(*c));
+    c->preproc = pp;
+    c->own_preproc = own;
+}
+
+/* Effective hop of a channel: its SET HOP override, else the default */
+static uint32_t ai_channel_hop(const shared_ai_config_t *cfg, uint32_t ch)
+{
+    uint32_t hop = cfg->channel_hop[ch] ? cfg->channel_hop[ch] : cfg->hop_frames;
+    return (hop == 0u || hop > AI_WINDOW_FRAMES) ? AI_WINDOW_FRAMES : hop;
+}
+
+#if AI_PROFILING
+/* Per c-layer cycle counts: the runtime calls the observer before and after every node */
+typedef struct {
+    uint16_t m_id;
+    uint16_t type;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+} ai_layer_prof_t;
+
+static struct {
+    ai_layer_prof_t layer[SHARED_AI_PROFILE_MAX_LAYERS];
+    uint32_t count;
+    uint32_t runs;
+    uint32_t t0;
+} s_prof;
+
+static ai_u32 ai_profile_on_node(const ai_handle cookie, const ai_u32 flags, const ai_observer_node *node)
+{
+    uint32_t now = DWT->CYCCNT;
+    (void)cookie;
+
+    if (node->c_idx >= s_prof.count) return 0;
+    if (flags & AI_OBSERVER_PRE_EVT) {
+        s_prof.t0 = DWT->CYCCNT;   /* read last so the callback itself is not counted */
+    } else if (flags & AI_OBSERVER_POST_EVT) {
+        ai_layer_prof_t *l = &s_prof.layer[node->c_idx];
+        uint32_t dt = now - s_prof.t0;
+        l->total += dt;
+        if (dt < l->min) l->min = dt;
+        if (dt > l->max) l->max = dt;
+        if (node->c_idx + 1u == s_prof.count) s_prof.runs++;
+    }
+    return 0;
+}
+
+/* Reset the statistics and observe every c-layer of the freshly created network */
+static bool ai_profile_attach(void)
+{
+    memset(&s_prof, 0, sizeof(s_prof));
+    for (uint32_t i = 0; i < SHARED_AI_PROFILE_MAX_LAYERS; i++) {
+        ai_observer_node info = { .c_idx = (ai_u16)i };
+        if (!ai_platform_observer_node_info(ai_mgr_net(AI_NET)->handle, &info)) break;
+        s_prof.layer[i].m_id = info.id;
+        s_prof.layer[i].type = info.type;
+        s_prof.layer[i].min = UINT32_MAX;
+        s_prof.count++;
+    }
+    return s_prof.count > 0u &&
+           ai_platform_observer_register(ai_mgr_net(AI_NET)->handle, ai_profile_on_node, AI_HANDLE_NULL,
+                                         AI_OBSERVER_PRE_EVT | AI_OBSERVER_POST_EVT);
+}
+
+static void ai_profile_publish(void)
+{
+    shared_ai_layer_prof_t layer[SHARED_AI_PROFILE_MAX_LAYERS];
+
+    if (s_prof.runs == 0u) return;
+    for (uint32_t i = 0; i < s_prof.count; i++) {
+        layer[i].c_id = (uint16_t)i;
+        layer[i].m_id = s_prof.layer[i].m_id;
+        layer[i].type = s_prof.layer[i].type;
+        layer[i].rsvd = 0;
+        layer[i].min_cycles = s_prof.layer[i].min;
+        layer[i].avg_cycles = (uint32_t)(s_prof.layer[i].total / s_prof.runs);
+        layer[i].max_cycles = s_prof.layer[i].max;
+    }
+    shared_publish_ai_profile(layer, s_prof.count, s_prof.runs, SystemCoreClock);
+}
+#endif
+
+/* Open the classifier over the given activations (NULL: the manager's shared arena) */
+static bool ai_network_open(void *activations, const void *weights)
+{
+    /* The registry refuses a network not trained with the stats in model_params.h */
+    if (!weights || !ai_mgr_open(AI_NET, activations, weights)) return false;
+
+    const ai_net_t *net = ai_mgr_net(AI_NET);
+    if (net->in_zero_point != MODEL_IN_ZERO_POINT || net->out_zero_point != MODEL_OUT_ZERO_POINT) {
+        AI_DeInit();
+        return false;
+    }
+#if AI_PROFILING
+    if (!ai_profile_attach()) {
+        AI_DeInit();
+        return false;
+    }
+#endif
+    return true;
+}
+
+#if AI_STREAMING || AI_ENGINE_BENCH
+/* Point the engines at s_weights; QSPI weights are prefetched layer by layer into DTCM */
+static void ai_engines_init(void)
+{
+    for (uint32_t i = 0; i < AI_ENGINES; i++) {
+        ai_engine_init(&s_engine[i], s_weights);
+#if AI_WEIGHTS_PLACEMENT == AI_PLACE_QSPI
+        if (s_weights == s_weights_qspi) ai_engine_set_fetch(&s_engine[i], ai_fetch_engine());
+#endif
+    }
+}
+#endif
+
+#if AI_MODEL_HOTSWAP || AI_WEIGHTS_PLACEMENT == AI_PLACE_QSPI
+/* What a bundle must match: the linked network, with the quantization of the open runtime */
+static void ai_bundle_target(model_bundle_target_t *target)
+{
+    const ai_net_t *net = ai_mgr_net(AI_NET);
+
+    target->network_signature = MODEL_PARAMS_HASH;
+    target->weights_size = AI_MOTOR_ANOMALIE_DATA_WEIGHTS_SIZE;
+    target->window_frames = MODEL_WINDOW_FRAMES;
+    target->num_axes = MODEL_NUM_AXES;
+    target->num_classes = MODEL_NUM_CLASSES;
+    target->in_scale = net->in_scale;
+    target->in_zero_point = net->in_zero_point;
+    target->out_scale = net->out_scale;
+    target->out_zero_point = net->out_zero_point;
+}
+#endif
+
+#if AI_WEIGHTS_PLACEMENT == AI_PLACE_QSPI
+/* Map the QSPI flash and check the bundle programmed there against the network, opened
+ * on the internal flash array for its quantization. The bundle's normalization stats
+ * replace the generated ones, as a hot swap would. */
+static bool ai_qspi_weights_open(void)
+{
+    const void *bundle = (const void *)AI_QSPI_BUNDLE_ADDR;
+    model_bundle_target_t target;
+    model_bundle_header_t h;
+
+    if (!qspi_flash_init() || !ai_network_open(NULL, s_motor_anomalie_weights_array_u64)) return false;
+    ai_bundle_target(&target);
+    AI_DeInit();
+    if (model_bundle_check(bundle, AI_QSPI_BUNDLE_SIZE, &target) != SHARED_MODEL_OK) return false;
+    memcpy(&h, bundle, sizeof(h));
+    if (!ai_preproc_init(&s_preproc, h.mean, h.std, MODEL_IN_SCALE, MODEL_IN_ZERO_POINT)) return false;
+    for (uint32_t ch = 0; ch < AI_CHANNELS; ch++) {
+        if (!s_channel[ch].own_preproc) s_channel[ch].preproc = s_preproc;
+    }
+#if AI_STREAMING || AI_ENGINE_BENCH
+    if (!ai_fetch_init()) return false;
+#endif
+    s_weights_qspi = model_bundle_weights(bundle);
+    return true;
+}
+#endif
+
+bool AI_Init(void)
 {
-    const ai_handle acts[] = { s_activations };
-    const ai_handle wts[]  = { AI_HANDLE_NULL };
-    ai_error err = ai_motor_anomalie_create_and_init(&s_network, acts, wts);
-    (void)err;
+    ai_weights_load();
+    if (!ai_mgr_init(ai_activations_at(AI_ACTIVATIONS_PLACEMENT), AI_MGR_ARENA_SIZE)) return false;
+#if AI_WEIGHTS_PLACEMENT == AI_PLACE_QSPI
+    if (!ai_qspi_weights_open()) return false;
+#endif
+    s_weights = ai_weights_at(AI_WEIGHTS_PLACEMENT);
+    if (!ai_network_open(NULL, s_weights)) return false;
+#if AI_STREAMING || AI_ENGINE_BENCH
+    /* The runtime stays open for the signature check and the input tensor */
+    ai_engines_init();
+#endif
+#if AI_OFFLOAD || AI_OFFLOAD_BENCH
+    ai_offload_init();
+#endif
+    return true;
 }
 
 void AI_DeInit(void)
 {
-    if (s_network) {
-        ai_motor_anomalie_destroy(s_network);
-        s_network = AI_HANDLE_NULL;
+#if AI_PROFILING
+    if (ai_mgr_net(AI_NET)->handle) {
+        ai_platform_observer_unregister(ai_mgr_net(AI_NET)->handle, ai_profile_on_node, AI_HANDLE_NULL);
     }
+#endif
+    ai_mgr_close(AI_NET);
 }
 
-bool AI_RunOnce(const int8_t *input_s8_60x3, int8_t *out_s8_4)
+/* Input and output tensors live in the activations arena (allocate-inputs/outputs):
+ * valid while AiTask holds the arena */
+ai_input_t *AI_GetInput(void)
 {
-    if (!s_network || !input_s8_60x3 || !out_s8_4) return false;
+    return (ai_input_t *)ai_mgr_input(AI_NET);
+}
 
-    ai_i8 in_buffer_mem[180];
-    memcpy(in_buffer_mem, input_s8_60x3, 180);
+const int8_t *AI_GetOutput(void)
+{
+#if AI_STREAMING
+    return s_engine[s_engine_last].weights ? s_engine[s_engine_last].out : NULL;
+#elif MODEL_PRECISION == MODEL_PRECISION_INT8
+    return ai_mgr_output(AI_NET);
+#else
+    /* Requantize the int16 or float softmax onto the int8 score grid */
+    static int8_t scores[MODEL_NUM_CLASSES];
+    const void *out = ai_mgr_output(AI_NET);
+    if (!out) return NULL;
+    for (uint32_t k = 0; k < MODEL_NUM_CLASSES; k++) {
+#if MODEL_PRECISION == MODEL_PRECISION_FLOAT32
+        float p = ((const float *)out)[k];
+#else
+        float p = (float)((int32_t)((const int16_t *)out)[k] - MODEL_OUT_ZERO_POINT) * MODEL_OUT_SCALE;
+#endif
+        int32_t q = (int32_t)floorf(p / AI_SCORE_SCALE + 0.5f) + AI_SCORE_ZERO_POINT;
+        scores[k] = (int8_t)((q > 127) ? 127 : (q < -128) ? -128 : q);
+    }
+    return scores;
+#endif
+}
 
-    ai_buffer in = AI_BUFFER_INIT(
-        AI_FLAG_NONE, AI_MOTOR_ANOMALIE_IN_1_FORMAT,
-        AI_BUFFER_SHAPE_INIT(AI_SHAPE_BCWH, 4, 1, AI_MOTOR_ANOMALIE_IN_1_CHANNEL, 1, AI_MOTOR_ANOMALIE_IN_1_HEIGHT),
-        AI_MOTOR_ANOMALIE_IN_1_SIZE, NULL, in_buffer_mem);
+bool AI_RunOnce(void)
+{
+    return ai_mgr_run(AI_NET);
+}
 
-    ai_i8 out_buffer_mem[4];
-    ai_buffer out = AI_BUFFER_INIT(
-        AI_FLAG_NONE, AI_MOTOR_ANOMALIE_OUT_1_FORMAT,
-        AI_BUFFER_SHAPE_INIT(AI_SHAPE_BCWH, 4, 1, AI_MOTOR_ANOMALIE_OUT_1_CHANNEL, 1, 1),
-        AI_MOTOR_ANOMALIE_OUT_1_SIZE, NULL, out_buffer_mem);
+/* Normalization of one channel's sensor (its own mounting and gain), quantized with the
+ * network's input scale. Call before AiTask starts; false leaves the channel unchanged. */
+bool AI_SetChannelPreproc(uint32_t channel, const float mean[3], const float std[3])
+{
+    ai_preproc_t pp;
 
-    ai_i32 nbatch = ai_motor_anomalie_run(s_network, &in, &out);
-    if (nbatch != 1) {
+    if (channel >= AI_CHANNELS || !ai_preproc_init(&pp, mean, std, MODEL_IN_SCALE, MODEL_IN_ZERO_POINT)) {
         return false;
     }
-    memcpy(out_s8_4, out_buffer_mem, 4);
+    s_channel[channel].preproc = pp;
+    s_channel[channel].own_preproc = true;
+    return true;
+}
+
+#if AI_STREAMING
+/* Run the channel's engine on the input tensor; `shift` = frames its window advanced
+ * since the channel's previous call (>= AI_MOTOR_ANOMALIE_IN_1_HEIGHT for an unrelated window).
+ * False if the engine could not fetch its weights (ai_fetch.c). */
+bool AI_RunStreaming(uint32_t channel, uint32_t shift)
+{
+    if (channel >= AI_ENGINES || !ai_mgr_net(AI_NET)->handle || !s_engine[channel].weights) return false;
+    /* A failed weight copy drops the window: no decision on scores it did not produce */
+    if (!ai_engine_run(&s_engine[channel], AI_GetInput(), shift)) return false;
+    s_engine_last = channel;
     return true;
 }
+#endif
+
+#if AI_PLACEMENT_BENCH
+/* Time ai_motor_anomalie_run() for every activations x weights placement on the same
+ * zero-point window: one warm-up run, then `runs` timed runs with the scheduler locked.
+ * Publishes the cycles for GET BENCH and reopens the configured placement. Needs DWT. */
+bool AI_BenchPlacements(uint32_t runs)
+{
+    static const uint8_t acts_places[] = { AI_PLACE_AXI, AI_PLACE_DTCM };
+    static const uint8_t weights_places[] = {
+        AI_PLACE_FLASH, AI_PLACE_AXI,
+#if AI_WEIGHTS_DTCM_FITS
+        AI_PLACE_DTCM,
+#endif
+#if AI_WEIGHTS_PLACEMENT == AI_PLACE_QSPI
+        AI_PLACE_QSPI,
+#endif
+    };
+    shared_ai_bench_entry_t entry[SHARED_AI_BENCH_MAX];
+    uint32_t n = 0;
+
+    if (runs == 0u || runs > UINT16_MAX) runs = AI_PLACEMENT_BENCH_RUNS;
+
+    for (uint32_t a = 0; a < sizeof(acts_places); a++) {
+        for (uint32_t w = 0; w < sizeof(weights_places) && n < SHARED_AI_BENCH_MAX; w++) {
+            AI_DeInit();
+            if (!ai_network_open(ai_activations_at(acts_places[a]), ai_weights_at(weights_places[w]))) {
+                continue;
+            }
+            memset(AI_GetInput(), MODEL_IN_ZERO_POINT, AI_MOTOR_ANOMALIE_IN_1_SIZE_BYTES);
+
+            uint32_t min = UINT32_MAX, max = 0;
+            uint64_t total = 0;
+            osKernelLock();
+            (void)AI_RunOnce();
+            for (uint32_t r = 0; r < runs; r++) {
+                uint32_t t0 = DWT->CYCCNT;
+                (void)AI_RunOnce();
+                uint32_t dt = DWT->CYCCNT - t0;
+                total += dt;
+                if (dt < min) min = dt;
+                if (dt > max) max = dt;
+            }
+            osKernelUnlock();
+
+            entry[n].acts_place = acts_places[a];
+            entry[n].weights_place = weights_places[w];
+            entry[n].runs = (uint16_t)runs;
+            entry[n].min_cycles = min;
+            entry[n].avg_cycles = (uint32_t)(total / runs);
+            entry[n].max_cycles = max;
+            n++;
+        }
+    }
+    AI_DeInit();
+    shared_publish_ai_bench(entry, n, SystemCoreClock);
+
+    return ai_network_open(NULL, ai_weights_at(AI_WEIGHTS_PLACEMENT));
+}
+#endif
+
+#if AI_ENGINE_BENCH
+typedef struct {
+    uint32_t min;
+    uint32_t max;
+    uint64_t total;
+    uint32_t runs;
+} ai_cycle_stats_t;
+
+static void ai_cycle_add(ai_cycle_stats_t *s, uint32_t dt)
+{
+    if (s->runs == 0u || dt < s->min) s->min = dt;
+    if (dt > s->max) s->max = dt;
+    s->total += dt;
+    s->runs++;
+}
+
+static void ai_cycle_publish(shared_ai_cycles_t *out, const ai_cycle_stats_t *s)
+{
+    out->min_cycles = s->min;
+    out->avg_cycles = s->runs ? (uint32_t)(s->total / s->runs) : 0u;
+    out->max_cycles = s->max;
+}
+
+/* Cycles the engines have waited for weights so far (prefetched QSPI weights only) */
+static uint32_t ai_bench_stall(void)
+{
+#if AI_WEIGHTS_PLACEMENT == AI_PLACE_QSPI
+    ai_fetch_stats_t st;
+    ai_fetch_get_stats(&st);
+    return st.stall_cycles;
+#else
+    return 0u;
+#endif
+}
+
+/* Synthetic input stream: per-axis random walk with occasional spikes, already int8 */
+static void ai_bench_stream(int8_t *frames, uint32_t count)
+{
+    uint32_t state = 1u;
+    int32_t walk[AI_MOTOR_ANOMALIE_IN_1_CHANNEL] = { 0 };
+
+    for (uint32_t i = 0; i < count * AI_MOTOR_ANOMALIE_IN_1_CHANNEL; i++) {
+        int32_t *v = &walk[i % AI_MOTOR_ANOMALIE_IN_1_CHANNEL];
+        state = state * 1664525u + 1013904223u;
+        *v += (int32_t)((state >> 8) % 41u) - 20;
+        if (*v > 127) *v = 127;
+        if (*v < -128) *v = -128;
+        frames[i] = ((state >> 24) & 7u) == 0u ? (int8_t)(state >> 16) : (int8_t)*v;
+    }
+}
+
+/* Run the runtime and the engine on the same windows of a synthetic stream, AI_ENGINE_BENCH_HOP
+ * frames apart: the engine streams from window to window and its scores are compared
+ * with the runtime's, then every window is run again as a full window. Publishes the
+ * cycles for GET ENGINE. Needs DWT; the scheduler is locked while timing. */
+bool AI_BenchEngine(uint32_t windows)
+{
+    static int8_t stream[((AI_ENGINE_BENCH_WINDOWS - 1u) * AI_ENGINE_BENCH_HOP + AI_WINDOW_FRAMES) *
+                         AI_MOTOR_ANOMALIE_IN_1_CHANNEL];
+    ai_cycle_stats_t runtime = { 0 }, engine = { 0 }, streaming = { 0 }, stall = { 0 };
+    shared_ai_engine_bench_t bench = { 0 };
+
+    if (windows == 0u || windows > AI_ENGINE_BENCH_WINDOWS) windows = AI_ENGINE_BENCH_WINDOWS;
+    if (!ai_mgr_net(AI_NET)->handle) return false;
+    ai_bench_stream(stream, (windows - 1u) * AI_ENGINE_BENCH_HOP + AI_WINDOW_FRAMES);
+
+    const int8_t *rt_out = ai_mgr_output(AI_NET);
+    osKernelLock();
+    ai_engine_reset(&s_engine[0]);
+    for (uint32_t w = 0; w < windows; w++) {
+        /* The runtime may reuse its input tensor as scratch: the engine reads the stream */
+        const int8_t *win = &stream[w * AI_ENGINE_BENCH_HOP * AI_MOTOR_ANOMALIE_IN_1_CHANNEL];
+        memcpy(AI_GetInput(), win, AI_MOTOR_ANOMALIE_IN_1_SIZE);
+
+        uint32_t t0 = DWT->CYCCNT;
+        bool ok = AI_RunOnce();
+        ai_cycle_add(&runtime, DWT->CYCCNT - t0);
+
+        uint32_t s0 = ai_bench_stall();
+        t0 = DWT->CYCCNT;
+        bool eng_ok = ai_engine_run(&s_engine[0], win, w ? AI_ENGINE_BENCH_HOP : AI_WINDOW_FRAMES);
+        ai_cycle_add(w ? &streaming : &engine, DWT->CYCCNT - t0);
+        ai_cycle_add(&stall, ai_bench_stall() - s0);
+
+        bool same = ok && eng_ok;
+        for (uint32_t k = 0; ok && eng_ok && k < AI_MOTOR_ANOMALIE_OUT_1_SIZE; k++) {
+            int32_t d = (int32_t)rt_out[k] - (int32_t)s_engine[0].out[k];
+            if (d < 0) d = -d;
+            if (d != 0) same = false;
+            if ((uint32_t)d > bench.max_diff) bench.max_diff = (uint16_t)d;
+        }
+        if (!same) bench.mismatches++;
+    }
+    for (uint32_t w = 1; w < windows; w++) {
+        ai_engine_reset(&s_engine[0]);
+        uint32_t s0 = ai_bench_stall();
+        uint32_t t0 = DWT->CYCCNT;
+        (void)ai_engine_run(&s_engine[0], &stream[w * AI_ENGINE_BENCH_HOP * AI_MOTOR_ANOMALIE_IN_1_CHANNEL], AI_WINDOW_FRAMES);
+        ai_cycle_add(&engine, DWT->CYCCNT - t0);
+        ai_cycle_add(&stall, ai_bench_stall() - s0);
+    }
+    ai_engine_reset(&s_engine[0]);
+    osKernelUnlock();
+
+    bench.core_hz = SystemCoreClock;
+    bench.windows = (uint16_t)windows;
+    bench.hop = AI_ENGINE_BENCH_HOP;
+    ai_cycle_publish(&bench.runtime, &runtime);
+    ai_cycle_publish(&bench.engine, &engine);
+    ai_cycle_publish(&bench.streaming, &streaming);
+    ai_cycle_publish(&bench.stall, &stall);
+    shared_publish_ai_engine_bench(&bench);
+    return true;
+}
+#endif
+
+#if AI_OFFLOAD_BENCH
+/* Preprocess window `w` of the synthetic stream and run the runtime on it (CM7 side) */
+static bool ai_offload_bench_run(int16_t (*stream)[AI_OFFLOAD_BENCH_WINDOWS - 1u + AI_WINDOW_FRAMES], uint32_t w)
+{
+    const int16_t *const axes[AI_PREPROC_AXES] = { &stream[0][w], &stream[1][w], &stream[2][w] };
+    ai_preproc_window(&s_preproc, axes, AI_WINDOW_FRAMES, AI_GetInput());
+    return AI_RunOnce();
+}
+
+/* Windows per second x100 for `windows` windows in `cycles` CM7 cycles */
+static uint32_t ai_offload_bench_wps(uint32_t windows, uint32_t cycles)
+{
+    return cycles ? (uint32_t)((uint64_t)windows * 100u * SystemCoreClock / cycles) : 0u;
+}
+
+/* Run AI_OFFLOAD_BENCH_WINDOWS raw windows of a synthetic stream, one frame apart, on CM7
+ * alone, then again with CM4 taking windows whenever one of its slots is free. CM4's
+ * scores are compared with CM7's for the same window. Publishes windows per second for
+ * GET OFFLOAD; the two-core figure stays 0 if CM4 did not sync within
+ * AI_OFFLOAD_BENCH_WAIT_MS. Needs DWT; the scheduler is locked while timing. */
+bool AI_BenchOffload(uint32_t windows)
+{
+    static int16_t stream[AI_PREPROC_AXES][AI_OFFLOAD_BENCH_WINDOWS - 1u + AI_WINDOW_FRAMES];
+    static int8_t ref[AI_OFFLOAD_BENCH_WINDOWS][SHARED_AI_NUM_CLASSES];
+    shared_ai_offload_bench_t bench = { 0 };
+    uint32_t state = 1u;
+
+    if (windows == 0u || windows > AI_OFFLOAD_BENCH_WINDOWS) windows = AI_OFFLOAD_BENCH_WINDOWS;
+    if (!ai_mgr_net(AI_NET)->handle) return false;
+
+    /* Per-axis random walk in raw sensor counts */
+    for (uint32_t a = 0; a < AI_PREPROC_AXES; a++) {
+        int32_t v = 0;
+        for (uint32_t i = 0; i < windows - 1u + AI_WINDOW_FRAMES; i++) {
+            state = state * 1664525u + 1013904223u;
+            v += (int32_t)((state >> 8) % 401u) - 200;
+            if (v > 8000) v = 8000;
+            if (v < -8000) v = -8000;
+            stream[a][i] = (int16_t)v;
+        }
+    }
+
+    /* CM4 starts its side once its scheduler runs */
+    uint32_t t_wait = osKernelGetTickCount();
+    while (!ai_offload_cm4_hz() && osKernelGetTickCount() - t_wait < AI_OFFLOAD_BENCH_WAIT_MS) {
+        osDelay(10);
+    }
+
+    const int8_t *out = ai_mgr_output(AI_NET);
+    osKernelLock();
+    uint32_t t0 = DWT->CYCCNT;
+    for (uint32_t w = 0; w < windows; w++) {
+        bool ok = ai_offload_bench_run(stream, w);
+        for (uint32_t k = 0; k < SHARED_AI_NUM_CLASSES; k++) ref[w][k] = ok ? out[k] : 0;
+    }
+    uint32_t one_core = DWT->CYCCNT - t0;
+
+    uint32_t two_core = 0;
+    if (ai_offload_cm4_hz()) {
+        const void *weights = ai_weights_cm4();
+        uint32_t next = 0, served = 0;
+        ai_offload_result_t r;
+        t0 = DWT->CYCCNT;
+        while (served < windows) {
+            while (ai_offload_collect(&r)) {
+                if (!r.ok) {
+                    /* Timed out or failed on CM4: CM7 does it after all */
+                    (void)ai_offload_bench_run(stream, r.tag);
+                } else {
+                    bench.cm4_windows++;
+                    if (memcmp(r.scores, ref[r.tag], sizeof(r.scores)) != 0) bench.mismatches++;
+                }
+                served++;
+            }
+            while (next < windows) {
+                const int16_t *const axes[AI_PREPROC_AXES] = { &stream[0][next], &stream[1][next], &stream[2][next] };
+                if (!ai_offload_submit(0u, next, weights, &s_preproc, axes, AI_WINDOW_FRAMES)) break;
+                next++;
+            }
+            if (next < windows) {
+                (void)ai_offload_bench_run(stream, next++);
+                served++;
+            }
+        }
+        two_core = DWT->CYCCNT - t0;
+    }
+    osKernelUnlock();
+
+    bench.core_hz = SystemCoreClock;
+    bench.windows = (uint16_t)windows;
+    bench.one_core_wps_x100 = ai_offload_bench_wps(windows, one_core);
+    bench.two_core_wps_x100 = bench.cm4_windows ? ai_offload_bench_wps(windows, two_core) : 0u;
+    shared_publish_ai_offload_bench(&bench);
+    return true;
+}
+#endif
+
+#if AI_MODEL_HOTSWAP
+/* Model in use and outcome of the last CM4 request (GET MODEL) */
+static shared_model_status_t s_model;
+
+static void ai_model_init(void)
+{
+    static const char *const labels[MODEL_NUM_CLASSES] = MODEL_LABELS;
+
+    memset(&s_model, 0, sizeof(s_model));
+    s_model.request = shared_model_stage.request;     /* nothing staged before boot counts */
+    strncpy(s_model.hash, MODEL_PARAMS_HASH, SHARED_MODEL_HASH_LEN);
+    for (uint32_t c = 0; c < MODEL_NUM_CLASSES; c++) {
+        strncpy(s_model.labels[c], labels[c], SHARED_MODEL_LABEL_LEN - 1u);
+    }
+#if AI_WEIGHTS_PLACEMENT == AI_PLACE_QSPI
+    /* Booted on the QSPI bundle AI_Init() checked */
+    model_bundle_header_t h;
+    memcpy(&h, (const void *)AI_QSPI_BUNDLE_ADDR, sizeof(h));
+    memcpy(s_model.hash, h.model_hash, SHARED_MODEL_HASH_LEN);
+    for (uint32_t c = 0; c < MODEL_NUM_CLASSES; c++) {
+        memcpy(s_model.labels[c], h.labels[c], SHARED_MODEL_LABEL_LEN);
+        s_model.labels[c][SHARED_MODEL_LABEL_LEN - 1u] = '\0';
+    }
+#endif
+    shared_publish_model_status(&s_model);
+}
+
+/* Load the bundle CM4 asked for: check it, copy its weights into the idle slot, then
+ * reopen the network on them holding the arena, i.e. between two inferences. A bundle
+ * the runtime refuses leaves the previous model running. */
+static void ai_model_poll(void)
+{
+    /* request, source, size and data come straight from D2: SHARED_D2 is non-cacheable
+     * on this core (MPU_Config), so CM4's writes are seen without invalidating */
+    uint32_t request = shared_model_stage.request;
+    if (request == s_model.request) return;
+#if AI_OFFLOAD
+    /* CM4 may still be reading the weights the idle slot held before */
+    if (ai_offload_in_flight()) return;
+#endif
+    __DMB();
+
+    uint32_t t0 = DWT->CYCCNT;
+    const void *bundle;
+    uint32_t size;
+    if (shared_model_stage.source == SHARED_MODEL_SRC_FLASH) {
+        bundle = (const void *)AI_MODEL_FLASH_ADDR;
+        size = AI_MODEL_FLASH_SIZE;
+    } else {
+        bundle = (const void *)shared_model_stage.data;
+        size = shared_model_stage.size;
+        if (size > SHARED_MODEL_STAGE_SIZE) size = SHARED_MODEL_STAGE_SIZE;
+    }
+
+    model_bundle_target_t target;
+    model_bundle_header_t h;
+    ai_preproc_t pp;
+    ai_bundle_target(&target);
+    uint8_t status = model_bundle_check(bundle, size, &target);
+    if (status == SHARED_MODEL_OK) {
+        memcpy(&h, bundle, sizeof(h));
+        if (!ai_preproc_init(&pp, h.mean, h.std, MODEL_IN_SCALE, MODEL_IN_ZERO_POINT)) {
+            status = SHARED_MODEL_ERR_FORMAT;
+        }
+    }
+
+    if (status == SHARED_MODEL_OK) {
+        uint32_t slot = (s_model.slot == 1u) ? 2u : 1u;
+        uint64_t *weights = s_weights_slot[slot - 1u];
+        memcpy(weights, model_bundle_weights(bundle), AI_MOTOR_ANOMALIE_DATA_WEIGHTS_SIZE);
+        /* Out of the D-cache for CM4 (AI_OFFLOAD) */
+        SCB_CleanDCache_by_Addr((uint32_t *)weights, AI_MOTOR_ANOMALIE_DATA_WEIGHTS_SIZE);
+
+        if (!ai_mgr_acquire(AI_NET, osWaitForever)) {
+            status = SHARED_MODEL_ERR_OPEN;
+        } else {
+            if (ai_network_open(NULL, weights)) {
+                s_weights = weights;
+                s_preproc = pp;
+                for (uint32_t ch = 0; ch < AI_CHANNELS; ch++) {
+                    if (!s_channel[ch].own_preproc) s_channel[ch].preproc = pp;
+                }
+#if AI_STREAMING || AI_ENGINE_BENCH
+                ai_engines_init();
+#endif
+                s_model.slot = (uint8_t)slot;
+                s_model.swaps++;
+                memcpy(s_model.hash, h.model_hash, SHARED_MODEL_HASH_LEN);
+                for (uint32_t c = 0; c < MODEL_NUM_CLASSES; c++) {
+                    memcpy(s_model.labels[c], h.labels[c], SHARED_MODEL_LABEL_LEN);
+                    s_model.labels[c][SHARED_MODEL_LABEL_LEN - 1u] = '\0';
+                }
+            } else {
+                (void)ai_network_open(NULL, s_weights);
+                status = SHARED_MODEL_ERR_OPEN;
+            }
+            ai_mgr_release(AI_NET);
+        }
+    }
+
+    s_model.request = request;
+    s_model.status = status;
+    s_model.swap_us = (DWT->CYCCNT - t0) / (SystemCoreClock / 1000000u);
+    shared_publish_model_status(&s_model);
+}
+#endif
+
+/* Inference timing summed over all channels (GET PERF) */
+static struct {
+    uint32_t infer_count;
+    uint32_t gated_count;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} s_perf;
+
+static void ai_perf_publish(void)
+{
+    shared_publish_ai_perf(s_perf.infer_count, s_perf.last_us, s_perf.max_us,
+                           s_perf.infer_count ? (uint32_t)(s_perf.total_us / s_perf.infer_count) : 0u,
+                           s_perf.gated_count);
+}
+
+static uint32_t s_dropped_frames;   /* frames for a channel >= AI_CHANNELS */
+#if AI_OFFLOAD
+/* Windows CM4 ran, and its cycles on them since the start of the sched period */
+static uint32_t s_offloaded;
+static uint64_t s_cm4_cycles;
+#endif
+
+/* Move queued frames into their channel's window. A channel whose window is still
+ * waiting to be served keeps taking frames: its window moves on to the newest ones and
+ * `fresh` counts every frame since its last inference, so a channel that falls behind
+ * skips ahead instead of holding up the frames of the others. */
+static void ai_route_frames(const shared_ai_config_t *cfg)
+{
+    uint32_t now = osKernelGetTickCount();
+    sensor_frame_t f;
+
+    /* A smaller SET HOP can complete a window without a new frame */
+    for (uint32_t ch = 0; ch < AI_CHANNELS; ch++) {
+        const ai_window_t *w = &s_channel[ch].window;
+        ai_sched_frames(&s_sched, ch, w->filled == AI_WINDOW_FRAMES, w->fresh, ai_channel_hop(cfg, ch), now);
+    }
+
+    while (shared_pop_frame_cm7(&f)) {
+        uint32_t ch = SHARED_FRAME_CHANNEL(f.flags);
+        if (ch >= AI_CHANNELS) {
+            s_dropped_frames++;
+            continue;
+        }
+        ai_window_t *w = &s_channel[ch].window;
+        ai_window_push(w, &f);
+        ai_sched_frames(&s_sched, ch, w->filled == AI_WINDOW_FRAMES, w->fresh, ai_channel_hop(cfg, ch), now);
+    }
+}
+
+/* LED0 on while every channel is normal, LED1 on while any channel reports a fault */
+static void ai_leds_update(void)
+{
+    bool fault = false;
+
+    for (uint32_t ch = 0; ch < AI_CHANNELS; ch++) {
+        if (s_channel[ch].decision.state != 0u) fault = true;
+    }
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_0, fault ? GPIO_PIN_RESET : GPIO_PIN_SET);
+    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_1, fault ? GPIO_PIN_SET : GPIO_PIN_RESET);
+}
+
+/* Decision stage parameters from the CM4 tuning: per-class thresholds fall back to
+ * SET THRESH, exit thresholds to the enter ones and never above them */
+static void ai_decision_params(const shared_ai_config_t *cfg, ai_decision_params_t *p)
+{
+    p->ema_shift = cfg->ema_shift;
+    p->enter_dwell_ms = cfg->enter_dwell_ms;
+    p->exit_dwell_ms = cfg->exit_dwell_ms;
+    for (uint32_t k = 0; k < MODEL_NUM_CLASSES; k++) {
+        uint8_t enter = cfg->enter_pct[k] ? cfg->enter_pct[k] : cfg->fault_thresh_pct;
+        uint8_t exit = cfg->exit_pct[k] ? cfg->exit_pct[k] : enter;
+        p->enter_pct[k] = enter;
+        p->exit_pct[k] = (exit < enter) ? exit : enter;
+    }
+}
+
+/* Decide on a channel's window from its int8 softmax scores: fold them into the channel's
+ * decision stage, publish the window for CM4 and, if the reported state changed, an event
+ * (black box trigger, GET DECISIONS, stream). Updates the LEDs. */
+static void ai_channel_decide(uint32_t ch, const shared_ai_config_t *cfg, const int8_t *scores, uint32_t ts)
+{
+    ai_channel_t *c = &s_channel[ch];
+    ai_decision_params_t params;
+    ai_decision_event_t change;
+    uint16_t prob[MODEL_NUM_CLASSES];
+
+    /* Probabilities on a Q8 grid, prob = (q - zp) * scale, and the most probable class */
+    int best = 0;
+    for (int k = 0; k < MODEL_NUM_CLASSES; ++k) {
+        float p = (float)((int32_t)scores[k] - AI_SCORE_ZERO_POINT) * AI_SCORE_SCALE * 256.0f + 0.5f;
+        prob[k] = (p <= 0.0f) ? 0u : (p >= 256.0f) ? 256u : (uint16_t)p;
+        if (scores[k] > scores[best]) best = k;
+    }
+    ai_decision_params(cfg, &params);
+    bool changed = ai_decision_update(&c->decision, &params, prob, ts, &change);
+
+    shared_publish_ai_result(ch, (uint8_t)best, c->decision.state, scores, ts);
+    if (changed) {
+        shared_ai_event_t ev = {
+            .ts = ts,
+            .onset_ts = change.onset_ts,
+            .channel = (uint8_t)ch,
+            .from_class = change.from,
+            .to_class = change.to,
+            .confidence_pct = change.confidence_pct,
+        };
+        shared_publish_ai_event(&ev);
+    }
+    memcpy(c->last_scores, scores, sizeof(c->last_scores));
+    c->last_class = (uint8_t)best;
+    c->have_decision = true;
+    ai_leds_update();
+}
+
+/* Serve a channel's complete window: its last decision again if CM4 gated the window,
+ * else preprocessing and inference. Returns the cycles spent on the network. */
+static uint32_t ai_channel_serve(uint32_t ch, const shared_ai_config_t *cfg)
+{
+    ai_channel_t *c = &s_channel[ch];
+    ai_window_t *w = &c->window;
+    uint32_t shift = w->fresh + c->gated_frames;
+
+    ai_sched_take(&s_sched, ch);
+    w->fresh = 0;
+
+    /* CM4 saw no vibration worth classifying: keep the last decision */
+    if ((w->last_flags & SHARED_FRAME_QUIET) && c->have_decision) {
+        c->gated++;
+        s_perf.gated_count++;
+        c->gated_frames = (shift < AI_WINDOW_FRAMES) ? shift : AI_WINDOW_FRAMES;
+        ai_perf_publish();
+        shared_publish_ai_result(ch, c->last_class, c->decision.state, c->last_scores, w->last_ts);
+        return 0;
+    }
+    c->gated_frames = 0;
+
+    /* Input, activations and output are the manager's shared arena from here on */
+    if (!ai_mgr_acquire(AI_NET, osWaitForever)) {
+        w->fresh = shift;
+        ai_sched_retry(&s_sched, ch);
+        return 0;
+    }
+    if (ai_sched_late(&s_sched, ch, osKernelGetTickCount())) c->late++;
+
+    /* Oldest frame first, interleaved [frame][axis], straight into the input tensor */
+    uint32_t t0 = DWT->CYCCNT;
+    const int16_t *const axes[AI_PREPROC_AXES] = {
+        &w->axis[0][w->head],
+        &w->axis[1][w->head],
+        &w->axis[2][w->head],
+    };
+    ai_preproc_window(&c->preproc, axes, AI_WINDOW_FRAMES, AI_GetInput());
+
+    uint32_t t1 = DWT->CYCCNT;
+#if AI_STREAMING
+    bool ok = AI_RunStreaming(ch, shift);
+#else
+    bool ok = AI_RunOnce();
+#endif
+    uint32_t us = (DWT->CYCCNT - t1) / (SystemCoreClock / 1000000u);
+    c->windows++;
+    s_perf.infer_count++;
+    s_perf.total_us += us;
+    s_perf.last_us = us;
+    if (us > s_perf.max_us) s_perf.max_us = us;
+    ai_perf_publish();
+#if AI_PROFILING
+    ai_profile_publish();
+#endif
+
+    if (ok) ai_channel_decide(ch, cfg, AI_GetOutput(), w->last_ts);
+    ai_mgr_release(AI_NET);
+    return DWT->CYCCNT - t0;
+}
+
+#if AI_OFFLOAD
+/* Hand a channel's complete window to CM4 instead of serving it. False if CM4 is not up
+ * or busy, or if the window is gated (keeping the last decision costs CM7 nothing). */
+static bool ai_channel_offload(uint32_t ch)
+{
+    ai_channel_t *c = &s_channel[ch];
+    ai_window_t *w = &c->window;
+
+    if ((w->last_flags & SHARED_FRAME_QUIET) && c->have_decision) return false;
+    const int16_t *const axes[AI_PREPROC_AXES] = {
+        &w->axis[0][w->head],
+        &w->axis[1][w->head],
+        &w->axis[2][w->head],
+    };
+    if (!ai_offload_submit(ch, w->last_ts, ai_weights_cm4(), &c->preproc, axes, AI_WINDOW_FRAMES)) return false;
+
+    if (ai_sched_late(&s_sched, ch, osKernelGetTickCount())) c->late++;
+    ai_sched_offload(&s_sched, ch);
+    c->gated_frames = 0;
+    w->fresh = 0;
+#if AI_STREAMING
+    /* The engine's activations no longer belong to the window before the next one */
+    ai_engine_reset(&s_engine[ch]);
+#endif
+    return true;
+}
+
+/* Decide on the windows CM4 has finished, in their channels */
+static void ai_channel_collect(const shared_ai_config_t *cfg)
+{
+    ai_offload_result_t r;
+
+    while (ai_offload_collect(&r)) {
+        ai_channel_t *c = &s_channel[r.channel];
+        ai_sched_done(&s_sched, r.channel);
+        c->windows++;
+        s_offloaded++;
+        s_cm4_cycles += r.cycles;
+        if (r.ok) ai_channel_decide(r.channel, cfg, r.scores, r.tag);
+    }
+}
+#endif
+
+/* Per-channel counters and rates, and the share of CM7 time spent serving windows,
+ * over the last `elapsed_ms` */
+static void ai_sched_publish(const shared_ai_config_t *cfg, uint64_t busy_cycles, uint32_t elapsed_ms)
+{
+    shared_ai_sched_t sched = { 0 };
+    uint64_t elapsed_cycles = (uint64_t)elapsed_ms * (SystemCoreClock / 1000u);
+
+    sched.policy = AI_SCHED_POLICY;
+    sched.channels = AI_CHANNELS;
+    sched.util_permille = elapsed_cycles ? (uint16_t)((busy_cycles >= elapsed_cycles) ? 1000u :
+                                                      busy_cycles * 1000u / elapsed_cycles) : 0u;
+    sched.dropped_frames = s_dropped_frames;
+#if AI_OFFLOAD
+    uint64_t cm4_cycles = (uint64_t)elapsed_ms * (ai_offload_cm4_hz() / 1000u);
+    sched.offloaded = s_offloaded;
+    sched.cm4_util_permille = cm4_cycles ? (uint16_t)((s_cm4_cycles >= cm4_cycles) ? 1000u :
+                                                      s_cm4_cycles * 1000u / cm4_cycles) : 0u;
+    s_cm4_cycles = 0;
+#endif
+    for (uint32_t ch = 0; ch < AI_CHANNELS; ch++) {
+        ai_channel_t *c = &s_channel[ch];
+        uint32_t served = c->windows + c->gated;
+        uint64_t wps_x100 = elapsed_ms ? (uint64_t)(served - c->period_start) * 100000u / elapsed_ms : 0u;
+        sched.ch[ch].windows = c->windows;
+        sched.ch[ch].gated = c->gated;
+        sched.ch[ch].late = c->late;
+        sched.ch[ch].hop = (uint16_t)ai_channel_hop(cfg, ch);
+        sched.ch[ch].wps_x100 = (wps_x100 > UINT16_MAX) ? UINT16_MAX : (uint16_t)wps_x100;
+        sched.ch[ch].last_class = c->last_class;
+        sched.ch[ch].state = c->decision.state;
+        c->period_start = served;
+    }
+    shared_publish_ai_sched(&sched);
+}
 
 void AiTask(void *argument)
 {
-    AI_Init();
-    int8_t input_s8[180];
-    int8_t out_s8[4];
+    for (uint32_t ch = 0; ch < AI_CHANNELS; ch++) {
+        ai_channel_reset(&s_channel[ch]);
+    }
+    ai_sched_init(&s_sched, AI_SCHED_POLICY, AI_CHANNELS);
     /* Simple GPIO feedback mapping: assumes LEDs on GPIOB PIN0/PIN1 */
     __HAL_RCC_GPIOB_CLK_ENABLE();
     GPIO_InitTypeDef GPIO_InitStruct = {0};
@@ -65,63 +1121,80 @@ void AiTask(void *argument)
     GPIO_InitStruct.Pull = GPIO_NOPULL;
     GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
     HAL_GPIO_Init(GPIOB, &GPIO_InitStruct);
-    const float scale = 0.025338666513562202f; /* input quant scale */
-    /* Embedded normalization means/stds from training (update with your stats) */
-    const float mean_x = 0.0f, mean_y = 0.0f, mean_z = 1000.0f;
-    const float std_x  = 50.0f, std_y  = 50.0f, std_z  = 80.0f;
-    const int zp = 12;                          /* input zero point */
+
+    /* Cycle counter for inference timing (GET PERF, GET BENCH) */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    bool ready = AI_Init();
+    /* The boot benchmarks run the network too: they hold the arena like an inference */
+    if (ready && ai_mgr_acquire(AI_NET, osWaitForever)) {
+#if AI_PLACEMENT_BENCH
+        ready = AI_BenchPlacements(AI_PLACEMENT_BENCH_RUNS);
+#endif
+#if AI_ENGINE_BENCH
+        ready = ready && AI_BenchEngine(AI_ENGINE_BENCH_WINDOWS);
+#endif
+#if AI_OFFLOAD_BENCH
+        ready = ready && AI_BenchOffload(AI_OFFLOAD_BENCH_WINDOWS);
+#endif
+        ai_mgr_release(AI_NET);
+    } else {
+        ready = false;
+    }
+    if (!ready) {
+        /* Network missing or built against other model_params.h: no inference, fault LED on */
+        HAL_GPIO_WritePin(GPIOB, GPIO_PIN_1, GPIO_PIN_SET);
+        for (;;) {
+            osDelay(1000);
+        }
+    }
+
+#if AI_MODEL_HOTSWAP
+    ai_model_init();
+#endif
+
+    /* Runtime tuning from CM4 (SET HOP / SET PERIOD / SET THRESH / SET DECISION / SET CLASS) */
+    shared_ai_config_t cfg = {
+        .seq = 0,
+        .hop_frames = SHARED_AI_DEFAULT_HOP,
+        .period_ms = SHARED_AI_DEFAULT_PERIOD_MS,
+        .fault_thresh_pct = SHARED_AI_DEFAULT_THRESH_PCT,
+    };
+
+    /* Scheduler period: cycles spent serving windows since sched_tick */
+    uint32_t sched_tick = osKernelGetTickCount();
+    uint64_t busy_cycles = 0;
 
     for (;;) {
-        /* Build a 60x3 window from shared ring (most recent 60 frames) */
-        sensor_frame_t buf[60];
-        int count = 0;
-        /* Drain up to 60 frames; if fewer, pad with zeros around zp */
-        while (count < 60) {
-            sensor_frame_t f;
-            if (!shared_pop_frame_cm7(&f)) break;
-            buf[count++] = f;
+        shared_read_ai_config(&cfg);
+#if AI_MODEL_HOTSWAP
+        /* A new model takes effect between two passes */
+        ai_model_poll();
+#endif
+
+        /* Fill the histories, then serve every complete window once per pass */
+        uint32_t order[SHARED_AI_MAX_CHANNELS];
+#if AI_OFFLOAD
+        ai_channel_collect(&cfg);
+#endif
+        ai_route_frames(&cfg);
+        uint32_t n = ai_sched_order(&s_sched, order);
+        for (uint32_t i = 0; i < n; i++) {
+#if AI_OFFLOAD
+            /* CM7 takes the most urgent window of the pass, CM4 what it can of the rest */
+            if (i > 0u && ai_channel_offload(order[i])) continue;
+#endif
+            busy_cycles += ai_channel_serve(order[i], &cfg);
         }
-        if (count > 0) {
-            /* Normalize (simple mg to standardization can be added later); here assume data already roughly centered */
-            /* Pack as int8 using quantization: q = round(x/scale) + zp */
-            for (int i = 0; i < 60; ++i) {
-                float xf = (i < count) ? (float)buf[i].x : 0.f;
-                float yf = (i < count) ? (float)buf[i].y : 0.f;
-                float zf = (i < count) ? (float)buf[i].z : 0.f;
-                /* z-score normalize */
-                xf = (xf - mean_x) / (std_x + 1e-6f);
-                yf = (yf - mean_y) / (std_y + 1e-6f);
-                zf = (zf - mean_z) / (std_z + 1e-6f);
-                /* quantize */
-                int32_t qxi = (int32_t)((xf / scale) + zp);
-                int32_t qyi = (int32_t)((yf / scale) + zp);
-                int32_t qzi = (int32_t)((zf / scale) + zp);
-                if (qxi > 127) qxi = 127; if (qxi < -128) qxi = -128;
-                if (qyi > 127) qyi = 127; if (qyi < -128) qyi = -128;
-                if (qzi > 127) qzi = 127; if (qzi < -128) qzi = -128;
-                int8_t qx = (int8_t)qxi;
-                int8_t qy = (int8_t)qyi;
-                int8_t qz = (int8_t)qzi;
-                input_s8[i*3 + 0] = qx;
-                input_s8[i*3 + 1] = qy;
-                input_s8[i*3 + 2] = qz;
-            }
-            if (AI_RunOnce(input_s8, out_s8)) {
-                /* Dequantize logits to pick class (softmax int8: scale 1/256, zp=-128) */
-                int best = 0; int8_t bestv = out_s8[0];
-                for (int k = 1; k < 4; ++k) { if (out_s8[k] > bestv) { bestv = out_s8[k]; best = k; } }
-                /* Map classes: 0=normal, >0=fault: LED0 normal ON, LED1 fault ON */
-                if (best == 0) {
-                    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_0, GPIO_PIN_SET);
-                    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_1, GPIO_PIN_RESET);
-                } else {
-                    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_0, GPIO_PIN_RESET);
-                    HAL_GPIO_WritePin(GPIOB, GPIO_PIN_1, GPIO_PIN_SET);
-                }
-            }
+
+        uint32_t now = osKernelGetTickCount();
+        if (now - sched_tick >= SHARED_AI_SCHED_PERIOD_MS) {
+            ai_sched_publish(&cfg, busy_cycles, now - sched_tick);
+            sched_tick = now;
+            busy_cycles = 0;
         }
-        osDelay(20);
+        osDelay(cfg.period_ms ? cfg.period_ms : 1u);
     }
 }
-
-
@@ -0,0 +1,205 @@
+#include "ai_manager.h"
+#include "cmsis_os.h"
+#include <string.h>
+
+#define AI_NET_DESC_(name_, NAME_, prio_, sig_) {                   \
+    .name = AI_##NAME_##_MODEL_NAME,                                \
+    .create_and_init = ai_##name_##_create_and_init,                \
+    .inputs_get = ai_##name_##_inputs_get,                          \
+    .outputs_get = ai_##name_##_outputs_get,                        \
+    .run = ai_##name_##_run,                                        \
+    .destroy = ai_##name_##_destroy,                                \
+    .get_report = ai_##name_##_get_report,                          \
+    .weights = s_##name_##_weights_array_u64,                       \
+    .activations_size = AI_##NAME_##_DATA_ACTIVATIONS_SIZE,         \
+    .in_size = AI_##NAME_##_IN_1_SIZE,                              \
+    .out_size = AI_##NAME_##_OUT_1_SIZE,                            \
+    .priority = (prio_),                                            \
+    .signature = (sig_),                                            \
+},
+
+static const ai_net_desc_t s_registry[AI_NET_COUNT] = {
+    AI_NETWORK_LIST(AI_NET_DESC_)
+};
+
+#define AI_MGR_NO_OWNER  (-1)
+
+static struct {
+    void *arena;
+    uint32_t arena_size;
+    osMutexId_t lock;
+    osSemaphoreId_t grant[AI_NET_COUNT];
+    int32_t owner;                  /* network holding the arena, AI_MGR_NO_OWNER if free */
+    bool waiting[AI_NET_COUNT];
+    ai_net_t net[AI_NET_COUNT];
+} s_mgr = { .owner = AI_MGR_NO_OWNER };
+
+/* Set the shared arena (all networks closed); creates the scheduler objects once */
+bool ai_mgr_init(void *arena, uint32_t size)
+{
+    if (!arena || size < AI_MGR_ARENA_SIZE) return false;
+    for (uint32_t i = 0; i < AI_NET_COUNT; i++) {
+        if (s_mgr.net[i].handle) return false;
+    }
+    if (!s_mgr.lock) {
+        s_mgr.lock = osMutexNew(NULL);
+        if (!s_mgr.lock) return false;
+        for (uint32_t i = 0; i < AI_NET_COUNT; i++) {
+            s_mgr.grant[i] = osSemaphoreNew(1u, 0u, NULL);
+            if (!s_mgr.grant[i]) return false;
+        }
+    }
+    s_mgr.arena = arena;
+    s_mgr.arena_size = size;
+    return true;
+}
+
+static bool ai_mgr_quant(const ai_buffer *buf, float *scale, int32_t *zero_point)
+{
+    const ai_buffer_meta_info *meta = AI_BUFFER_META_INFO(buf);
+    if (AI_BUFFER_META_INFO_INTQ_GET_SIZE(meta) == 0) {
+        *scale = 0.0f;              /* float tensor */
+        *zero_point = 0;
+        return false;
+    }
+    *scale = AI_BUFFER_META_INFO_INTQ_GET_SCALE(meta, 0);
+    *zero_point = AI_BUFFER_META_INFO_INTQ_GET_ZEROPOINT(meta, 0);
+    return true;
+}
+
+/* Create a network over the shared arena (activations NULL) or its own buffer, with the
+ * given weights (NULL: the generated flash array). Checks the signature and I/O sizes. */
+bool ai_mgr_open(ai_net_id_t id, void *activations, const void *weights)
+{
+    if ((uint32_t)id >= AI_NET_COUNT) return false;
+    const ai_net_desc_t *d = &s_registry[id];
+    ai_net_t *n = &s_mgr.net[id];
+
+    ai_mgr_close(id);
+    if (!activations) activations = s_mgr.arena;
+    if (!weights) weights = d->weights;
+    if (!activations) return false;
+
+    const ai_handle acts[] = { activations };
+    const ai_handle wts[]  = { (ai_handle)weights };
+    ai_error err = d->create_and_init(&n->handle, acts, wts);
+    if (err.type != AI_ERROR_NONE) {
+        n->handle = AI_HANDLE_NULL;
+        return false;
+    }
+
+    ai_network_report report;
+    if (d->signature &&
+        (!d->get_report(n->handle, &report) || !report.model_signature ||
+         strncmp(report.model_signature, "0x", 2) != 0 ||
+         strcmp(report.model_signature + 2, d->signature) != 0)) {
+        ai_mgr_close(id);
+        return false;
+    }
+
+    n->input = d->inputs_get(n->handle, NULL);
+    n->output = d->outputs_get(n->handle, NULL);
+    if (!n->input || !n->output || !n->input->data || !n->output->data ||
+        AI_BUFFER_SIZE_UNPAD(n->input) != d->in_size ||
+        AI_BUFFER_SIZE_UNPAD(n->output) != d->out_size) {
+        ai_mgr_close(id);
+        return false;
+    }
+    (void)ai_mgr_quant(n->input, &n->in_scale, &n->in_zero_point);
+    (void)ai_mgr_quant(n->output, &n->out_scale, &n->out_zero_point);
+    return true;
+}
+
+void ai_mgr_close(ai_net_id_t id)
+{
+    if ((uint32_t)id >= AI_NET_COUNT) return;
+    ai_net_t *n = &s_mgr.net[id];
+    if (n->handle) {
+        s_registry[id].destroy(n->handle);
+    }
+    n->handle = AI_HANDLE_NULL;
+    n->input = NULL;
+    n->output = NULL;
+}
+
+const ai_net_desc_t *ai_mgr_desc(ai_net_id_t id)
+{
+    return ((uint32_t)id < AI_NET_COUNT) ? &s_registry[id] : NULL;
+}
+
+const ai_net_t *ai_mgr_net(ai_net_id_t id)
+{
+    return ((uint32_t)id < AI_NET_COUNT) ? &s_mgr.net[id] : NULL;
+}
+
+/* Take the arena for `id`; waits up to `timeout` ticks behind the current holder */
+bool ai_mgr_acquire(ai_net_id_t id, uint32_t timeout)
+{
+    if ((uint32_t)id >= AI_NET_COUNT || !s_mgr.lock) return false;
+
+    osMutexAcquire(s_mgr.lock, osWaitForever);
+    if (s_mgr.owner == AI_MGR_NO_OWNER) {
+        s_mgr.owner = (int32_t)id;
+        osMutexRelease(s_mgr.lock);
+        return true;
+    }
+    s_mgr.waiting[id] = true;
+    s_mgr.net[id].waits++;
+    osMutexRelease(s_mgr.lock);
+
+    if (osSemaphoreAcquire(s_mgr.grant[id], timeout) == osOK) return true;
+
+    /* Timed out, unless the arena was handed over in the meantime */
+    osMutexAcquire(s_mgr.lock, osWaitForever);
+    bool granted = (s_mgr.owner == (int32_t)id);
+    s_mgr.waiting[id] = false;
+    osMutexRelease(s_mgr.lock);
+    if (granted) (void)osSemaphoreAcquire(s_mgr.grant[id], 0u);
+    return granted;
+}
+
+/* Hand the arena to the waiting network with the highest priority (lowest id on a tie) */
+void ai_mgr_release(ai_net_id_t id)
+{
+    if ((uint32_t)id >= AI_NET_COUNT || !s_mgr.lock) return;
+
+    osMutexAcquire(s_mgr.lock, osWaitForever);
+    if (s_mgr.owner == (int32_t)id) {
+        int32_t next = AI_MGR_NO_OWNER;
+        for (uint32_t i = 0; i < AI_NET_COUNT; i++) {
+            if (s_mgr.waiting[i] &&
+                (next == AI_MGR_NO_OWNER || s_registry[i].priority > s_registry[next].priority)) {
+                next = (int32_t)i;
+            }
+        }
+        s_mgr.owner = next;
+        if (next != AI_MGR_NO_OWNER) {
+            s_mgr.waiting[next] = false;
+            osSemaphoreRelease(s_mgr.grant[next]);
+        }
+    }
+    osMutexRelease(s_mgr.lock);
+}
+
+/* Run on the input tensor; the caller must hold the arena */
+bool ai_mgr_run(ai_net_id_t id)
+{
+    if ((uint32_t)id >= AI_NET_COUNT || s_mgr.owner != (int32_t)id) return false;
+    ai_net_t *n = &s_mgr.net[id];
+    if (!n->handle || s_registry[id].run(n->handle, n->input, n->output) != 1) return false;
+    n->runs++;
+    return true;
+}
+
+/* Input and output tensors, inside the activations: valid while the arena is held */
+int8_t *ai_mgr_input(ai_net_id_t id)
+{
+    const ai_net_t *n = ai_mgr_net(id);
+    return (n && n->input) ? AI_BUFFER_DATA(n->input, int8_t) : NULL;
+}
+
+const int8_t *ai_mgr_output(ai_net_id_t id)
+{
+    const ai_net_t *n = ai_mgr_net(id);
+    return (n && n->output) ? AI_BUFFER_DATA(n->output, const int8_t) : NULL;
+}
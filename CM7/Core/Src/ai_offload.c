@@ -0,0 +1,111 @@
+#include "ai_offload.h"
+#include "stm32h7xx_hal.h"
+#include <stddef.h>
+#include <string.h>
+
+_Static_assert(sizeof(ai_preproc_t) == sizeof(shared_offload.job[0].preproc), "shared preprocessing != ai_preproc_t");
+_Static_assert(offsetof(shared_offload_t, cm4_session) % 32u == 0u, "each core must write its own lines of shared_offload");
+
+/* Slots as CM7 sees them */
+static struct {
+    uint32_t request[SHARED_OFFLOAD_SLOTS];     /* last request handed out per slot */
+    uint32_t submitted[SHARED_OFFLOAD_SLOTS];   /* HAL tick: runs while the scheduler is locked */
+    uint32_t channel[SHARED_OFFLOAD_SLOTS];
+    uint32_t tag[SHARED_OFFLOAD_SLOTS];
+    bool busy[SHARED_OFFLOAD_SLOTS];
+    bool abandoned[SHARED_OFFLOAD_SLOTS];       /* reported failed, CM4 still on it */
+} s_off;
+
+/* Start a new session: CM4 marks every slot done before it takes jobs again */
+void ai_offload_init(void)
+{
+    memset(&s_off, 0, sizeof(s_off));
+    for (uint32_t i = 0; i < SHARED_OFFLOAD_SLOTS; i++) {
+        s_off.request[i] = shared_offload.job[i].request;
+    }
+    shared_offload.session = shared_offload.session + 1u;
+    __DSB();
+}
+
+/* CM4 core clock once it has synced to this session, else 0 (no offload) */
+uint32_t ai_offload_cm4_hz(void)
+{
+    return (shared_offload.cm4_session == shared_offload.session) ? shared_offload.cm4_hz : 0u;
+}
+
+/* Copy a window into a free slot for CM4; false if CM4 is not up or every slot is taken.
+ * `weights` must be readable by CM4 (flash, AXI SRAM or QSPI, not DTCM) and written back
+ * from the D-cache. */
+bool ai_offload_submit(uint32_t channel, uint32_t tag, const void *weights, const ai_preproc_t *pp,
+                       const int16_t *const axis[AI_PREPROC_AXES], uint32_t frames)
+{
+    uint32_t i = 0;
+
+    if (frames > SHARED_OFFLOAD_FRAMES || !weights || !ai_offload_cm4_hz()) return false;
+    while (i < SHARED_OFFLOAD_SLOTS && s_off.busy[i]) i++;
+    if (i == SHARED_OFFLOAD_SLOTS) return false;
+
+    volatile shared_offload_job_t *job = &shared_offload.job[i];
+    job->weights = (uint32_t)(uintptr_t)weights;
+    job->frames = (uint16_t)frames;
+    job->channel = (uint8_t)channel;
+    memcpy((void *)job->preproc, pp, sizeof(job->preproc));
+    for (uint32_t a = 0; a < AI_PREPROC_AXES; a++) {
+        memcpy((void *)job->axis[a], axis[a], frames * sizeof(int16_t));
+    }
+    /* The window reaches D2 before the request that hands it over (SHARED_D2 is
+     * non-cacheable on CM7, see MPU_Config) */
+    __DMB();
+    job->request = ++s_off.request[i];
+    __DSB();
+
+    s_off.busy[i] = true;
+    s_off.submitted[i] = HAL_GetTick();
+    s_off.channel[i] = channel;
+    s_off.tag[i] = tag;
+    return true;
+}
+
+/* Next window CM4 has finished, or has held longer than AI_OFFLOAD_TIMEOUT_MS */
+bool ai_offload_collect(ai_offload_result_t *out)
+{
+    for (uint32_t i = 0; i < SHARED_OFFLOAD_SLOTS; i++) {
+        if (!s_off.busy[i]) continue;
+        volatile shared_offload_result_t *res = &shared_offload.result[i];
+
+        bool done = (res->done == s_off.request[i]);
+        __DMB();    /* scores after done */
+        if (done) {
+            s_off.busy[i] = false;
+            if (s_off.abandoned[i]) {
+                s_off.abandoned[i] = false;
+                continue;
+            }
+        } else if (s_off.abandoned[i] || HAL_GetTick() - s_off.submitted[i] <= AI_OFFLOAD_TIMEOUT_MS) {
+            continue;
+        } else {
+            s_off.abandoned[i] = true;
+        }
+
+        out->channel = s_off.channel[i];
+        out->tag = s_off.tag[i];
+        out->ok = done && res->ok;
+        out->cycles = done ? res->cycles : 0u;
+        for (uint32_t k = 0; k < SHARED_AI_NUM_CLASSES; k++) {
+            out->scores[k] = out->ok ? res->scores[k] : 0;
+        }
+        return true;
+    }
+    return false;
+}
+
+/* Windows CM4 may still be reading, abandoned ones included */
+uint32_t ai_offload_in_flight(void)
+{
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < SHARED_OFFLOAD_SLOTS; i++) {
+        if (s_off.busy[i]) n++;
+    }
+    return n;
+}
@@ -0,0 +1,74 @@
+#include "ai_sched.h"
+#include <string.h>
+
+void ai_sched_init(ai_sched_t *s, uint8_t policy, uint32_t channels)
+{
+    memset(s, 0, sizeof(*s));
+    s->policy = policy;
+    s->channels = (channels > SHARED_AI_MAX_CHANNELS) ? SHARED_AI_MAX_CHANNELS : channels;
+}
+
+/* A channel's window after new frames (or a smaller hop) at tick `now`: `full` once it
+ * holds a whole window, `fresh` frames since the last one served. A pending channel
+ * keeps its deadline while its window moves on to the newest frames. */
+void ai_sched_frames(ai_sched_t *s, uint32_t ch, bool full, uint32_t fresh, uint32_t hop, uint32_t now)
+{
+    ai_sched_channel_t *c = &s->ch[ch];
+
+    if (c->pending || !full || fresh < hop) return;
+    c->pending = true;
+    c->deadline = now + hop * SHARED_FRAME_PERIOD_MS;
+}
+
+/* Pending channels that are not blocked on CM4, in the order the policy serves them.
+ * Rotates the round-robin start once per call. */
+uint32_t ai_sched_order(ai_sched_t *s, uint32_t order[SHARED_AI_MAX_CHANNELS])
+{
+    uint32_t n = 0;
+
+    for (uint32_t i = 0; i < s->channels; i++) {
+        uint32_t ch = (s->rr_next + i) % s->channels;
+        if (!s->ch[ch].pending || s->ch[ch].offloaded) continue;
+        uint32_t k = n++;
+        if (s->policy == SHARED_AI_SCHED_DEADLINE) {
+            /* Insertion keeps equal deadlines in rotating order; wrap-safe compare */
+            while (k > 0u && (int32_t)(s->ch[ch].deadline - s->ch[order[k - 1u]].deadline) < 0) {
+                order[k] = order[k - 1u];
+                k--;
+            }
+        }
+        order[k] = ch;
+    }
+    if (s->channels) s->rr_next = (s->rr_next + 1u) % s->channels;
+    return n;
+}
+
+/* Served at `now`, the window is after its deadline */
+bool ai_sched_late(const ai_sched_t *s, uint32_t ch, uint32_t now)
+{
+    return (int32_t)(now - s->ch[ch].deadline) > 0;
+}
+
+/* Serving the window on CM7 */
+void ai_sched_take(ai_sched_t *s, uint32_t ch)
+{
+    s->ch[ch].pending = false;
+}
+
+/* Serving failed before the network ran: the window is pending again, same deadline */
+void ai_sched_retry(ai_sched_t *s, uint32_t ch)
+{
+    s->ch[ch].pending = true;
+}
+
+/* The window went to CM4: the channel is blocked until ai_sched_done() */
+void ai_sched_offload(ai_sched_t *s, uint32_t ch)
+{
+    s->ch[ch].pending = false;
+    s->ch[ch].offloaded = true;
+}
+
+void ai_sched_done(ai_sched_t *s, uint32_t ch)
+{
+    s->ch[ch].offloaded = false;
+}
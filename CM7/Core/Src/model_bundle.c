@@ -0,0 +1,62 @@
+#include "model_bundle.h"
+#include <stddef.h>
+#include <string.h>
+
+_Static_assert(sizeof(model_bundle_header_t) % 8u == 0u, "bundle weights must stay 8-byte aligned");
+
+/* CRC-32 (IEEE 802.3, reflected, as zlib.crc32): pass 0 to start, the result to continue */
+uint32_t model_bundle_crc32(uint32_t crc, const uint8_t *data, uint32_t len)
+{
+    static const uint32_t nibble[16] = {
+        0x00000000u, 0x1DB71064u, 0x3B6E20C8u, 0x26D930ACu, 0x76DC4190u, 0x6B6B51F4u, 0x4DB26158u, 0x5005713Cu,
+        0xEDB88320u, 0xF00F9344u, 0xD6D6A3E8u, 0xCB61B38Cu, 0x9B64C2B0u, 0x86D3D2D4u, 0xA00AE278u, 0xBDBDF21Cu,
+    };
+
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        crc = (crc >> 4) ^ nibble[crc & 0xFu];
+        crc = (crc >> 4) ^ nibble[crc & 0xFu];
+    }
+    return ~crc;
+}
+
+/* SHARED_MODEL_OK if the bundle is intact and fits the target network */
+uint8_t model_bundle_check(const void *bundle, uint32_t size, const model_bundle_target_t *target)
+{
+    model_bundle_header_t h;
+    static const uint8_t zero[sizeof(h.crc32)] = { 0 };
+
+    if (!bundle || size < sizeof(h)) return SHARED_MODEL_ERR_FORMAT;
+    memcpy(&h, bundle, sizeof(h));
+    if (h.magic != MODEL_BUNDLE_MAGIC || h.version != MODEL_BUNDLE_VERSION ||
+        h.header_size != sizeof(h) || h.total_size > size ||
+        h.total_size != sizeof(h) + h.weights_size) {
+        return SHARED_MODEL_ERR_FORMAT;
+    }
+
+    /* crc32 is computed with its own field zeroed */
+    const uint8_t *p = (const uint8_t *)bundle;
+    uint32_t at = offsetof(model_bundle_header_t, crc32);
+    uint32_t crc = model_bundle_crc32(0u, p, at);
+    crc = model_bundle_crc32(crc, zero, sizeof(zero));
+    crc = model_bundle_crc32(crc, p + at + sizeof(zero), h.total_size - at - sizeof(zero));
+    if (crc != h.crc32) return SHARED_MODEL_ERR_CRC;
+
+    if (strncmp(h.network_signature, target->network_signature, SHARED_MODEL_HASH_LEN) != 0 ||
+        h.weights_size != target->weights_size || h.window_frames != target->window_frames ||
+        h.num_axes != target->num_axes || h.num_classes != target->num_classes) {
+        return SHARED_MODEL_ERR_NETWORK;
+    }
+    if (h.in_scale != target->in_scale || h.in_zero_point != target->in_zero_point ||
+        h.out_scale != target->out_scale || h.out_zero_point != target->out_zero_point) {
+        return SHARED_MODEL_ERR_QUANT;
+    }
+    return SHARED_MODEL_OK;
+}
+
+/* Weights of a checked bundle */
+const uint8_t *model_bundle_weights(const void *bundle)
+{
+    return (const uint8_t *)bundle + sizeof(model_bundle_header_t);
+}
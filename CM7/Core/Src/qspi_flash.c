@@ -0,0 +1,166 @@
+#include "qspi_flash.h"
+#include "stm32h7xx_hal.h"
+
+/* W25Q256JV instructions */
+#define W25Q_ENABLE_RESET       0x66u
+#define W25Q_RESET              0x99u
+#define W25Q_WRITE_ENABLE       0x06u
+#define W25Q_READ_SR1           0x05u
+#define W25Q_READ_SR2           0x35u
+#define W25Q_WRITE_SR2          0x31u
+#define W25Q_FAST_READ_QUAD_4B  0xECu   /* 1-4-4, 4-byte address, mode byte + 4 dummy cycles */
+#define W25Q_SR1_BUSY           0x01u
+#define W25Q_SR2_QE             0x02u
+
+/* CCR line modes */
+#define QSPI_LINES_1            1u
+#define QSPI_LINES_4            3u
+#define QSPI_FMODE_WRITE        0u
+#define QSPI_FMODE_READ         1u
+#define QSPI_FMODE_MAPPED       3u
+
+#define QSPI_TIMEOUT_MS         100u
+
+static bool s_mapped;
+
+static bool qspi_wait(uint32_t flag)
+{
+    uint32_t t0 = HAL_GetTick();
+    while (!(QUADSPI->SR & flag)) {
+        if (HAL_GetTick() - t0 > QSPI_TIMEOUT_MS) return false;
+    }
+    return true;
+}
+
+/* One instruction on a single line, with `len` data bytes written (0-1) or read (1) */
+static bool qspi_command(uint8_t instruction, uint32_t fmode, uint32_t len, uint8_t *data)
+{
+    while (QUADSPI->SR & QUADSPI_SR_BUSY) {
+    }
+    if (len) QUADSPI->DLR = len - 1u;
+    QUADSPI->CCR = (fmode << QUADSPI_CCR_FMODE_Pos) |
+                   ((len ? QSPI_LINES_1 : 0u) << QUADSPI_CCR_DMODE_Pos) |
+                   (QSPI_LINES_1 << QUADSPI_CCR_IMODE_Pos) | instruction;
+    if (len && fmode == QSPI_FMODE_WRITE) {
+        if (!qspi_wait(QUADSPI_SR_FTF)) return false;
+        *(volatile uint8_t *)&QUADSPI->DR = *data;
+    }
+    if (len && fmode == QSPI_FMODE_READ) {
+        if (!qspi_wait(QUADSPI_SR_FTF | QUADSPI_SR_TCF)) return false;
+        *data = *(volatile uint8_t *)&QUADSPI->DR;
+    }
+    if (!qspi_wait(QUADSPI_SR_TCF)) return false;
+    QUADSPI->FCR = QUADSPI_FCR_CTCF;
+    return true;
+}
+
+static bool qspi_wait_ready(void)
+{
+    uint32_t t0 = HAL_GetTick();
+    uint8_t sr1;
+
+    do {
+        if (!qspi_command(W25Q_READ_SR1, QSPI_FMODE_READ, 1u, &sr1)) return false;
+        if (HAL_GetTick() - t0 > QSPI_TIMEOUT_MS) return false;
+    } while (sr1 & W25Q_SR1_BUSY);
+    return true;
+}
+
+static void qspi_gpio_init(void)
+{
+    GPIO_InitTypeDef gpio = {0};
+
+    __HAL_RCC_GPIOB_CLK_ENABLE();
+    __HAL_RCC_GPIOD_CLK_ENABLE();
+    __HAL_RCC_GPIOE_CLK_ENABLE();
+    gpio.Mode = GPIO_MODE_AF_PP;
+    gpio.Pull = GPIO_NOPULL;
+    gpio.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+
+    gpio.Pin = QSPI_FLASH_CLK_PIN;
+    gpio.Alternate = QSPI_FLASH_CLK_AF;
+    HAL_GPIO_Init(QSPI_FLASH_CLK_PORT, &gpio);
+    gpio.Pin = QSPI_FLASH_NCS_PIN;
+    gpio.Alternate = QSPI_FLASH_NCS_AF;
+    gpio.Pull = GPIO_PULLUP;
+    HAL_GPIO_Init(QSPI_FLASH_NCS_PORT, &gpio);
+    gpio.Pull = GPIO_NOPULL;
+    gpio.Alternate = QSPI_FLASH_IO_AF;
+    gpio.Pin = QSPI_FLASH_IO0_PIN;
+    HAL_GPIO_Init(QSPI_FLASH_IO0_PORT, &gpio);
+    gpio.Pin = QSPI_FLASH_IO1_PIN;
+    HAL_GPIO_Init(QSPI_FLASH_IO1_PORT, &gpio);
+    gpio.Pin = QSPI_FLASH_IO2_PIN;
+    HAL_GPIO_Init(QSPI_FLASH_IO2_PORT, &gpio);
+    gpio.Pin = QSPI_FLASH_IO3_PIN;
+    HAL_GPIO_Init(QSPI_FLASH_IO3_PORT, &gpio);
+}
+
+/* Reset the flash, make sure quad I/O is enabled and map it at QSPI_FLASH_BASE.
+ * Register level: the QSPI HAL module is not part of this project. */
+bool qspi_flash_init(void)
+{
+    if (s_mapped) return true;
+
+    qspi_gpio_init();
+    __HAL_RCC_QSPI_CLK_ENABLE();
+    __HAL_RCC_QSPI_FORCE_RESET();
+    __HAL_RCC_QSPI_RELEASE_RESET();
+
+    /* FSIZE: 2^(FSIZE + 1) bytes; chip select high for 3 cycles between commands */
+    QUADSPI->DCR = ((uint32_t)(31 - __builtin_clz(QSPI_FLASH_SIZE) - 1) << QUADSPI_DCR_FSIZE_Pos) |
+                   (2u << QUADSPI_DCR_CSHT_Pos);
+    QUADSPI->CR = (QSPI_FLASH_PRESCALER << QUADSPI_CR_PRESCALER_Pos) | QUADSPI_CR_SSHIFT |
+                  (3u << QUADSPI_CR_FTHRES_Pos) | QUADSPI_CR_EN;
+
+    uint8_t sr2 = 0;
+    if (!qspi_command(W25Q_ENABLE_RESET, QSPI_FMODE_WRITE, 0u, NULL) ||
+        !qspi_command(W25Q_RESET, QSPI_FMODE_WRITE, 0u, NULL)) {
+        return false;
+    }
+    HAL_Delay(1);   /* tRST 30 us */
+    if (!qspi_wait_ready() || !qspi_command(W25Q_READ_SR2, QSPI_FMODE_READ, 1u, &sr2)) return false;
+    if (!(sr2 & W25Q_SR2_QE)) {
+        sr2 |= W25Q_SR2_QE;
+        if (!qspi_command(W25Q_WRITE_ENABLE, QSPI_FMODE_WRITE, 0u, NULL) ||
+            !qspi_command(W25Q_WRITE_SR2, QSPI_FMODE_WRITE, 1u, &sr2) || !qspi_wait_ready()) {
+            return false;
+        }
+    }
+
+    /* Memory-mapped 1-4-4 reads: mode byte 0xFF (no continuous read), 4 dummy cycles */
+    while (QUADSPI->SR & QUADSPI_SR_BUSY) {
+    }
+    QUADSPI->ABR = 0xFFu;
+    QUADSPI->CCR = (QSPI_FMODE_MAPPED << QUADSPI_CCR_FMODE_Pos) | (QSPI_LINES_4 << QUADSPI_CCR_DMODE_Pos) |
+                   (4u << QUADSPI_CCR_DCYC_Pos) | (0u << QUADSPI_CCR_ABSIZE_Pos) |
+                   (QSPI_LINES_4 << QUADSPI_CCR_ABMODE_Pos) | (3u << QUADSPI_CCR_ADSIZE_Pos) |
+                   (QSPI_LINES_4 << QUADSPI_CCR_ADMODE_Pos) | (QSPI_LINES_1 << QUADSPI_CCR_IMODE_Pos) |
+                   W25Q_FAST_READ_QUAD_4B;
+
+    /* MPU_Config() denies 0x60000000-0xDFFFFFFF: open the mapped flash read-only,
+     * cacheable (write-through), not executable */
+    MPU_Region_InitTypeDef mpu = {0};
+    HAL_MPU_Disable();
+    mpu.Enable = MPU_REGION_ENABLE;
+    mpu.Number = QSPI_FLASH_MPU_REGION;
+    mpu.BaseAddress = QSPI_FLASH_BASE;
+    mpu.Size = MPU_REGION_SIZE_32MB;
+    mpu.SubRegionDisable = 0x00;
+    mpu.TypeExtField = MPU_TEX_LEVEL0;
+    mpu.AccessPermission = MPU_REGION_PRIV_RO_URO;
+    mpu.DisableExec = MPU_INSTRUCTION_ACCESS_DISABLE;
+    mpu.IsShareable = MPU_ACCESS_NOT_SHAREABLE;
+    mpu.IsCacheable = MPU_ACCESS_CACHEABLE;
+    mpu.IsBufferable = MPU_ACCESS_NOT_BUFFERABLE;
+    HAL_MPU_ConfigRegion(&mpu);
+    HAL_MPU_Enable(MPU_PRIVILEGED_DEFAULT);
+
+    s_mapped = true;
+    return true;
+}
+
+bool qspi_flash_mapped(void)
+{
+    return s_mapped;
+}
@@ -0,0 +1,70 @@
+#ifndef __AI_ENGINE_H
+#define __AI_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "model_params.h"
+
+#if MODEL_ENGINE_SUPPORTED
+
+/* Open int8 engine for conv -> maxpool -> conv -> maxpool -> conv -> mean -> dense -> dense
+ * -> softmax, in TFLite int8 reference arithmetic over the X-CUBE-AI weights blob
+ * (layer constants generated into model_params.h).
+ *
+ * Streaming: every activation is kept per layer as [column][channel]. When the window
+ * advanced by `shift` frames, a conv column whose receptive field lies inside the part
+ * the previous window also covered, away from the zero padding, is moved instead of
+ * recomputed; the GAP keeps running sums of the last conv. Results are bit-identical to
+ * a full window. Reuse needs shift to be a multiple of the layer's stride in frames
+ * (1, 2 and 4 for the three convs here). */
+#define AI_ENGINE_FRAMES    MODEL_WINDOW_FRAMES
+#define AI_ENGINE_C1_LEN    AI_ENGINE_FRAMES
+#define AI_ENGINE_P1_LEN    (AI_ENGINE_C1_LEN / MODEL_POOL1_SIZE)
+#define AI_ENGINE_C2_LEN    AI_ENGINE_P1_LEN
+#define AI_ENGINE_P2_LEN    (AI_ENGINE_C2_LEN / MODEL_POOL2_SIZE)
+#define AI_ENGINE_C3_LEN    AI_ENGINE_P2_LEN
+
+/* Bytes of a weighted layer's block in the blob: weights, then int32 biases */
+#define AI_ENGINE_CONV_BYTES(n_)  (MODEL_CONV##n_##_B_OFFSET - MODEL_CONV##n_##_W_OFFSET + 4u * MODEL_CONV##n_##_OUT_CH)
+#define AI_ENGINE_FC_BYTES(n_)    (MODEL_FC##n_##_B_OFFSET - MODEL_FC##n_##_W_OFFSET + 4u * MODEL_FC##n_##_OUT_CH)
+#define AI_ENGINE_MAX(a_, b_)     ((a_) > (b_) ? (a_) : (b_))
+#define AI_ENGINE_STAGE_BYTES     AI_ENGINE_MAX(AI_ENGINE_MAX(AI_ENGINE_MAX(AI_ENGINE_CONV_BYTES(1), \
+                                  AI_ENGINE_CONV_BYTES(2)), AI_ENGINE_MAX(AI_ENGINE_CONV_BYTES(3),   \
+                                  AI_ENGINE_FC_BYTES(1))), AI_ENGINE_FC_BYTES(2))
+
+/* Weights behind a slow bus (e.g. memory-mapped QSPI): the engine computes each weighted
+ * layer from a staging buffer while `start` copies the next layer's block into the other
+ * one. `start` begins one copy, `wait` returns once it has landed; one copy at a time.
+ * Either returns false when the copy failed (nothing left in flight): the run stops there.
+ * The staging buffers take AI_ENGINE_STAGE_BYTES each, fast memory (TCM) preferably. */
+typedef struct {
+    bool (*start)(void *ctx, void *dst, const void *src, uint32_t len);
+    bool (*wait)(void *ctx);
+    void *ctx;
+    uint8_t *stage[2];
+} ai_engine_fetch_t;
+
+typedef struct {
+    int8_t c1[AI_ENGINE_C1_LEN * MODEL_CONV1_OUT_CH];
+    int8_t p1[AI_ENGINE_P1_LEN * MODEL_CONV1_OUT_CH];
+    int8_t c2[AI_ENGINE_C2_LEN * MODEL_CONV2_OUT_CH];
+    int8_t p2[AI_ENGINE_P2_LEN * MODEL_CONV2_OUT_CH];
+    int8_t c3[AI_ENGINE_C3_LEN * MODEL_CONV3_OUT_CH];
+    int32_t gap_sum[MODEL_CONV3_OUT_CH];     /* sum of c3 over the window, per channel */
+    int8_t gap[MODEL_CONV3_OUT_CH];
+    int8_t fc1[MODEL_FC1_OUT_CH];
+    int8_t fc2[MODEL_FC2_OUT_CH];
+    int8_t out[MODEL_NUM_CLASSES];           /* int8 softmax, MODEL_OUT_SCALE / ZERO_POINT */
+    const uint8_t *weights;
+    const ai_engine_fetch_t *fetch;          /* NULL: weights read in place */
+    bool primed;                             /* activations hold the previous window */
+} ai_engine_t;
+
+void ai_engine_init(ai_engine_t *e, const void *weights);
+void ai_engine_set_fetch(ai_engine_t *e, const ai_engine_fetch_t *fetch);
+void ai_engine_reset(ai_engine_t *e);
+bool ai_engine_run(ai_engine_t *e, const int8_t *in, uint32_t shift);
+
+#endif /* MODEL_ENGINE_SUPPORTED */
+
+#endif /* __AI_ENGINE_H */
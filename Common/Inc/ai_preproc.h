@@ -0,0 +1,47 @@
+#ifndef __AI_PREPROC_H
+#define __AI_PREPROC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "model_params.h"
+
+#define AI_PREPROC_AXES     3u
+
+#if MODEL_PRECISION == MODEL_PRECISION_FLOAT32
+/* Network input element of the precision built in (MODEL_PRECISION) */
+typedef float ai_input_t;
+
+/* z-score normalize in float: y = x * mult + offset */
+typedef struct {
+    float mult;         /* 1 / std */
+    float offset;       /* -mean / std */
+    uint32_t shift;     /* unused: same layout as the fixed-point fold */
+} ai_preproc_axis_t;
+#else
+#if MODEL_PRECISION == MODEL_PRECISION_INT16X8
+typedef int16_t ai_input_t;
+#else
+typedef int8_t ai_input_t;
+#endif
+
+/* z-score normalize + quantize folded into q = sat((x * mult + offset) >> shift), sat8
+ * or sat16 by precision, with a 64-bit accumulator: bit-exact with
+ * ai_preproc_reference() for every int16 input. */
+typedef struct {
+    int64_t mult;       /* round(2^shift / (std * scale)), <= 2^46 */
+    int64_t offset;     /* round((zp - mean / (std * scale)) * 2^shift) + rounding half */
+    uint32_t shift;
+} ai_preproc_axis_t;
+#endif
+
+typedef struct {
+    ai_preproc_axis_t axis[AI_PREPROC_AXES];
+} ai_preproc_t;
+
+bool ai_preproc_init(ai_preproc_t *pp, const float mean[AI_PREPROC_AXES], const float std[AI_PREPROC_AXES],
+                     float scale, int32_t zero_point);
+void ai_preproc_window(const ai_preproc_t *pp, const int16_t *const axis[AI_PREPROC_AXES],
+                       uint32_t frames, ai_input_t *out);
+ai_input_t ai_preproc_reference(int16_t x, float mean, float std, float scale, int32_t zero_point);
+
+#endif /* __AI_PREPROC_H */
@@ -0,0 +1,176 @@
+/* Generated by python_ai_pipeline/export_model_params.py - do not edit.
+ * Regenerate after training; the CM7 build checks MODEL_PARAMS_HASH against the network. */
+#ifndef __MODEL_PARAMS_H
+#define __MODEL_PARAMS_H
+
+/* Precision of the network built in: -DMODEL_PRECISION=<one of these> for CM7 and CM4,
+ * with X-CUBE-AI/App generated from the matching .tflite */
+#define MODEL_PRECISION_INT8       0   /* int8 weights and activations */
+#define MODEL_PRECISION_INT16X8    1   /* int8 weights, int16 activations */
+#define MODEL_PRECISION_FLOAT32    2
+#ifndef MODEL_PRECISION
+#define MODEL_PRECISION            MODEL_PRECISION_INT8
+#endif
+
+#define MODEL_WINDOW_FRAMES        60
+#define MODEL_NUM_AXES             3
+#define MODEL_NUM_CLASSES          4
+
+/* z-score normalization per axis (mg) */
+#define MODEL_MEAN_X               (-1.0858362913131714f)
+#define MODEL_MEAN_Y               (-0.2939590513706207f)
+#define MODEL_MEAN_Z               1002.42236328125f
+#define MODEL_STD_X                126.47188568115234f
+#define MODEL_STD_Y                109.08601379394531f
+#define MODEL_STD_Z                151.05593872070312f
+
+#define MODEL_LABELS { "normal", "imbalance", "bearing fault", "misalignment" }
+
+#if MODEL_PRECISION == MODEL_PRECISION_INT8
+#define MODEL_PARAMS_HASH          "ffa8546049c20e4326a03650d45f6a27"   /* md5 of motor_cnn_int8.tflite */
+
+/* int8 input/output quantization: real = (q - zero_point) * scale */
+#define MODEL_IN_SCALE             0.025338666513562202f
+#define MODEL_IN_ZERO_POINT        (12)
+#define MODEL_OUT_SCALE            0.00390625f
+#define MODEL_OUT_ZERO_POINT       (-128)
+
+/* Normalize + quantize folded for ai_preproc_t: { mult, offset, shift } per axis (sat8) */
+#define MODEL_PREPROC_INIT { { \
+    { 43916937413594, 1806905208888610, 47u }, \
+    { 50916315436459, 1774185916226589, 47u }, \
+    { 36769543356439, -35099393943691968, 47u }, \
+} }
+
+/* Open int8 engine (ai_engine.c): TFLite int8 reference arithmetic.
+ * *_W_OFFSET / *_B_OFFSET are bytes into the X-CUBE-AI weights blob (OHWI int8 / int32);
+ * *_REQUANT is { Q31 multiplier, shift (left if > 0) } per output channel. */
+#define MODEL_ENGINE_SUPPORTED     1
+#define MODEL_CONV1_IN_CH          3
+#define MODEL_CONV1_OUT_CH         32
+#define MODEL_CONV1_KERNEL         9
+#define MODEL_CONV1_W_OFFSET       0
+#define MODEL_CONV1_B_OFFSET       864
+#define MODEL_CONV1_ACT_MIN        (-128)
+#define MODEL_CONV1_ACT_MAX        127
+#define MODEL_CONV1_IN_ZP          12
+#define MODEL_CONV1_OUT_ZP         (-128)
+#define MODEL_CONV1_REQUANT { \
+    { 1773249193, -8 }, { 1799470743, -8 }, { 1640564658, -8 }, { 1649176640, -8 }, \
+    { 1793432437, -8 }, { 1577433875, -8 }, { 1800282128, -8 }, { 1710567575, -8 }, \
+    { 1670384238, -8 }, { 1705566336, -8 }, { 1669957515, -8 }, { 1628522102, -8 }, \
+    { 1633858097, -8 }, { 1696338831, -8 }, { 1512796771, -8 }, { 1710473411, -8 }, \
+    { 1565575882, -8 }, { 1773059138, -8 }, { 1775851903, -8 }, { 1670477147, -8 }, \
+    { 1648579322, -8 }, { 1709654335, -8 }, { 1605945351, -8 }, { 1599049676, -8 }, \
+    { 1777033355, -8 }, { 1724779841, -8 }, { 1712958101, -8 }, { 1775698415, -8 }, \
+    { 1527512347, -8 }, { 1641365528, -8 }, { 1554232812, -8 }, { 1724879655, -8 }, \
+}
+#define MODEL_POOL1_SIZE           2
+#define MODEL_CONV2_IN_CH          32
+#define MODEL_CONV2_OUT_CH         64
+#define MODEL_CONV2_KERNEL         7
+#define MODEL_CONV2_W_OFFSET       992
+#define MODEL_CONV2_B_OFFSET       15328
+#define MODEL_CONV2_ACT_MIN        (-128)
+#define MODEL_CONV2_ACT_MAX        127
+#define MODEL_CONV2_IN_ZP          (-128)
+#define MODEL_CONV2_OUT_ZP         (-128)
+#define MODEL_CONV2_REQUANT { \
+    { 2100106263, -11 }, { 1243439792, -10 }, { 1370829194, -10 }, { 1211957558, -10 }, \
+    { 1181084718, -10 }, { 1106825536, -10 }, { 1229633751, -10 }, { 1080100801, -10 }, \
+    { 1203873774, -10 }, { 1154709328, -10 }, { 1396339868, -10 }, { 1107468530, -10 }, \
+    { 1236787447, -10 }, { 1211198218, -10 }, { 1172354129, -10 }, { 1243112314, -10 }, \
+    { 1225881317, -10 }, { 1212068038, -10 }, { 2104519521, -11 }, { 1221868454, -10 }, \
+    { 1204300684, -10 }, { 1222921519, -10 }, { 1244546268, -10 }, { 1259523396, -10 }, \
+    { 1096597677, -10 }, { 1192534333, -10 }, { 1215287426, -10 }, { 1188868149, -10 }, \
+    { 1227212715, -10 }, { 1146725356, -10 }, { 1226026236, -10 }, { 1301824595, -10 }, \
+    { 1182928134, -10 }, { 1243301044, -10 }, { 1253378650, -10 }, { 1141838787, -10 }, \
+    { 1436697076, -10 }, { 1162768807, -10 }, { 1196118610, -10 }, { 1253037457, -10 }, \
+    { 1087956463, -10 }, { 1271982113, -10 }, { 1168697546, -10 }, { 1213442333, -10 }, \
+    { 1091224691, -10 }, { 1265703648, -10 }, { 1201382716, -10 }, { 1094066923, -10 }, \
+    { 2004936033, -11 }, { 1123883651, -10 }, { 1289491825, -10 }, { 1287582120, -10 }, \
+    { 1211709778, -10 }, { 1269112528, -10 }, { 1206370698, -10 }, { 1143631154, -10 }, \
+    { 1197051594, -10 }, { 1237609875, -10 }, { 1189414530, -10 }, { 1203588583, -10 }, \
+    { 1217030115, -10 }, { 1169472963, -10 }, { 1219796382, -10 }, { 1113395440, -10 }, \
+}
+#define MODEL_POOL2_SIZE           2
+#define MODEL_CONV3_IN_CH          64
+#define MODEL_CONV3_OUT_CH         64
+#define MODEL_CONV3_KERNEL         5
+#define MODEL_CONV3_W_OFFSET       15584
+#define MODEL_CONV3_B_OFFSET       36064
+#define MODEL_CONV3_ACT_MIN        (-128)
+#define MODEL_CONV3_ACT_MAX        127
+#define MODEL_CONV3_IN_ZP          (-128)
+#define MODEL_CONV3_OUT_ZP         (-128)
+#define MODEL_CONV3_REQUANT { \
+    { 1226159859, -11 }, { 1202644807, -11 }, { 1325942058, -11 }, { 1292132863, -11 }, \
+    { 2061920920, -12 }, { 1190602938, -11 }, { 1239753786, -11 }, { 1247158553, -11 }, \
+    { 1249084077, -11 }, { 1333611871, -11 }, { 1174403077, -11 }, { 1153581431, -11 }, \
+    { 1359288136, -11 }, { 1127348945, -11 }, { 1230887362, -11 }, { 1281784510, -11 }, \
+    { 1247532470, -11 }, { 1152847937, -11 }, { 1150038676, -11 }, { 1096168059, -11 }, \
+    { 1193962338, -11 }, { 1259742902, -11 }, { 1233563425, -11 }, { 2060046677, -12 }, \
+    { 1347905729, -11 }, { 1105146508, -11 }, { 1258584959, -11 }, { 1243921839, -11 }, \
+    { 1190758962, -11 }, { 1256297531, -11 }, { 1260166525, -11 }, { 1315143653, -11 }, \
+    { 1181293520, -11 }, { 1303800889, -11 }, { 2144284422, -12 }, { 2121988580, -12 }, \
+    { 1216924248, -11 }, { 1303591556, -11 }, { 2090730283, -12 }, { 1374152932, -11 }, \
+    { 1280097226, -11 }, { 1381774841, -11 }, { 1085188176, -11 }, { 1336576931, -11 }, \
+    { 1316590968, -11 }, { 1258508299, -11 }, { 1391081181, -11 }, { 1960629836, -12 }, \
+    { 1203087426, -11 }, { 1420577561, -11 }, { 1269266084, -11 }, { 1199422434, -11 }, \
+    { 1271378192, -11 }, { 1361634656, -11 }, { 1311915048, -11 }, { 1213536241, -11 }, \
+    { 2138757051, -12 }, { 1261987308, -11 }, { 1268328737, -11 }, { 1329189734, -11 }, \
+    { 1309383972, -11 }, { 1256811254, -11 }, { 1187798707, -11 }, { 1080643502, -11 }, \
+}
+#define MODEL_GAP_IN_ZP            (-128)
+#define MODEL_GAP_OUT_ZP           (-128)
+#define MODEL_GAP_MULT             846730124
+#define MODEL_GAP_SHIFT            (-2)
+#define MODEL_FC1_IN_CH            64
+#define MODEL_FC1_OUT_CH           64
+#define MODEL_FC1_W_OFFSET         36320
+#define MODEL_FC1_B_OFFSET         40416
+#define MODEL_FC1_ACT_MIN          (-128)
+#define MODEL_FC1_ACT_MAX          127
+#define MODEL_FC1_IN_ZP            (-128)
+#define MODEL_FC1_OUT_ZP           (-128)
+#define MODEL_FC1_REQUANT { \
+    { 1408146028, -9 }, { 1370215950, -9 }, { 1580642673, -9 }, { 1394379071, -9 }, \
+    { 1463587346, -9 }, { 1477795329, -9 }, { 1346593566, -9 }, { 1598482977, -9 }, \
+    { 1456683944, -9 }, { 1556603862, -9 }, { 1339844313, -9 }, { 1434535328, -9 }, \
+    { 1490163253, -9 }, { 1317388990, -9 }, { 1359708102, -9 }, { 1546533954, -9 }, \
+    { 1580189019, -9 }, { 1476041324, -9 }, { 1488232276, -9 }, { 1583910854, -9 }, \
+    { 1398168908, -9 }, { 1472603560, -9 }, { 1540018076, -9 }, { 1387083189, -9 }, \
+    { 1422619562, -9 }, { 1557810863, -9 }, { 1497432477, -9 }, { 1363032592, -9 }, \
+    { 1398996242, -9 }, { 1341680163, -9 }, { 1443588209, -9 }, { 1303718751, -9 }, \
+    { 1475471777, -9 }, { 1542945222, -9 }, { 1563048559, -9 }, { 1523601405, -9 }, \
+    { 1373839104, -9 }, { 1596796131, -9 }, { 1357498759, -9 }, { 1400441295, -9 }, \
+    { 1444834870, -9 }, { 1493102278, -9 }, { 1494894165, -9 }, { 1369617313, -9 }, \
+    { 1397545297, -9 }, { 1481077821, -9 }, { 1406373315, -9 }, { 1535366390, -9 }, \
+    { 1487459661, -9 }, { 1465250994, -9 }, { 1440253430, -9 }, { 1552440813, -9 }, \
+    { 1602839928, -9 }, { 1483977467, -9 }, { 1350058268, -9 }, { 1539357612, -9 }, \
+    { 1385988713, -9 }, { 1400644457, -9 }, { 1300380697, -9 }, { 1397308555, -9 }, \
+    { 1492187860, -9 }, { 1392518808, -9 }, { 1441477174, -9 }, { 1420814018, -9 }, \
+}
+#define MODEL_FC2_IN_CH            64
+#define MODEL_FC2_OUT_CH           4
+#define MODEL_FC2_W_OFFSET         40672
+#define MODEL_FC2_B_OFFSET         40928
+#define MODEL_FC2_ACT_MIN          (-128)
+#define MODEL_FC2_ACT_MAX          127
+#define MODEL_FC2_IN_ZP            (-128)
+#define MODEL_FC2_OUT_ZP           34
+#define MODEL_FC2_REQUANT { \
+    { 1078294626, -9 }, { 1092658507, -9 }, { 2113410046, -10 }, { 1083167563, -9 }, \
+}
+#define MODEL_SOFTMAX_MULT         1227085696
+#define MODEL_SOFTMAX_SHIFT        24
+#define MODEL_SOFTMAX_DIFF_MIN     (-124)
+#elif MODEL_PRECISION == MODEL_PRECISION_INT16X8
+#error "model_params.h was generated without the int16x8 variant (models/motor_cnn_int16x8.tflite)"
+#elif MODEL_PRECISION == MODEL_PRECISION_FLOAT32
+#error "model_params.h was generated without the float32 variant (models/motor_cnn_fp32.tflite)"
+#else
+#error "MODEL_PRECISION: unknown precision"
+#endif
+
+#endif /* __MODEL_PARAMS_H */
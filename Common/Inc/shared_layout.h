@@ -0,0 +1,346 @@
+#ifndef __SHARED_LAYOUT_H
+#define __SHARED_LAYOUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#define SHARED_FRAMES_COUNT 256u
+#define SHARED_FRAME_PERIOD_MS 100u /* AcquisitionTask period */
+#define SHARED_AI_NUM_CLASSES 4u
+#define SHARED_AI_MAX_CHANNELS 4u  /* input channels (motors) CM7 can be built for, see AI_CHANNELS */
+
+/* CM7 inference defaults, used until CM4 publishes a configuration */
+#define SHARED_AI_DEFAULT_HOP        60u   /* fresh frames per inference */
+#define SHARED_AI_DEFAULT_PERIOD_MS  20u   /* AiTask loop period */
+#define SHARED_AI_DEFAULT_THRESH_PCT 0u    /* min fault score, 0 = plain argmax */
+
+/* Frames the CM4 energy gate looks back over; at least the CM7 inference window */
+#define SHARED_GATE_WINDOW_FRAMES    60u
+
+/* sensor_frame_t.flags */
+#define SHARED_FRAME_QUIET           0x0001u  /* energy gate: the window ending here is quiet */
+#define SHARED_FRAME_CHANNEL_SHIFT   8u
+#define SHARED_FRAME_CHANNEL_MASK    0x0F00u  /* input channel (motor) the frame belongs to */
+#define SHARED_FRAME_CHANNEL(flags_) (((flags_) & SHARED_FRAME_CHANNEL_MASK) >> SHARED_FRAME_CHANNEL_SHIFT)
+#define SHARED_FRAME_FLAGS_CHANNEL(ch_) ((uint16_t)(((uint32_t)(ch_) << SHARED_FRAME_CHANNEL_SHIFT) & SHARED_FRAME_CHANNEL_MASK))
+
+typedef struct {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+    uint16_t flags; /* SHARED_FRAME_* (fills the padding before ts) */
+    uint32_t ts; /* timestamp ms */
+} sensor_frame_t;
+
+/* Frame ring: CM4 pushes (shared_push_frame), CM7 pops */
+
+typedef struct {
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    sensor_frame_t frames[SHARED_FRAMES_COUNT];
+} shared_ring_t;
+
+/* Latest inference result of one channel, published by CM7 (seqlock: seq is odd while CM7 writes) */
+typedef struct {
+    volatile uint32_t seq;
+    uint32_t window_end_ts;  /* timestamp of the newest frame in the window */
+    uint8_t class_id;        /* most probable class of this window */
+    uint8_t channel;
+    int8_t scores[SHARED_AI_NUM_CLASSES];
+    uint8_t state;           /* class the decision stage reports (see shared_ai_event_t) */
+    uint8_t rsvd;
+} shared_ai_result_t;
+
+/* Inference tuning written by CM4 (USB SET commands), read by CM7 (seqlock) */
+typedef struct {
+    volatile uint32_t seq;
+    uint16_t hop_frames;       /* fresh frames required before the next inference */
+    uint16_t period_ms;        /* AiTask loop period */
+    uint8_t  fault_thresh_pct; /* a fault class wins only above this score */
+    uint16_t channel_hop[SHARED_AI_MAX_CHANNELS]; /* per channel, 0 = hop_frames */
+    uint8_t  ema_shift;        /* score average: each window weighs 1/2^ema_shift, 0 = none */
+    uint8_t  enter_pct[SHARED_AI_NUM_CLASSES]; /* per fault class, 0 = fault_thresh_pct */
+    uint8_t  exit_pct[SHARED_AI_NUM_CLASSES];  /* per fault class, 0 = its enter threshold */
+    uint16_t enter_dwell_ms;   /* a fault must persist this long before it is reported */
+    uint16_t exit_dwell_ms;    /* and normal this long before the fault clears */
+} shared_ai_config_t;
+
+/* Inference timing published by CM7 (seqlock) */
+typedef struct {
+    volatile uint32_t seq;
+    uint32_t infer_count;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint32_t avg_us;
+    uint32_t gated_count;    /* windows skipped on SHARED_FRAME_QUIET, last decision kept */
+} shared_ai_perf_t;
+
+/* Memory placements of the CM7 network buffers (AI_*_PLACEMENT in CM7 ai_infer.h) */
+#define SHARED_AI_PLACE_FLASH  0u
+#define SHARED_AI_PLACE_AXI    1u   /* AXI SRAM (RAM_D1), cached */
+#define SHARED_AI_PLACE_DTCM   2u
+#define SHARED_AI_PLACE_QSPI   3u   /* external QSPI flash, memory-mapped (weights only) */
+#define SHARED_AI_BENCH_MAX    8u
+
+/* ai_motor_anomalie_run() cycles for one activations/weights placement */
+typedef struct {
+    uint8_t  acts_place;
+    uint8_t  weights_place;
+    uint16_t runs;
+    uint32_t min_cycles;
+    uint32_t avg_cycles;
+    uint32_t max_cycles;
+} shared_ai_bench_entry_t;
+
+/* Placement benchmark published once by CM7 when built with AI_PLACEMENT_BENCH (seqlock) */
+typedef struct {
+    volatile uint32_t seq;
+    uint32_t core_hz;
+    uint32_t count;
+    shared_ai_bench_entry_t entry[SHARED_AI_BENCH_MAX];
+} shared_ai_bench_t;
+
+#define SHARED_AI_PROFILE_MAX_LAYERS 16u
+
+/* Cycles spent in one c-layer (c_id/id as in motor_anomalie_generate_report.txt) */
+typedef struct {
+    uint16_t c_id;     /* execution order */
+    uint16_t m_id;     /* model layer id */
+    uint16_t type;     /* runtime node type */
+    uint16_t rsvd;
+    uint32_t min_cycles;
+    uint32_t avg_cycles;
+    uint32_t max_cycles;
+} shared_ai_layer_prof_t;
+
+/* Per-layer profile published after every inference when CM7 is built with AI_PROFILING (seqlock) */
+typedef struct {
+    volatile uint32_t seq;
+    uint32_t core_hz;
+    uint32_t runs;
+    uint32_t count;
+    shared_ai_layer_prof_t layer[SHARED_AI_PROFILE_MAX_LAYERS];
+} shared_ai_profile_t;
+
+/* min/avg/max CPU cycles of one kind of inference run */
+typedef struct {
+    uint32_t min_cycles;
+    uint32_t avg_cycles;
+    uint32_t max_cycles;
+} shared_ai_cycles_t;
+
+/* Open engine vs X-CUBE-AI runtime on the same windows, published once by CM7 when
+ * built with AI_ENGINE_BENCH (seqlock) */
+typedef struct {
+    volatile uint32_t seq;
+    uint32_t core_hz;
+    uint16_t windows;
+    uint16_t hop;                   /* frames between windows of the streaming runs */
+    uint16_t mismatches;            /* windows whose engine scores differ from the runtime's */
+    uint16_t max_diff;              /* largest score difference, int8 LSB */
+    shared_ai_cycles_t runtime;     /* ai_motor_anomalie_run() */
+    shared_ai_cycles_t engine;      /* ai_engine.c, full window */
+    shared_ai_cycles_t streaming;   /* ai_engine.c, window advanced by hop */
+    shared_ai_cycles_t stall;       /* per engine run, waiting for weights (AI_PLACE_QSPI) */
+} shared_ai_engine_bench_t;
+
+/* Scheduler counters of one CM7 input channel (motor) */
+typedef struct {
+    uint32_t windows;          /* inferences run */
+    uint32_t gated;            /* windows answered with the last decision (energy gate) */
+    uint32_t late;             /* inferences started after the channel's next window was due */
+    uint16_t hop;              /* hop in use */
+    uint16_t wps_x100;         /* windows (run + gated) per second over the last period, x100 */
+    uint8_t  last_class;
+    uint8_t  state;            /* class the decision stage reports */
+    uint8_t  rsvd[2];
+} shared_ai_channel_stats_t;
+
+/* CM7 multi-channel scheduler, published every SHARED_AI_SCHED_PERIOD_MS (seqlock) */
+#define SHARED_AI_SCHED_PERIOD_MS    1000u
+#define SHARED_AI_SCHED_ROUND_ROBIN  0u
+#define SHARED_AI_SCHED_DEADLINE     1u
+
+typedef struct {
+    volatile uint32_t seq;
+    uint8_t  policy;           /* SHARED_AI_SCHED_* */
+    uint8_t  channels;
+    uint16_t util_permille;    /* CM7 time in preprocessing + inference over the last period */
+    uint32_t dropped_frames;   /* frames for a channel CM7 was not built for */
+    uint32_t offloaded;        /* windows CM4 ran for CM7 (AI_OFFLOAD), counted in ch[].windows */
+    uint16_t cm4_util_permille; /* CM4 time running them over the last period */
+    uint16_t rsvd;
+    shared_ai_channel_stats_t ch[SHARED_AI_MAX_CHANNELS];
+} shared_ai_sched_t;
+
+/* Model hot-swap: CM4 stages a bundle (MODEL commands), CM7 checks it and switches the
+ * network to its weights between two inferences (see CM7 model_bundle.h) */
+#define SHARED_MODEL_STAGE_SIZE      (48u * 1024u)
+#define SHARED_MODEL_HASH_LEN        32u   /* md5, hex */
+#define SHARED_MODEL_LABEL_LEN       16u
+#define SHARED_MODEL_SRC_STAGE       0u    /* shared_model_stage.data */
+#define SHARED_MODEL_SRC_FLASH       1u    /* CM7 flash bundle slot */
+
+/* shared_model_status_t.status */
+#define SHARED_MODEL_OK              0u
+#define SHARED_MODEL_ERR_FORMAT      1u    /* magic, version or sizes */
+#define SHARED_MODEL_ERR_CRC         2u
+#define SHARED_MODEL_ERR_NETWORK     3u    /* weights for another network, window or class count */
+#define SHARED_MODEL_ERR_QUANT       4u    /* I/O quantization differs from the compiled network */
+#define SHARED_MODEL_ERR_OPEN        5u    /* runtime refused the weights, previous model kept */
+
+/* Written by CM4 only while no request is pending (request == status.request) */
+typedef struct {
+    volatile uint32_t request;     /* CM4 increments it to have CM7 load a bundle */
+    uint32_t source;               /* SHARED_MODEL_SRC_* */
+    uint32_t size;                 /* bytes in data */
+    uint32_t rsvd[5];              /* data 32-byte aligned */
+    uint8_t data[SHARED_MODEL_STAGE_SIZE];
+} shared_model_stage_t;
+
+/* Model in use and outcome of the last request, published by CM7 (seqlock) */
+typedef struct {
+    volatile uint32_t seq;
+    uint32_t request;              /* last request handled */
+    uint8_t  status;               /* SHARED_MODEL_* of that request */
+    uint8_t  slot;                 /* weights in use: 0 built-in, 1-2 hot-swap slots */
+    uint16_t rsvd;
+    uint32_t swaps;
+    uint32_t swap_us;              /* last switch: check, copy and reopen */
+    char hash[SHARED_MODEL_HASH_LEN + 1];
+    char labels[SHARED_AI_NUM_CLASSES][SHARED_MODEL_LABEL_LEN];
+} shared_model_status_t;
+
+/* Windows CM7 hands to CM4 while it has more complete windows than it serves itself
+ * (CM7 AI_OFFLOAD). CM7 fills the job of an idle slot (request == done) and bumps its
+ * request; CM4 (ai_offload.c) normalizes the raw window, runs the open engine on the
+ * weights at `weights` and sets done = request. Nothing here is zeroed at boot: CM7 starts
+ * a new session, and CM4 marks every slot done before echoing it in cm4_session.
+ * What each core writes is on its own 32-byte lines. */
+#define SHARED_OFFLOAD_SLOTS   2u
+#define SHARED_OFFLOAD_FRAMES  64u    /* window capacity */
+
+/* One axis of the CM7 preprocessing: q = sat8((x * mult + offset) >> shift) */
+typedef struct {
+    int64_t  mult;
+    int64_t  offset;
+    uint32_t shift;
+    uint32_t rsvd;
+} shared_offload_preproc_t;
+
+typedef struct {
+    volatile uint32_t request;     /* bumped by CM7 once the job is written */
+    uint32_t weights;              /* X-CUBE-AI weights blob, at an address CM4 can read */
+    uint16_t frames;
+    uint8_t  channel;
+    uint8_t  rsvd0;
+    uint32_t rsvd1;                /* 8-byte aligned preproc */
+    shared_offload_preproc_t preproc[3];
+    int16_t  axis[3][SHARED_OFFLOAD_FRAMES];   /* oldest frame first */
+    uint32_t rsvd[2];              /* 32-byte multiple */
+} shared_offload_job_t;
+
+typedef struct {
+    volatile uint32_t done;        /* request of the last job CM4 finished */
+    uint8_t  ok;                   /* 0: CM4 could not run it */
+    uint8_t  rsvd0[3];
+    uint32_t cycles;               /* CM4 cycles, preprocessing + network */
+    int8_t   scores[SHARED_AI_NUM_CLASSES];
+    uint32_t rsvd[4];              /* one 32-byte line */
+} shared_offload_result_t;
+
+typedef struct {
+    volatile uint32_t session;     /* CM7: new value at every CM7 boot */
+    uint32_t rsvd0[7];
+    volatile uint32_t cm4_session; /* CM4: session its slots are synced to */
+    uint32_t cm4_hz;               /* CM4 core clock */
+    uint32_t rsvd1[6];
+    shared_offload_job_t job[SHARED_OFFLOAD_SLOTS];
+    shared_offload_result_t result[SHARED_OFFLOAD_SLOTS];
+} shared_offload_t;
+
+/* CM7 alone vs CM7 + CM4 on the same synthetic windows, published once by CM7 when
+ * built with AI_OFFLOAD_BENCH (seqlock) */
+typedef struct {
+    volatile uint32_t seq;
+    uint32_t core_hz;
+    uint16_t windows;
+    uint16_t cm4_windows;          /* windows CM4 ran in the two-core pass */
+    uint16_t mismatches;           /* CM4 windows whose scores differ from CM7's */
+    uint16_t rsvd;
+    uint32_t one_core_wps_x100;    /* windows per second x100 */
+    uint32_t two_core_wps_x100;    /* 0 if CM4 never picked up a job */
+} shared_ai_offload_bench_t;
+
+/* Changes of the reported state of any channel, published by CM7 into a ring. CM7 never
+ * resets count: it writes event[count % SHARED_AI_EVENTS], then bumps count. Every CM4
+ * reader keeps its own cursor (shared_read_ai_event()) and loses the oldest events if
+ * it falls SHARED_AI_EVENTS behind. */
+#define SHARED_AI_EVENTS       16u
+
+typedef struct {
+    uint32_t event_id;             /* count after this event */
+    uint32_t ts;                   /* window_end_ts of the window that made the change */
+    uint32_t onset_ts;             /* first window that pointed at the new state */
+    uint8_t  channel;
+    uint8_t  from_class;
+    uint8_t  to_class;
+    uint8_t  confidence_pct;       /* averaged probability of to_class */
+} shared_ai_event_t;
+
+typedef struct {
+    volatile uint32_t count;
+    uint32_t rsvd[7];
+    shared_ai_event_t event[SHARED_AI_EVENTS];
+} shared_ai_events_t;
+
+/* Everything the cores share, as one block. Both linker scripts put shared_d2 at
+ * ORIGIN(SHARED_D2), so CM4 and CM7 see every member at the same address without
+ * either image defining it. CM7 maps SHARED_D2 shareable and non-cacheable (MPU region 1),
+ * so neither core does cache maintenance on it. Each member starts a 32-byte line. */
+#define SHARED_D2_SIZE         (64u * 1024u)   /* LENGTH(SHARED_D2) in both linker scripts */
+#define SHARED_LINE            __attribute__((aligned(32)))
+
+typedef struct {
+    SHARED_LINE shared_ring_t ring;
+    SHARED_LINE shared_ai_result_t ai_result[SHARED_AI_MAX_CHANNELS];
+    SHARED_LINE shared_ai_config_t ai_config;
+    SHARED_LINE shared_ai_perf_t ai_perf;
+    SHARED_LINE shared_ai_bench_t ai_bench;
+    SHARED_LINE shared_ai_profile_t ai_profile;
+    SHARED_LINE shared_ai_engine_bench_t ai_engine_bench;
+    SHARED_LINE shared_ai_sched_t ai_sched;
+    SHARED_LINE shared_model_stage_t model_stage;
+    SHARED_LINE shared_model_status_t model_status;
+    SHARED_LINE shared_offload_t offload;
+    SHARED_LINE shared_ai_offload_bench_t ai_offload_bench;
+    SHARED_LINE shared_ai_events_t ai_events;
+} shared_layout_t;
+
+_Static_assert(sizeof(shared_layout_t) <= SHARED_D2_SIZE, "shared_layout_t does not fit SHARED_D2");
+_Static_assert(offsetof(shared_layout_t, model_stage) % 32u == 0u &&
+               offsetof(shared_model_stage_t, data) % 32u == 0u, "model stage data not line aligned");
+_Static_assert(offsetof(shared_layout_t, offload) % 32u == 0u &&
+               offsetof(shared_offload_t, job) % 32u == 0u && sizeof(shared_offload_job_t) % 32u == 0u &&
+               offsetof(shared_offload_t, result) % 32u == 0u && sizeof(shared_offload_result_t) % 32u == 0u,
+               "offload jobs and results not on their own lines");
+
+/* Defined by the linker scripts, not in C: shared_d2 = ORIGIN(SHARED_D2) */
+extern volatile shared_layout_t shared_d2;
+
+#define shared_ring              (shared_d2.ring)
+#define shared_ai_result         (shared_d2.ai_result)
+#define shared_ai_config         (shared_d2.ai_config)
+#define shared_ai_perf           (shared_d2.ai_perf)
+#define shared_ai_bench          (shared_d2.ai_bench)
+#define shared_ai_profile        (shared_d2.ai_profile)
+#define shared_ai_engine_bench   (shared_d2.ai_engine_bench)
+#define shared_ai_sched          (shared_d2.ai_sched)
+#define shared_model_stage       (shared_d2.model_stage)
+#define shared_model_status      (shared_d2.model_status)
+#define shared_offload           (shared_d2.offload)
+#define shared_ai_offload_bench  (shared_d2.ai_offload_bench)
+#define shared_ai_events         (shared_d2.ai_events)
+
+#endif /* __SHARED_LAYOUT_H */
@@ -0,0 +1,400 @@
+#include "ai_engine.h"
+#include <string.h>
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+#include "main.h"   /* CMSIS SIMD intrinsics */
+#endif
+
+#if MODEL_ENGINE_SUPPORTED
+
+_Static_assert(MODEL_CONV1_IN_CH == MODEL_NUM_AXES, "conv1 input channels != window axes");
+_Static_assert(MODEL_CONV2_IN_CH == MODEL_CONV1_OUT_CH, "conv2 input channels != conv1 output");
+_Static_assert(MODEL_CONV3_IN_CH == MODEL_CONV2_OUT_CH, "conv3 input channels != conv2 output");
+_Static_assert(MODEL_FC1_IN_CH == MODEL_CONV3_OUT_CH, "fc1 inputs != conv3 channels");
+_Static_assert(MODEL_FC2_IN_CH == MODEL_FC1_OUT_CH, "fc2 inputs != fc1 outputs");
+_Static_assert(MODEL_FC2_OUT_CH == MODEL_NUM_CLASSES, "fc2 outputs != classes");
+
+typedef struct {
+    int32_t mult;       /* Q31 */
+    int32_t shift;      /* left if > 0 */
+} ai_engine_requant_t;
+
+/* Frames column t of a layer depends on: [stride * t + lo, stride * t + hi] */
+typedef struct {
+    int32_t stride;
+    int32_t lo;
+    int32_t hi;
+} ai_engine_field_t;
+
+typedef struct {
+    uint32_t in_ch;
+    uint32_t out_ch;
+    uint32_t kernel;
+    uint32_t pad;           /* SAME padding before the first column */
+    int32_t in_offset;      /* -input zero point */
+    int32_t out_zp;
+    int32_t act_min;
+    int32_t act_max;
+    uint32_t w_offset;      /* bytes into the weights blob */
+    uint32_t b_offset;
+    const ai_engine_requant_t *rq;
+    ai_engine_field_t field;
+} ai_engine_layer_t;
+
+static const ai_engine_requant_t s_conv1_rq[MODEL_CONV1_OUT_CH] = MODEL_CONV1_REQUANT;
+static const ai_engine_requant_t s_conv2_rq[MODEL_CONV2_OUT_CH] = MODEL_CONV2_REQUANT;
+static const ai_engine_requant_t s_conv3_rq[MODEL_CONV3_OUT_CH] = MODEL_CONV3_REQUANT;
+static const ai_engine_requant_t s_fc1_rq[MODEL_FC1_OUT_CH] = MODEL_FC1_REQUANT;
+static const ai_engine_requant_t s_fc2_rq[MODEL_FC2_OUT_CH] = MODEL_FC2_REQUANT;
+static const ai_engine_requant_t s_gap_rq = { MODEL_GAP_MULT, MODEL_GAP_SHIFT };
+
+/* Receptive fields: a conv widens its input's by its taps, a pool by its window and
+ * multiplies the stride */
+#define AI_ENGINE_PAD(k_)       (((k_) - 1) / 2)
+#define AI_ENGINE_C1_STRIDE     1
+#define AI_ENGINE_C1_LO         (-AI_ENGINE_PAD(MODEL_CONV1_KERNEL))
+#define AI_ENGINE_C1_HI         (MODEL_CONV1_KERNEL - 1 - AI_ENGINE_PAD(MODEL_CONV1_KERNEL))
+#define AI_ENGINE_C2_STRIDE     (AI_ENGINE_C1_STRIDE * MODEL_POOL1_SIZE)
+#define AI_ENGINE_P1_HI         (AI_ENGINE_C1_HI + (MODEL_POOL1_SIZE - 1) * AI_ENGINE_C1_STRIDE)
+#define AI_ENGINE_C2_LO         (AI_ENGINE_C1_LO - AI_ENGINE_PAD(MODEL_CONV2_KERNEL) * AI_ENGINE_C2_STRIDE)
+#define AI_ENGINE_C2_HI         (AI_ENGINE_P1_HI + (MODEL_CONV2_KERNEL - 1 - AI_ENGINE_PAD(MODEL_CONV2_KERNEL)) * AI_ENGINE_C2_STRIDE)
+#define AI_ENGINE_C3_STRIDE     (AI_ENGINE_C2_STRIDE * MODEL_POOL2_SIZE)
+#define AI_ENGINE_P2_HI         (AI_ENGINE_C2_HI + (MODEL_POOL2_SIZE - 1) * AI_ENGINE_C2_STRIDE)
+#define AI_ENGINE_C3_LO         (AI_ENGINE_C2_LO - AI_ENGINE_PAD(MODEL_CONV3_KERNEL) * AI_ENGINE_C3_STRIDE)
+#define AI_ENGINE_C3_HI         (AI_ENGINE_P2_HI + (MODEL_CONV3_KERNEL - 1 - AI_ENGINE_PAD(MODEL_CONV3_KERNEL)) * AI_ENGINE_C3_STRIDE)
+
+#define AI_ENGINE_CONV(n_, stride_, lo_, hi_) {                                        \
+    MODEL_CONV##n_##_IN_CH, MODEL_CONV##n_##_OUT_CH, MODEL_CONV##n_##_KERNEL,          \
+    AI_ENGINE_PAD(MODEL_CONV##n_##_KERNEL), -(MODEL_CONV##n_##_IN_ZP),                 \
+    MODEL_CONV##n_##_OUT_ZP, MODEL_CONV##n_##_ACT_MIN, MODEL_CONV##n_##_ACT_MAX,       \
+    MODEL_CONV##n_##_W_OFFSET, MODEL_CONV##n_##_B_OFFSET, s_conv##n_##_rq,             \
+    { (stride_), (lo_), (hi_) } }
+
+#define AI_ENGINE_FC(n_) {                                                             \
+    MODEL_FC##n_##_IN_CH, MODEL_FC##n_##_OUT_CH, 1u, 0u, -(MODEL_FC##n_##_IN_ZP),      \
+    MODEL_FC##n_##_OUT_ZP, MODEL_FC##n_##_ACT_MIN, MODEL_FC##n_##_ACT_MAX,             \
+    MODEL_FC##n_##_W_OFFSET, MODEL_FC##n_##_B_OFFSET, s_fc##n_##_rq, { 1, 0, 0 } }
+
+static const ai_engine_layer_t s_conv1 = AI_ENGINE_CONV(1, AI_ENGINE_C1_STRIDE, AI_ENGINE_C1_LO, AI_ENGINE_C1_HI);
+static const ai_engine_layer_t s_conv2 = AI_ENGINE_CONV(2, AI_ENGINE_C2_STRIDE, AI_ENGINE_C2_LO, AI_ENGINE_C2_HI);
+static const ai_engine_layer_t s_conv3 = AI_ENGINE_CONV(3, AI_ENGINE_C3_STRIDE, AI_ENGINE_C3_LO, AI_ENGINE_C3_HI);
+static const ai_engine_layer_t s_fc1 = AI_ENGINE_FC(1);
+static const ai_engine_layer_t s_fc2 = AI_ENGINE_FC(2);
+
+/* Weighted layers in execution order: the order their blocks are fetched */
+static const ai_engine_layer_t *const s_weighted[] = { &s_conv1, &s_conv2, &s_conv3, &s_fc1, &s_fc2 };
+#define AI_ENGINE_WEIGHTED  (sizeof(s_weighted) / sizeof(s_weighted[0]))
+
+/* gemmlowp SaturatingRoundingDoublingHighMul */
+static inline int32_t ai_engine_mul_high(int32_t a, int32_t b)
+{
+    if (a == INT32_MIN && b == INT32_MIN) return INT32_MAX;
+    int64_t ab = (int64_t)a * (int64_t)b;
+    int32_t nudge = ab >= 0 ? (1 << 30) : (1 - (1 << 30));
+    return (int32_t)((ab + nudge) / (1LL << 31));
+}
+
+/* gemmlowp RoundingDivideByPOT: round half away from zero */
+static inline int32_t ai_engine_div_pot(int32_t x, int32_t exponent)
+{
+    const int32_t mask = (int32_t)((1LL << exponent) - 1);
+    const int32_t remainder = x & mask;
+    const int32_t threshold = (mask >> 1) + (x < 0 ? 1 : 0);
+    return (x >> exponent) + (remainder > threshold ? 1 : 0);
+}
+
+/* gemmlowp SaturatingRoundingMultiplyByPOT for a positive exponent */
+static inline int32_t ai_engine_mul_pot(int32_t x, int32_t exponent)
+{
+    const int32_t limit = INT32_MAX >> exponent;
+    if (x > limit) return INT32_MAX;
+    if (x < -limit - 1) return INT32_MIN;
+    return (int32_t)((uint32_t)x << exponent);
+}
+
+/* TFLite MultiplyByQuantizedMultiplier */
+static inline int32_t ai_engine_requant(int32_t acc, const ai_engine_requant_t *rq)
+{
+    const int32_t left = rq->shift > 0 ? rq->shift : 0;
+    const int32_t right = rq->shift > 0 ? 0 : -rq->shift;
+    return ai_engine_div_pot(ai_engine_mul_high(acc * (1 << left), rq->mult), right);
+}
+
+static inline int8_t ai_engine_out(int32_t acc, const ai_engine_requant_t *rq, const ai_engine_layer_t *l)
+{
+    int32_t v = ai_engine_requant(acc, rq) + l->out_zp;
+    if (v < l->act_min) v = l->act_min;
+    if (v > l->act_max) v = l->act_max;
+    return (int8_t)v;
+}
+
+/* sum of w[i] * (x[i] + offset) */
+static inline int32_t ai_engine_dot(const int8_t *w, const int8_t *x, uint32_t n, int32_t offset)
+{
+    int32_t acc = 0;
+    uint32_t i = 0;
+
+#if defined(__ARM_FEATURE_DSP) && (__ARM_FEATURE_DSP == 1)
+    /* Four int8 per word: SXTB16 sign-extends bytes 0/2 (and 1/3 after a rotate) into
+     * int16 pairs, SADD16 adds the offset to the inputs (x + offset fits an int16) and
+     * SMLAD multiply-accumulates both pairs */
+    const uint32_t off2 = __PKHBT((uint32_t)offset, (uint32_t)offset, 16);
+    for (; i + 4u <= n; i += 4u) {
+        const uint32_t wv = __UNALIGNED_UINT32_READ(&w[i]);
+        const uint32_t xv = __UNALIGNED_UINT32_READ(&x[i]);
+        const uint32_t x02 = __SADD16(__SXTB16(xv), off2);
+        const uint32_t x13 = __SADD16(__SXTB16(__ROR(xv, 8)), off2);
+        acc = (int32_t)__SMLAD(__SXTB16(wv), x02, (uint32_t)acc);
+        acc = (int32_t)__SMLAD(__SXTB16(__ROR(wv, 8)), x13, (uint32_t)acc);
+    }
+#endif
+    for (; i < n; i++) {
+        acc += (int32_t)w[i] * ((int32_t)x[i] + offset);
+    }
+    return acc;
+}
+
+/* One output column of a stride-1 SAME conv over [len][in_ch] into out[t][out_ch], with
+ * the layer's weights and biases at `wb`. Taps on the padding hold the input zero point
+ * and add nothing, so they are skipped; the remaining taps are contiguous in both the
+ * input and the OHWI weights. */
+static void ai_engine_conv_col(const uint8_t *wb, const ai_engine_layer_t *l,
+                               const int8_t *in, uint32_t len, uint32_t t, int8_t *out)
+{
+    const int8_t *w = (const int8_t *)wb;
+    const int32_t *bias = (const int32_t *)(wb + (l->b_offset - l->w_offset));
+    const int32_t first = (int32_t)t - (int32_t)l->pad;
+    const int32_t k0 = first < 0 ? -first : 0;
+    const int32_t k1 = ((int32_t)len - first) < (int32_t)l->kernel ? ((int32_t)len - first) : (int32_t)l->kernel;
+    const uint32_t n = (uint32_t)(k1 - k0) * l->in_ch;
+    const int8_t *x = in + (uint32_t)(first + k0) * l->in_ch;
+    int8_t *y = out + t * l->out_ch;
+
+    for (uint32_t o = 0; o < l->out_ch; o++) {
+        const int8_t *wo = w + (o * l->kernel + (uint32_t)k0) * l->in_ch;
+        y[o] = ai_engine_out(bias[o] + ai_engine_dot(wo, x, n, l->in_offset), &l->rq[o], l);
+    }
+}
+
+/* Bring a conv layer's output up to date for a window that advanced `shift` frames
+ * (AI_ENGINE_FRAMES: nothing to reuse). Column t is reused when its receptive field
+ * avoids the padding and lies in frames [0, FRAMES - shift), which the previous window
+ * saw as column t + shift / stride; every other column is recomputed. With `sum`, the
+ * per-channel column sums follow: dropped columns out, recomputed ones in. */
+static void ai_engine_conv(const uint8_t *wb, const ai_engine_layer_t *l, const int8_t *in,
+                           uint32_t len, int8_t *out, uint32_t shift, int32_t *sum)
+{
+    const ai_engine_field_t *f = &l->field;
+    const uint32_t oc = l->out_ch;
+    const int32_t last = (int32_t)AI_ENGINE_FRAMES - 1 - (int32_t)shift - f->hi;
+    int32_t lo = 0, hi = -1;    /* reused columns */
+
+    if (last >= 0 && shift % (uint32_t)f->stride == 0u) {
+        lo = (-f->lo + f->stride - 1) / f->stride;
+        hi = last / f->stride;
+    }
+
+    if (lo <= hi) {
+        const uint32_t move = shift / (uint32_t)f->stride;
+        if (sum) {
+            for (uint32_t t = 0; t < len; t++) {
+                if ((int32_t)t >= lo + (int32_t)move && (int32_t)t <= hi + (int32_t)move) continue;
+                for (uint32_t c = 0; c < oc; c++) sum[c] -= out[t * oc + c];
+            }
+        }
+        memmove(out + (uint32_t)lo * oc, out + ((uint32_t)lo + move) * oc, (uint32_t)(hi - lo + 1) * oc);
+    } else if (sum) {
+        memset(sum, 0, oc * sizeof(sum[0]));
+    }
+
+    for (uint32_t t = 0; t < len; t++) {
+        if ((int32_t)t >= lo && (int32_t)t <= hi) continue;
+        ai_engine_conv_col(wb, l, in, len, t, out);
+        if (sum) {
+            for (uint32_t c = 0; c < oc; c++) sum[c] += out[t * oc + c];
+        }
+    }
+}
+
+/* VALID max pool, window == stride, over [len][ch] */
+static void ai_engine_maxpool(const int8_t *in, uint32_t out_len, uint32_t ch, uint32_t size, int8_t *out)
+{
+    for (uint32_t j = 0; j < out_len; j++) {
+        const int8_t *x = in + j * size * ch;
+        for (uint32_t c = 0; c < ch; c++) {
+            int8_t m = x[c];
+            for (uint32_t k = 1; k < size; k++) {
+                if (x[k * ch + c] > m) m = x[k * ch + c];
+            }
+            out[j * ch + c] = m;
+        }
+    }
+}
+
+/* TFLite QuantizedMeanOrSum over the columns, from the running sums (1/len folded into
+ * the multiplier at generation time) */
+static void ai_engine_gap(const int32_t *sum, int8_t *out)
+{
+    for (uint32_t c = 0; c < MODEL_CONV3_OUT_CH; c++) {
+        int32_t v = ai_engine_requant(sum[c] - MODEL_GAP_IN_ZP * (int32_t)AI_ENGINE_C3_LEN, &s_gap_rq) + MODEL_GAP_OUT_ZP;
+        if (v < -128) v = -128;
+        if (v > 127) v = 127;
+        out[c] = (int8_t)v;
+    }
+}
+
+static void ai_engine_dense(const uint8_t *wb, const ai_engine_layer_t *l, const int8_t *in, int8_t *out)
+{
+    const int8_t *w = (const int8_t *)wb;
+    const int32_t *bias = (const int32_t *)(wb + (l->b_offset - l->w_offset));
+
+    for (uint32_t o = 0; o < l->out_ch; o++) {
+        out[o] = ai_engine_out(bias[o] + ai_engine_dot(w + o * l->in_ch, in, l->in_ch, l->in_offset), &l->rq[o], l);
+    }
+}
+
+/* gemmlowp exp_on_negative_values for a Q5.26 input, Q0.31 result */
+static int32_t ai_engine_exp_neg(int32_t a)
+{
+    static const int32_t barrel[] = { 1672461947, 1302514674, 790015084, 290630308, 39332535, 720401, 242 };
+    const int32_t quarter = 1 << 24;
+    const int32_t a_mod = (a & (quarter - 1)) - quarter;
+    const int32_t remainder = a_mod - a;
+
+    /* exp on [-1/4, 0): Taylor expansion around -1/8 */
+    const int32_t x = a_mod * (1 << 5) + (1 << 28);
+    const int32_t x2 = ai_engine_mul_high(x, x);
+    const int32_t x3 = ai_engine_mul_high(x2, x);
+    const int32_t x4 = ai_engine_mul_high(x2, x2);
+    const int32_t poly = ai_engine_div_pot(ai_engine_mul_high(ai_engine_div_pot(x4, 2) + x3, 715827883) + x2, 1);
+    int32_t result = 1895147668 + ai_engine_mul_high(1895147668, x + poly);
+
+    for (uint32_t i = 0; i < sizeof(barrel) / sizeof(barrel[0]); i++) {
+        if (remainder & (1 << (24 + i))) result = ai_engine_mul_high(result, barrel[i]);
+    }
+    return a == 0 ? INT32_MAX : result;
+}
+
+/* gemmlowp one_over_one_plus_x_for_x_in_0_1: Newton-Raphson on Q2.29 */
+static int32_t ai_engine_recip(int32_t a)
+{
+    const int64_t s = (int64_t)a + INT32_MAX;
+    const int32_t half_den = (int32_t)((s + (s >= 0 ? 1 : -1)) / 2);
+    int32_t x = 1515870810 + ai_engine_mul_high(half_den, -1010580540);
+
+    for (int i = 0; i < 3; i++) {
+        x += ai_engine_mul_pot(ai_engine_mul_high(x, (1 << 29) - ai_engine_mul_high(half_den, x)), 2);
+    }
+    return ai_engine_mul_pot(x, 1);
+}
+
+/* TFLite int8 softmax (reference_ops::Softmax, 12 accumulation integer bits) */
+static void ai_engine_softmax(const int8_t *in, int8_t *out)
+{
+    int32_t max = in[0];
+    int32_t sum = 0;
+
+    for (uint32_t i = 1; i < MODEL_NUM_CLASSES; i++) {
+        if (in[i] > max) max = in[i];
+    }
+    for (uint32_t i = 0; i < MODEL_NUM_CLASSES; i++) {
+        const int32_t diff = in[i] - max;
+        if (diff >= MODEL_SOFTMAX_DIFF_MIN) {
+            sum += ai_engine_div_pot(ai_engine_exp_neg(ai_engine_mul_high(diff * (1 << MODEL_SOFTMAX_SHIFT), MODEL_SOFTMAX_MULT)), 12);
+        }
+    }
+
+    const int32_t headroom = __builtin_clz((uint32_t)sum);
+    const int32_t bits_over_unit = 12 - headroom;
+    const int32_t scale = ai_engine_recip((int32_t)(((uint32_t)sum << headroom) - (1u << 31)));
+
+    for (uint32_t i = 0; i < MODEL_NUM_CLASSES; i++) {
+        const int32_t diff = in[i] - max;
+        if (diff < MODEL_SOFTMAX_DIFF_MIN) {
+            out[i] = -128;
+            continue;
+        }
+        const int32_t e = ai_engine_exp_neg(ai_engine_mul_high(diff * (1 << MODEL_SOFTMAX_SHIFT), MODEL_SOFTMAX_MULT));
+        int32_t v = ai_engine_div_pot(ai_engine_mul_high(scale, e), bits_over_unit + 23) - 128;
+        if (v > 127) v = 127;
+        if (v < -128) v = -128;
+        out[i] = (int8_t)v;
+    }
+}
+
+/* Block of weighted layer i: in place, or from its staging buffer once it landed, the
+ * copy of layer i + 1 starting behind it. NULL if a copy failed; none is in flight then. */
+static const uint8_t *ai_engine_weights(const ai_engine_t *e, uint32_t i)
+{
+    const ai_engine_layer_t *l = s_weighted[i];
+    const ai_engine_fetch_t *f = e->fetch;
+
+    if (!f) return e->weights + l->w_offset;
+    if (!f->wait(f->ctx)) return NULL;
+    if (i + 1u < AI_ENGINE_WEIGHTED) {
+        const ai_engine_layer_t *next = s_weighted[i + 1u];
+        if (!f->start(f->ctx, f->stage[(i + 1u) & 1u], e->weights + next->w_offset,
+                      next->b_offset - next->w_offset + 4u * next->out_ch)) {
+            return NULL;
+        }
+    }
+    return f->stage[i & 1u];
+}
+
+/* A run stopped part way: the layers hold a mix of two windows, so the next run
+ * recomputes a full one */
+static bool ai_engine_abort(ai_engine_t *e)
+{
+    e->primed = false;
+    return false;
+}
+
+void ai_engine_init(ai_engine_t *e, const void *weights)
+{
+    memset(e, 0, sizeof(*e));
+    e->weights = (const uint8_t *)weights;
+}
+
+/* Stream the weights through `fetch` from the next run on (NULL: read them in place) */
+void ai_engine_set_fetch(ai_engine_t *e, const ai_engine_fetch_t *fetch)
+{
+    e->fetch = fetch;
+}
+
+/* The next run computes a full window */
+void ai_engine_reset(ai_engine_t *e)
+{
+    e->primed = false;
+}
+
+/* `in` is the quantized window [frame][axis]; `shift` the frames it advanced since the
+ * previous run. Scores land in e->out; false if a weight copy failed, e->out is then
+ * not updated. */
+bool ai_engine_run(ai_engine_t *e, const int8_t *in, uint32_t shift)
+{
+    const uint8_t *w;
+
+    if (!e->primed || shift > AI_ENGINE_FRAMES) shift = AI_ENGINE_FRAMES;
+    if (e->fetch && !e->fetch->start(e->fetch->ctx, e->fetch->stage[0], e->weights + s_conv1.w_offset,
+                                     AI_ENGINE_CONV_BYTES(1))) {
+        return ai_engine_abort(e);
+    }
+
+    if (!(w = ai_engine_weights(e, 0))) return ai_engine_abort(e);
+    ai_engine_conv(w, &s_conv1, in, AI_ENGINE_C1_LEN, e->c1, shift, NULL);
+    ai_engine_maxpool(e->c1, AI_ENGINE_P1_LEN, MODEL_CONV1_OUT_CH, MODEL_POOL1_SIZE, e->p1);
+    if (!(w = ai_engine_weights(e, 1))) return ai_engine_abort(e);
+    ai_engine_conv(w, &s_conv2, e->p1, AI_ENGINE_C2_LEN, e->c2, shift, NULL);
+    ai_engine_maxpool(e->c2, AI_ENGINE_P2_LEN, MODEL_CONV2_OUT_CH, MODEL_POOL2_SIZE, e->p2);
+    if (!(w = ai_engine_weights(e, 2))) return ai_engine_abort(e);
+    ai_engine_conv(w, &s_conv3, e->p2, AI_ENGINE_C3_LEN, e->c3, shift, e->gap_sum);
+    ai_engine_gap(e->gap_sum, e->gap);
+    if (!(w = ai_engine_weights(e, 3))) return ai_engine_abort(e);
+    ai_engine_dense(w, &s_fc1, e->gap, e->fc1);
+    if (!(w = ai_engine_weights(e, 4))) return ai_engine_abort(e);
+    ai_engine_dense(w, &s_fc2, e->fc1, e->fc2);
+    ai_engine_softmax(e->fc2, e->out);
+    e->primed = true;
+    return true;
+}
+
+#endif /* MODEL_ENGINE_SUPPORTED */
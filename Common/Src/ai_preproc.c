@@ -0,0 +1,140 @@
+#include "ai_preproc.h"
+#include <math.h>
+
+#if MODEL_PRECISION == MODEL_PRECISION_FLOAT32
+bool ai_preproc_init(ai_preproc_t *pp, const float mean[AI_PREPROC_AXES], const float std[AI_PREPROC_AXES],
+                     float scale, int32_t zero_point)
+{
+    (void)scale;
+    (void)zero_point;
+    if (!pp || !mean || !std) return false;
+
+    for (uint32_t a = 0; a < AI_PREPROC_AXES; a++) {
+        if (!(std[a] > 0.0f)) return false;
+        pp->axis[a].mult = 1.0f / std[a];
+        pp->axis[a].offset = -mean[a] / std[a];
+        pp->axis[a].shift = 0;
+    }
+    return true;
+}
+
+/* Normalize frames [0, frames) of each axis history into interleaved float [frame][axis].
+ * Each axis pointer must address `frames` contiguous samples (any alignment). */
+void ai_preproc_window(const ai_preproc_t *pp, const int16_t *const axis[AI_PREPROC_AXES],
+                       uint32_t frames, ai_input_t *out)
+{
+    for (uint32_t a = 0; a < AI_PREPROC_AXES; a++) {
+        const int16_t *src = axis[a];
+        float *dst = out + a;
+        const float mult = pp->axis[a].mult;
+        const float offset = pp->axis[a].offset;
+
+        for (uint32_t i = 0; i < frames; i++) {
+            dst[i * AI_PREPROC_AXES] = (float)src[i] * mult + offset;
+        }
+    }
+}
+
+/* Float reference: the z-score itself (scale and zero point unused) */
+ai_input_t ai_preproc_reference(int16_t x, float mean, float std, float scale, int32_t zero_point)
+{
+    (void)scale;
+    (void)zero_point;
+    return (float)(((double)x - (double)mean) / (double)std);
+}
+#else
+#if MODEL_PRECISION == MODEL_PRECISION_INT16X8
+#define AI_PREPROC_BITS     16
+#define AI_PREPROC_MIN      INT16_MIN
+#define AI_PREPROC_MAX      INT16_MAX
+#else
+#define AI_PREPROC_BITS     8
+#define AI_PREPROC_MIN      INT8_MIN
+#define AI_PREPROC_MAX      INT8_MAX
+#endif
+
+static inline ai_input_t ai_preproc_sat(int64_t v)
+{
+    if (v > AI_PREPROC_MAX) return AI_PREPROC_MAX;
+    if (v < AI_PREPROC_MIN) return AI_PREPROC_MIN;
+    return (ai_input_t)v;
+}
+
+/* Fold mean, std, scale and zero point into an int64 multiplier, offset and shift.
+ * Picks the largest shift with mult <= 2^46 and |offset| <= 2^61, so x * mult + offset
+ * stays within +-2^62 for any int16 input; at ~46 bits the multiplier is exact enough
+ * that every int16 input rounds as ai_preproc_reference() does. */
+static bool ai_preproc_fold(ai_preproc_axis_t *ax, float mean, float std, float scale, int32_t zero_point)
+{
+    if (!(std > 0.0f) || !(scale > 0.0f)) return false;
+
+    double k = 1.0 / ((double)std * (double)scale);
+
+    for (int32_t shift = 62; shift >= 0; shift--) {
+        double one = ldexp(1.0, shift);
+        double m = k * one;
+        double o = ((double)zero_point - (double)mean * k) * one;
+        if (m > 0x1p46 || fabs(o) > 0x1p61) continue;
+        ax->mult = llround(m);
+        ax->offset = llround(o) + (shift ? (1LL << (shift - 1)) : 0);
+        ax->shift = (uint32_t)shift;
+        return true;
+    }
+    return false;
+}
+
+bool ai_preproc_init(ai_preproc_t *pp, const float mean[AI_PREPROC_AXES], const float std[AI_PREPROC_AXES],
+                     float scale, int32_t zero_point)
+{
+    if (!pp || !mean || !std) return false;
+
+    for (uint32_t a = 0; a < AI_PREPROC_AXES; a++) {
+        if (!ai_preproc_fold(&pp->axis[a], mean[a], std[a], scale, zero_point)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Quantize frames [0, frames) of each axis history into interleaved ai_input_t [frame][axis].
+ * Each axis pointer must address `frames` contiguous samples (any alignment). */
+void ai_preproc_window(const ai_preproc_t *pp, const int16_t *const axis[AI_PREPROC_AXES],
+                       uint32_t frames, ai_input_t *out)
+{
+    for (uint32_t a = 0; a < AI_PREPROC_AXES; a++) {
+        const int16_t *src = axis[a];
+        ai_input_t *dst = out + a;
+        const int64_t mult = pp->axis[a].mult;
+        const int64_t offset = pp->axis[a].offset;
+        const uint32_t shift = pp->axis[a].shift;
+
+        /* The 64-bit product is UMULL + two MLA and the add ADDS/ADC on the M7. With
+         * shift >= 32 only the high word survives, so the tail is one ASR and a 32-bit
+         * saturate instead of a variable 64-bit shift and compare (~13 vs ~26 cycles
+         * per sample, llvm-mca cortex-m7). Large k = 1 / (std * scale) folds to a
+         * smaller shift and takes the generic loop. */
+        if (shift >= 32u) {
+            const uint32_t hi_shift = shift - 32u;
+            for (uint32_t i = 0; i < frames; i++) {
+                int32_t hi = (int32_t)(((int64_t)src[i] * mult + offset) >> 32);
+                dst[i * AI_PREPROC_AXES] = ai_preproc_sat(hi >> hi_shift);
+            }
+        } else {
+            for (uint32_t i = 0; i < frames; i++) {
+                dst[i * AI_PREPROC_AXES] = ai_preproc_sat(((int64_t)src[i] * mult + offset) >> shift);
+            }
+        }
+    }
+}
+
+/* Float reference the folded path is checked against: round-half-up of the z-score
+ * divided by the input scale, plus the zero point, saturated to the input type */
+ai_input_t ai_preproc_reference(int16_t x, float mean, float std, float scale, int32_t zero_point)
+{
+    double v = ((double)x - (double)mean) / (double)std / (double)scale + (double)zero_point;
+    v = floor(v + 0.5);
+    if (v > (double)AI_PREPROC_MAX) return AI_PREPROC_MAX;
+    if (v < (double)AI_PREPROC_MIN) return AI_PREPROC_MIN;
+    return (ai_input_t)v;
+}
+#endif
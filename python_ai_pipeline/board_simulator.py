@@ -0,0 +1,1017 @@
+#!/usr/bin/env python3
+"""
+Motor Anomaly Detection - Board Simulator
+Stands in for the CM4 USB-CDC interface on a pseudo-terminal so that
+data_collector.py, stream_receiver.py and test_connection.py can run without
+hardware. Vibration data is replayed from the collected_data CSVs.
+
+    python board_simulator.py                 # prints the PTY path to connect to
+    python board_simulator.py --bench         # ASCII vs binary throughput benchmark
+"""
+
+import os
+import sys
+import csv
+import glob
+import json
+import time
+import tty
+import fcntl
+import select
+import struct
+import zlib
+import termios
+import argparse
+import math
+import threading
+import statistics
+from typing import Callable, Dict, List, Optional, Tuple
+
+from data_collector import crc16_ccitt
+import model_bundle
+from decision_tune import DecisionStage, resolve_thresholds, score_probs
+
+
+# Firmware constants (CM4/Core/Inc/ai_data_collection.h, stream.h, usb_commands.h)
+AI_SAMPLE_RATE_HZ = 1000
+AI_SAMPLE_DURATION_SEC = 10
+AI_SAMPLES_PER_COLLECTION = AI_SAMPLE_RATE_HZ * AI_SAMPLE_DURATION_SEC
+AI_MAX_SAMPLE_RATE_HZ = 1000
+AI_MAX_DURATION_SEC = 65
+AI_CHUNK_SAMPLES = 100
+AI_SAMPLE_BLOCK_SIZE = 20 + AI_SAMPLES_PER_COLLECTION * 6     # sizeof(ai_training_sample_t)
+
+STATUS_IDLE, STATUS_ACTIVE, STATUS_COMPLETE = 0, 1, 2
+
+ACQ_DEFAULT_ODR_HZ = 125
+MSA301_ODR_TABLE_HZ = (1, 2, 4, 8, 16, 31, 62, 125, 250, 500, 1000)
+USB_CMD_MAX_TOKENS = 6
+USB_MAX_HOP_FRAMES = 60
+USB_MAX_PERIOD_MS = 1000
+USB_MAX_EMA_SHIFT = 7
+USB_MAX_DWELL_MS = 60000
+AI_WINDOW_FRAMES = 60
+SHARED_GATE_WINDOW_FRAMES = 60
+SHARED_AI_MAX_CHANNELS = 4
+SHARED_AI_EVENTS = 16
+
+STREAM_FRAMES_PER_PACKET = 16
+STREAM_QUEUE_FRAMES = 256
+STREAM_MAX_LATENCY_MS = 100
+STREAM_STATS_PERIOD_MS = 1000
+STREAM_DEFAULT_CREDITS = 32
+STREAM_MAX_CREDITS = 1024
+PKT_SAMPLES, PKT_RESULT, PKT_STATS, PKT_DECISION = 1, 2, 3, 4
+STREAM_CONTENT_ALL, STREAM_CONTENT_DECISIONS = 0, 1
+
+TX_WAIT_S = 0.1         # usb_tx_wait_free() timeout used by the bulk senders
+
+CLASS_DIRS = {"normal": 0, "imbalance": 1, "bearing_fault": 2, "misalignment": 3}
+CLASS_NAMES = ("NORMAL", "IMBALANCE", "BEARING", "MISALIGN")
+START_NAMES = ("normal motor", "imbalance motor", "bearing fault", "misalignment")
+
+
+def load_dataset(data_dir: str) -> Dict[int, Tuple[float, List[Tuple[int, int, int]]]]:
+    """
+    Load one replay trace per class from collected_data/<class>/*_vibration_data.csv
+
+    Returns:
+        {class_id: (trace_rate_hz, [(x, y, z), ...])}, values in mg rounded to int16
+    """
+    dataset = {}
+    for name, class_id in CLASS_DIRS.items():
+        files = sorted(glob.glob(os.path.join(data_dir, name, "*.csv")))
+        if not files:
+            continue
+        with open(files[0], newline="") as f:
+            text = f.read()
+        delimiter = ";" if text.count(";") > text.count(",") else ","
+        rows, stamps = [], []
+        for row in csv.DictReader(text.splitlines(), delimiter=delimiter):
+            try:
+                rows.append(tuple(max(-32768, min(32767, int(round(float(row[axis])))))
+                                  for axis in ("X_axis_mg", "Y_axis_mg", "Z_axis_mg")))
+                if row.get("timestamp"):
+                    stamps.append(float(row["timestamp"]))
+            except (KeyError, ValueError):
+                continue
+        if not rows:
+            continue
+        # Timestamps are in seconds, as in dataset_loader.infer_sample_rate()
+        rate = 100.0
+        if len(stamps) == len(rows) and len(rows) > 1 and stamps[-1] > stamps[0]:
+            rate = (len(rows) - 1) / (stamps[-1] - stamps[0])
+        dataset[class_id] = (rate, rows)
+
+    # Flat 1 g trace for classes without data so every command still works
+    for class_id in range(len(CLASS_NAMES)):
+        dataset.setdefault(class_id, (100.0, [(0, 0, 1000)]))
+    return dataset
+
+
+class EnergyGate:
+    # energy_gate.c: rms / peak / band (first-difference RMS) per axis over the last
+    # SHARED_GATE_WINDOW_FRAMES frames, in integer LSB; thresholds of 0 are off
+
+    def __init__(self):
+        self.rms_max = self.peak_max = self.band_max = 0
+        self.hist: List[Tuple[int, int, int]] = []
+        self.diffs: List[Tuple[int, int, int]] = []
+        self.frames = 0
+        self.quiet_frames = 0
+        self.rms = self.peak = self.band = 0
+        self.quiet = False
+
+    def feed(self, frame: Tuple[int, int, int]) -> bool:
+        n = SHARED_GATE_WINDOW_FRAMES
+        prev = self.hist[-1] if self.hist else frame
+        self.hist = (self.hist + [frame])[-n:]
+        self.diffs = (self.diffs + [tuple(v - p for v, p in zip(frame, prev))])[-n:]
+        full = len(self.hist) == n
+        self.rms = self.peak = self.band = 0
+        if full:
+            for a in range(3):
+                w = [f[a] for f in self.hist]
+                total = sum(w)
+                mean = int(total / n)   # C division truncates toward zero
+                self.rms = max(self.rms, min(math.isqrt(n * sum(v * v for v in w) - total * total) // n, 0xFFFF))
+                self.peak = max(self.peak, min(max(abs(v - mean) for v in w), 0xFFFF))
+                self.band = max(self.band, min(math.isqrt(sum(d[a] * d[a] for d in self.diffs) // n), 0xFFFF))
+        enabled = self.rms_max or self.peak_max or self.band_max
+        self.quiet = bool(enabled and full and (not self.rms_max or self.rms < self.rms_max) and
+                          (not self.peak_max or self.peak < self.peak_max) and
+                          (not self.band_max or self.band < self.band_max))
+        self.frames += 1
+        self.quiet_frames += self.quiet
+        return self.quiet
+
+
+class SimulatedBoard:
+    # Command table and state machines of the CM4 firmware, driven by tick()
+
+    def __init__(self, dataset: Dict[int, Tuple[float, List[Tuple[int, int, int]]]],
+                 write: Callable[[bytes, float], bool], speed: float = 1.0, stream_class: int = 0):
+        self.dataset = dataset
+        self.write = write
+        self.speed = speed
+        self.stream_class = stream_class
+        self.start = time.monotonic()
+        self.rx = bytearray()
+
+        # Capture (ai_data_collection.c)
+        self.status = STATUS_IDLE
+        self.sample = None
+        self.sample_id = 0
+        self.sample_counter = 0
+        self.capture_start = 0.0
+        self.data_ready = False
+        self.pool_peak = 0
+        self.pool_failures = 0
+        self.capture_sec = AI_SAMPLE_DURATION_SEC
+        self.capture_hz = AI_SAMPLE_RATE_HZ
+
+        # Live acquisition and inference tuning (acquisition_m4.c, shared_ai_config)
+        self.odr_hz = ACQ_DEFAULT_ODR_HZ
+        self.hop = USB_MAX_HOP_FRAMES
+        self.channel_hop = [0] * SHARED_AI_MAX_CHANNELS    # one sensor: only channel 0 is fed
+        self.period_ms = 20
+        self.thresh_pct = 0
+        self.frames = 0
+        self.last_acq = self.start
+        self.since_infer = 0
+        self.infer_count = 0
+        self.gated_count = 0
+        self.gate = EnergyGate()
+
+        # Decision stage (CM7 ai_decision.c) and the shared_ai_events ring it reports into
+        self.ema_shift = 0
+        self.enter_dwell_ms = self.exit_dwell_ms = 0
+        self.enter_pct = [0] * len(CLASS_NAMES)
+        self.exit_pct = [0] * len(CLASS_NAMES)
+        self.decision = DecisionStage()
+        self.events: List[Tuple[int, int, int, int, int, int, int]] = []   # id, ts, onset, ch, from, to, conf
+        self.event_count = 0
+        self.decision_cursor = 0
+
+        # Model hot-swap (model_loader.c, CM7 ai_model_poll()); CM7 answers at once here
+        self.model_target = model_bundle.firmware_target()
+        self.model_stage = bytearray()
+        self.model_size = 0
+        self.model_crc = 0
+        self.model_received = 0
+        self.model_active = False
+        self.model = {"hash": self.model_target["network_signature"], "slot": 0, "status": 0, "swaps": 0,
+                      "request": 0, "labels": ["normal", "imbalance", "bearing fault", "misalignment"]}
+
+        # Stream (stream.c)
+        self.streaming = False
+        self.credits = 0
+        self.queue: List[Tuple[int, int, int, int, int]] = []
+        self.queue_since = 0.0
+        self.pending_results: List[bytes] = []
+        self.content = STREAM_CONTENT_ALL
+        self.stream_cursor = 0
+        self.packet_seq = 0
+        self.last_stats = 0.0
+        self.st = {"queued": 0, "dropped": 0, "packets": 0, "stalls": 0, "lost": 0, "tx_drops": 0}
+
+        # usb_tx counters
+        self.tx_sent = 0
+        self.tx_dropped = 0
+        self.tx_transfers = 0
+
+        self.table = [
+            ("START_NORMAL", "", "START_NORMAL", self.cmd_start, 0),
+            ("START_IMBALANCE", "", "START_IMBALANCE", self.cmd_start, 1),
+            ("START_BEARING", "", "START_BEARING", self.cmd_start, 2),
+            ("START_MISALIGN", "", "START_MISALIGN", self.cmd_start, 3),
+            ("CAPTURE", "w|uu", "CAPTURE <class> [<seconds>] [<hz>]", self.cmd_capture, 0),
+            ("STOP", "", "STOP", self.cmd_stop, 0),
+            ("GET_DATA", "|u", "GET_DATA [<first_chunk>]", self.cmd_get_data, 0),
+            ("NACK", "u|u", "NACK <first> [<last>]", self.cmd_nack, 0),
+            ("ACK", "", "ACK", self.cmd_ack, 0),
+            ("STATUS", "", "STATUS", self.cmd_status, 0),
+            ("RESET", "", "RESET", self.cmd_reset, 0),
+            ("GET_EVENTS", "", "GET_EVENTS", self.cmd_get_events, 0),
+            ("CLEAR_EVENTS", "", "CLEAR_EVENTS", self.cmd_clear_events, 0),
+            ("GET_POOLS", "", "GET_POOLS", self.cmd_get_pools, 0),
+            ("SET ODR", "u", "SET ODR <hz>", self.cmd_set_odr, 0),
+            ("SET HOP", "u|u", "SET HOP <frames> [<channel>]", self.cmd_set_hop, 0),
+            ("SET PERIOD", "u", "SET PERIOD <ms>", self.cmd_set_period, 0),
+            ("SET THRESH", "u", "SET THRESH <percent>", self.cmd_set_thresh, 0),
+            ("SET GATE", "uuu", "SET GATE <rms> <peak> <band>", self.cmd_set_gate, 0),
+            ("SET DECISION", "uuu", "SET DECISION <ema_shift> <enter_dwell_ms> <exit_dwell_ms>", self.cmd_set_decision, 0),
+            ("SET CLASS", "wuu", "SET CLASS <class> <enter_pct> <exit_pct>", self.cmd_set_class, 0),
+            ("GET CONFIG", "", "GET CONFIG", self.cmd_get_config, 0),
+            ("GET PERF", "", "GET PERF", self.cmd_get_perf, 0),
+            ("GET GATE", "", "GET GATE", self.cmd_get_gate, 0),
+            ("GET BENCH", "", "GET BENCH", self.cmd_get_bench, 0),
+            ("GET ENGINE", "", "GET ENGINE", self.cmd_get_engine, 0),
+            ("GET PROFILE", "", "GET PROFILE", self.cmd_get_profile, 0),
+            ("GET CHANNELS", "", "GET CHANNELS", self.cmd_get_channels, 0),
+            ("GET OFFLOAD", "", "GET OFFLOAD", self.cmd_get_offload, 0),
+            ("GET DECISIONS", "", "GET DECISIONS", self.cmd_get_decisions, 0),
+            ("MODEL BEGIN", "uu", "MODEL BEGIN <size> <crc32>", self.cmd_model_begin, 0),
+            ("MODEL DATA", "uw", "MODEL DATA <offset> <hex>", self.cmd_model_data, 0),
+            ("MODEL COMMIT", "", "MODEL COMMIT", self.cmd_model_commit, 0),
+            ("MODEL FLASH", "", "MODEL FLASH", self.cmd_model_flash, 0),
+            ("GET MODEL", "", "GET MODEL", self.cmd_get_model, 0),
+            ("STREAM ON", "|uw", "STREAM ON [<credits>] [ALL|DECISIONS]", self.cmd_stream_on, 0),
+            ("STREAM OFF", "", "STREAM OFF", self.cmd_stream_off, 0),
+            ("STREAM CREDIT", "u", "STREAM CREDIT <n>", self.cmd_stream_credit, 0),
+            ("HELP", "", "HELP", self.cmd_help, 0),
+        ]
+
+    # --- output ---------------------------------------------------------
+
+    def now_ms(self) -> int:
+        return int((time.monotonic() - self.start) * 1000) & 0xFFFFFFFF
+
+    def send(self, data: bytes, wait: float = 0.0) -> bool:
+        if self.write(data, wait):
+            self.tx_sent += len(data)
+            self.tx_transfers += 1
+            return True
+        self.tx_dropped += len(data)
+        return False
+
+    def respond(self, text: str):
+        self.send(f"{text}\r\n".encode("utf-8"))
+
+    # --- command parsing (usb_commands.c) -------------------------------
+
+    def feed(self, data: bytes):
+        self.rx.extend(data)
+        while True:
+            ends = [i for i in (self.rx.find(b"\r"), self.rx.find(b"\n")) if i >= 0]
+            if not ends:
+                return
+            end = min(ends)
+            line = bytes(self.rx[:end]).decode("utf-8", errors="replace")
+            del self.rx[:end + 1]
+            if line.strip():
+                self.execute(line)
+
+    def execute(self, line: str):
+        tokens = line.split()
+        if len(tokens) > USB_CMD_MAX_TOKENS:
+            self.respond("ERROR: Unknown command")
+            return
+        for keyword, spec, usage, handler, param in self.table:
+            words = keyword.split()
+            if tokens[:len(words)] != words:
+                continue
+            args = self.parse_args(spec, tokens[len(words):])
+            if args is None:
+                self.respond(f"ERROR: Usage: {usage}")
+            else:
+                handler(args, param)
+            return
+        self.respond("ERROR: Unknown command")
+
+    @staticmethod
+    def parse_args(spec: str, tokens: List[str]) -> Optional[list]:
+        args, optional = [], False
+        for kind in spec:
+            if kind == "|":
+                optional = True
+                continue
+            if len(args) >= len(tokens):
+                return args if optional else None
+            tok = tokens[len(args)]
+            if kind == "u":
+                if not tok.isdigit():
+                    return None
+                args.append(int(tok) & 0xFFFFFFFF)
+            else:
+                args.append(tok)
+        return args if len(args) == len(tokens) else None
+
+    # --- capture --------------------------------------------------------
+
+    def frame_at(self, class_id: int, t: float) -> Tuple[int, int, int]:
+        rate, rows = self.dataset[class_id]
+        return rows[int(t * rate) % len(rows)]
+
+    def start_collection(self, fault: int, seconds: int, hz: int) -> bool:
+        if self.status != STATUS_IDLE:
+            if self.sample is not None:
+                self.pool_failures += 1
+            return False
+        self.sample_id += 1
+        num = seconds * hz
+        self.sample = {"id": self.sample_id, "timestamp": self.now_ms(), "fault": fault,
+                       "rate": hz, "duration_ms": seconds * 1000, "num": num,
+                       "rows": [self.frame_at(fault, i / hz) for i in range(num)]}
+        self.sample_counter = 0
+        self.capture_start = time.monotonic()
+        self.data_ready = False
+        self.pool_peak = 1
+        self.capture_sec, self.capture_hz = seconds, hz
+        self.status = STATUS_ACTIVE
+        return True
+
+    def send_chunks(self, first: int, last: int) -> bool:
+        if self.status != STATUS_COMPLETE or self.sample is None:
+            return False
+        s = self.sample
+        num_chunks = (s["num"] + AI_CHUNK_SAMPLES - 1) // AI_CHUNK_SAMPLES
+        if num_chunks > 0 and (first >= num_chunks or first > last):
+            return False
+        self.send((f"AI_SAMPLE_START\r\nID:{s['id']}\r\nTIMESTAMP:{s['timestamp']}\r\n"
+                   f"FAULT_TYPE:{s['fault']}\r\nSAMPLE_RATE:{s['rate']}\r\n"
+                   f"DURATION:{s['duration_ms']}\r\nNUM_SAMPLES:{s['num']}\r\n"
+                   f"CHUNK_SAMPLES:{AI_CHUNK_SAMPLES}\r\nNUM_CHUNKS:{num_chunks}\r\n"
+                   f"DATA_START\r\n").encode(), TX_WAIT_S)
+        for seq in range(first, min(last, num_chunks - 1) + 1):
+            rows = s["rows"][seq * AI_CHUNK_SAMPLES:(seq + 1) * AI_CHUNK_SAMPLES][:s["num"] - seq * AI_CHUNK_SAMPLES]
+            values = [v for row in rows for v in row]
+            crc = crc16_ccitt(struct.pack(f"<{len(values)}h", *values))
+            lines = [f"CHUNK:{seq},{len(rows)},{crc:04X}"] + [f"{x},{y},{z}" for x, y, z in rows]
+            self.send(("\r\n".join(lines) + "\r\n").encode(), TX_WAIT_S)
+        self.send(b"DATA_END\r\nAI_SAMPLE_END\r\n", TX_WAIT_S)
+        self.data_ready = False
+        return True
+
+    def release_sample(self) -> bool:
+        if self.status != STATUS_COMPLETE or self.sample is None:
+            return False
+        self.sample = None
+        self.status = STATUS_IDLE
+        return True
+
+    def cmd_start(self, args, fault):
+        if self.start_collection(fault, AI_SAMPLE_DURATION_SEC, AI_SAMPLE_RATE_HZ):
+            self.respond(f"OK: Started {START_NAMES[fault]} data collection")
+        else:
+            self.respond("ERROR: Failed to start collection")
+
+    def cmd_capture(self, args, _):
+        seconds = args[1] if len(args) > 1 else AI_SAMPLE_DURATION_SEC
+        hz = args[2] if len(args) > 2 else AI_SAMPLE_RATE_HZ
+        name = args[0]
+        fault = CLASS_NAMES.index(name) if name in CLASS_NAMES else \
+            int(name) if name in ("0", "1", "2", "3") else None
+        if fault is None:
+            self.respond("ERROR: Unknown class (NORMAL|IMBALANCE|BEARING|MISALIGN|0-3)")
+        elif not (1 <= hz <= AI_MAX_SAMPLE_RATE_HZ and 1 <= seconds <= AI_MAX_DURATION_SEC
+                  and seconds * hz <= AI_SAMPLES_PER_COLLECTION):
+            self.respond(f"ERROR: Out of range (hz 1-{AI_MAX_SAMPLE_RATE_HZ}, seconds 1-{AI_MAX_DURATION_SEC}, "
+                         f"hz*seconds <= {AI_SAMPLES_PER_COLLECTION})")
+        elif not self.start_collection(fault, seconds, hz):
+            self.respond("ERROR: Failed to start collection")
+        else:
+            self.respond(f"OK: CAPTURE class={fault} seconds={seconds} hz={hz} samples={seconds * hz}")
+
+    def cmd_stop(self, args, _):
+        if self.status == STATUS_ACTIVE:
+            self.sample["num"] = self.sample_counter
+            self.status = STATUS_COMPLETE
+            self.data_ready = True
+        self.respond("OK: Collection stopped")
+
+    def cmd_get_data(self, args, _):
+        if not self.send_chunks(args[0] if args else 0, 0xFFFFFFFF):
+            self.respond("ERROR: No data available")
+
+    def cmd_nack(self, args, _):
+        if not self.send_chunks(args[0], args[1] if len(args) > 1 else args[0]):
+            self.respond("ERROR: Invalid chunk range")
+
+    def cmd_ack(self, args, _):
+        if self.release_sample():
+            self.respond("OK: Sample released")
+        else:
+            self.respond("ERROR: No data to acknowledge")
+
+    def cmd_status(self, args, _):
+        self.respond(f"STATUS: {self.status}")
+
+    def cmd_reset(self, args, _):
+        self.sample = None
+        self.status = STATUS_IDLE
+        self.data_ready = False
+        self.respond("OK: System reset")
+
+    def cmd_get_events(self, args, _):
+        self.respond("BB_EVENTS:0")
+        self.respond("OK: Events sent")
+
+    def cmd_clear_events(self, args, _):
+        self.respond("OK: Events cleared")
+
+    def cmd_get_pools(self, args, _):
+        in_use = 1 if self.sample is not None else 0
+        self.respond(f"POOL:ai_sample,{AI_SAMPLE_BLOCK_SIZE},1,{in_use},{self.pool_peak},{self.pool_failures}")
+        self.respond("OK: Pool stats sent")
+
+    # --- tuning ---------------------------------------------------------
+
+    def cmd_set_odr(self, args, _):
+        if args[0] == 0:
+            self.respond("ERROR: Out of range (hz >= 1)")
+            return
+        self.odr_hz = next((hz for hz in MSA301_ODR_TABLE_HZ if hz >= args[0]), MSA301_ODR_TABLE_HZ[-1])
+        self.respond(f"OK: ODR odr_hz={self.odr_hz}")
+
+    def cmd_set_hop(self, args, _):
+        if not 1 <= args[0] <= USB_MAX_HOP_FRAMES:
+            self.respond(f"ERROR: Out of range (frames 1-{USB_MAX_HOP_FRAMES})")
+            return
+        if len(args) > 1 and args[1] >= SHARED_AI_MAX_CHANNELS:
+            self.respond(f"ERROR: Out of range (channel 0-{SHARED_AI_MAX_CHANNELS - 1})")
+            return
+        if len(args) > 1:
+            self.channel_hop[args[1]] = args[0]
+            self.respond(f"OK: HOP hop={args[0]} channel={args[1]}")
+        else:
+            self.hop = args[0]
+            self.respond(f"OK: HOP hop={self.hop}")
+
+    def cmd_set_period(self, args, _):
+        if not 1 <= args[0] <= USB_MAX_PERIOD_MS:
+            self.respond(f"ERROR: Out of range (ms 1-{USB_MAX_PERIOD_MS})")
+            return
+        self.period_ms = args[0]
+        self.respond(f"OK: PERIOD period_ms={self.period_ms}")
+
+    def cmd_set_thresh(self, args, _):
+        if args[0] > 100:
+            self.respond("ERROR: Out of range (percent 0-100)")
+            return
+        self.thresh_pct = args[0]
+        self.respond(f"OK: THRESH thresh_pct={self.thresh_pct}")
+
+    def cmd_set_gate(self, args, _):
+        if any(v > 0xFFFF for v in args):
+            self.respond("ERROR: Out of range (lsb 0-65535, 0 = metric off)")
+            return
+        self.gate.rms_max, self.gate.peak_max, self.gate.band_max = args
+        self.respond(f"OK: GATE rms_max={args[0]} peak_max={args[1]} band_max={args[2]}")
+
+    def cmd_set_decision(self, args, _):
+        if args[0] > USB_MAX_EMA_SHIFT or args[1] > USB_MAX_DWELL_MS or args[2] > USB_MAX_DWELL_MS:
+            self.respond(f"ERROR: Out of range (ema_shift 0-{USB_MAX_EMA_SHIFT}, dwell ms 0-{USB_MAX_DWELL_MS})")
+            return
+        self.ema_shift, self.enter_dwell_ms, self.exit_dwell_ms = args
+        self.respond(f"OK: DECISION ema_shift={args[0]} enter_dwell_ms={args[1]} exit_dwell_ms={args[2]}")
+
+    def cmd_set_class(self, args, _):
+        names = {name: k for k, name in enumerate(CLASS_NAMES)}
+        names.update({str(k): k for k in range(len(CLASS_NAMES))})
+        fault = names.get(args[0], 0)
+        if not fault:
+            self.respond("ERROR: Unknown fault class (IMBALANCE, BEARING, MISALIGN or 1-3)")
+            return
+        if args[1] > 100 or args[2] > 100 or (args[1] and args[2] > args[1]):
+            self.respond("ERROR: Out of range (percent 0-100, exit <= enter)")
+            return
+        self.enter_pct[fault], self.exit_pct[fault] = args[1], args[2]
+        self.respond(f"OK: CLASS class={fault} enter_pct={args[1]} exit_pct={args[2]}")
+
+    def cmd_get_config(self, args, _):
+        self.respond(f"OK: CONFIG capture_hz={self.capture_hz} capture_sec={self.capture_sec} "
+                     f"capture_max_samples={AI_SAMPLES_PER_COLLECTION} odr_hz={self.odr_hz} "
+                     f"hop={self.hop} channel_hop={','.join(map(str, self.channel_hop))} "
+                     f"period_ms={self.period_ms} thresh_pct={self.thresh_pct} "
+                     f"ema_shift={self.ema_shift} enter_dwell_ms={self.enter_dwell_ms} "
+                     f"exit_dwell_ms={self.exit_dwell_ms} enter_pct={','.join(map(str, self.enter_pct[1:]))} "
+                     f"exit_pct={','.join(map(str, self.exit_pct[1:]))}")
+
+    def cmd_get_perf(self, args, _):
+        self.respond(f"OK: PERF frames={self.frames} ring_drops=0 read_errors=0 infer_count={self.infer_count} "
+                     f"gated={self.gated_count} infer_last_us=0 infer_max_us=0 infer_avg_us=0 dlog_dropped=0 rx_overflows=0 "
+                     f"tx_sent={self.tx_sent} tx_dropped={self.tx_dropped} tx_transfers={self.tx_transfers}")
+
+    def cmd_get_gate(self, args, _):
+        g = self.gate
+        self.respond(f"OK: GATE rms_max={g.rms_max} peak_max={g.peak_max} band_max={g.band_max} "
+                     f"window={SHARED_GATE_WINDOW_FRAMES} rms={g.rms} peak={g.peak} band={g.band} "
+                     f"quiet={int(g.quiet)} frames={g.frames} quiet_frames={g.quiet_frames} "
+                     f"gated={self.gated_count} infer_count={self.infer_count}")
+
+    def cmd_get_bench(self, args, _):
+        # No CM7 here, so never a placement benchmark
+        self.respond("ERROR: No placement benchmark (build CM7 with AI_PLACEMENT_BENCH=1)")
+
+    def cmd_get_engine(self, args, _):
+        self.respond("ERROR: No engine benchmark (build CM7 with AI_ENGINE_BENCH=1)")
+
+    def cmd_get_profile(self, args, _):
+        self.respond("ERROR: No layer profile (build CM7 with AI_PROFILING=1)")
+
+    def cmd_get_channels(self, args, _):
+        # A single-channel CM7 build with the default round-robin policy (no offload)
+        elapsed = max(time.monotonic() - self.start, 1e-3)
+        wps_x100 = int((self.infer_count + self.gated_count) * 100 / elapsed)
+        self.respond(f"CHANNEL:0,{self.channel_hop[0] or self.hop},{self.infer_count},{self.gated_count},0,"
+                     f"{min(wps_x100, 0xFFFF)},{self.stream_class},{self.decision.state}")
+        self.respond("OK: CHANNELS channels=1 policy=round_robin util_permille=0 dropped_frames=0 "
+                     "offloaded=0 cm4_util_permille=0")
+
+    def cmd_get_offload(self, args, _):
+        self.respond("ERROR: No offload benchmark (build CM7 with AI_OFFLOAD_BENCH=1)")
+
+    def read_event(self, cursor: int) -> Tuple[int, Optional[tuple], int]:
+        # shared_read_ai_event(): skip what the ring may be overwriting, then one event
+        lost = 0
+        if self.event_count - cursor >= SHARED_AI_EVENTS:
+            lost = self.event_count - SHARED_AI_EVENTS + 1 - cursor
+            cursor = self.event_count - SHARED_AI_EVENTS + 1
+        return cursor + 1, self.events[cursor % SHARED_AI_EVENTS], lost
+
+    def cmd_get_decisions(self, args, _):
+        n = lost = 0
+        while self.decision_cursor != self.event_count:
+            self.decision_cursor, ev, skipped = self.read_event(self.decision_cursor)
+            lost += skipped
+            self.respond("DECISION:{0},{3},{4},{5},{6},{2},{1}".format(*ev))
+            n += 1
+        self.respond(f"OK: DECISIONS events={n} lost={lost}")
+
+    # --- model hot-swap -------------------------------------------------
+
+    def cmd_model_begin(self, args, _):
+        if not 0 < args[0] <= model_bundle.STAGE_SIZE:
+            self.respond("ERROR: Model out of range")
+            return
+        self.model_size, self.model_crc = args
+        self.model_stage = bytearray(self.model_size)
+        self.model_received = 0
+        self.model_active = True
+        self.respond(f"OK: MODEL size={self.model_size} chunk={model_bundle.CHUNK_BYTES}")
+
+    def cmd_model_data(self, args, _):
+        offset, text = args
+        if not self.model_active:
+            self.respond("ERROR: Model no transfer")
+            return
+        try:
+            if not text or len(text) % 2 or len(text) // 2 > model_bundle.CHUNK_BYTES:
+                raise ValueError
+            chunk = bytes.fromhex(text)
+        except ValueError:
+            self.respond("ERROR: Model bad hex")
+            return
+        if offset > self.model_received or offset + len(chunk) > self.model_size:
+            self.respond("ERROR: Model out of range")
+            return
+        self.model_stage[offset:offset + len(chunk)] = chunk
+        self.model_received = max(self.model_received, offset + len(chunk))
+        self.respond(f"OK: MODEL received={self.model_received}")
+
+    def cmd_model_commit(self, args, _):
+        if not self.model_active:
+            self.respond("ERROR: Model no transfer")
+            return
+        if self.model_received != self.model_size:
+            self.respond("ERROR: Model incomplete")
+            return
+        self.model_active = False
+        data = bytes(self.model_stage)
+        if zlib.crc32(data) & 0xFFFFFFFF != self.model_crc:
+            self.respond("ERROR: Model crc mismatch")
+            return
+        self.model_load(data)
+        self.respond(f"OK: MODEL request={self.model['request']} source=stage")
+
+    def cmd_model_flash(self, args, _):
+        # Nothing programmed at 0x080E0000 on a simulated board
+        self.model_active = False
+        self.model_load(b"")
+        self.respond(f"OK: MODEL request={self.model['request']} source=flash")
+
+    def model_load(self, data: bytes):
+        m = self.model
+        m["request"] += 1
+        m["status"] = model_bundle.check_bundle(data, self.model_target)
+        if m["status"] == 0:
+            h = model_bundle.parse_bundle(data)
+            m["slot"] = 2 if m["slot"] == 1 else 1
+            m["swaps"] += 1
+            m["hash"] = h["model_hash"]
+            m["labels"] = h["labels"]
+
+    def cmd_get_model(self, args, _):
+        m = self.model
+        for c, label in enumerate(m["labels"]):
+            self.respond(f"LABEL:{c},{label}")
+        self.respond(f"OK: MODEL hash={m['hash']} slot={m['slot']} status={model_bundle.STATUS_NAMES[m['status']]} "
+                     f"swaps={m['swaps']} swap_us=0 request={m['request']} pending=0")
+
+    def cmd_help(self, args, _):
+        for entry in self.table:
+            self.respond(entry[2])
+        self.respond("OK: Help sent")
+
+    # --- stream ---------------------------------------------------------
+
+    def cmd_stream_on(self, args, _):
+        if len(args) > 1 and args[1] not in ("ALL", "DECISIONS"):
+            self.respond("ERROR: Usage: STREAM ON [<credits>] [ALL|DECISIONS]")
+            return
+        self.content = STREAM_CONTENT_DECISIONS if len(args) > 1 and args[1] == "DECISIONS" else STREAM_CONTENT_ALL
+        self.credits = min(args[0] if args else STREAM_DEFAULT_CREDITS, STREAM_MAX_CREDITS)
+        self.queue.clear()
+        self.pending_results.clear()
+        self.stream_cursor = self.event_count
+        self.packet_seq = 0
+        self.st = {"queued": 0, "dropped": 0, "packets": 0, "stalls": 0, "lost": 0, "tx_drops": 0}
+        self.last_stats = time.monotonic()
+        self.streaming = True
+        self.respond(f"OK: STREAM state=on credits={self.credits} "
+                     f"content={'decisions' if self.content == STREAM_CONTENT_DECISIONS else 'all'}")
+
+    def cmd_stream_off(self, args, _):
+        self.streaming = False
+        self.respond(f"OK: STREAM state=off frames={self.st['queued']} dropped={self.st['dropped']} "
+                     f"packets={self.st['packets']} credit_stalls={self.st['stalls']} decisions_lost={self.st['lost']} "
+                     f"tx_drops={self.st['tx_drops']}")
+
+    def cmd_stream_credit(self, args, _):
+        # No reply, as on the board
+        self.credits = min(self.credits + args[0], STREAM_MAX_CREDITS)
+
+    def send_packet(self, ptype: int, payload: bytes):
+        body = struct.pack("<BHH", ptype, self.packet_seq, len(payload)) + payload
+        self.packet_seq = (self.packet_seq + 1) & 0xFFFF
+        self.credits -= 1
+        if self.send(b"\xA5\x5A" + body + struct.pack("<H", crc16_ccitt(body)), TX_WAIT_S):
+            self.st["packets"] += 1
+        else:
+            self.st["tx_drops"] += 1
+
+    def acquire(self, now: float):
+        # AcquisitionTask: frames at the ODR (or as fast as the stream drains when speed is 0)
+        if self.speed > 0:
+            due = int((now - self.last_acq) * self.odr_hz * self.speed)
+            if due == 0:
+                return
+            self.last_acq += due / (self.odr_hz * self.speed)
+        else:
+            due = STREAM_QUEUE_FRAMES - len(self.queue) if self.streaming else 0
+        for _ in range(due):
+            t = self.frames / self.odr_hz
+            x, y, z = self.frame_at(self.stream_class, t)
+            quiet = self.gate.feed((x, y, z))
+            frame = (self.frames, int(t * 1000) & 0xFFFFFFFF, x, y, z)
+            self.frames += 1
+            if self.streaming and self.content == STREAM_CONTENT_ALL:
+                if len(self.queue) < STREAM_QUEUE_FRAMES:
+                    if not self.queue:
+                        self.queue_since = now
+                    self.queue.append(frame)
+                    self.st["queued"] += 1
+                else:
+                    self.st["dropped"] += 1
+            # CM7 stand-in: one result per hop once a full window is buffered; quiet
+            # windows repeat the last decision without inference
+            self.since_infer += 1
+            if self.frames >= AI_WINDOW_FRAMES and self.since_infer >= (self.channel_hop[0] or self.hop):
+                self.since_infer = 0
+                if quiet and self.infer_count:
+                    self.gated_count += 1
+                else:
+                    self.infer_count += 1
+                scores = [-128] * len(CLASS_NAMES)
+                scores[self.stream_class] = 127
+                state = self.decide(scores, frame[1])
+                if self.streaming and self.content == STREAM_CONTENT_ALL:
+                    self.pending_results.append(struct.pack("<IIB4bBBx", self.infer_count, frame[1],
+                                                            self.stream_class, *scores, 0, state))
+
+    def decide(self, scores: List[int], ts: int) -> int:
+        # ai_channel_decide(): fold the window into the decision stage, publish a change
+        d = self.decision
+        d.ema_shift, d.enter_dwell_ms, d.exit_dwell_ms = self.ema_shift, self.enter_dwell_ms, self.exit_dwell_ms
+        d.enter_pct, d.exit_pct = resolve_thresholds(self.thresh_pct, self.enter_pct, self.exit_pct)
+        change = d.update(score_probs(scores), ts)
+        if change:
+            ev = (self.event_count + 1, ts, change["onset_ts"], 0, change["from"], change["to"],
+                  change["confidence_pct"])
+            if len(self.events) < SHARED_AI_EVENTS:
+                self.events.append(ev)
+            else:
+                self.events[self.event_count % SHARED_AI_EVENTS] = ev
+            self.event_count += 1
+        return d.state
+
+    def pump_stream(self, now: float):
+        if not self.streaming:
+            return
+        while self.stream_cursor != self.event_count and self.credits > 0:
+            self.stream_cursor, ev, lost = self.read_event(self.stream_cursor)
+            self.st["lost"] += lost
+            self.send_packet(PKT_DECISION, struct.pack("<IIIBBBB", ev[0], ev[1], ev[2], *ev[3:]))
+        while self.pending_results and self.credits > 0:
+            self.send_packet(PKT_RESULT, self.pending_results.pop(0))
+        latency_hit = self.speed > 0 and (now - self.queue_since) * 1000 * self.speed >= STREAM_MAX_LATENCY_MS
+        while self.queue and (len(self.queue) >= STREAM_FRAMES_PER_PACKET or latency_hit):
+            if self.credits <= 0:
+                self.st["stalls"] += 1
+                break
+            batch = self.queue[:STREAM_FRAMES_PER_PACKET]
+            del self.queue[:len(batch)]
+            self.queue_since = now
+            payload = struct.pack("<IHH", batch[0][0], len(batch), 0) + \
+                b"".join(struct.pack("<Ihhh", *f[1:]) for f in batch)
+            self.send_packet(PKT_SAMPLES, payload)
+        if (now - self.last_stats) * 1000 >= STREAM_STATS_PERIOD_MS and self.credits > 0:
+            self.last_stats = now
+            self.send_packet(PKT_STATS, struct.pack("<IIII", self.st["queued"], self.st["dropped"],
+                                                    self.st["packets"], self.st["stalls"]))
+
+    def tick(self):
+        now = time.monotonic()
+        if self.status == STATUS_ACTIVE:
+            s = self.sample
+            elapsed = (now - self.capture_start) * self.speed if self.speed > 0 else float("inf")
+            self.sample_counter = int(min(elapsed * s["rate"], s["num"]))
+            if self.sample_counter >= s["num"]:
+                self.status = STATUS_COMPLETE
+                self.data_ready = True
+        # AIDataCollectionTask sends a finished sample once on its own
+        if self.status == STATUS_COMPLETE and self.data_ready:
+            self.send_chunks(0, 0xFFFFFFFF)
+        self.acquire(now)
+        self.pump_stream(now)
+
+
+class PtyLink:
+    # Master side of the PTY: non-blocking writes bounded like usb_tx_wait_free(), optional rate limit
+
+    def __init__(self, link_kib: float = 0.0):
+        self.master, self.slave = os.openpty()
+        tty.setraw(self.slave)
+        flags = fcntl.fcntl(self.master, fcntl.F_GETFL)
+        fcntl.fcntl(self.master, fcntl.F_SETFL, flags | os.O_NONBLOCK)
+        self.path = os.ttyname(self.slave)
+        self.link_kib = link_kib
+
+    def write(self, data: bytes, wait: float) -> bool:
+        deadline = time.monotonic() + wait
+        view = memoryview(data)
+        while view:
+            try:
+                n = os.write(self.master, view)
+                view = view[n:]
+            except BlockingIOError:
+                remaining = deadline - time.monotonic()
+                if remaining <= 0:
+                    return False
+                select.select([], [self.master], [], remaining)
+        if self.link_kib > 0:
+            time.sleep(len(data) / (self.link_kib * 1024))
+        return True
+
+    def read(self) -> bytes:
+        try:
+            return os.read(self.master, 4096)
+        except (BlockingIOError, OSError):
+            return b""
+
+
+def serve(board: SimulatedBoard, link: PtyLink, stop: threading.Event):
+    # Poll period stands in for the firmware task periods; short enough not to dominate latency
+    while not stop.is_set():
+        readable, _, _ = select.select([link.master], [], [], 0.002)
+        if readable:
+            data = link.read()
+            if data:
+                board.feed(data)
+        board.tick()
+
+
+class FdPort:
+    # Minimal pyserial-like wrapper over the PTY slave, used by the benchmark client
+
+    def __init__(self, path: str, timeout: float = 1.0):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        self.timeout = timeout
+        self.buf = bytearray()
+        self.bytes_in = 0
+        self.is_open = True
+
+    @property
+    def in_waiting(self) -> int:
+        pending = struct.unpack("I", fcntl.ioctl(self.fd, termios.FIONREAD, b"\0\0\0\0"))[0]
+        return len(self.buf) + pending
+
+    def _fill(self, timeout: float) -> bool:
+        readable, _, _ = select.select([self.fd], [], [], timeout)
+        if not readable:
+            return False
+        data = os.read(self.fd, 65536)
+        self.bytes_in += len(data)
+        self.buf.extend(data)
+        return bool(data)
+
+    def read(self, size: int = 1) -> bytes:
+        if not self.buf:
+            self._fill(self.timeout)
+        data = bytes(self.buf[:size])
+        del self.buf[:size]
+        return data
+
+    def readline(self) -> bytes:
+        deadline = time.monotonic() + self.timeout
+        while b"\n" not in self.buf:
+            remaining = deadline - time.monotonic()
+            if remaining <= 0 or not self._fill(remaining):
+                break
+        end = self.buf.find(b"\n") + 1 or len(self.buf)
+        line = bytes(self.buf[:end])
+        del self.buf[:end]
+        return line
+
+    def write(self, data: bytes) -> int:
+        return os.write(self.fd, data)
+
+    def flushInput(self):
+        while self._fill(0):
+            pass
+        self.buf.clear()
+
+    def flushOutput(self):
+        pass
+
+    def close(self):
+        if self.is_open:
+            os.close(self.fd)
+            self.is_open = False
+
+
+def bench_latency(port: FdPort, rounds: int) -> Dict[str, float]:
+    times = []
+    for _ in range(rounds):
+        t0 = time.perf_counter()
+        port.write(b"STATUS\r\n")
+        while not port.readline().startswith(b"STATUS:"):
+            pass
+        times.append((time.perf_counter() - t0) * 1000)
+    times.sort()
+    return {"rounds": rounds, "mean_ms": statistics.mean(times), "p50_ms": times[len(times) // 2],
+            "p95_ms": times[int(len(times) * 0.95) - 1], "max_ms": times[-1]}
+
+
+def bench_ascii(port: FdPort, seconds: int, rate_hz: int) -> Dict[str, float]:
+    # The real collector: CAPTURE, chunk/CRC verification, ACK
+    from data_collector import STM32DataCollector, MotorFaultType
+
+    collector = STM32DataCollector(port="simulator")
+    collector.serial_conn = port
+    collector.is_connected = True
+    bytes0 = port.bytes_in
+    cpu0, t0 = time.thread_time(), time.perf_counter()
+    sample = collector.collect_sample(MotorFaultType.NORMAL, "bench", seconds=seconds, rate_hz=rate_hz)
+    wall, cpu = time.perf_counter() - t0, time.thread_time() - cpu0
+    samples = sample.num_samples if sample else 0
+    return {"samples": samples, "wall_s": wall, "cpu_s": cpu, "bytes": port.bytes_in - bytes0}
+
+
+def bench_binary(port: FdPort, frames: int, window: int) -> Dict[str, float]:
+    # stream_receiver.py parser and credit loop, until `frames` frames have arrived
+    from stream_receiver import StreamParser, StreamStats
+
+    stats = StreamStats()
+    parser = StreamParser(stats.on_packet)
+    bytes0 = port.bytes_in
+    cpu0, t0 = time.thread_time(), time.perf_counter()
+    port.write(f"STREAM ON {window}\r\n".encode())
+    granted = window
+    deadline = time.monotonic() + 60
+    while stats.frames < frames and time.monotonic() < deadline:
+        if port._fill(0.05):
+            parser.feed(bytes(port.buf))
+            port.buf.clear()
+        outstanding = granted - stats.credits_used
+        if outstanding < window // 2:
+            port.write(f"STREAM CREDIT {window - outstanding}\r\n".encode())
+            granted += window - outstanding
+    wall, cpu = time.perf_counter() - t0, time.thread_time() - cpu0
+    received = port.bytes_in - bytes0
+
+    # Drain up to the STREAM OFF reply so the next run starts clean
+    done = threading.Event()
+    parser.on_text = lambda line: done.set() if line.startswith("OK: STREAM state=off") else None
+    port.write(b"STREAM OFF\r\n")
+    while not done.is_set() and port._fill(1.0):
+        parser.feed(bytes(port.buf))
+        port.buf.clear()
+    return {"samples": stats.frames, "wall_s": wall, "cpu_s": cpu, "bytes": received,
+            "lost_frames": stats.lost_frames, "crc_errors": parser.crc_errors}
+
+
+def run_bench(args, dataset) -> dict:
+    link = PtyLink(args.link_kib)
+    board = SimulatedBoard(dataset, link.write, speed=0.0)
+    stop = threading.Event()
+    server = threading.Thread(target=serve, args=(board, link, stop), daemon=True)
+    server.start()
+    port = FdPort(link.path, timeout=1.0)
+    try:
+        results = {"latency": bench_latency(port, args.rounds)}
+        results["ascii"] = bench_ascii(port, args.seconds, args.rate)
+        results["binary"] = bench_binary(port, args.seconds * args.rate, args.window)
+    finally:
+        stop.set()
+        server.join()
+        port.close()
+
+    lat = results["latency"]
+    print(f"Command latency (STATUS x{lat['rounds']}): mean {lat['mean_ms']:.2f} ms, "
+          f"p50 {lat['p50_ms']:.2f} ms, p95 {lat['p95_ms']:.2f} ms, max {lat['max_ms']:.2f} ms")
+    print(f"{'protocol':<8} {'samples':>8} {'wall s':>8} {'samples/s':>10} {'B/sample':>9} "
+          f"{'cpu s':>7} {'cpu us/sample':>14}")
+    for name in ("ascii", "binary"):
+        r = results[name]
+        n = max(r["samples"], 1)
+        r["samples_per_s"] = r["samples"] / max(r["wall_s"], 1e-9)
+        r["cpu_us_per_sample"] = r["cpu_s"] * 1e6 / n
+        print(f"{name:<8} {r['samples']:>8} {r['wall_s']:>8.3f} {r['samples_per_s']:>10.0f} "
+              f"{r['bytes'] / n:>9.1f} {r['cpu_s']:>7.3f} {r['cpu_us_per_sample']:>14.2f}")
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Simulate the CM4 USB-CDC interface on a pseudo-terminal.")
+    parser.add_argument("--data", default=os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                                       "..", "collected_data"),
+                        help="collected_data directory with <class>/*.csv traces")
+    parser.add_argument("--speed", type=float, default=1.0,
+                        help="Time scale for captures and acquisition (0 = as fast as possible)")
+    parser.add_argument("--stream-class", type=int, default=0, choices=range(len(CLASS_NAMES)),
+                        help="Class replayed by the live acquisition/stream")
+    parser.add_argument("--link-kib", type=float, default=0.0, help="Throttle output to N KiB/s (0 = unlimited)")
+    parser.add_argument("--bench", action="store_true", help="Run the ASCII vs binary benchmark and exit")
+    parser.add_argument("--rounds", type=int, default=200, help="Benchmark: STATUS round trips")
+    parser.add_argument("--seconds", type=int, default=AI_SAMPLE_DURATION_SEC, help="Benchmark: capture seconds")
+    parser.add_argument("--rate", type=int, default=AI_SAMPLE_RATE_HZ, help="Benchmark: capture rate (Hz)")
+    parser.add_argument("--window", type=int, default=64, help="Benchmark: stream credit window")
+    parser.add_argument("--json", default="", help="Benchmark: also write the results to this file")
+    args = parser.parse_args()
+
+    dataset = load_dataset(args.data)
+
+    if args.bench:
+        results = run_bench(args, dataset)
+        if args.json:
+            with open(args.json, "w") as f:
+                json.dump(results, f, indent=2)
+        ok = results["ascii"]["samples"] == args.seconds * args.rate and \
+            results["binary"]["samples"] >= args.seconds * args.rate
+        return 0 if ok else 1
+
+    link = PtyLink(args.link_kib)
+    board = SimulatedBoard(dataset, link.write, speed=args.speed, stream_class=args.stream_class)
+    print(f"Simulated board on {link.path} (Ctrl-C to stop)", flush=True)
+    stop = threading.Event()
+    try:
+        serve(board, link, stop)
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -11,6 +11,7 @@ import numpy as np
 import pandas as pd
 import json
 import os
+import struct
 from datetime import datetime
 from typing import Dict, List, Optional, Tuple
 import logging
@@ -21,6 +22,27 @@ from enum import Enum
 logging.basicConfig(level=logging.INFO, format='%(asctime)s - %(levelname)s - %(message)s')
 logger = logging.getLogger(__name__)
 
+def crc16_ccitt(data: bytes, crc: int = 0xFFFF) -> int:
+    """CRC-16/CCITT-FALSE, matches crc16_ccitt_update() in the CM4 firmware"""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def missing_ranges(missing: List[int]) -> List[Tuple[int, int]]:
+    """Collapse sorted chunk numbers into inclusive (first, last) ranges"""
+    ranges = []
+    for seq in missing:
+        if ranges and seq == ranges[-1][1] + 1:
+            ranges[-1] = (ranges[-1][0], seq)
+        else:
+            ranges.append((seq, seq))
+    return ranges
+
+
 class MotorFaultType(Enum):
     """Motor fault types matching STM32 firmware"""
     NORMAL = 0
@@ -62,6 +84,8 @@ class STM32DataCollector:
         self.serial_conn = None
         self.is_connected = False
         self.collected_samples = []
+        # Partially received sample kept across timeouts so the offload can resume
+        self.pending_transfer = None
         
     def connect(self) -> bool:
         """
@@ -167,14 +191,47 @@ class STM32DataCollector:
             logger.error(f"Failed to read response: {str(e)}")
             return None
     
+    def query(self, command: str) -> Optional[Dict[str, int]]:
+        """
+        Send a command with a machine-readable reply ("OK: <NAME> key=value ...")
+
+        Args:
+            command: e.g. "GET CONFIG", "GET PERF", "SET HOP 10"
+
+        Returns:
+            Dictionary of the key=value fields, or None on error/timeout
+        """
+        if not self.send_command(command):
+            return None
+        response = self.read_response()
+        if not response:
+            return None
+        line = response.splitlines()[-1]
+        if not line.startswith("OK:"):
+            logger.error(f"{command} failed: {line}")
+            return None
+        fields = {}
+        for token in line[3:].split():
+            if '=' in token:
+                key, value = token.split('=', 1)
+                try:
+                    fields[key] = int(value)
+                except ValueError:
+                    fields[key] = value
+        return fields
+
     def collect_sample(self, fault_type: MotorFaultType, 
-                      sample_description: str = "") -> Optional[MotorSample]:
+                      sample_description: str = "",
+                      seconds: Optional[int] = None,
+                      rate_hz: Optional[int] = None) -> Optional[MotorSample]:
         """
         Collect a single vibration sample from the motor
         
         Args:
             fault_type: Type of motor fault to collect
             sample_description: Optional description for the sample
+            seconds: Capture duration (firmware default if None)
+            rate_hz: Capture rate (firmware default if None)
             
         Returns:
             MotorSample object or None if collection failed
@@ -195,6 +252,15 @@ class STM32DataCollector:
         if not command:
             logger.error(f"Unknown fault type: {fault_type}")
             return None
+        if seconds is not None or rate_hz is not None:
+            command = f"CAPTURE {fault_type.value}"
+            if seconds is not None:
+                command += f" {seconds}"
+                if rate_hz is not None:
+                    command += f" {rate_hz}"
+            elif rate_hz is not None:
+                logger.error("rate_hz needs seconds")
+                return None
         
         logger.info(f"Starting data collection for {fault_type.name}")
         
@@ -223,84 +289,188 @@ class STM32DataCollector:
             logger.error("Failed to collect sample data")
             return None
     
-    def wait_for_sample_data(self, max_wait_time: float = 30.0) -> Optional[MotorSample]:
+    def _read_sample_frame(self, max_wait_time: float) -> Tuple[Dict, Dict[int, List[Tuple[int, int, int]]]]:
         """
-        Wait for sample data transmission from STM32
-        
-        Args:
-            max_wait_time: Maximum time to wait for data
-            
+        Read one AI_SAMPLE_START ... AI_SAMPLE_END frame
+
+        Each chunk is "CHUNK:<seq>,<count>,<crc>" followed by <count> "x,y,z"
+        lines. Chunks with a bad line, a short count or a CRC mismatch are
+        dropped so they show up as missing and get retransmitted.
+
         Returns:
-            MotorSample object or None if timeout/error
+            (sample_info, {seq: [(x, y, z), ...]}) for the chunks that verified
         """
         start_time = time.time()
-        buffer = ""
         in_data_section = False
         sample_info = {}
-        data_lines = []
-        
+        chunks = {}
+        chunk = None
+
+        def close_chunk():
+            if chunk is None:
+                return
+            values = [v for row in chunk['rows'] for v in row]
+            payload = struct.pack(f'<{len(values)}h', *values)
+            if chunk['valid'] and len(chunk['rows']) == chunk['count'] and \
+                    crc16_ccitt(payload) == chunk['crc']:
+                chunks[chunk['seq']] = chunk['rows']
+            else:
+                logger.warning(f"Chunk {chunk['seq']} failed verification")
+
         while (time.time() - start_time) < max_wait_time:
             if self.serial_conn.in_waiting > 0:
-                line = self.serial_conn.readline().decode('utf-8').strip()
-                
-                if line == "AI_SAMPLE_START":
-                    logger.info("Sample data transmission started")
+                line = self.serial_conn.readline().decode('utf-8', errors='replace').strip()
+
+                if line.startswith("#D:"):
+                    # Deferred log record interleaved by DLogTask (see dlog_decode.py)
                     continue
+                elif line == "AI_SAMPLE_START":
+                    logger.info("Sample data transmission started")
                 elif line == "DATA_START":
                     in_data_section = True
-                    continue
                 elif line == "DATA_END":
+                    close_chunk()
+                    chunk = None
                     in_data_section = False
-                    continue
                 elif line == "AI_SAMPLE_END":
                     logger.info("Sample data transmission completed")
                     break
-                elif line.startswith("ID:"):
-                    sample_info['sample_id'] = int(line.split(':')[1])
-                elif line.startswith("TIMESTAMP:"):
-                    sample_info['timestamp'] = int(line.split(':')[1])
-                elif line.startswith("FAULT_TYPE:"):
-                    sample_info['fault_type'] = MotorFaultType(int(line.split(':')[1]))
-                elif line.startswith("SAMPLE_RATE:"):
-                    sample_info['sample_rate'] = int(line.split(':')[1])
-                elif line.startswith("DURATION:"):
-                    sample_info['duration_ms'] = int(line.split(':')[1])
-                elif line.startswith("NUM_SAMPLES:"):
-                    sample_info['num_samples'] = int(line.split(':')[1])
-                elif in_data_section and ',' in line:
-                    data_lines.append(line)
-            
-            time.sleep(0.01)
-        
-        # Parse collected data
-        if data_lines and sample_info:
-            return self.parse_sample_data(sample_info, data_lines)
+                elif line.startswith("ERROR:"):
+                    logger.error(f"Transfer refused: {line}")
+                    break
+                elif in_data_section and line.startswith("CHUNK:"):
+                    close_chunk()
+                    try:
+                        seq, count, crc = line[6:].split(',')
+                        chunk = {'seq': int(seq), 'count': int(count), 'crc': int(crc, 16),
+                                 'rows': [], 'valid': True}
+                    except ValueError:
+                        logger.warning(f"Invalid chunk header: {line}")
+                        chunk = None
+                elif in_data_section and chunk is not None:
+                    try:
+                        x, y, z = map(int, line.split(','))
+                        chunk['rows'].append((x, y, z))
+                    except ValueError:
+                        chunk['valid'] = False
+                elif not in_data_section and ':' in line:
+                    key, value = line.split(':', 1)
+                    try:
+                        if key == 'ID':
+                            sample_info['sample_id'] = int(value)
+                        elif key == 'TIMESTAMP':
+                            sample_info['timestamp'] = int(value)
+                        elif key == 'FAULT_TYPE':
+                            sample_info['fault_type'] = MotorFaultType(int(value))
+                        elif key == 'SAMPLE_RATE':
+                            sample_info['sample_rate'] = int(value)
+                        elif key == 'DURATION':
+                            sample_info['duration_ms'] = int(value)
+                        elif key == 'NUM_SAMPLES':
+                            sample_info['num_samples'] = int(value)
+                        elif key == 'NUM_CHUNKS':
+                            sample_info['num_chunks'] = int(value)
+                    except ValueError:
+                        logger.warning(f"Invalid header line: {line}")
+            else:
+                time.sleep(0.01)
+
+        return sample_info, chunks
+
+    def wait_for_sample_data(self, max_wait_time: float = 30.0,
+                             max_retries: int = 5) -> Optional[MotorSample]:
+        """
+        Receive a sample, NACK missing or corrupt chunk ranges and ACK when complete
+
+        A transfer that is still incomplete after max_retries stays in
+        self.pending_transfer and can be finished with resume_transfer().
+
+        Args:
+            max_wait_time: Maximum time to wait for each frame
+            max_retries: Number of NACK rounds before giving up
+
+        Returns:
+            MotorSample object or None if timeout/error
+        """
+        self._merge_frame(*self._read_sample_frame(max_wait_time))
+
+        for attempt in range(max_retries + 1):
+            pending = self.pending_transfer
+            if pending is None:
+                logger.error("Incomplete sample data received")
+                return None
+
+            missing = [seq for seq in range(pending['info']['num_chunks'])
+                       if seq not in pending['chunks']]
+            if not missing:
+                self.send_command("ACK")
+                self.read_response()
+                self.pending_transfer = None
+                return self.parse_sample_data(pending['info'], pending['chunks'])
+
+            if attempt == max_retries:
+                break
+
+            # Ask only for what is missing; each NACK answers with its own frame
+            ranges = missing_ranges(missing)
+            logger.warning(f"Missing {len(missing)} chunk(s), requesting {ranges}")
+            for first, last in ranges:
+                self.send_command(f"NACK {first} {last}")
+                self._merge_frame(*self._read_sample_frame(max_wait_time))
+
+        logger.error("Sample transfer incomplete, call resume_transfer() to continue")
+        return None
+
+    def _merge_frame(self, sample_info: Dict, chunks: Dict[int, List[Tuple[int, int, int]]]):
+        """Add verified chunks to the pending transfer, restarting it on a new sample ID"""
+        if 'num_chunks' not in sample_info:
+            return
+        pending = self.pending_transfer
+        if pending is None or pending['info'].get('sample_id') != sample_info.get('sample_id'):
+            pending = {'info': sample_info, 'chunks': {}}
+            self.pending_transfer = pending
+        pending['chunks'].update(chunks)
+
+    def resume_transfer(self, max_wait_time: float = 30.0) -> Optional[MotorSample]:
+        """
+        Continue an interrupted offload from the first missing chunk
+
+        Returns:
+            MotorSample object or None if the transfer is still incomplete
+        """
+        pending = self.pending_transfer
+        if pending is None:
+            self.send_command("GET_DATA")
         else:
-            logger.error("Incomplete sample data received")
-            return None
-    
-    def parse_sample_data(self, sample_info: Dict, data_lines: List[str]) -> MotorSample:
+            first = next(seq for seq in range(pending['info']['num_chunks'])
+                         if seq not in pending['chunks'])
+            self.send_command(f"GET_DATA {first}")
+
+        sample = self.wait_for_sample_data(max_wait_time)
+        if sample:
+            self.collected_samples.append(sample)
+        return sample
+
+    def parse_sample_data(self, sample_info: Dict,
+                          chunks: Dict[int, List[Tuple[int, int, int]]]) -> MotorSample:
         """
-        Parse raw sample data into MotorSample object
-        
+        Assemble verified chunks into a MotorSample object
+
         Args:
             sample_info: Sample metadata
-            data_lines: Raw data lines in format "x,y,z"
-            
+            chunks: Rows of (x, y, z) keyed by chunk sequence number
+
         Returns:
             MotorSample object
         """
         x_data, y_data, z_data = [], [], []
-        
-        for line in data_lines:
-            try:
-                x, y, z = map(int, line.split(','))
+
+        for seq in sorted(chunks):
+            for x, y, z in chunks[seq]:
                 x_data.append(x)
                 y_data.append(y)
                 z_data.append(z)
-            except ValueError:
-                logger.warning(f"Skipping invalid data line: {line}")
-        
+
         return MotorSample(
             sample_id=sample_info['sample_id'],
             timestamp=sample_info['timestamp'],
@@ -314,6 +484,61 @@ class STM32DataCollector:
             metadata={}
         )
     
+    def fetch_events(self, max_wait_time: float = 30.0) -> List[Dict]:
+        """
+        Download the black box event records captured around fault decisions
+
+        Args:
+            max_wait_time: Maximum time to wait for the transfer
+
+        Returns:
+            List of event dictionaries (metadata plus ts/x/y/z lists)
+        """
+        if not self.send_command("GET_EVENTS"):
+            return []
+
+        events = []
+        event = None
+        in_data_section = False
+        start_time = time.time()
+
+        while (time.time() - start_time) < max_wait_time:
+            if self.serial_conn.in_waiting > 0:
+                line = self.serial_conn.readline().decode('utf-8').strip()
+
+                if line == "BB_EVENT_START":
+                    event = {'ts': [], 'x': [], 'y': [], 'z': []}
+                elif line == "DATA_START":
+                    in_data_section = True
+                elif line == "DATA_END":
+                    in_data_section = False
+                elif line == "BB_EVENT_END" and event is not None:
+                    events.append(event)
+                    event = None
+                elif line.startswith("OK:") or line.startswith("ERROR:"):
+                    break
+                elif event is not None and in_data_section and ',' in line:
+                    try:
+                        ts, x, y, z = map(int, line.split(','))
+                    except ValueError:
+                        logger.warning(f"Skipping invalid event line: {line}")
+                        continue
+                    event['ts'].append(ts)
+                    event['x'].append(x)
+                    event['y'].append(y)
+                    event['z'].append(z)
+                elif event is not None and ':' in line:
+                    key, value = line.split(':', 1)
+                    if key == 'SCORES':
+                        event['scores'] = [int(v) for v in value.split(',')]
+                    else:
+                        event[key.lower()] = int(value)
+            else:
+                time.sleep(0.01)
+
+        logger.info(f"Received {len(events)} black box event(s)")
+        return events
+
     def save_samples_to_file(self, filename: str, file_format: str = 'hdf5'):
         """
         Save collected samples to file
@@ -0,0 +1,185 @@
+#!/usr/bin/env python3
+"""
+Replay per-window scores through the CM7 decision stage (CM7/Core/Src/ai_decision.c) for a
+grid of settings, to pick SET DECISION / SET CLASS values from recorded data:
+
+    python stream_receiver.py COM5 --csv run          # writes run_results.csv
+    python decision_tune.py run_results.csv --ema 0,2,3 --enter-dwell 0,500,1000 \\
+        --exit-dwell 1000 --enter 60 --exit 40 --fault-at 120000
+
+Per setting it prints the state changes reported, windows per change (how much less a
+host has to process than one result per window), the confirm delay the board reports
+(event ts - onset_ts) and, with --fault-at (ms, window timestamps, repeatable), the
+time-to-alarm after each known fault onset and the fault alarms raised outside them.
+DecisionStage is bit-exact with the firmware; board_simulator.py uses it too.
+"""
+
+import sys
+import csv
+import argparse
+import itertools
+from typing import Dict, List, Optional, Sequence, Tuple
+
+NUM_CLASSES = 4
+DECISION_Q = 16
+DECISION_MAX_SHIFT = 7
+SCORE_SCALE = 1.0 / 256.0     # int8 softmax output grid (AI_SCORE_SCALE / AI_SCORE_ZERO_POINT)
+SCORE_ZERO_POINT = -128
+
+
+def score_probs(scores: Sequence[int]) -> List[int]:
+    """int8 softmax scores -> Q8 probabilities, as ai_channel_decide()"""
+    out = []
+    for q in scores:
+        p = (q - SCORE_ZERO_POINT) * SCORE_SCALE * 256.0 + 0.5
+        out.append(0 if p <= 0.0 else 256 if p >= 256.0 else int(p))
+    return out
+
+
+def resolve_thresholds(fault_thresh_pct: int, enter: Sequence[int], exit_: Sequence[int]) -> Tuple[List[int], List[int]]:
+    """Per-class thresholds as ai_decision_params(): 0 = SET THRESH / the enter threshold"""
+    enter_pct, exit_pct = [], []
+    for k in range(NUM_CLASSES):
+        e = enter[k] or fault_thresh_pct
+        x = exit_[k] or e
+        enter_pct.append(e)
+        exit_pct.append(min(x, e))
+    return enter_pct, exit_pct
+
+
+class DecisionStage:
+    # ai_decision.c: Q16 averages, argmax with enter/exit thresholds, dwell on window timestamps
+
+    def __init__(self, ema_shift: int = 0, enter_pct: Sequence[int] = (0,) * NUM_CLASSES,
+                 exit_pct: Sequence[int] = (0,) * NUM_CLASSES, enter_dwell_ms: int = 0, exit_dwell_ms: int = 0):
+        self.ema_shift = ema_shift
+        self.enter_pct = list(enter_pct)
+        self.exit_pct = list(exit_pct)
+        self.enter_dwell_ms = enter_dwell_ms
+        self.exit_dwell_ms = exit_dwell_ms
+        self.avg = [0] * NUM_CLASSES
+        self.primed = False
+        self.state = 0
+        self.candidate = 0
+        self.candidate_ts = 0
+
+    def pct(self, cls: int) -> int:
+        return (self.avg[cls] * 100 + (1 << (DECISION_Q - 1))) >> DECISION_Q
+
+    def target(self) -> int:
+        best = 0
+        for k in range(1, NUM_CLASSES):
+            if self.avg[k] > self.avg[best]:
+                best = k
+        if best == 0:
+            return 0
+        pct = self.exit_pct[best] if best == self.state else self.enter_pct[best]
+        return 0 if self.avg[best] * 100 < (pct << DECISION_Q) else best
+
+    def update(self, prob_q8: Sequence[int], ts: int) -> Optional[Dict]:
+        """Fold one window; the change as {from, to, confidence_pct, onset_ts, ts} or None"""
+        shift = min(self.ema_shift, DECISION_MAX_SHIFT)
+        for k in range(NUM_CLASSES):
+            x = prob_q8[k] << (DECISION_Q - 8)
+            self.avg[k] = x if not self.primed else self.avg[k] + ((x - self.avg[k]) >> shift)
+        self.primed = True
+
+        target = self.target()
+        if target == self.state:
+            self.candidate = self.state
+            return None
+        if target != self.candidate:
+            self.candidate = target
+            self.candidate_ts = ts
+        dwell = self.enter_dwell_ms if target else self.exit_dwell_ms
+        if ((ts - self.candidate_ts) & 0xFFFFFFFF) < dwell:
+            return None
+        change = {"from": self.state, "to": target, "onset_ts": self.candidate_ts, "ts": ts}
+        self.state = target
+        change["confidence_pct"] = self.pct(target)
+        return change
+
+
+def load_results(path: str, channel: int) -> List[Tuple[int, List[int]]]:
+    """(window_end_ts, scores) of one channel from a stream_receiver.py *_results.csv"""
+    rows = []
+    with open(path, newline="") as f:
+        for r in csv.DictReader(f):
+            if int(r["channel"]) == channel:
+                rows.append((int(r["window_end_ts"]), [int(r[f"s{k}"]) for k in range(NUM_CLASSES)]))
+    return rows
+
+
+def replay(windows: List[Tuple[int, List[int]]], stage: DecisionStage) -> List[Dict]:
+    events = []
+    for ts, scores in windows:
+        change = stage.update(score_probs(scores), ts)
+        if change:
+            events.append(change)
+    return events
+
+
+def evaluate(windows: List[Tuple[int, List[int]]], events: List[Dict], fault_at: List[int]) -> Dict:
+    confirm = [e["ts"] - e["onset_ts"] for e in events]
+    alarms = [e for e in events if e["from"] == 0 and e["to"] != 0]
+    out = {"events": len(events),
+           "windows_per_event": len(windows) / len(events) if events else float(len(windows)),
+           "confirm_ms": sum(confirm) / len(confirm) if confirm else None,
+           "time_to_alarm_ms": None, "missed": 0, "false_alarms": len(alarms)}
+    if fault_at:
+        ttas, matched = [], set()
+        for onset in sorted(fault_at):
+            hit = next((a for a in alarms if a["ts"] >= onset and id(a) not in matched), None)
+            if hit is None:
+                out["missed"] += 1
+                continue
+            matched.add(id(hit))
+            ttas.append(hit["ts"] - onset)
+        out["time_to_alarm_ms"] = sum(ttas) / len(ttas) if ttas else None
+        out["false_alarms"] = len(alarms) - len(matched)
+    return out
+
+
+def int_list(text: str) -> List[int]:
+    return [int(v) for v in text.split(",") if v != ""]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Tune the CM7 decision stage on recorded per-window scores.")
+    parser.add_argument("results", help="stream_receiver.py <csv>_results.csv")
+    parser.add_argument("--channel", type=int, default=0)
+    parser.add_argument("--ema", type=int_list, default=[0, 1, 2, 3], help="ema_shift values to try")
+    parser.add_argument("--enter-dwell", type=int_list, default=[0, 500, 1000], help="enter_dwell_ms values")
+    parser.add_argument("--exit-dwell", type=int_list, default=[0, 1000], help="exit_dwell_ms values")
+    parser.add_argument("--thresh", type=int, default=0, help="SET THRESH percent")
+    parser.add_argument("--enter", type=int_list, default=[0], help="enter_pct values (all fault classes)")
+    parser.add_argument("--exit", type=int_list, default=[0], help="exit_pct values (all fault classes)")
+    parser.add_argument("--fault-at", type=int, action="append", default=[],
+                        help="Known fault onset, ms in window timestamps (repeatable)")
+    args = parser.parse_args()
+
+    windows = load_results(args.results, args.channel)
+    if not windows:
+        print(f"error: no windows of channel {args.channel} in {args.results}", file=sys.stderr)
+        return 1
+
+    def fmt(v, spec: str) -> str:
+        return format(v, spec) if v is not None else "-"
+
+    print(f"{len(windows)} windows of channel {args.channel}")
+    print("ema enter_dwell exit_dwell enter exit  events win/event confirm_ms alarm_ms missed false")
+    for ema, ed, xd, en, ex in itertools.product(args.ema, args.enter_dwell, args.exit_dwell, args.enter, args.exit):
+        if en and ex > en:
+            continue
+        enter_pct, exit_pct = resolve_thresholds(args.thresh, [0] + [en] * (NUM_CLASSES - 1),
+                                                 [0] + [ex] * (NUM_CLASSES - 1))
+        stage = DecisionStage(ema, enter_pct, exit_pct, ed, xd)
+        r = evaluate(windows, replay(windows, stage), args.fault_at)
+        print(f"{ema:>3} {ed:>11} {xd:>10} {en:>5} {ex:>4} {r['events']:>7} {r['windows_per_event']:>9.1f} "
+              f"{fmt(r['confirm_ms'], '.0f'):>10} {fmt(r['time_to_alarm_ms'], '.0f'):>8} {r['missed']:>6} "
+              f"{r['false_alarms']:>5}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,85 @@
+import os
+import re
+import sys
+import argparse
+from typing import List, Tuple
+
+
+DLOG_PREFIX = "#D:"
+_ENTRY_RE = re.compile(r'X\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*,\s*(\d+)\s*\)')
+_CONV_RE = re.compile(r'%[-+ #0]*\d*(?:\.\d+)?(?:hh|h|ll|l|z)?([diuxXc%])')
+
+
+def load_messages(header_path: str) -> List[Tuple[str, str, int]]:
+    # Entry position in DLOG_MESSAGES is the message ID
+    with open(header_path, "r", encoding="utf-8") as f:
+        text = f.read()
+    return [(name, fmt, int(nargs)) for name, fmt, nargs in _ENTRY_RE.findall(text)]
+
+
+def render(fmt: str, args: List[int]) -> str:
+    # Apply a C printf format to raw 32-bit args
+    it = iter(args)
+
+    def conv(m: re.Match) -> str:
+        kind = m.group(1)
+        if kind == "%":
+            return "%"
+        value = next(it, 0)
+        if kind in "di":
+            value = value - (1 << 32) if value & 0x80000000 else value
+            return str(value)
+        if kind == "u":
+            return str(value)
+        if kind == "x":
+            return format(value, "x")
+        if kind == "X":
+            return format(value, "X")
+        return chr(value & 0xFF)
+
+    return _CONV_RE.sub(conv, fmt)
+
+
+def decode_line(line: str, messages: List[Tuple[str, str, int]]) -> str:
+    # "#D:<ts>,<id>[,<arg>...]" (hex) -> "[ts ms] text"; other lines pass through
+    if not line.startswith(DLOG_PREFIX):
+        return line
+    try:
+        fields = [int(v, 16) for v in line[len(DLOG_PREFIX):].split(",")]
+    except ValueError:
+        return f"<bad dlog record: {line}>"
+    ts, msg_id, args = fields[0], fields[1], fields[2:]
+    if msg_id >= len(messages):
+        return f"[{ts:>10} ms] <unknown dlog id {msg_id}> {args}"
+    name, fmt, _ = messages[msg_id]
+    return f"[{ts:>10} ms] {render(fmt, args)}"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Render CM4 deferred log records (#D: lines) as text.")
+    script_dir = os.path.dirname(os.path.abspath(__file__))
+    default_header = os.path.normpath(os.path.join(script_dir, "..", "CM4", "Core", "Inc", "dlog_msgs.h"))
+    parser.add_argument("input", nargs="?", default="-", help="Captured log file, serial port, or - for stdin")
+    parser.add_argument("--header", default=default_header, help="Path to dlog_msgs.h")
+    parser.add_argument("--baud", type=int, default=115200, help="Baud rate when input is a serial port")
+    args = parser.parse_args()
+
+    messages = load_messages(args.header)
+
+    if args.input == "-":
+        stream = sys.stdin
+    elif os.path.isfile(args.input):
+        stream = open(args.input, "r", encoding="utf-8", errors="replace")
+    else:
+        import serial
+        ser = serial.Serial(args.input, args.baud, timeout=1.0)
+        stream = (raw.decode("utf-8", errors="replace") for raw in iter(ser.readline, None))
+
+    for line in stream:
+        line = line.strip()
+        if line:
+            print(decode_line(line, messages), flush=True)
+
+
+if __name__ == "__main__":
+    main()
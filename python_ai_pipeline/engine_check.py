@@ -0,0 +1,403 @@
+#!/usr/bin/env python3
+"""
+Build the open int8 engine (Common/Src/ai_engine.c) for the host through its
+portable C path and check it bit for bit against the TFLite interpreter, both as full
+windows and streaming from window to window.
+
+Weights fetched layer by layer (ai_engine_fetch_t, as from QSPI on CM7) are checked
+too, through a simulated slow memory: a copy lands `latency + bytes / bandwidth` after
+it started, and the time the engine spends waiting for it is the stall. It is measured
+with the next layer prefetched during the current one and with every copy waited for
+as soon as it starts.
+
+    python engine_check.py                        # 256 synthetic windows, hop 4
+    python engine_check.py --windows 2000 --hop 8
+    python engine_check.py --no-tflite            # streaming vs full window only
+    python engine_check.py --slow-mb-s 25 --slow-latency-us 2
+    python engine_check.py --write-vectors ../tests/engine_vectors.h
+
+The interpreter runs with its reference kernels (OpResolverType.BUILTIN_REF): the
+optimized int8 softmax is a lookup table that rounds differently from the reference
+arithmetic ai_engine.c implements. Without tensorflow or tflite_runtime installed the
+check exits with SKIPPED (status 77, as ctest's engine_tflite test expects).
+
+--write-vectors writes the reference scores and fc2 logits of a few windows for
+tests/test_engine.c, so the host tests check the engine without Python. They come from
+the interpreter when one is installed, else from tflite_ref.py, a numpy port of the
+same reference kernels that reads the .tflite directly; with an interpreter the check
+also compares that port with it.
+"""
+
+import os
+import sys
+import random
+import argparse
+import tempfile
+import subprocess
+from typing import List, Optional, Tuple
+
+EXIT_SKIPPED = 77
+
+from export_model_params import DEFAULT_HEADER, DEFAULT_NETWORK_C, DEFAULT_TFLITE, file_md5, header_hash, weights_blob
+from tflite_reader import TFLiteModel
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+COMMON_DIR = os.path.normpath(os.path.join(SCRIPT_DIR, "..", "Common"))
+
+# stdin: windows of MODEL_WINDOW_FRAMES x MODEL_NUM_AXES int8, each `hop` frames after the
+# previous one; stdout: per window the scores of streaming, full window, streaming with
+# prefetched and with synchronous slow-memory weights; stderr: the fetch timings
+DRIVER_C = r"""
+#define _POSIX_C_SOURCE 199309L
+#include "ai_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define WINDOW_BYTES (MODEL_WINDOW_FRAMES * MODEL_NUM_AXES)
+
+static ai_engine_t streaming, full, prefetched, synchronous;
+
+/* Slow memory: a copy is only visible once its transfer time has elapsed */
+typedef struct {
+    double ns_per_byte;
+    double latency_ns;
+    int sync;               /* wait inside start(): no overlap with compute */
+    void *dst;
+    const void *src;
+    uint32_t len;
+    double done_ns;
+    double stall_ns;
+    double bytes;
+} slow_mem_t;
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static bool slow_wait(void *ctx)
+{
+    slow_mem_t *m = ctx;
+    if (!m->dst) return true;
+    double t0 = now_ns(), t = t0;
+    while (t < m->done_ns) t = now_ns();
+    m->stall_ns += t - t0;
+    memcpy(m->dst, m->src, m->len);
+    m->dst = NULL;
+    return true;
+}
+
+static bool slow_start(void *ctx, void *dst, const void *src, uint32_t len)
+{
+    slow_mem_t *m = ctx;
+    m->dst = dst;
+    m->src = src;
+    m->len = len;
+    m->done_ns = now_ns() + m->latency_ns + len * m->ns_per_byte;
+    m->bytes += len;
+    return m->sync ? slow_wait(ctx) : true;
+}
+
+static _Alignas(32) uint8_t stage[4][AI_ENGINE_STAGE_BYTES];
+static slow_mem_t mem_prefetch, mem_sync;
+static ai_engine_fetch_t fetch_prefetch = { slow_start, slow_wait, &mem_prefetch, { stage[0], stage[1] } };
+static ai_engine_fetch_t fetch_sync = { slow_start, slow_wait, &mem_sync, { stage[2], stage[3] } };
+
+int main(int argc, char **argv)
+{
+    if (argc != 5) return 2;
+    FILE *f = fopen(argv[1], "rb");
+    if (!f) return 2;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint64_t *blob = malloc((size_t)size + 8u);
+    if (!blob || fread(blob, 1, (size_t)size, f) != (size_t)size) return 2;
+    fclose(f);
+
+    uint32_t hop = (uint32_t)atoi(argv[2]);
+    double mb_s = atof(argv[3]), latency_us = atof(argv[4]);
+    mem_prefetch.ns_per_byte = mem_sync.ns_per_byte = 1e3 / mb_s;
+    mem_prefetch.latency_ns = mem_sync.latency_ns = latency_us * 1e3;
+    mem_sync.sync = 1;
+
+    int8_t window[WINDOW_BYTES];
+    ai_engine_init(&streaming, blob);
+    ai_engine_init(&full, blob);
+    ai_engine_init(&prefetched, blob);
+    ai_engine_init(&synchronous, blob);
+    ai_engine_set_fetch(&prefetched, &fetch_prefetch);
+    ai_engine_set_fetch(&synchronous, &fetch_sync);
+    double run_ns[2] = { 0, 0 };
+    uint32_t n = 0;
+    for (; fread(window, 1, sizeof(window), stdin) == sizeof(window); n++) {
+        uint32_t shift = n ? hop : MODEL_WINDOW_FRAMES;
+        ai_engine_run(&streaming, window, shift);
+        ai_engine_reset(&full);
+        ai_engine_run(&full, window, MODEL_WINDOW_FRAMES);
+        double t0 = now_ns();
+        ai_engine_run(&prefetched, window, shift);
+        double t1 = now_ns();
+        ai_engine_run(&synchronous, window, shift);
+        run_ns[0] += t1 - t0;
+        run_ns[1] += now_ns() - t1;
+        fwrite(streaming.out, 1, sizeof(streaming.out), stdout);
+        fwrite(full.out, 1, sizeof(full.out), stdout);
+        fwrite(prefetched.out, 1, sizeof(prefetched.out), stdout);
+        fwrite(synchronous.out, 1, sizeof(synchronous.out), stdout);
+    }
+    if (n) {
+        fprintf(stderr, "%.0f %.0f %.0f %.0f %.0f\n", mem_prefetch.bytes / n, run_ns[0] / n,
+                mem_prefetch.stall_ns / n, run_ns[1] / n, mem_sync.stall_ns / n);
+    }
+    return 0;
+}
+"""
+
+
+def synthetic_stream(frames: int, axes: int, seed: int) -> List[int]:
+    """Per-axis int8 random walk with occasional spikes (as AI_BenchEngine() on CM7)"""
+    rng = random.Random(seed)
+    walk = [0] * axes
+    out = []
+    for i in range(frames * axes):
+        a = i % axes
+        walk[a] = max(-128, min(127, walk[a] + rng.randint(-20, 20)))
+        out.append(rng.randint(-128, 127) if rng.random() < 0.125 else walk[a])
+    return out
+
+
+def tone_window(frames: int, axes: int, rng: random.Random) -> List[int]:
+    """One window of per-axis sinusoids with an offset and noise: these reach the
+    classes and unsaturated scores the random walk rarely does"""
+    import math
+    freq = [rng.uniform(0.05, 1.5) for _ in range(axes)]
+    amp = [rng.uniform(0.0, 140.0) for _ in range(axes)]
+    offset = [rng.uniform(-60.0, 60.0) for _ in range(axes)]
+    phase = [rng.uniform(0.0, 2.0 * math.pi) for _ in range(axes)]
+    noise = rng.uniform(0.0, 30.0)
+    return [max(-128, min(127, int(offset[a] + amp[a] * math.sin(freq[a] * t + phase[a]) + rng.gauss(0.0, noise))))
+            for t in range(frames) for a in range(axes)]
+
+
+def vector_windows(frames: int, axes: int, seed: int, count: int, scores_of) -> List[bytes]:
+    """`count` windows for tests/engine_vectors.h: every predicted class the candidates
+    reach, then unsaturated scores (a saturated softmax hides logit errors), then any"""
+    rng = random.Random(seed)
+    stream = synthetic_stream(255 * 4 + frames, axes, seed)
+    candidates = [stream[i * 4 * axes:(i * 4 + frames) * axes] for i in range(256)]
+    candidates += [tone_window(frames, axes, rng) for _ in range(768)]
+    windows = [bytes(v & 0xFF for v in w) for w in candidates]
+    scores = [scores_of(w) for w in windows]
+
+    picked = []
+    for k in range(len(scores[0])):
+        picked += [i for i, sc in enumerate(scores) if sc.index(max(sc)) == k][:2]
+    picked += [i for i, sc in enumerate(scores) if max(sc) < 127 and i not in picked]
+    picked += [i for i in range(len(windows)) if i not in picked]
+    return [windows[i] for i in sorted(picked[:count])]
+
+
+def write_vectors(path: str, tflite: str, source: str, windows: List[bytes],
+                  logits: List[List[int]], scores: List[List[int]]) -> None:
+    def row(values) -> str:
+        return "{ " + ", ".join(str(b - 256 if b > 127 else b) for b in values) + " }"
+
+    lines = [f"/* Generated by python_ai_pipeline/engine_check.py --write-vectors; do not edit.",
+             f" * Reference: {source} on {os.path.basename(tflite)}. */",
+             "#ifndef __ENGINE_VECTORS_H",
+             "#define __ENGINE_VECTORS_H",
+             "",
+             f"#define ENGINE_VECTORS_HASH     \"{file_md5(tflite)}\"   /* md5 of {os.path.basename(tflite)} */",
+             f"#define ENGINE_VECTORS          {len(windows)}u",
+             "",
+             "/* Quantized windows [frame][axis] */",
+             "static const int8_t engine_vector_in[ENGINE_VECTORS][MODEL_WINDOW_FRAMES * MODEL_NUM_AXES] = {"]
+    for w in windows:
+        vals = [str(b - 256 if b > 127 else b) for b in w]
+        lines.append("    {")
+        for i in range(0, len(vals), 18):
+            lines.append("        " + ", ".join(vals[i:i + 18]) + ",")
+        lines.append("    },")
+    lines += ["};", "", "/* fc2 output (softmax input) and scores */",
+              "static const int8_t engine_vector_logits[ENGINE_VECTORS][MODEL_NUM_CLASSES] = {"]
+    lines += [f"    {row([v & 0xFF for v in l])}," for l in logits]
+    lines += ["};", "static const int8_t engine_vector_scores[ENGINE_VECTORS][MODEL_NUM_CLASSES] = {"]
+    lines += [f"    {row([v & 0xFF for v in sc])}," for sc in scores]
+    lines += ["};", "", "#endif /* __ENGINE_VECTORS_H */", ""]
+    with open(path, "w", encoding="utf-8") as f:
+        f.write("\n".join(lines))
+
+
+def build_engine(workdir: str, cc: str) -> str:
+    driver = os.path.join(workdir, "engine_driver.c")
+    exe = os.path.join(workdir, "engine_host")
+    with open(driver, "w", encoding="utf-8") as f:
+        f.write(DRIVER_C)
+    cmd = [cc, "-O2", "-std=gnu11", "-Wall", "-I", os.path.join(COMMON_DIR, "Inc"),
+           driver, os.path.join(COMMON_DIR, "Src", "ai_engine.c"), "-o", exe]
+    subprocess.run(cmd, check=True)
+    return exe
+
+
+def run_engine(exe: str, blob_path: str, hop: int, windows: List[bytes], mb_s: float,
+               latency_us: float) -> Tuple[List[Tuple[List[int], ...]], List[float]]:
+    """Per window (streaming, full, prefetched, synchronous) scores, and the fetch timings
+    [bytes, prefetched run ns, prefetched stall ns, synchronous run ns, synchronous stall ns]
+    per window"""
+    proc = subprocess.run([exe, blob_path, str(hop), str(mb_s), str(latency_us)],
+                          input=b"".join(windows), capture_output=True, check=True)
+    scores = [b - 256 if b > 127 else b for b in proc.stdout]
+    n = len(scores) // 16
+    results = [tuple(scores[16 * i + 4 * k:16 * i + 4 * k + 4] for k in range(4)) for i in range(n)]
+    timing = [float(v) for v in proc.stderr.split()] if proc.stderr.strip() else [0.0] * 5
+    return results, timing
+
+
+def tflite_interpreter(path: str) -> Tuple[Optional[object], str]:
+    """Interpreter on the reference kernels (every tensor kept, for the fc2 logits) and
+    its name and version, from tensorflow or tflite_runtime; None if neither is installed"""
+    try:
+        import tensorflow as tf
+        return (tf.lite.Interpreter(model_path=path,
+                                    experimental_op_resolver_type=tf.lite.experimental.OpResolverType.BUILTIN_REF,
+                                    experimental_preserve_all_tensors=True),
+                f"TFLite interpreter (tensorflow {tf.__version__}, BUILTIN_REF)")
+    except ImportError:
+        pass
+    try:
+        import tflite_runtime
+        from tflite_runtime.interpreter import Interpreter, OpResolverType
+        return (Interpreter(model_path=path, experimental_op_resolver_type=OpResolverType.BUILTIN_REF,
+                            experimental_preserve_all_tensors=True),
+                f"TFLite interpreter (tflite_runtime {tflite_runtime.__version__}, BUILTIN_REF)")
+    except ImportError:
+        return None, ""
+
+
+def run_tflite(interp, tflite: str, windows: List[bytes], frames: int,
+               axes: int) -> Tuple[List[List[int]], List[List[int]]]:
+    """Per window the fc2 logits (the softmax input) and the scores"""
+    import numpy as np
+    model = TFLiteModel(tflite)
+    logits_idx = next(op.inputs[0] for op in model.operators if op.name == "SOFTMAX")
+    interp.allocate_tensors()
+    in_idx = interp.get_input_details()[0]["index"]
+    out_idx = interp.get_output_details()[0]["index"]
+    logits, scores = [], []
+    for w in windows:
+        interp.set_tensor(in_idx, np.frombuffer(w, dtype=np.int8).reshape(1, frames, axes))
+        interp.invoke()
+        logits.append([int(v) for v in interp.get_tensor(logits_idx).reshape(-1)])
+        scores.append([int(v) for v in interp.get_tensor(out_idx).reshape(-1)])
+    return logits, scores
+
+
+def run_numpy_ref(tflite: str, windows: List[bytes], frames: int,
+                  axes: int) -> Tuple[List[List[int]], List[List[int]]]:
+    """The same from tflite_ref.py"""
+    import numpy as np
+    from tflite_ref import ReferenceModel
+    ref = ReferenceModel(tflite)
+    out = [ref.run(np.frombuffer(w, dtype=np.int8).reshape(frames, axes)) for w in windows]
+    return [l for l, _ in out], [sc for _, sc in out]
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Check the open int8 engine against TFLite on the host.")
+    parser.add_argument("--tflite", default=DEFAULT_TFLITE)
+    parser.add_argument("--network", default=DEFAULT_NETWORK_C, help="X-CUBE-AI network .c (weights blob next to it)")
+    parser.add_argument("--windows", type=int, default=256)
+    parser.add_argument("--hop", type=int, default=4, help="Frames between consecutive windows")
+    parser.add_argument("--seed", type=int, default=1)
+    parser.add_argument("--cc", default=os.environ.get("CC", "cc"), help="Host C compiler")
+    parser.add_argument("--no-tflite", action="store_true", help="Only compare streaming with full windows")
+    parser.add_argument("--slow-mb-s", type=float, default=50.0,
+                        help="Simulated weight memory bandwidth (quad SPI at 100 MHz: ~50 MB/s)")
+    parser.add_argument("--slow-latency-us", type=float, default=1.0, help="Simulated latency per copy")
+    parser.add_argument("--write-vectors", metavar="PATH", help="Write reference vectors for tests/test_engine.c")
+    parser.add_argument("--vectors", type=int, default=16, help="Windows in --write-vectors")
+    args = parser.parse_args()
+
+    if header_hash(DEFAULT_HEADER) != file_md5(args.tflite):
+        print(f"error: {DEFAULT_HEADER} was not generated from {args.tflite}; rerun export_model_params.py",
+              file=sys.stderr)
+        return 1
+
+    frames, axes = 60, 3
+    with open(DEFAULT_HEADER, encoding="utf-8") as f:
+        for line in f:
+            parts = line.split()
+            if len(parts) >= 3 and parts[1] == "MODEL_WINDOW_FRAMES":
+                frames = int(parts[2])
+            elif len(parts) >= 3 and parts[1] == "MODEL_NUM_AXES":
+                axes = int(parts[2])
+
+    if args.write_vectors:
+        interp, source = tflite_interpreter(args.tflite)
+        if interp is None:
+            source = "numpy port of the TFLite reference kernels (tflite_ref.py)"
+
+        def reference(windows):
+            if interp is not None:
+                return run_tflite(interp, args.tflite, windows, frames, axes)
+            return run_numpy_ref(args.tflite, windows, frames, axes)
+
+        windows = vector_windows(frames, axes, args.seed, args.vectors, lambda w: reference([w])[1][0])
+        logits, scores = reference(windows)
+        write_vectors(args.write_vectors, args.tflite, source, windows, logits, scores)
+        print(f"{len(windows)} windows from the {source} -> {args.write_vectors}")
+        return 0
+
+    interp = None
+    if not args.no_tflite:
+        interp, source = tflite_interpreter(args.tflite)
+        if interp is None:
+            print("SKIPPED: neither tensorflow nor tflite_runtime is installed (--no-tflite checks streaming only)")
+            return EXIT_SKIPPED
+
+    stream = synthetic_stream((args.windows - 1) * args.hop + frames, axes, args.seed)
+    raw = bytes(v & 0xFF for v in stream)
+    windows = [raw[i * args.hop * axes:(i * args.hop + frames) * axes] for i in range(args.windows)]
+
+    with tempfile.TemporaryDirectory() as tmp:
+        blob_path = os.path.join(tmp, "weights.bin")
+        with open(blob_path, "wb") as f:
+            f.write(weights_blob(args.network))
+        exe = build_engine(tmp, args.cc)
+        results, timing = run_engine(exe, blob_path, args.hop, windows, args.slow_mb_s, args.slow_latency_us)
+
+    stream_bad = sum(1 for s, full, _, _ in results if s != full)
+    fetch_bad = sum(1 for s, _, pre, syn in results if pre != s or syn != s)
+    print(f"{len(results)} windows, hop {args.hop}: streaming != full window in {stream_bad}")
+    print(f"fetched weights != in place in {fetch_bad}")
+    nbytes, pre_ns, pre_stall, syn_ns, syn_stall = timing
+    print(f"slow memory {args.slow_mb_s:g} MB/s + {args.slow_latency_us:g} us, {nbytes:.0f} bytes/window: "
+          f"prefetch {pre_ns / 1e3:.1f} us/window ({pre_stall / 1e3:.1f} us stalled), "
+          f"synchronous {syn_ns / 1e3:.1f} us/window ({syn_stall / 1e3:.1f} us stalled)")
+    failed = stream_bad != 0 or fetch_bad != 0 or len(results) != len(windows)
+
+    if interp is not None:
+        print(source)
+        ref_logits, ref = run_tflite(interp, args.tflite, windows, frames, axes)
+        diffs = [max(abs(a - b) for a, b in zip(full, r)) for (_, full, _, _), r in zip(results, ref)]
+        tfl_bad = sum(1 for d in diffs if d)
+        print(f"engine != TFLite in {tfl_bad} windows (max diff {max(diffs, default=0)} LSB)")
+        np_logits, np_scores = run_numpy_ref(args.tflite, windows, frames, axes)
+        np_bad = sum(1 for a, b, c, d in zip(np_logits, ref_logits, np_scores, ref) if a != b or c != d)
+        print(f"tflite_ref.py != TFLite in {np_bad} windows")
+        failed = failed or tfl_bad != 0 or np_bad != 0
+
+    if failed:
+        print("FAIL")
+    else:
+        print("OK: streaming == full" if interp is None else "OK: bit-exact with TFLite (reference kernels)")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,475 @@
+#!/usr/bin/env python3
+"""
+Generate Common/Inc/model_params.h from the training artifacts and check it
+against the X-CUBE-AI generated network.
+
+The header holds every precision variant model_trainer.py exported (int8, int16x8,
+float32); the firmware builds one of them with -DMODEL_PRECISION=MODEL_PRECISION_<...>.
+
+    python export_model_params.py                          # regenerate
+    python export_model_params.py --input-quant 0.0253386665,12 --output-quant 0.00390625,-128
+    python export_model_params.py --check ../CM7/X-CUBE-AI/App/motor_anomalie.c   # pre-build step
+"""
+
+import os
+import re
+import sys
+import json
+import math
+import struct
+import hashlib
+import argparse
+from typing import Dict, List, Optional, Tuple
+
+from tflite_reader import (TFLiteModel, TYPE_FLOAT32, TYPE_INT8, TYPE_INT32, PADDING_SAME, PADDING_VALID,
+                           ACT_NONE, ACT_RELU, ACT_RELU6, conv_options, pool_options,
+                           fc_activation, softmax_beta)
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_HEADER = os.path.normpath(os.path.join(SCRIPT_DIR, "..", "Common", "Inc", "model_params.h"))
+DEFAULT_NETWORK_C = os.path.normpath(os.path.join(SCRIPT_DIR, "..", "CM7", "X-CUBE-AI", "App", "motor_anomalie.c"))
+DEFAULT_TFLITE = os.path.join(SCRIPT_DIR, "models", "motor_cnn_int8.tflite")
+AXES = ("X", "Y", "Z")
+
+# Precision variants: model_trainer.py export name and the firmware's MODEL_PRECISION value
+PRECISIONS = ("int8", "int16x8", "float32")
+PRECISION_FILES = {"int8": "motor_cnn_int8.tflite", "int16x8": "motor_cnn_int16x8.tflite",
+                   "float32": "motor_cnn_fp32.tflite"}
+PRECISION_MACROS = {"int8": "MODEL_PRECISION_INT8", "int16x8": "MODEL_PRECISION_INT16X8",
+                    "float32": "MODEL_PRECISION_FLOAT32"}
+
+
+def variant_tflite(precision: str, models_dir: str = os.path.join(SCRIPT_DIR, "models")) -> str:
+    return os.path.join(models_dir, PRECISION_FILES[precision])
+
+
+def f32(v: float) -> float:
+    """Round to float32, as the firmware stores the constant"""
+    return struct.unpack("<f", struct.pack("<f", float(v)))[0]
+
+
+def c_round(v: float) -> int:
+    """llround(): half away from zero"""
+    return int(math.copysign(math.floor(abs(v) + 0.5), v))
+
+
+def fold_axis(mean: float, std: float, scale: float, zero_point: int) -> Tuple[int, int, int]:
+    """Same fold as ai_preproc_fold() in Common/Src/ai_preproc.c: (mult, offset, shift)"""
+    mean, std, scale = f32(mean), f32(std), f32(scale)
+    if not (std > 0 and scale > 0):
+        raise ValueError("std and scale must be positive")
+    k = 1.0 / (std * scale)
+    for shift in range(62, -1, -1):
+        one = math.ldexp(1.0, shift)
+        m, o = k * one, (zero_point - mean * k) * one
+        if m > 2.0**46 or abs(o) > 2.0**61:
+            continue
+        return c_round(m), c_round(o) + ((1 << (shift - 1)) if shift else 0), shift
+    raise ValueError("no fixed-point fold fits int64")
+
+
+def c_int(v: int) -> str:
+    return f"({v})" if v < 0 else str(v)
+
+
+def c_float(v: float) -> str:
+    text = f"{v!r}f"
+    return f"({text})" if v < 0 else text
+
+
+def file_md5(path: str) -> str:
+    with open(path, "rb") as f:
+        return hashlib.md5(f.read()).hexdigest()
+
+
+def tflite_quant_params(path: str) -> Tuple[Tuple[float, int], Tuple[float, int]]:
+    """((input_scale, input_zp), (output_scale, output_zp)) of a TFLite model; (1.0, 0)
+    for a float tensor"""
+    model = TFLiteModel(path)
+
+    def quant(t):
+        return (1.0, 0) if t.type == TYPE_FLOAT32 else (t.scale, t.zero_point)
+
+    return quant(model.input()), quant(model.output())
+
+
+# Layer sequence ai_engine.c implements (shape-only EXPAND_DIMS / RESHAPE ops dropped)
+ENGINE_TOPOLOGY = ("CONV_2D", "MAX_POOL_2D", "CONV_2D", "MAX_POOL_2D", "CONV_2D",
+                   "MEAN", "FULLY_CONNECTED", "FULLY_CONNECTED", "SOFTMAX")
+
+
+def quantize_multiplier(real: float) -> Tuple[int, int]:
+    """TFLite QuantizeMultiplier(): Q31 significand and exponent (left shift if > 0)"""
+    if real == 0.0:
+        return 0, 0
+    q, shift = math.frexp(real)
+    q_fixed = c_round(q * (1 << 31))
+    if q_fixed == 1 << 31:
+        q_fixed //= 2
+        shift += 1
+    if shift < -31:
+        return 0, 0
+    if shift > 30:
+        return (1 << 31) - 1, 30
+    return q_fixed, shift
+
+
+def activation_range(act: int, scale: float, zero_point: int) -> Tuple[int, int]:
+    """TFLite CalculateActivationRangeQuantized() for int8"""
+    lo, hi = -128, 127
+    if act in (ACT_RELU, ACT_RELU6):
+        lo = max(lo, zero_point + c_round(0.0 / scale))
+    if act == ACT_RELU6:
+        hi = min(hi, zero_point + c_round(6.0 / scale))
+    elif act not in (ACT_NONE, ACT_RELU):
+        raise ValueError(f"unsupported fused activation {act}")
+    return lo, hi
+
+
+def softmax_params(input_scale: float, beta: float) -> Tuple[int, int, int]:
+    """TFLite PreprocessSoftmaxScaling() with 5 integer bits: (multiplier, left_shift, diff_min)"""
+    real = min(beta * input_scale * (1 << 26), (1 << 31) - 1.0)
+    mult, shift = quantize_multiplier(real)
+    radius = math.floor(((1 << 5) - 1) * (1 << 26) / (1 << shift))
+    return mult, shift, -radius
+
+
+def engine_layers(model: TFLiteModel) -> Optional[List[Dict]]:
+    """Parameters of every ai_engine.c layer, or None when the model does not fit it.
+    Weight offsets follow the X-CUBE-AI blob layout: weights then bias of each
+    layer, packed in graph order (--check verifies them against the blob)."""
+    ops = model.compute_ops()
+    if tuple(op.name for op in ops) != ENGINE_TOPOLOGY:
+        return None
+
+    layers, offset, count = [], 0, {}
+    for op in ops:
+        t_in, t_out = model.tensors[op.inputs[0]], model.tensors[op.outputs[0]]
+        if t_in.type != TYPE_INT8 or t_out.type != TYPE_INT8:
+            return None
+        kind = {"CONV_2D": "CONV", "MAX_POOL_2D": "POOL", "FULLY_CONNECTED": "FC",
+                "MEAN": "GAP", "SOFTMAX": "SOFTMAX"}[op.name]
+        count[kind] = count.get(kind, 0) + 1
+        name = kind + (str(count[kind]) if kind in ("CONV", "POOL", "FC") else "")
+        layer = {"name": name, "kind": kind, "in_zp": t_in.zero_point, "out_zp": t_out.zero_point}
+
+        if kind in ("CONV", "FC"):
+            w, b = model.tensors[op.inputs[1]], model.tensors[op.inputs[2]]
+            if w.type != TYPE_INT8 or b.type != TYPE_INT32 or any(w.zero_points):
+                return None
+            out_ch = w.shape[0]
+            scales = w.scales if len(w.scales) == out_ch else w.scales * out_ch
+            if kind == "CONV":
+                opts = conv_options(op)
+                if (opts["padding"] != PADDING_SAME or opts["stride_w"] != 1 or opts["stride_h"] != 1
+                        or len(w.shape) != 4 or w.shape[1] != 1):
+                    return None
+                layer.update(kernel=w.shape[2], in_ch=w.shape[3])
+                act = opts["activation"]
+            else:
+                layer.update(kernel=1, in_ch=w.shape[1])
+                act = fc_activation(op)
+            layer.update(out_ch=out_ch, w_offset=offset, b_offset=offset + len(w.data),
+                         w_data=w.data, b_data=b.data,
+                         act=activation_range(act, t_out.scale, t_out.zero_point),
+                         requant=[quantize_multiplier(t_in.scale * s / t_out.scale) for s in scales])
+            offset += len(w.data) + len(b.data)
+        elif kind == "POOL":
+            opts = pool_options(op)
+            if (opts["padding"] != PADDING_VALID or opts["filter_h"] != 1 or opts["stride_h"] != 1
+                    or opts["filter_w"] != opts["stride_w"] or opts["activation"] != ACT_NONE
+                    or t_in.scale != t_out.scale or t_in.zero_point != t_out.zero_point):
+                return None
+            layer.update(size=opts["filter_w"])
+        elif kind == "GAP":
+            axis = model.tensors[op.inputs[1]].values()
+            if axis != [1] or len(t_in.shape) != 3:
+                return None
+            # reduce.h QuantizedMeanOrSum(): fold 1/len into the multiplier
+            n = t_in.shape[1]
+            mult, shift = quantize_multiplier(t_in.scale / t_out.scale)
+            fold = min(n.bit_length() - 1, 32, 31 + shift)
+            layer.update(requant=[((mult << fold) // n, shift - fold)])
+        else:
+            if t_out.scale != 1.0 / 256 or t_out.zero_point != -128:
+                return None
+            layer.update(softmax=softmax_params(t_in.scale, softmax_beta(op)))
+        layers.append(layer)
+    return layers
+
+
+def render_engine(layers: Optional[List[Dict]]) -> List[str]:
+    lines = ["/* Open int8 engine (ai_engine.c): TFLite int8 reference arithmetic.",
+             " * *_W_OFFSET / *_B_OFFSET are bytes into the X-CUBE-AI weights blob (OHWI int8 / int32);",
+             " * *_REQUANT is { Q31 multiplier, shift (left if > 0) } per output channel. */"]
+    if layers is None:
+        return lines + ["#define MODEL_ENGINE_SUPPORTED     0   /* topology not supported by ai_engine.c */"]
+
+    lines.append("#define MODEL_ENGINE_SUPPORTED     1")
+    for layer in layers:
+        p = f"MODEL_{layer['name']}_"
+
+        def define(key, value):
+            lines.append(f"#define {p + key:<27}{value}")
+
+        kind = layer["kind"]
+        if kind == "POOL":
+            define("SIZE", layer["size"])
+            continue
+        if kind == "SOFTMAX":
+            mult, shift, diff_min = layer["softmax"]
+            define("MULT", mult)
+            define("SHIFT", shift)
+            define("DIFF_MIN", c_int(diff_min))
+            continue
+        if kind in ("CONV", "FC"):
+            define("IN_CH", layer["in_ch"])
+            define("OUT_CH", layer["out_ch"])
+            if kind == "CONV":
+                define("KERNEL", layer["kernel"])
+            define("W_OFFSET", layer["w_offset"])
+            define("B_OFFSET", layer["b_offset"])
+            define("ACT_MIN", c_int(layer['act'][0]))
+            define("ACT_MAX", c_int(layer['act'][1]))
+        define("IN_ZP", c_int(layer['in_zp']))
+        define("OUT_ZP", c_int(layer['out_zp']))
+        if kind == "GAP":
+            mult, shift = layer["requant"][0]
+            define("MULT", mult)
+            define("SHIFT", c_int(shift))
+            continue
+        lines.append(f"#define {p}REQUANT {{ \\")
+        pairs = [f"{{ {m}, {s} }}," for m, s in layer["requant"]]
+        for i in range(0, len(pairs), 4):
+            lines.append("    " + " ".join(pairs[i:i + 4]) + " \\")
+        lines.append("}")
+    return lines
+
+
+def render_variant(precision: str, model_hash: str, in_q: Tuple[float, int], out_q: Tuple[float, int],
+                   mean: List[float], std: List[float], layers: Optional[List[Dict]]) -> List[str]:
+    """The MODEL_PRECISION block of one exported variant"""
+    lines = [f'#define MODEL_PARAMS_HASH          "{model_hash}"   /* md5 of {PRECISION_FILES[precision]} */', ""]
+    if precision == "float32":
+        lines += [
+            "/* float32 input/output: no quantization (scale 1, zero point 0) */",
+            "#define MODEL_IN_SCALE             1.0f",
+            "#define MODEL_IN_ZERO_POINT        (0)",
+            "#define MODEL_OUT_SCALE            1.0f",
+            "#define MODEL_OUT_ZERO_POINT       (0)",
+            "",
+            "/* Normalization for ai_preproc_t: { 1 / std, -mean / std } per axis, in float */",
+            "#define MODEL_PREPROC_INIT { { \\",
+        ]
+        lines += [f"    {{ {c_float(f32(1.0 / std[a]))}, {c_float(f32(-mean[a] / std[a]))}, 0u }}, \\"
+                  for a in range(len(AXES))]
+    else:
+        bits = 8 if precision == "int8" else 16
+        folds = [fold_axis(mean[a], std[a], in_q[0], in_q[1]) for a in range(len(AXES))]
+        lines += [
+            f"/* int{bits} input/output quantization: real = (q - zero_point) * scale */",
+            f"#define MODEL_IN_SCALE             {c_float(f32(in_q[0]))}",
+            f"#define MODEL_IN_ZERO_POINT        ({in_q[1]})",
+            f"#define MODEL_OUT_SCALE            {c_float(f32(out_q[0]))}",
+            f"#define MODEL_OUT_ZERO_POINT       ({out_q[1]})",
+            "",
+            f"/* Normalize + quantize folded for ai_preproc_t: {{ mult, offset, shift }} per axis (sat{bits}) */",
+            "#define MODEL_PREPROC_INIT { { \\",
+        ]
+        lines += [f"    {{ {m}, {o}, {s}u }}, \\" for m, o, s in folds]
+    lines += ["} }", ""]
+    if precision != "int8":
+        return lines + ["#define MODEL_ENGINE_SUPPORTED     0   /* ai_engine.c is int8 only */"]
+    return lines + render_engine(layers)
+
+
+def render_header(stats: Dict, labels: List[str], window_frames: int, variants: Dict[str, Dict]) -> str:
+    """`variants`: precision -> {hash, in_q, out_q, layers} for every exported variant"""
+    mean = [f32(v) for v in stats["mean"]]
+    std = [f32(v) for v in stats["std"]]
+
+    lines = [
+        "/* Generated by python_ai_pipeline/export_model_params.py - do not edit.",
+        " * Regenerate after training; the CM7 build checks MODEL_PARAMS_HASH against the network. */",
+        "#ifndef __MODEL_PARAMS_H",
+        "#define __MODEL_PARAMS_H",
+        "",
+        "/* Precision of the network built in: -DMODEL_PRECISION=<one of these> for CM7 and CM4,",
+        " * with X-CUBE-AI/App generated from the matching .tflite */",
+        "#define MODEL_PRECISION_INT8       0   /* int8 weights and activations */",
+        "#define MODEL_PRECISION_INT16X8    1   /* int8 weights, int16 activations */",
+        "#define MODEL_PRECISION_FLOAT32    2",
+        "#ifndef MODEL_PRECISION",
+        "#define MODEL_PRECISION            MODEL_PRECISION_INT8",
+        "#endif",
+        "",
+        f"#define MODEL_WINDOW_FRAMES        {window_frames}",
+        f"#define MODEL_NUM_AXES             {len(AXES)}",
+        f"#define MODEL_NUM_CLASSES          {len(labels)}",
+        "",
+        "/* z-score normalization per axis (mg) */",
+    ]
+    for a, axis in enumerate(AXES):
+        lines.append(f"#define MODEL_MEAN_{axis}               {c_float(mean[a])}")
+    for a, axis in enumerate(AXES):
+        lines.append(f"#define MODEL_STD_{axis}                {c_float(std[a])}")
+    lines += [
+        "",
+        "#define MODEL_LABELS { " + ", ".join(json.dumps(l) for l in labels) + " }",
+        "",
+    ]
+    for i, precision in enumerate(PRECISIONS):
+        lines.append(f"#{'if' if i == 0 else 'elif'} MODEL_PRECISION == {PRECISION_MACROS[precision]}")
+        v = variants.get(precision)
+        if v is None:
+            lines.append(f'#error "model_params.h was generated without the {precision} variant '
+                         f'(models/{PRECISION_FILES[precision]})"')
+            continue
+        lines += render_variant(precision, v["hash"], v["in_q"], v["out_q"], mean, std, v["layers"])
+    lines += [
+        "#else",
+        '#error "MODEL_PRECISION: unknown precision"',
+        "#endif",
+        "",
+        "#endif /* __MODEL_PARAMS_H */",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def write_model_params(out_path: str, stats: Dict, labels: List[str], window_frames: int,
+                       tflites: Dict[str, str], in_q: Optional[Tuple[float, int]] = None,
+                       out_q: Optional[Tuple[float, int]] = None):
+    """`tflites`: precision -> .tflite of every exported variant. in_q / out_q override the
+    int8 variant's I/O quantization (read from its .tflite by default)."""
+    variants = {}
+    for precision, path in tflites.items():
+        q_in, q_out = tflite_quant_params(path)
+        if precision == "int8":
+            q_in, q_out = in_q or q_in, out_q or q_out
+        variants[precision] = {"hash": file_md5(path), "in_q": q_in, "out_q": q_out,
+                               "layers": engine_layers(TFLiteModel(path))}
+    text = render_header(stats, labels, window_frames, variants)
+    with open(out_path, "w", encoding="utf-8", newline="\n") as f:
+        f.write(text)
+
+
+def header_hashes(path: str) -> Dict[str, str]:
+    """MODEL_PARAMS_HASH of every variant in the header, by precision"""
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+    macros = {macro: precision for precision, macro in PRECISION_MACROS.items()}
+    found = re.findall(r'#(?:el)?if\s+MODEL_PRECISION\s*==\s*(\w+)\s+#define\s+MODEL_PARAMS_HASH\s+"([0-9a-fA-F]+)"', text)
+    return {macros[m]: h.lower() for m, h in found if m in macros}
+
+
+def header_hash(path: str, precision: str = "int8") -> str:
+    hashes = header_hashes(path)
+    if precision not in hashes:
+        raise ValueError(f"MODEL_PARAMS_HASH of the {precision} variant not found in {path}")
+    return hashes[precision]
+
+
+def network_signature(path: str) -> str:
+    with open(path, encoding="utf-8") as f:
+        m = re.search(r'#define\s+AI_\w+_MODEL_SIGNATURE\s+"(?:0x)?([0-9a-fA-F]+)"', f.read())
+    if not m:
+        raise ValueError(f"model signature not found in {path}")
+    return m.group(1).lower()
+
+
+def weights_blob(network_c: str) -> bytes:
+    """The X-CUBE-AI weights array from the *_data_params.c next to the network"""
+    path = re.sub(r"\.c$", "_data_params.c", network_c)
+    with open(path, encoding="utf-8") as f:
+        text = f.read()
+    m = re.search(r"_weights_array_u64\[\d+\]\s*=\s*\{([^}]*)\}", text)
+    if not m:
+        raise ValueError(f"weights array not found in {path}")
+    return b"".join(struct.pack("<Q", int(v, 16)) for v in re.findall(r"0x([0-9a-fA-F]+)", m.group(1)))
+
+
+def check_engine_offsets(layers: List[Dict], blob: bytes) -> List[str]:
+    """Layers whose weights or bias are not where model_params.h says in the blob"""
+    bad = []
+    for layer in layers:
+        for key in ("w", "b"):
+            if f"{key}_data" not in layer:
+                continue
+            off, data = layer[f"{key}_offset"], layer[f"{key}_data"]
+            if blob[off:off + len(data)] != data:
+                bad.append(f"{layer['name']}_{key.upper()}_OFFSET={off}")
+    return bad
+
+
+def parse_quant(text: str) -> Tuple[float, int]:
+    scale, zp = text.split(",")
+    return float(scale), int(zp)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate or check the model_params.h header.")
+    parser.add_argument("--stats", default=os.path.join(SCRIPT_DIR, "models", "normalization_stats.json"))
+    parser.add_argument("--labels", default=os.path.join(SCRIPT_DIR, "models", "label_map.json"))
+    parser.add_argument("--tflite", default=DEFAULT_TFLITE,
+                        help="int8 variant; int16x8 / float32 are taken from next to it when exported")
+    parser.add_argument("--out", default=DEFAULT_HEADER, help="Header to write (or check)")
+    parser.add_argument("--window-frames", type=int, default=0,
+                        help="Window length (default: window_seconds * inferred_sample_rate from the stats)")
+    parser.add_argument("--input-quant", default="", help="scale,zero_point (default: read from the .tflite)")
+    parser.add_argument("--output-quant", default="", help="scale,zero_point (default: read from the .tflite)")
+    parser.add_argument("--check", metavar="NETWORK_C", nargs="?", const=DEFAULT_NETWORK_C,
+                        help="Only verify --out against the generated network's model signature")
+    parser.add_argument("--precision", choices=PRECISIONS, default="int8",
+                        help="With --check: the MODEL_PRECISION the firmware is built with")
+    args = parser.parse_args()
+
+    if args.check:
+        hashes, actual = header_hashes(args.out), network_signature(args.check)
+        expected = hashes.get(args.precision)
+        if expected != actual:
+            other = [p for p, h in hashes.items() if h == actual]
+            hint = (f"build with -DMODEL_PRECISION={PRECISION_MACROS[other[0]]} or regenerate the network"
+                    if other else "rerun export_model_params.py")
+            have = f"{args.precision} model {expected}" if expected else f"no {args.precision} model"
+            print(f"error: {args.out} has {have}, but {args.check} is model {actual}; {hint}", file=sys.stderr)
+            return 1
+        # The open engine reads the network's weights blob at the generated offsets
+        if args.precision == "int8" and os.path.isfile(args.tflite) and file_md5(args.tflite) == expected:
+            layers = engine_layers(TFLiteModel(args.tflite))
+            bad = check_engine_offsets(layers, weights_blob(args.check)) if layers else []
+            if bad:
+                print(f"error: weights blob layout differs from {args.out}: {', '.join(bad)}", file=sys.stderr)
+                return 1
+        print(f"model_params.h ({args.precision}) matches network signature {actual}")
+        return 0
+
+    with open(args.stats, encoding="utf-8") as f:
+        stats = json.load(f)
+    with open(args.labels, encoding="utf-8") as f:
+        id_to_class = json.load(f)
+    labels = [id_to_class[str(i)] for i in range(len(id_to_class))]
+
+    window = args.window_frames
+    if not window:
+        info = stats["info"]
+        window = int(round(info["window_seconds"] * info["inferred_sample_rate"]))
+
+    in_q = out_q = None
+    if args.input_quant and args.output_quant:
+        in_q, out_q = parse_quant(args.input_quant), parse_quant(args.output_quant)
+
+    models_dir = os.path.dirname(os.path.abspath(args.tflite))
+    tflites = {"int8": args.tflite}
+    for precision in PRECISIONS[1:]:
+        path = variant_tflite(precision, models_dir)
+        if os.path.isfile(path):
+            tflites[precision] = path
+
+    write_model_params(args.out, stats, labels, window, tflites, in_q, out_q)
+    print(f"Wrote {args.out} ({', '.join(tflites)})")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
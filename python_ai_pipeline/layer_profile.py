@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""
+Render the CM7 per-layer profile (GET PROFILE, firmware built with AI_PROFILING=1)
+next to the MACC/ROM figures of the X-CUBE-AI generate report.
+
+    python layer_profile.py COM5                    # query the board
+    python layer_profile.py capture.txt             # LAYER: lines captured earlier
+    python layer_profile.py COM5 --csv layers.csv   # also write a CSV
+"""
+
+import os
+import re
+import sys
+import csv
+import time
+import argparse
+from typing import Dict, Iterable, List, Optional, Tuple
+
+SCRIPT_DIR = os.path.dirname(os.path.abspath(__file__))
+DEFAULT_REPORT = os.path.normpath(os.path.join(SCRIPT_DIR, "..", "CM7", "X-CUBE-AI", "App",
+                                               "motor_anomalie_generate_report.txt"))
+
+# "0      conv2d_1               1    Conv2D          51872    992     I: ..." in the C-Layers table
+_CLAYER_RE = re.compile(r"^(\d+)\s+(\w+)\s+(\d+)\s+(\w+)\s+(\d+)\s+(\d+)\s+[IOSW]:")
+_LAYER_RE = re.compile(r"^LAYER:(\d+),(\d+),(\d+),(\d+),(\d+),(\d+)$")
+_SUMMARY_RE = re.compile(r"^OK: PROFILE layers=(\d+) runs=(\d+) core_hz=(\d+)$")
+
+
+def load_report_layers(path: str) -> Dict[int, Dict]:
+    """c_id -> {name, id, type, macc, rom} from the generate report's C-Layers table"""
+    layers = {}
+    with open(path, encoding="utf-8", errors="replace") as f:
+        for line in f:
+            m = _CLAYER_RE.match(line.strip())
+            if m:
+                c_id, name, m_id, ltype, macc, rom = m.groups()
+                layers[int(c_id)] = {"name": name, "id": int(m_id), "type": ltype,
+                                     "macc": int(macc), "rom": int(rom)}
+    return layers
+
+
+def parse_profile(lines: Iterable[str]) -> Tuple[List[Dict], Optional[Dict]]:
+    """LAYER: records and the OK: PROFILE summary; raises on the firmware's ERROR reply"""
+    records, summary = [], None
+    for line in lines:
+        line = line.strip()
+        m = _LAYER_RE.match(line)
+        if m:
+            c_id, m_id, ntype, lo, avg, hi = (int(v) for v in m.groups())
+            records.append({"c_id": c_id, "m_id": m_id, "node_type": ntype,
+                            "min": lo, "avg": avg, "max": hi})
+            continue
+        m = _SUMMARY_RE.match(line)
+        if m:
+            summary = {"layers": int(m.group(1)), "runs": int(m.group(2)), "core_hz": int(m.group(3))}
+            break
+        if line.startswith("ERROR:"):
+            raise RuntimeError(line)
+    return records, summary
+
+
+def query_board(port: str, baud: int, timeout: float = 3.0) -> List[str]:
+    import serial
+    with serial.Serial(port, baud, timeout=0.2) as ser:
+        ser.reset_input_buffer()
+        ser.write(b"GET PROFILE\n")
+        lines, deadline = [], time.monotonic() + timeout
+        while time.monotonic() < deadline:
+            raw = ser.readline()
+            if not raw:
+                continue
+            line = raw.decode("utf-8", errors="replace").strip()
+            lines.append(line)
+            if line.startswith("OK: PROFILE") or line.startswith("ERROR:"):
+                break
+        return lines
+
+
+def merge(records: List[Dict], report: Dict[int, Dict]) -> List[Dict]:
+    rows = []
+    total_avg = sum(r["avg"] for r in records) or 1
+    for r in records:
+        info = report.get(r["c_id"], {"name": "?", "id": -1, "type": "?", "macc": 0, "rom": 0})
+        rows.append({
+            "c_id": r["c_id"], "name": info["name"], "id": r["m_id"], "layer_type": info["type"],
+            "macc": info["macc"], "rom": info["rom"],
+            "min_cycles": r["min"], "avg_cycles": r["avg"], "max_cycles": r["max"],
+            "cycles_per_macc": (r["avg"] / info["macc"]) if info["macc"] else None,
+            "share": 100.0 * r["avg"] / total_avg,
+            "id_mismatch": info["id"] != r["m_id"],
+        })
+    return rows
+
+
+def render(rows: List[Dict], summary: Optional[Dict]) -> str:
+    sep = ("------ ---------------------- ---- --------------- -------- ------- "
+           "---------- ---------- ---------- --------- ------")
+    out = []
+    if summary:
+        mhz = summary["core_hz"] / 1e6
+        out.append(f"C-Layers measured on target ({summary['runs']} runs, {mhz:.0f} MHz)")
+    else:
+        out.append("C-Layers measured on target")
+    out += [
+        sep,
+        "c_id   name (*_layer)         id   layer_type      macc     rom     "
+        "min_cyc    avg_cyc    max_cyc    cyc/macc  share",
+        sep,
+    ]
+    for r in rows:
+        cpm = f"{r['cycles_per_macc']:.2f}" if r["cycles_per_macc"] is not None else "-"
+        mark = "  (id differs from report)" if r["id_mismatch"] else ""
+        out.append(f"{r['c_id']:<6} {r['name']:<22} {r['id']:<4} {r['layer_type']:<15} {r['macc']:<8} "
+                   f"{r['rom']:<7} {r['min_cycles']:<10} {r['avg_cycles']:<10} {r['max_cycles']:<10} "
+                   f"{cpm:<9} {r['share']:5.1f}%{mark}")
+    out.append(sep)
+    total_macc = sum(r["macc"] for r in rows)
+    total_avg = sum(r["avg_cycles"] for r in rows)
+    line = f"total macc={total_macc:,} avg_cycles={total_avg:,}"
+    if total_macc:
+        line += f" cyc/macc={total_avg / total_macc:.2f}"
+    if summary and summary["core_hz"]:
+        line += f" avg_us={total_avg * 1e6 / summary['core_hz']:.1f}"
+    out.append(line)
+    return "\n".join(out)
+
+
+def write_csv(path: str, rows: List[Dict]):
+    fields = ["c_id", "name", "id", "layer_type", "macc", "rom",
+              "min_cycles", "avg_cycles", "max_cycles", "cycles_per_macc", "share"]
+    with open(path, "w", newline="", encoding="utf-8") as f:
+        w = csv.DictWriter(f, fieldnames=fields, extrasaction="ignore")
+        w.writeheader()
+        w.writerows(rows)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Per-layer CM7 inference profile vs the X-CUBE-AI report.")
+    parser.add_argument("input", nargs="?", default="-", help="Serial port, captured GET PROFILE output, or - for stdin")
+    parser.add_argument("--report", default=DEFAULT_REPORT, help="Path to motor_anomalie_generate_report.txt")
+    parser.add_argument("--baud", type=int, default=115200, help="Baud rate when input is a serial port")
+    parser.add_argument("--csv", default="", help="Also write the merged table as CSV")
+    args = parser.parse_args()
+
+    report = load_report_layers(args.report)
+    if args.input == "-":
+        lines = sys.stdin.readlines()
+    elif os.path.isfile(args.input):
+        with open(args.input, encoding="utf-8", errors="replace") as f:
+            lines = f.readlines()
+    else:
+        lines = query_board(args.input, args.baud)
+
+    try:
+        records, summary = parse_profile(lines)
+    except RuntimeError as e:
+        print(f"error: board replied {e}", file=sys.stderr)
+        return 1
+    if not records:
+        print("error: no LAYER: records found", file=sys.stderr)
+        return 1
+
+    rows = merge(records, report)
+    print(render(rows, summary))
+    if args.csv:
+        write_csv(args.csv, rows)
+        print(f"Wrote {args.csv}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
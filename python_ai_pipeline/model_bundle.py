@@ -0,0 +1,330 @@
+#!/usr/bin/env python3
+"""
+Build, inspect and upload CM7 model bundles: a retrained model loaded into the
+running network (MODEL commands) instead of regenerating and reflashing CM7.
+
+    python model_bundle.py build --tflite models/retrained_int8.tflite --out motor.mmbn
+    python model_bundle.py info motor.mmbn
+    python model_bundle.py send COM5 motor.mmbn
+    python model_bundle.py send COM5 --flash        # reload the bundle programmed at 0x080E0000
+
+The network code keeps the quantization X-CUBE-AI compiled into it, so the new
+weights are requantized onto the per-channel scales of the base model (the
+.tflite the network was generated from) and the bundle carries the base I/O
+quantization. The retrained model must have the base topology and shapes, and
+its activation scales should stay close to the base ones: `build` reports how
+far they drifted. Layout: CM7/Core/Inc/model_bundle.h.
+"""
+
+import os
+import re
+import sys
+import json
+import time
+import zlib
+import struct
+import argparse
+from typing import Dict, List, Optional, Tuple
+
+from tflite_reader import TFLiteModel
+from export_model_params import (DEFAULT_HEADER, DEFAULT_NETWORK_C, DEFAULT_TFLITE, SCRIPT_DIR, f32, file_md5,
+                                 engine_layers, network_signature, weights_blob)
+
+BUNDLE_MAGIC = 0x4E424D4D          # "MMBN"
+BUNDLE_VERSION = 1
+BUNDLE_AXES = 3
+BUNDLE_CLASSES = 4                 # SHARED_AI_NUM_CLASSES
+HASH_LEN = 32
+LABEL_LEN = 16
+# model_bundle_header_t, little endian
+HEADER_FMT = "<IHHII%ds%dsIHBB%df%dffifi" % (HASH_LEN, HASH_LEN, BUNDLE_AXES, BUNDLE_AXES) + \
+             "%ds" % LABEL_LEN * BUNDLE_CLASSES
+HEADER_SIZE = struct.calcsize(HEADER_FMT)
+CRC_OFFSET = 12                    # offsetof(model_bundle_header_t, crc32)
+STAGE_SIZE = 48 * 1024             # SHARED_MODEL_STAGE_SIZE
+CHUNK_BYTES = 80                   # MODEL_LOADER_CHUNK_MAX, send uses the chunk= MODEL BEGIN reports
+STATUS_NAMES = ("ok", "format", "crc", "network", "quant", "open")
+
+assert HEADER_SIZE == 192
+
+
+def bundle_crc(data: bytes) -> int:
+    """zlib CRC-32 of the bundle with its crc32 field zeroed (model_bundle_check())"""
+    return zlib.crc32(data[:CRC_OFFSET] + b"\0\0\0\0" + data[CRC_OFFSET + 4:]) & 0xFFFFFFFF
+
+
+def pack_bundle(model_hash: str, signature: str, weights: bytes, window_frames: int,
+                mean: List[float], std: List[float], in_q: Tuple[float, int], out_q: Tuple[float, int],
+                labels: List[str]) -> bytes:
+    names = [l.encode("utf-8")[:LABEL_LEN - 1] for l in labels] + [b""] * (BUNDLE_CLASSES - len(labels))
+    header = struct.pack(HEADER_FMT, BUNDLE_MAGIC, BUNDLE_VERSION, HEADER_SIZE, HEADER_SIZE + len(weights), 0,
+                         model_hash.encode("ascii"), signature.encode("ascii"), len(weights), window_frames,
+                         BUNDLE_AXES, len(labels), *[f32(v) for v in mean], *[f32(v) for v in std],
+                         f32(in_q[0]), in_q[1], f32(out_q[0]), out_q[1], *names)
+    data = header + weights
+    return data[:CRC_OFFSET] + struct.pack("<I", bundle_crc(data)) + data[CRC_OFFSET + 4:]
+
+
+def parse_bundle(data: bytes) -> Dict:
+    """Header fields of a bundle; raises ValueError on what CM7 would reject as format/crc"""
+    if len(data) < HEADER_SIZE:
+        raise ValueError("shorter than the header")
+    v = struct.unpack_from(HEADER_FMT, data)
+    a = BUNDLE_AXES
+    h = {
+        "magic": v[0], "version": v[1], "header_size": v[2], "total_size": v[3], "crc32": v[4],
+        "model_hash": v[5].decode("ascii", "replace"), "network_signature": v[6].decode("ascii", "replace"),
+        "weights_size": v[7], "window_frames": v[8], "num_axes": v[9], "num_classes": v[10],
+        "mean": list(v[11:11 + a]), "std": list(v[11 + a:11 + 2 * a]),
+        "in_q": (v[11 + 2 * a], v[12 + 2 * a]), "out_q": (v[13 + 2 * a], v[14 + 2 * a]),
+        "labels": [l.split(b"\0", 1)[0].decode("utf-8", "replace") for l in v[15 + 2 * a:]],
+    }
+    if (h["magic"] != BUNDLE_MAGIC or h["version"] != BUNDLE_VERSION or h["header_size"] != HEADER_SIZE
+            or h["total_size"] > len(data) or h["total_size"] != HEADER_SIZE + h["weights_size"]):
+        raise ValueError("bad magic, version or sizes")
+    if bundle_crc(data[:h["total_size"]]) != h["crc32"]:
+        raise ValueError("crc mismatch")
+    return h
+
+
+def firmware_target(header: str = DEFAULT_HEADER, network_c: str = DEFAULT_NETWORK_C) -> Dict:
+    """What CM7 checks a bundle against (model_bundle_target_t), from its sources"""
+    with open(header, encoding="utf-8") as f:
+        text = f.read()
+    num = lambda name: re.search(r"#define\s+%s\s+\(?(-?[0-9.]+)f?\)?" % name, text).group(1)
+    return {"network_signature": network_signature(network_c), "weights_size": len(weights_blob(network_c)),
+            "window_frames": int(num("MODEL_WINDOW_FRAMES")), "num_axes": int(num("MODEL_NUM_AXES")),
+            "num_classes": int(num("MODEL_NUM_CLASSES")),
+            "in_q": (f32(float(num("MODEL_IN_SCALE"))), int(num("MODEL_IN_ZERO_POINT"))),
+            "out_q": (f32(float(num("MODEL_OUT_SCALE"))), int(num("MODEL_OUT_ZERO_POINT")))}
+
+
+def check_bundle(data: bytes, target: Dict) -> int:
+    """Index into STATUS_NAMES, as model_bundle_check() returns it"""
+    try:
+        h = parse_bundle(data)
+    except ValueError as e:
+        return STATUS_NAMES.index("crc" if "crc" in str(e) else "format")
+    if any(h[k] != target[k] for k in ("network_signature", "weights_size", "window_frames",
+                                        "num_axes", "num_classes")):
+        return STATUS_NAMES.index("network")
+    if h["in_q"] != target["in_q"] or h["out_q"] != target["out_q"]:
+        return STATUS_NAMES.index("quant")
+    return STATUS_NAMES.index("ok")
+
+
+def _int8(data: bytes) -> List[int]:
+    return list(struct.unpack("<%db" % len(data), data))
+
+
+def _int32(data: bytes) -> List[int]:
+    return list(struct.unpack("<%di" % (len(data) // 4), data))
+
+
+def _layer_scales(model: TFLiteModel) -> List[Dict]:
+    """Per weighted layer: input/output activation scales and per-channel weight scales"""
+    out = []
+    for op in model.compute_ops():
+        if op.name not in ("CONV_2D", "FULLY_CONNECTED"):
+            continue
+        w = model.tensors[op.inputs[1]]
+        n = w.shape[0]
+        out.append({"in": model.tensors[op.inputs[0]].scale, "out": model.tensors[op.outputs[0]].scale,
+                    "w": list(w.scales) if len(w.scales) == n else list(w.scales) * n})
+    return out
+
+
+def requantize(base: TFLiteModel, new: TFLiteModel, blob: bytes) -> Tuple[bytes, Dict]:
+    """The base weights blob with every layer's weights and biases replaced by the new
+    model's, expressed on the base scales. Returns the blob and drift statistics."""
+    base_layers, new_layers = engine_layers(base), engine_layers(new)
+    if base_layers is None or new_layers is None:
+        raise ValueError("model does not fit the CM7 engine topology")
+    if [(l["name"], l.get("out_ch"), l.get("in_ch"), l.get("kernel")) for l in base_layers] != \
+       [(l["name"], l.get("out_ch"), l.get("in_ch"), l.get("kernel")) for l in new_layers]:
+        raise ValueError("layer shapes differ from the base model")
+
+    out = bytearray(blob)
+    stats = {"clipped": 0, "max_w_err": 0.0, "act_drift": 0.0}
+    weighted = [(b, n) for b, n in zip(base_layers, new_layers) if "w_data" in b]
+    for (b, n), bs, ns in zip(weighted, _layer_scales(base), _layer_scales(new)):
+        stats["act_drift"] = max(stats["act_drift"], abs(ns["in"] / bs["in"] - 1.0), abs(ns["out"] / bs["out"] - 1.0))
+        w_new, b_new = _int8(n["w_data"]), _int32(n["b_data"])
+        per_ch = len(w_new) // b["out_ch"]
+        w_q, b_q = [], []
+        for o in range(b["out_ch"]):
+            ratio = ns["w"][o] / bs["w"][o]
+            for q in w_new[o * per_ch:(o + 1) * per_ch]:
+                r = q * ratio
+                v = int(round(r))
+                if v < -127 or v > 127:
+                    stats["clipped"] += 1
+                    v = max(-127, min(127, v))
+                stats["max_w_err"] = max(stats["max_w_err"], abs(r - v) * bs["w"][o])
+                w_q.append(v)
+            # bias scale = input scale * weight scale
+            bias_ratio = (ns["in"] * ns["w"][o]) / (bs["in"] * bs["w"][o])
+            b_q.append(max(-2**31, min(2**31 - 1, int(round(b_new[o] * bias_ratio)))))
+        out[b["w_offset"]:b["w_offset"] + len(w_q)] = struct.pack("<%db" % len(w_q), *w_q)
+        out[b["b_offset"]:b["b_offset"] + 4 * len(b_q)] = struct.pack("<%di" % len(b_q), *b_q)
+    return bytes(out), stats
+
+
+def cmd_build(args) -> int:
+    signature = network_signature(args.network)
+    if file_md5(args.base) != signature:
+        print(f"error: {args.base} is not the model {args.network} was generated from ({signature})",
+              file=sys.stderr)
+        return 1
+    with open(args.stats, encoding="utf-8") as f:
+        stats = json.load(f)
+    with open(args.labels, encoding="utf-8") as f:
+        id_to_class = json.load(f)
+    labels = [id_to_class[str(i)] for i in range(len(id_to_class))]
+    window = args.window_frames or int(round(stats["info"]["window_seconds"] * stats["info"]["inferred_sample_rate"]))
+
+    base, new = TFLiteModel(args.base), TFLiteModel(args.tflite)
+    try:
+        weights, drift = requantize(base, new, weights_blob(args.network))
+    except ValueError as e:
+        print(f"error: {args.tflite}: {e}", file=sys.stderr)
+        return 1
+    if drift["act_drift"] > args.max_drift:
+        print(f"error: activation scales moved {drift['act_drift']:.1%} from the base model "
+              f"(--max-drift {args.max_drift:.1%}); regenerate the network instead", file=sys.stderr)
+        return 1
+
+    b_in, b_out = base.input(), base.output()
+    data = pack_bundle(file_md5(args.tflite), signature, weights, window, stats["mean"], stats["std"],
+                       (b_in.scale, b_in.zero_point), (b_out.scale, b_out.zero_point), labels)
+    if len(data) > STAGE_SIZE:
+        print(f"error: bundle is {len(data)} bytes, the CM4 stage holds {STAGE_SIZE}", file=sys.stderr)
+        return 1
+    with open(args.out, "wb") as f:
+        f.write(data)
+    print(f"Wrote {args.out}: {len(data)} bytes, crc32 0x{bundle_crc(data):08x}, "
+          f"{drift['clipped']} weights clipped, max weight error {drift['max_w_err']:.3g}, "
+          f"activation drift {drift['act_drift']:.1%}")
+    return 0
+
+
+def cmd_info(args) -> int:
+    with open(args.bundle, "rb") as f:
+        data = f.read()
+    try:
+        h = parse_bundle(data)
+    except ValueError as e:
+        print(f"error: {args.bundle}: {e}", file=sys.stderr)
+        return 1
+    print(f"model      {h['model_hash']}")
+    print(f"network    {h['network_signature']}")
+    print(f"size       {h['total_size']} bytes ({h['weights_size']} weights), crc32 0x{h['crc32']:08x}")
+    print(f"window     {h['window_frames']} frames x {h['num_axes']} axes, {h['num_classes']} classes")
+    print(f"mean       {', '.join(f'{v:.4f}' for v in h['mean'])}")
+    print(f"std        {', '.join(f'{v:.4f}' for v in h['std'])}")
+    print(f"input      scale {h['in_q'][0]!r} zero_point {h['in_q'][1]}")
+    print(f"output     scale {h['out_q'][0]!r} zero_point {h['out_q'][1]}")
+    print(f"labels     {', '.join(h['labels'][:h['num_classes']])}")
+    return 0
+
+
+def _command(ser, line: str, timeout: float = 2.0) -> str:
+    """Send one command, return its OK:/ERROR: reply"""
+    ser.write((line + "\n").encode("ascii"))
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        reply = ser.readline().decode("utf-8", errors="replace").strip()
+        if reply.startswith("OK:") or reply.startswith("ERROR:"):
+            return reply
+    return "ERROR: timeout"
+
+
+def _model_status(reply: str) -> Dict[str, str]:
+    return dict(kv.split("=", 1) for kv in reply.split()[2:] if "=" in kv)
+
+
+def cmd_send(args) -> int:
+    import serial
+    data = b""
+    if not args.flash:
+        if not args.bundle:
+            print("error: no bundle to send (or --flash)", file=sys.stderr)
+            return 1
+        with open(args.bundle, "rb") as f:
+            data = f.read()
+        try:
+            parse_bundle(data)
+        except ValueError as e:
+            print(f"error: {args.bundle}: {e}", file=sys.stderr)
+            return 1
+
+    with serial.Serial(args.port, args.baud, timeout=0.2) as ser:
+        ser.reset_input_buffer()
+        if args.flash:
+            reply = _command(ser, "MODEL FLASH")
+        else:
+            reply = _command(ser, f"MODEL BEGIN {len(data)} {zlib.crc32(data) & 0xFFFFFFFF}")
+            step = int(_model_status(reply).get("chunk", CHUNK_BYTES))
+            for off in range(0, len(data), step):
+                if not reply.startswith("OK:"):
+                    break
+                chunk = data[off:off + step].hex()
+                for _ in range(args.retries + 1):
+                    reply = _command(ser, f"MODEL DATA {off} {chunk}")
+                    if reply.startswith("OK:"):
+                        break
+            if reply.startswith("OK:"):
+                reply = _command(ser, "MODEL COMMIT")
+        if not reply.startswith("OK:"):
+            print(f"error: board replied {reply}", file=sys.stderr)
+            return 1
+
+        # CM7 switches between two inferences: wait for it to handle the request
+        request = _model_status(reply).get("request")
+        deadline = time.monotonic() + args.timeout
+        while time.monotonic() < deadline:
+            st = _model_status(_command(ser, "GET MODEL"))
+            if st.get("request") == request and st.get("pending") == "0":
+                print(f"status {st.get('status')}: model {st.get('hash')} in slot {st.get('slot')}, "
+                      f"switch took {st.get('swap_us')} us")
+                return 0 if st.get("status") == "ok" else 1
+            time.sleep(0.1)
+    print("error: CM7 did not handle the request", file=sys.stderr)
+    return 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build, inspect and upload CM7 model bundles.")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("build", help="Requantize a retrained .tflite onto the linked network")
+    p.add_argument("--tflite", required=True, help="Retrained int8 model")
+    p.add_argument("--stats", default=os.path.join(SCRIPT_DIR, "models", "normalization_stats.json"))
+    p.add_argument("--labels", default=os.path.join(SCRIPT_DIR, "models", "label_map.json"))
+    p.add_argument("--base", default=DEFAULT_TFLITE, help="Model the CM7 network was generated from")
+    p.add_argument("--network", default=DEFAULT_NETWORK_C, help="X-CUBE-AI network .c linked into CM7")
+    p.add_argument("--window-frames", type=int, default=0)
+    p.add_argument("--max-drift", type=float, default=0.25,
+                   help="Largest relative change of an activation scale from the base model")
+    p.add_argument("--out", required=True)
+    p.set_defaults(func=cmd_build)
+
+    p = sub.add_parser("info", help="Print a bundle's header")
+    p.add_argument("bundle")
+    p.set_defaults(func=cmd_info)
+
+    p = sub.add_parser("send", help="Upload a bundle and wait for CM7 to switch to it")
+    p.add_argument("port")
+    p.add_argument("bundle", nargs="?", default="")
+    p.add_argument("--baud", type=int, default=115200)
+    p.add_argument("--flash", action="store_true", help="Load the bundle already in CM7 flash instead")
+    p.add_argument("--retries", type=int, default=2, help="Resends of a chunk without OK")
+    p.add_argument("--timeout", type=float, default=5.0, help="Seconds to wait for CM7 to switch")
+    p.set_defaults(func=cmd_send)
+
+    args = parser.parse_args()
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -9,6 +9,7 @@ from sklearn.model_selection import train_test_split
 from sklearn.metrics import classification_report, confusion_matrix
 
 from dataset_loader import build_dataset, ID_TO_CLASS_NAME
+from export_model_params import DEFAULT_HEADER, PRECISIONS, PRECISION_FILES, write_model_params
 
 
 def standardize(X: np.ndarray) -> Tuple[np.ndarray, dict]:
@@ -37,23 +38,48 @@ def build_cnn(input_shape: Tuple[int, int], num_classes: int) -> tf.keras.Model:
     return model
 
 
-def to_tflite_int8(model: tf.keras.Model, rep_ds: np.ndarray, out_path: str):
+def to_tflite(model: tf.keras.Model, rep_ds: np.ndarray, out_path: str, precision: str = "int8"):
+    """int8: full integer; int16x8: int8 weights with int16 activations; float32: no quantization"""
     def rep_data_gen():
         for i in range(min(200, len(rep_ds))):
             x = rep_ds[i:i+1]
             yield [x.astype(np.float32)]
 
     conv = tf.lite.TFLiteConverter.from_keras_model(model)
-    conv.optimizations = [tf.lite.Optimize.DEFAULT]
-    conv.representative_dataset = rep_data_gen
-    conv.target_spec.supported_ops = [tf.lite.OpsSet.TFLITE_BUILTINS_INT8]
-    conv.inference_input_type = tf.int8
-    conv.inference_output_type = tf.int8
+    if precision != "float32":
+        conv.optimizations = [tf.lite.Optimize.DEFAULT]
+        conv.representative_dataset = rep_data_gen
+    if precision == "int8":
+        conv.target_spec.supported_ops = [tf.lite.OpsSet.TFLITE_BUILTINS_INT8]
+        conv.inference_input_type = tf.int8
+        conv.inference_output_type = tf.int8
+    elif precision == "int16x8":
+        conv.target_spec.supported_ops = [tf.lite.OpsSet.EXPERIMENTAL_TFLITE_BUILTINS_ACTIVATIONS_INT16_WEIGHTS_INT8]
+        conv.inference_input_type = tf.int16
+        conv.inference_output_type = tf.int16
     tflite = conv.convert()
     with open(out_path, "wb") as f:
         f.write(tflite)
 
 
+def tflite_accuracy(path: str, X: np.ndarray, y: np.ndarray) -> float:
+    """Test accuracy of a .tflite on standardized windows, quantizing its input as the firmware does"""
+    interp = tf.lite.Interpreter(model_path=path)
+    interp.allocate_tensors()
+    inp, out = interp.get_input_details()[0], interp.get_output_details()[0]
+    correct = 0
+    for i in range(len(X)):
+        x = X[i:i+1].astype(np.float32)
+        if inp["dtype"] != np.float32:
+            scale, zp = inp["quantization"]
+            info = np.iinfo(inp["dtype"])
+            x = np.clip(np.floor(x / scale + 0.5) + zp, info.min, info.max).astype(inp["dtype"])
+        interp.set_tensor(inp["index"], x)
+        interp.invoke()
+        correct += int(np.argmax(interp.get_tensor(out["index"])[0]) == y[i])
+    return correct / max(len(X), 1)
+
+
 def main():
     parser = argparse.ArgumentParser(description="Train motor anomaly CNN and export TFLite.")
     # Default dataset path: ../collected_data relative to this script
@@ -64,6 +90,8 @@ def main():
     parser.add_argument("--step", type=float, default=0.5, help="Stride in seconds between windows")
     parser.add_argument("--epochs", type=int, default=50, help="Training epochs")
     parser.add_argument("--batch", type=int, default=64, help="Batch size")
+    parser.add_argument("--params-header", default=DEFAULT_HEADER,
+                        help="Generated C header with preprocessing/quantization constants for the CM7 firmware")
     args = parser.parse_args()
 
     base_dir = args.data
@@ -106,10 +134,26 @@ def main():
     with open("models/label_map.json", "w", encoding="utf-8") as f:
         json.dump(info["id_to_class"], f, indent=2)
 
-    # INT8 TFLite
-    to_tflite_int8(model, X_train[:500], "models/motor_cnn_int8.tflite")
+    # TFLite in every precision the firmware can build (MODEL_PRECISION), with the test
+    # accuracy of each for precision_report.py
+    tflites, evaluation = {}, {"keras_accuracy": float(np.mean(y_pred == y_test)), "variants": {}}
+    for precision in PRECISIONS:
+        path = os.path.join("models", PRECISION_FILES[precision])
+        to_tflite(model, X_train[:500], path, precision)
+        tflites[precision] = path
+        acc = tflite_accuracy(path, X_test, y_test)
+        evaluation["variants"][precision] = {"file": PRECISION_FILES[precision], "accuracy": acc,
+                                             "size_bytes": os.path.getsize(path)}
+        print(f"{precision:>8}: test accuracy {acc:.4f}")
+    with open("models/precision_eval.json", "w", encoding="utf-8") as f:
+        json.dump(evaluation, f, indent=2)
     print("Saved models to ./models/")
 
+    # Firmware constants for exactly these models (checked against the X-CUBE-AI signature at build time)
+    labels = [ID_TO_CLASS_NAME.get(i, str(i)) for i in range(num_classes)]
+    write_model_params(args.params_header, stats, labels, int(X.shape[1]), tflites)
+    print(f"Wrote {args.params_header}")
+
 
 if __name__ == "__main__":
     main()
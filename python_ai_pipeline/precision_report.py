@@ -0,0 +1,237 @@
+#!/usr/bin/env python3
+"""
+Tabulate the precision variants model_trainer.py exports (int8, int16x8, float32):
+test accuracy, ROM and RAM from the X-CUBE-AI generate report, and cycles per inference
+measured on the board, so a deployment can pick its MODEL_PRECISION from real numbers.
+
+Each variant is a separate CM7 build (X-CUBE-AI/App generated from its .tflite, built
+with -DMODEL_PRECISION=...). After flashing one, record it:
+
+    python precision_report.py measure COM5          # variant found from the report's model hash
+    python precision_report.py measure --no-board    # ROM/RAM only
+    python precision_report.py show [--csv precision.csv]
+
+Accuracy comes from models/precision_eval.json (model_trainer.py). Cycles come from
+GET BENCH when CM7 is built with AI_PLACEMENT_BENCH=1 (fastest placement), else from the
+GET PERF average inference time at --core-hz. A CM7 built with AI_OFFLOAD_BENCH=1 also
+reports windows/s on CM7 alone and with CM4 taking offloaded windows (GET OFFLOAD); measure
+waits up to --offload-wait seconds for that boot benchmark to finish.
+"""
+
+import os
+import re
+import sys
+import csv
+import json
+import time
+import argparse
+from typing import Dict, List, Optional
+
+from export_model_params import DEFAULT_HEADER, PRECISIONS, PRECISION_MACROS, SCRIPT_DIR, header_hashes
+
+DEFAULT_REPORT = os.path.normpath(os.path.join(SCRIPT_DIR, "..", "CM7", "X-CUBE-AI", "App",
+                                               "motor_anomalie_generate_report.txt"))
+DEFAULT_EVAL = os.path.join(SCRIPT_DIR, "models", "precision_eval.json")
+DEFAULT_STORE = os.path.join(SCRIPT_DIR, "models", "precision_report.json")
+
+_BENCH_RE = re.compile(r"^BENCH:(\w+),(\w+),(\d+),(\d+),(\d+),(\d+)$")
+_BENCH_OK_RE = re.compile(r"^OK: BENCH entries=(\d+) core_hz=(\d+)$")
+_PERF_AVG_RE = re.compile(r"\binfer_avg_us=(\d+)")
+_OFFLOAD_RE = re.compile(r"^OK: OFFLOAD windows=(\d+) one_core_wps_x100=(\d+) two_core_wps_x100=(\d+) "
+                         r"cm4_windows=(\d+) mismatches=(\d+) core_hz=(\d+)$")
+
+
+def parse_generate_report(path: str) -> Dict:
+    """model_hash, macc, weights (ROM) and activations (RAM) bytes of a generate report"""
+    with open(path, encoding="utf-8", errors="replace") as f:
+        text = f.read()
+
+    def field(name: str) -> str:
+        m = re.search(r"^%s\s*:\s*(.+)$" % re.escape(name), text, re.MULTILINE)
+        if not m:
+            raise ValueError(f"'{name}' not found in {path}")
+        return m.group(1).strip()
+
+    def num(value: str) -> int:
+        return int(re.match(r"([\d,]+)", value).group(1).replace(",", ""))
+
+    return {"model_hash": field("model_hash").lower().replace("0x", ""),
+            "macc": num(field("macc")),
+            "rom_bytes": num(field("weights (ro)")),
+            "ram_bytes": num(field("activations (rw)"))}
+
+
+def board_command(ser, command: str, done: str, timeout: float = 3.0) -> List[str]:
+    ser.reset_input_buffer()
+    ser.write((command + "\n").encode())
+    lines, deadline = [], time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        raw = ser.readline()
+        if not raw:
+            continue
+        line = raw.decode("utf-8", errors="replace").strip()
+        lines.append(line)
+        if line.startswith(done) or line.startswith("ERROR:"):
+            break
+    return lines
+
+
+def measure_cycles(port: str, baud: int, core_hz: float) -> Optional[Dict]:
+    """Average cycles per inference: GET BENCH (fastest placement), else GET PERF"""
+    import serial
+    with serial.Serial(port, baud, timeout=0.2) as ser:
+        best, hz = None, None
+        for line in board_command(ser, "GET BENCH", "OK: BENCH"):
+            m = _BENCH_RE.match(line)
+            if m and (best is None or int(m.group(5)) < best["cycles"]):
+                best = {"cycles": int(m.group(5)), "source": f"GET BENCH {m.group(1)}/{m.group(2)}"}
+            m = _BENCH_OK_RE.match(line)
+            if m:
+                hz = int(m.group(2))
+        if best and hz:
+            return dict(best, core_hz=hz)
+
+        for line in board_command(ser, "GET PERF", "OK: PERF"):
+            m = _PERF_AVG_RE.search(line)
+            if m and line.startswith("OK: PERF") and int(m.group(1)) > 0:
+                return {"cycles": int(int(m.group(1)) * core_hz / 1e6), "core_hz": int(core_hz),
+                        "source": "GET PERF infer_avg_us"}
+    return None
+
+
+def measure_offload(port: str, baud: int, wait_s: float) -> Optional[Dict]:
+    """Windows/s on CM7 alone and with CM4 offload from GET OFFLOAD, None without the benchmark"""
+    import serial
+    with serial.Serial(port, baud, timeout=0.2) as ser:
+        deadline = time.monotonic() + wait_s
+        while True:
+            for line in board_command(ser, "GET OFFLOAD", "OK: OFFLOAD"):
+                m = _OFFLOAD_RE.match(line)
+                if m:
+                    two = int(m.group(3)) / 100.0
+                    return {"offload_windows": int(m.group(1)), "one_core_wps": int(m.group(2)) / 100.0,
+                            "two_core_wps": two if two > 0 else None, "cm4_windows": int(m.group(4)),
+                            "offload_mismatches": int(m.group(5))}
+            if time.monotonic() >= deadline:
+                return None
+            time.sleep(0.5)
+
+
+def load_json(path: str) -> Dict:
+    if not os.path.isfile(path):
+        return {}
+    with open(path, encoding="utf-8") as f:
+        return json.load(f)
+
+
+def cmd_measure(args) -> int:
+    report = parse_generate_report(args.report)
+    precision = args.precision
+    if not precision:
+        found = [p for p, h in header_hashes(args.header).items() if h == report["model_hash"]]
+        if not found:
+            print(f"error: {args.report} is model {report['model_hash']}, which is no variant of "
+                  f"{args.header}; rerun export_model_params.py or pass --precision", file=sys.stderr)
+            return 1
+        precision = found[0]
+
+    entry = dict(report)
+    if not args.no_board:
+        cycles = measure_cycles(args.port, args.baud, args.core_hz)
+        if cycles is None:
+            print("error: no inference timing from the board (GET BENCH / GET PERF)", file=sys.stderr)
+            return 1
+        entry.update(cycles)
+        offload = measure_offload(args.port, args.baud, args.offload_wait)
+        if offload:
+            entry.update(offload)
+            if offload["two_core_wps"] is None:
+                print("warning: CM4 did not join the offload benchmark (two_core_wps_x100=0)", file=sys.stderr)
+            if offload["offload_mismatches"]:
+                print(f"warning: {offload['offload_mismatches']} CM4 windows differ from the CM7 runtime",
+                      file=sys.stderr)
+
+    store = load_json(args.store)
+    store.setdefault(precision, {}).update(entry)
+    with open(args.store, "w", encoding="utf-8") as f:
+        json.dump(store, f, indent=2)
+    print(f"{precision}: {json.dumps(entry)}")
+    print(f"Recorded in {args.store} (the CM7 build must use -DMODEL_PRECISION={PRECISION_MACROS[precision]})")
+    return 0
+
+
+def rows_for(store: Dict, evaluation: Dict) -> List[Dict]:
+    rows = []
+    for precision in PRECISIONS:
+        s = store.get(precision, {})
+        acc = evaluation.get("variants", {}).get(precision, {}).get("accuracy")
+        cycles, hz = s.get("cycles"), s.get("core_hz")
+        rows.append({"precision": precision, "accuracy": acc, "rom_bytes": s.get("rom_bytes"),
+                     "ram_bytes": s.get("ram_bytes"), "macc": s.get("macc"), "cycles": cycles,
+                     "us": (cycles * 1e6 / hz) if cycles and hz else None,
+                     "cycles_per_macc": (cycles / s["macc"]) if cycles and s.get("macc") else None,
+                     "one_core_wps": s.get("one_core_wps"), "two_core_wps": s.get("two_core_wps"),
+                     "source": s.get("source", "")})
+    return rows
+
+
+def render(rows: List[Dict], keras_accuracy: Optional[float]) -> str:
+    def fmt(v, spec: str) -> str:
+        return format(v, spec) if v is not None else "-"
+
+    sep = "--------- -------- ---------- ---------- ---------- ---------- -------- -------- -------- --------"
+    out = [sep, "precision accuracy rom_bytes  ram_bytes  macc       cycles     us       cyc/macc 1core/s  2core/s", sep]
+    for r in rows:
+        out.append(f"{r['precision']:<9} {fmt(r['accuracy'], '.4f'):<8} {fmt(r['rom_bytes'], ','):<10} "
+                   f"{fmt(r['ram_bytes'], ','):<10} {fmt(r['macc'], ','):<10} {fmt(r['cycles'], ','):<10} "
+                   f"{fmt(r['us'], '.1f'):<8} {fmt(r['cycles_per_macc'], '.2f'):<8} "
+                   f"{fmt(r['one_core_wps'], '.1f'):<8} {fmt(r['two_core_wps'], '.1f'):<8}")
+    out.append(sep)
+    if keras_accuracy is not None:
+        out.append(f"keras float model accuracy {keras_accuracy:.4f}")
+    return "\n".join(out)
+
+
+def cmd_show(args) -> int:
+    evaluation = load_json(args.eval)
+    rows = rows_for(load_json(args.store), evaluation)
+    print(render(rows, evaluation.get("keras_accuracy")))
+    if args.csv:
+        with open(args.csv, "w", newline="", encoding="utf-8") as f:
+            w = csv.DictWriter(f, fieldnames=list(rows[0].keys()))
+            w.writeheader()
+            w.writerows(rows)
+        print(f"Wrote {args.csv}")
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Accuracy / ROM / RAM / cycles of the model precision variants.")
+    parser.add_argument("--store", default=DEFAULT_STORE, help="Measurements recorded so far")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("measure", help="Record the variant the board runs now")
+    p.add_argument("port", nargs="?", default="", help="Serial port of the board")
+    p.add_argument("--baud", type=int, default=115200)
+    p.add_argument("--report", default=DEFAULT_REPORT, help="Generate report of the network built in")
+    p.add_argument("--header", default=DEFAULT_HEADER, help="model_params.h holding the variants")
+    p.add_argument("--precision", choices=PRECISIONS, default="", help="Default: from the report's model hash")
+    p.add_argument("--core-hz", type=float, default=480e6, help="CM7 clock for GET PERF timings")
+    p.add_argument("--no-board", action="store_true", help="Only record ROM/RAM/MACC")
+    p.add_argument("--offload-wait", type=float, default=0.0,
+                   help="Seconds to wait for the AI_OFFLOAD_BENCH boot benchmark (GET OFFLOAD)")
+    p.set_defaults(func=cmd_measure)
+
+    p = sub.add_parser("show", help="Print the trade-off table")
+    p.add_argument("--eval", default=DEFAULT_EVAL, help="precision_eval.json from model_trainer.py")
+    p.add_argument("--csv", default="", help="Also write the table as CSV")
+    p.set_defaults(func=cmd_show)
+
+    args = parser.parse_args()
+    if args.cmd == "measure" and not args.no_board and not args.port:
+        parser.error("measure needs a serial port (or --no-board)")
+    return args.func(args)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
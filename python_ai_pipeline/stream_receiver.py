@@ -0,0 +1,216 @@
+import sys
+import time
+import struct
+import argparse
+from typing import Callable, List, Optional
+
+from data_collector import crc16_ccitt
+
+
+SYNC = b"\xA5\x5A"
+HEADER_SIZE = 7          # sync(2) type(1) seq(2) len(2)
+MAX_PAYLOAD = 512
+PKT_SAMPLES = 1
+PKT_RESULT = 2
+PKT_STATS = 3
+PKT_DECISION = 4
+CREDIT_RESYNC_S = 2.0    # the device sends counters every second while it has credit
+
+
+class StreamParser:
+    # Splits the CDC byte stream into packets (see CM4/Core/Inc/stream.h) and text lines
+
+    def __init__(self, on_packet: Callable[[int, int, bytes], None],
+                 on_text: Optional[Callable[[str], None]] = None):
+        self.buf = bytearray()
+        self.text = bytearray()
+        self.on_packet = on_packet
+        self.on_text = on_text
+        self.crc_errors = 0
+
+    def _emit_text(self, data: bytes):
+        self.text.extend(data)
+        while b"\n" in self.text:
+            line, _, rest = bytes(self.text).partition(b"\n")
+            self.text = bytearray(rest)
+            line = line.decode("utf-8", errors="replace").strip()
+            if line and self.on_text:
+                self.on_text(line)
+
+    def feed(self, data: bytes):
+        self.buf.extend(data)
+        while True:
+            idx = self.buf.find(SYNC)
+            if idx < 0:
+                # Keep a trailing 0xA5 that may start the next sync
+                keep = 1 if self.buf.endswith(SYNC[:1]) else 0
+                self._emit_text(bytes(self.buf[:len(self.buf) - keep]))
+                del self.buf[:len(self.buf) - keep]
+                return
+            if idx:
+                self._emit_text(bytes(self.buf[:idx]))
+                del self.buf[:idx]
+            if len(self.buf) < HEADER_SIZE:
+                return
+            ptype, seq, length = struct.unpack_from("<BHH", self.buf, 2)
+            if length > MAX_PAYLOAD:
+                del self.buf[:1]
+                continue
+            total = HEADER_SIZE + length + 2
+            if len(self.buf) < total:
+                return
+            (crc,) = struct.unpack_from("<H", self.buf, HEADER_SIZE + length)
+            if crc16_ccitt(bytes(self.buf[2:HEADER_SIZE + length])) != crc:
+                self.crc_errors += 1
+                del self.buf[:1]
+                continue
+            payload = bytes(self.buf[HEADER_SIZE:HEADER_SIZE + length])
+            del self.buf[:total]
+            self.on_packet(ptype, seq, payload)
+
+
+class StreamStats:
+    # Throughput and loss accounting for one streaming session
+
+    def __init__(self):
+        self.packets = 0
+        self.bytes = 0
+        self.frames = 0
+        self.results = 0
+        self.changes = 0
+        self.lost_packets = 0
+        self.credits_used = 0       # packets the device numbered, i.e. credits it spent
+        self.lost_frames = 0
+        self.device = None
+        self.last_seq = None
+        self.next_frame_index = None
+        self.samples: List[tuple] = []
+        self.decisions: List[tuple] = []
+        self.events: List[tuple] = []
+        self.keep = False
+
+    def on_packet(self, ptype: int, seq: int, payload: bytes):
+        self.packets += 1
+        self.bytes += HEADER_SIZE + len(payload) + 2
+        # Every packet costs the device one credit and one seq (from 0 at STREAM ON), so
+        # packets lost on the wire still count as spent
+        if self.last_seq is not None:
+            gap = (seq - self.last_seq - 1) & 0xFFFF
+            self.lost_packets += gap
+            self.credits_used += gap + 1
+        else:
+            self.credits_used = seq + 1
+        self.last_seq = seq
+
+        if ptype == PKT_SAMPLES:
+            first, count, _ = struct.unpack_from("<IHH", payload, 0)
+            if self.next_frame_index is not None and first > self.next_frame_index:
+                self.lost_frames += first - self.next_frame_index
+            self.next_frame_index = first + count
+            self.frames += count
+            if self.keep:
+                for i in range(count):
+                    ts, x, y, z = struct.unpack_from("<Ihhh", payload, 8 + i * 10)
+                    self.samples.append((first + i, ts, x, y, z))
+        elif ptype == PKT_RESULT:
+            rseq, ts, cls = struct.unpack_from("<IIB", payload, 0)
+            scores = struct.unpack_from("<4b", payload, 9)
+            channel, state = payload[13], payload[14]
+            self.results += 1
+            if self.keep:
+                self.decisions.append((rseq, ts, channel, cls) + tuple(scores) + (state,))
+        elif ptype == PKT_DECISION:
+            # Kept regardless of --csv: one packet per state change, not per window
+            self.changes += 1
+            self.events.append(struct.unpack_from("<IIIBBBB", payload, 0))
+        elif ptype == PKT_STATS:
+            queued, dropped, sent, stalls = struct.unpack_from("<IIII", payload, 0)
+            self.device = {"queued": queued, "dropped": dropped, "packets": sent, "credit_stalls": stalls}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Receive the CM4 STREAM ON feed and report throughput and drops.")
+    parser.add_argument("port", help="Serial port of the board (e.g. COM3, /dev/ttyACM0)")
+    parser.add_argument("--baud", type=int, default=115200, help="Baud rate")
+    parser.add_argument("--window", type=int, default=64, help="Credit window (packets in flight)")
+    parser.add_argument("--duration", type=float, default=0.0, help="Stop after N seconds (0 = until Ctrl-C)")
+    parser.add_argument("--csv", default="", help="Write samples to <csv>_samples.csv, results to <csv>_results.csv "
+                                                  "and state changes to <csv>_decisions.csv")
+    parser.add_argument("--decisions", action="store_true",
+                        help="Stream only state changes and stats (STREAM ON <window> DECISIONS)")
+    args = parser.parse_args()
+
+    import serial
+    ser = serial.Serial(args.port, args.baud, timeout=0.05)
+    stats = StreamStats()
+    stats.keep = bool(args.csv)
+    stream = StreamParser(stats.on_packet, on_text=lambda line: print(f"< {line}"))
+
+    def send(cmd: str):
+        ser.write(f"{cmd}\r\n".encode("utf-8"))
+
+    send(f"STREAM ON {args.window}" + (" DECISIONS" if args.decisions else ""))
+    granted = args.window
+    written_off = 0
+    start = last_report = last_data = time.time()
+    last_packets = last_frames = last_bytes = 0
+
+    try:
+        while not args.duration or (time.time() - start) < args.duration:
+            data = ser.read(4096)
+            now = time.time()
+            if data:
+                stream.feed(data)
+                last_data = now
+            elif now - last_data >= CREDIT_RESYNC_S and max(stats.credits_used, written_off) < granted:
+                # Silent with credit out: whatever was in flight was lost after the
+                # last packet seen, so write the window off and grant it again
+                written_off = granted
+                last_data = now
+
+            # Top the credit window back up once half of it is used
+            outstanding = granted - max(stats.credits_used, written_off)
+            if outstanding < args.window // 2:
+                grant = args.window - outstanding
+                send(f"STREAM CREDIT {grant}")
+                granted += grant
+
+            if now - last_report >= 1.0:
+                dt = now - last_report
+                print(f"{(stats.packets - last_packets) / dt:7.1f} pkt/s "
+                      f"{(stats.frames - last_frames) / dt:7.1f} frames/s "
+                      f"{(stats.bytes - last_bytes) / dt / 1024:7.2f} KiB/s | "
+                      f"results={stats.results} decisions={stats.changes} lost_pkts={stats.lost_packets} "
+                      f"lost_frames={stats.lost_frames} crc_err={stream.crc_errors} device={stats.device}",
+                      flush=True)
+                last_report, last_packets, last_frames, last_bytes = now, stats.packets, stats.frames, stats.bytes
+    except KeyboardInterrupt:
+        pass
+    finally:
+        send("STREAM OFF")
+        time.sleep(0.2)
+        stream.feed(ser.read(4096))
+        ser.close()
+
+    elapsed = max(time.time() - start, 1e-6)
+    print(f"\nTotal: {stats.packets} packets, {stats.frames} frames, {stats.results} results in {elapsed:.1f} s "
+          f"({stats.bytes / elapsed / 1024:.2f} KiB/s sustained)")
+    print(f"Lost packets: {stats.lost_packets}, lost frames: {stats.lost_frames}, CRC errors: {stream.crc_errors}")
+    for event_id, ts, onset, channel, frm, to, conf in stats.events:
+        print(f"Decision {event_id}: channel {channel} class {frm} -> {to} at {ts} ms, confidence {conf}%, "
+              f"confirmed {ts - onset} ms after onset")
+
+    if args.csv:
+        with open(f"{args.csv}_samples.csv", "w") as f:
+            f.write("index,ts,x,y,z\n")
+            f.writelines(",".join(map(str, row)) + "\n" for row in stats.samples)
+        with open(f"{args.csv}_results.csv", "w") as f:
+            f.write("seq,window_end_ts,channel,class,s0,s1,s2,s3,state\n")
+            f.writelines(",".join(map(str, row)) + "\n" for row in stats.decisions)
+        with open(f"{args.csv}_decisions.csv", "w") as f:
+            f.write("event_id,ts,onset_ts,channel,from,to,confidence_pct\n")
+            f.writelines(",".join(map(str, row)) + "\n" for row in stats.events)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
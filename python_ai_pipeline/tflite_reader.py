@@ -0,0 +1,172 @@
+#!/usr/bin/env python3
+"""
+Minimal reader for the .tflite flatbuffer: tensors, quantization, constant buffers and
+operators with their builtin options. Enough for the code generators in this folder to
+run without tensorflow.
+
+    from tflite_reader import TFLiteModel
+    model = TFLiteModel("models/motor_cnn_int8.tflite")
+    for op in model.operators:
+        print(op.name, [model.tensors[i].name for i in op.inputs])
+"""
+
+import struct
+from typing import Dict, List, Optional
+
+# BuiltinOperator codes used by this model family
+BUILTIN_NAMES = {
+    3: "CONV_2D",
+    9: "FULLY_CONNECTED",
+    17: "MAX_POOL_2D",
+    22: "RESHAPE",
+    25: "SOFTMAX",
+    40: "MEAN",
+    70: "EXPAND_DIMS",
+}
+
+# TensorType
+TYPE_FLOAT32, TYPE_INT32, TYPE_UINT8, TYPE_INT64, TYPE_INT16, TYPE_INT8 = 0, 2, 3, 4, 7, 9
+_STRUCT_FMT = {TYPE_FLOAT32: "f", TYPE_INT32: "i", TYPE_INT64: "q", TYPE_UINT8: "B",
+               TYPE_INT16: "h", TYPE_INT8: "b"}
+
+# Padding / ActivationFunctionType
+PADDING_SAME, PADDING_VALID = 0, 1
+ACT_NONE, ACT_RELU, ACT_RELU_N1_TO_1, ACT_RELU6 = 0, 1, 2, 3
+
+
+class _Table:
+    """A flatbuffer table: field i lives at vtable slot 4 + 2 * i"""
+
+    def __init__(self, buf: bytes, pos: int):
+        self.buf = buf
+        self.pos = pos
+        self.vtable = pos - struct.unpack_from("<i", buf, pos)[0]
+        self.vtable_len = struct.unpack_from("<H", buf, self.vtable)[0]
+
+    def _offset(self, field: int) -> int:
+        slot = 4 + 2 * field
+        return struct.unpack_from("<H", self.buf, self.vtable + slot)[0] if slot < self.vtable_len else 0
+
+    def scalar(self, field: int, fmt: str, default=0):
+        off = self._offset(field)
+        return struct.unpack_from("<" + fmt, self.buf, self.pos + off)[0] if off else default
+
+    def _indirect(self, field: int) -> Optional[int]:
+        off = self._offset(field)
+        if not off:
+            return None
+        return self.pos + off + struct.unpack_from("<I", self.buf, self.pos + off)[0]
+
+    def table(self, field: int) -> Optional["_Table"]:
+        pos = self._indirect(field)
+        return _Table(self.buf, pos) if pos is not None else None
+
+    def _vector(self, field: int):
+        pos = self._indirect(field)
+        if pos is None:
+            return None, 0
+        return pos + 4, struct.unpack_from("<I", self.buf, pos)[0]
+
+    def tables(self, field: int) -> List["_Table"]:
+        pos, n = self._vector(field)
+        if pos is None:
+            return []
+        return [_Table(self.buf, pos + 4 * k + struct.unpack_from("<I", self.buf, pos + 4 * k)[0])
+                for k in range(n)]
+
+    def scalars(self, field: int, fmt: str) -> list:
+        pos, n = self._vector(field)
+        if pos is None:
+            return []
+        return list(struct.unpack_from("<%d%s" % (n, fmt), self.buf, pos))
+
+    def string(self, field: int) -> str:
+        pos, n = self._vector(field)
+        return self.buf[pos:pos + n].decode("utf-8") if pos is not None else ""
+
+    def raw(self, field: int) -> bytes:
+        pos, n = self._vector(field)
+        return self.buf[pos:pos + n] if pos is not None else b""
+
+
+class Tensor:
+    def __init__(self, t: _Table, buffers: List[bytes]):
+        self.shape = t.scalars(0, "i")
+        self.type = t.scalar(1, "b", 0)
+        self.data = buffers[t.scalar(2, "I", 0)]
+        self.name = t.string(3)
+        q = t.table(4)
+        self.scales = q.scalars(2, "f") if q else []
+        self.zero_points = q.scalars(3, "q") if q else []
+        self.quant_dim = q.scalar(6, "i", 0) if q else 0
+
+    @property
+    def scale(self) -> float:
+        return float(self.scales[0])
+
+    @property
+    def zero_point(self) -> int:
+        return int(self.zero_points[0])
+
+    def values(self) -> list:
+        """Constant data as a flat list (empty for activations)"""
+        fmt = _STRUCT_FMT[self.type]
+        return list(struct.unpack("<%d%s" % (len(self.data) // struct.calcsize(fmt), fmt), self.data))
+
+
+class Operator:
+    def __init__(self, op: _Table, codes: List[int]):
+        self.code = codes[op.scalar(0, "I", 0)]
+        self.name = BUILTIN_NAMES.get(self.code, f"BUILTIN_{self.code}")
+        self.inputs = op.scalars(1, "i")
+        self.outputs = op.scalars(2, "i")
+        self.options = op.table(4)
+
+    def option(self, field: int, fmt: str, default=0):
+        return self.options.scalar(field, fmt, default) if self.options else default
+
+
+class TFLiteModel:
+    def __init__(self, path: str):
+        with open(path, "rb") as f:
+            buf = f.read()
+        model = _Table(buf, struct.unpack_from("<I", buf, 0)[0])
+        # builtin_code (int32) superseded the deprecated int8 field at 127
+        codes = [max(oc.scalar(0, "b", 0), oc.scalar(3, "i", 0)) for oc in model.tables(1)]
+        buffers = [b.raw(0) for b in model.tables(4)]
+        graph = model.tables(2)[0]
+        self.tensors = [Tensor(t, buffers) for t in graph.tables(0)]
+        self.inputs = graph.scalars(1, "i")
+        self.outputs = graph.scalars(2, "i")
+        self.operators = [Operator(o, codes) for o in graph.tables(3)]
+
+    def input(self, index: int = 0) -> Tensor:
+        return self.tensors[self.inputs[index]]
+
+    def output(self, index: int = 0) -> Tensor:
+        return self.tensors[self.outputs[index]]
+
+    def compute_ops(self) -> List[Operator]:
+        """Operators without the shape-only EXPAND_DIMS / RESHAPE glue"""
+        return [op for op in self.operators if op.name not in ("EXPAND_DIMS", "RESHAPE")]
+
+
+def conv_options(op: Operator) -> Dict:
+    """Conv2DOptions: padding, stride_w, stride_h, fused_activation_function"""
+    return {"padding": op.option(0, "b"), "stride_w": op.option(1, "i"), "stride_h": op.option(2, "i"),
+            "activation": op.option(3, "b")}
+
+
+def pool_options(op: Operator) -> Dict:
+    """Pool2DOptions: padding, stride_w, stride_h, filter_width, filter_height"""
+    return {"padding": op.option(0, "b"), "stride_w": op.option(1, "i"), "stride_h": op.option(2, "i"),
+            "filter_w": op.option(3, "i"), "filter_h": op.option(4, "i"), "activation": op.option(5, "b")}
+
+
+def fc_activation(op: Operator) -> int:
+    """FullyConnectedOptions.fused_activation_function"""
+    return op.option(0, "b")
+
+
+def softmax_beta(op: Operator) -> float:
+    return op.option(0, "f", 1.0)
@@ -0,0 +1,170 @@
+#!/usr/bin/env python3
+"""
+TFLite int8 reference kernels (reference_integer_ops / reference_ops, gemmlowp fixed
+point) in numpy, for the graph ai_engine.c implements. Weights, biases and
+quantization come straight from the .tflite, not from the X-CUBE-AI blob the engine
+reads, and every layer is computed over the full window.
+
+engine_check.py uses it to write tests/engine_vectors.h when neither tensorflow nor
+tflite_runtime is installed, and checks it against the interpreter when one is.
+
+    from tflite_ref import ReferenceModel
+    ref = ReferenceModel("models/motor_cnn_int8.tflite")
+    logits, scores = ref.run(window)        # window: int8 [frames][axes]
+"""
+
+from typing import List, Tuple
+
+import numpy as np
+
+from export_model_params import ENGINE_TOPOLOGY, activation_range, quantize_multiplier, softmax_params
+from tflite_reader import TFLiteModel, conv_options, fc_activation, softmax_beta
+
+INT32_MIN, INT32_MAX = -(1 << 31), (1 << 31) - 1
+
+
+def mul_high(a, b):
+    """gemmlowp SaturatingRoundingDoublingHighMul"""
+    a, b = np.int64(a), np.int64(b)
+    ab = a * b
+    nudge = np.where(ab >= 0, 1 << 30, 1 - (1 << 30))
+    q = ab + nudge
+    # C division truncates towards zero
+    out = np.where(q >= 0, q >> 31, -((-q) >> 31))
+    return np.where((a == INT32_MIN) & (b == INT32_MIN), INT32_MAX, out)
+
+
+def div_pot(x, exponent):
+    """gemmlowp RoundingDivideByPOT"""
+    x, exponent = np.int64(x), np.int64(exponent)
+    mask = (np.int64(1) << exponent) - 1
+    remainder = x & mask
+    threshold = (mask >> 1) + (x < 0)
+    return (x >> exponent) + (remainder > threshold)
+
+
+def mul_pot(x, exponent):
+    """gemmlowp SaturatingRoundingMultiplyByPOT for a positive exponent"""
+    return np.clip(np.int64(x) << exponent, INT32_MIN, INT32_MAX)
+
+
+def requant(acc, mult, shift):
+    """MultiplyByQuantizedMultiplier, per element of mult / shift"""
+    mult, shift = np.asarray(mult, dtype=np.int64), np.asarray(shift, dtype=np.int64)
+    left = np.maximum(shift, 0)
+    x = mul_high(np.int64(acc) * (np.int64(1) << left), mult)
+    return div_pot(x, np.maximum(-shift, 0))
+
+
+def exp_on_negative_values(a):
+    """gemmlowp exp_on_negative_values: Q5.26 in, Q0.31 out"""
+    quarter = 1 << 24
+    a_mod = (a & (quarter - 1)) - quarter
+    x = a_mod * (1 << 5) + (1 << 28)
+    x2 = mul_high(x, x)
+    x3 = mul_high(x2, x)
+    x4 = mul_high(x2, x2)
+    poly = div_pot(mul_high(div_pot(x4, 2) + x3, 715827883) + x2, 1)
+    result = 1895147668 + mul_high(1895147668, x + poly)
+    remainder = a_mod - a
+    for i, m in enumerate((1672461947, 1302514674, 790015084, 290630308, 39332535, 720401, 242)):
+        result = np.where(remainder & (1 << (24 + i)), mul_high(result, m), result)
+    return np.where(a == 0, INT32_MAX, result)
+
+
+def one_over_one_plus_x(a):
+    """gemmlowp one_over_one_plus_x_for_x_in_0_1"""
+    s = int(a) + INT32_MAX
+    half_den = (s + 1) // 2 if s >= 0 else -((1 - s) // 2)     # (s +- 1) / 2 in C
+    x = 1515870810 + int(mul_high(half_den, -1010580540))
+    for _ in range(3):
+        x += int(mul_pot(mul_high(x, (1 << 29) - int(mul_high(half_den, x))), 2))
+    return int(mul_pot(x, 1))
+
+
+class ReferenceModel:
+    def __init__(self, path: str):
+        model = TFLiteModel(path)
+        ops = model.compute_ops()
+        if tuple(op.name for op in ops) != ENGINE_TOPOLOGY:
+            raise ValueError(f"{path}: not the topology ai_engine.c implements")
+        self.layers = []
+        for op in ops:
+            t_in, t_out = model.tensors[op.inputs[0]], model.tensors[op.outputs[0]]
+            layer = {"op": op.name, "in_zp": t_in.zero_point, "out_zp": t_out.zero_point}
+            if op.name in ("CONV_2D", "FULLY_CONNECTED"):
+                w, b = model.tensors[op.inputs[1]], model.tensors[op.inputs[2]]
+                out_ch = w.shape[0]
+                scales = w.scales if len(w.scales) == out_ch else w.scales * out_ch
+                rq = [quantize_multiplier(t_in.scale * s / t_out.scale) for s in scales]
+                act = conv_options(op)["activation"] if op.name == "CONV_2D" else fc_activation(op)
+                layer.update(w=np.array(w.values(), dtype=np.int64).reshape(w.shape),
+                             b=np.array(b.values(), dtype=np.int64),
+                             mult=[m for m, _ in rq], shift=[s for _, s in rq],
+                             act=activation_range(act, t_out.scale, t_out.zero_point))
+            elif op.name == "MAX_POOL_2D":
+                layer["size"] = op.option(3, "i")
+            elif op.name == "MEAN":
+                layer.update(in_scale=t_in.scale, out_scale=t_out.scale)
+            else:
+                layer["softmax"] = softmax_params(t_in.scale, softmax_beta(op))
+            self.layers.append(layer)
+
+    @staticmethod
+    def _conv(x, layer):
+        """ConvPerChannel, stride 1, SAME: taps on the padding are skipped"""
+        w = layer["w"][:, 0]                    # [out][k][in]
+        k = w.shape[1]
+        pad = (k - 1) // 2
+        xp = np.zeros((x.shape[0] + k - 1, x.shape[1]), dtype=np.int64)
+        xp[pad:pad + x.shape[0]] = x - layer["in_zp"]
+        acc = np.tile(layer["b"], (x.shape[0], 1))
+        for t in range(k):
+            acc += xp[t:t + x.shape[0]] @ w[:, t].T
+        return acc
+
+    @staticmethod
+    def _out(acc, layer):
+        v = requant(acc, layer["mult"], layer["shift"]) + layer["out_zp"]
+        return np.clip(v, *layer["act"])
+
+    @staticmethod
+    def _mean(x, layer):
+        """QuantizedMeanOrSum over axis 1 with 1/n folded into the multiplier (reduce.cc)"""
+        n = x.shape[0]
+        mult, shift = quantize_multiplier(layer["in_scale"] / layer["out_scale"])
+        fold = min(n.bit_length() - 1, 32, 31 + shift)
+        v = requant(x.sum(axis=0) - layer["in_zp"] * n, (mult << fold) // n, shift - fold) + layer["out_zp"]
+        return np.clip(v, -128, 127)
+
+    @staticmethod
+    def _softmax(x, layer):
+        """reference_ops::Softmax for int8, 12 accumulation integer bits"""
+        mult, shift, diff_min = layer["softmax"]
+        diff = x - x.max()
+        e = exp_on_negative_values(mul_high(diff * (1 << shift), mult))
+        total = int(np.where(diff >= diff_min, div_pot(e, 12), 0).sum())
+        headroom = 32 - total.bit_length()
+        scale = one_over_one_plus_x((total << headroom) - (1 << 31))
+        v = div_pot(mul_high(scale, e), 12 - headroom + 23) - 128
+        return np.where(diff >= diff_min, np.clip(v, -128, 127), -128)
+
+    def run(self, window: np.ndarray) -> Tuple[List[int], List[int]]:
+        """(fc2 logits, softmax scores) of one int8 [frames][axes] window"""
+        x = np.asarray(window, dtype=np.int64)
+        logits = None
+        for layer in self.layers:
+            op = layer["op"]
+            if op == "CONV_2D":
+                x = self._out(self._conv(x, layer), layer)
+            elif op == "MAX_POOL_2D":
+                s = layer["size"]
+                x = x[:x.shape[0] // s * s].reshape(-1, s, x.shape[1]).max(axis=1)
+            elif op == "MEAN":
+                x = self._mean(x, layer)
+            elif op == "FULLY_CONNECTED":
+                x = self._out(layer["b"] + layer["w"] @ (x - layer["in_zp"]), layer)
+                logits = x
+            else:
+                x = self._softmax(x, layer)
+        return [int(v) for v in logits], [int(v) for v in x]
@@ -0,0 +1,243 @@
+/* Generated by python_ai_pipeline/engine_check.py --write-vectors; do not edit.
+ * Reference: numpy port of the TFLite reference kernels (tflite_ref.py) on motor_cnn_int8.tflite. */
+#ifndef __ENGINE_VECTORS_H
+#define __ENGINE_VECTORS_H
+
+#define ENGINE_VECTORS_HASH     "ffa8546049c20e4326a03650d45f6a27"   /* md5 of motor_cnn_int8.tflite */
+#define ENGINE_VECTORS          16u
+
+/* Quantized windows [frame][axis] */
+static const int8_t engine_vector_in[ENGINE_VECTORS][MODEL_WINDOW_FRAMES * MODEL_NUM_AXES] = {
+    {
+        -12, -16, 11, -2, -114, 15, -22, -26, 9, -36, -124, 13, -29, -32, 21, -14, -38, 30,
+        -33, -23, 16, 42, -11, 23, -43, 6, 34, -31, -12, 39, -40, -73, 29, -35, -28, 28,
+        -16, -23, 18, -36, -9, 33, -24, 7, 30, -6, -13, 42, 7, -20, 25, 10, -28, 31,
+        12, -48, 50, 13, -67, 70, 30, -82, -92, 15, 15, 61, 34, -47, 57, 24, -78, 57,
+        69, -77, 49, 7, -65, 67, -12, -60, 57, 0, -46, 77, 13, -33, 82, 13, 24, 70,
+        -4, -42, 69, 2, -109, 86, 18, -35, 90, 4, -28, 71, 2, -47, 106, -17, -47, 122,
+        -16, -50, 126, -14, -36, 127, -42, -46, 120, -31, -50, -8, -13, -39, 127, -91, -35, 116,
+        65, -51, 110, -15, -53, 97, -105, -121, 82, -36, -38, 69, -41, -52, 73, -27, -54, 83,
+        -34, 23, 101, -29, 34, 119, -42, -69, 127, -32, -73, 120, -37, 101, 105, -36, -72, 87,
+        -36, -55, 86, -50, -38, 71, -69, -92, -123, -71, -31, 39, -87, -40, 33, -87, -28, 51,
+    },
+    {
+        -29, -32, 21, -14, -38, 30, -33, -23, 16, 42, -11, 23, -43, 6, 34, -31, -12, 39,
+        -40, -73, 29, -35, -28, 28, -16, -23, 18, -36, -9, 33, -24, 7, 30, -6, -13, 42,
+        7, -20, 25, 10, -28, 31, 12, -48, 50, 13, -67, 70, 30, -82, -92, 15, 15, 61,
+        34, -47, 57, 24, -78, 57, 69, -77, 49, 7, -65, 67, -12, -60, 57, 0, -46, 77,
+        13, -33, 82, 13, 24, 70, -4, -42, 69, 2, -109, 86, 18, -35, 90, 4, -28, 71,
+        2, -47, 106, -17, -47, 122, -16, -50, 126, -14, -36, 127, -42, -46, 120, -31, -50, -8,
+        -13, -39, 127, -91, -35, 116, 65, -51, 110, -15, -53, 97, -105, -121, 82, -36, -38, 69,
+        -41, -52, 73, -27, -54, 83, -34, 23, 101, -29, 34, 119, -42, -69, 127, -32, -73, 120,
+        -37, 101, 105, -36, -72, 87, -36, -55, 86, -50, -38, 71, -69, -92, -123, -71, -31, 39,
+        -87, -40, 33, -87, -28, 51, -94, -46, 70, -79, -53, 77, -96, -58, 61, -88, -43, 69,
+    },
+    {
+        -46, -72, 40, -122, -58, 63, -49, -51, 30, 98, -43, 44, -33, -39, 14, -13, -27, 68,
+        0, -28, 76, 13, 71, 93, 18, 4, 77, 13, 2, 83, 2, 7, 74, 7, 13, 88,
+        29, 24, -78, 46, 98, 81, 36, 31, 78, 29, 26, 60, 38, 9, 90, 57, 14, 81,
+        53, 15, 77, 48, -4, 96, 55, -9, -44, 72, -20, 84, 62, -32, 92, 67, -39, -12,
+        72, -53, -117, 65, -42, 92, -40, -56, 86, 66, -62, 84, 83, -54, 85, 70, -126, 95,
+        74, -71, 100, 63, -54, 66, 59, -81, 113, 41, -68, 95, 28, -62, 92, 20, -72, 89,
+        40, -89, 106, 47, -74, 89, 62, -82, 103, 46, -63, 87, 32, -70, -82, 44, 32, 51,
+        26, -79, 10, 11, -111, 5, 11, -83, 50, -3, -71, 51, 22, -54, 39, 30, -39, 56,
+        21, -49, 60, 30, -61, 42, 44, -62, 39, 57, 34, 39, 15, -39, 42, 77, -54, 25,
+        90, -58, 41, 93, -55, 50, 94, 0, 44, 81, -59, -78, 95, -73, 47, 108, -89, 40,
+    },
+    {
+        -33, -39, 14, -13, -27, 68, 0, -28, 76, 13, 71, 93, 18, 4, 77, 13, 2, 83,
+        2, 7, 74, 7, 13, 88, 29, 24, -78, 46, 98, 81, 36, 31, 78, 29, 26, 60,
+        38, 9, 90, 57, 14, 81, 53, 15, 77, 48, -4, 96, 55, -9, -44, 72, -20, 84,
+        62, -32, 92, 67, -39, -12, 72, -53, -117, 65, -42, 92, -40, -56, 86, 66, -62, 84,
+        83, -54, 85, 70, -126, 95, 74, -71, 100, 63, -54, 66, 59, -81, 113, 41, -68, 95,
+        28, -62, 92, 20, -72, 89, 40, -89, 106, 47, -74, 89, 62, -82, 103, 46, -63, 87,
+        32, -70, -82, 44, 32, 51, 26, -79, 10, 11, -111, 5, 11, -83, 50, -3, -71, 51,
+        22, -54, 39, 30, -39, 56, 21, -49, 60, 30, -61, 42, 44, -62, 39, 57, 34, 39,
+        15, -39, 42, 77, -54, 25, 90, -58, 41, 93, -55, 50, 94, 0, 44, 81, -59, -78,
+        95, -73, 47, 108, -89, 40, 99, 60, 51, 97, -90, 46, 100, -98, 30, 96, -118, 34,
+    },
+    {
+        18, 4, 77, 13, 2, 83, 2, 7, 74, 7, 13, 88, 29, 24, -78, 46, 98, 81,
+        36, 31, 78, 29, 26, 60, 38, 9, 90, 57, 14, 81, 53, 15, 77, 48, -4, 96,
+        55, -9, -44, 72, -20, 84, 62, -32, 92, 67, -39, -12, 72, -53, -117, 65, -42, 92,
+        -40, -56, 86, 66, -62, 84, 83, -54, 85, 70, -126, 95, 74, -71, 100, 63, -54, 66,
+        59, -81, 113, 41, -68, 95, 28, -62, 92, 20, -72, 89, 40, -89, 106, 47, -74, 89,
+        62, -82, 103, 46, -63, 87, 32, -70, -82, 44, 32, 51, 26, -79, 10, 11, -111, 5,
+        11, -83, 50, -3, -71, 51, 22, -54, 39, 30, -39, 56, 21, -49, 60, 30, -61, 42,
+        44, -62, 39, 57, 34, 39, 15, -39, 42, 77, -54, 25, 90, -58, 41, 93, -55, 50,
+        94, 0, 44, 81, -59, -78, 95, -73, 47, 108, -89, 40, 99, 60, 51, 97, -90, 46,
+        100, -98, 30, 96, -118, 34, 89, -128, 25, 87, -128, 43, 101, -113, 49, 114, -93, 57,
+    },
+    {
+        29, 24, -78, 46, 98, 81, 36, 31, 78, 29, 26, 60, 38, 9, 90, 57, 14, 81,
+        53, 15, 77, 48, -4, 96, 55, -9, -44, 72, -20, 84, 62, -32, 92, 67, -39, -12,
+        72, -53, -117, 65, -42, 92, -40, -56, 86, 66, -62, 84, 83, -54, 85, 70, -126, 95,
+        74, -71, 100, 63, -54, 66, 59, -81, 113, 41, -68, 95, 28, -62, 92, 20, -72, 89,
+        40, -89, 106, 47, -74, 89, 62, -82, 103, 46, -63, 87, 32, -70, -82, 44, 32, 51,
+        26, -79, 10, 11, -111, 5, 11, -83, 50, -3, -71, 51, 22, -54, 39, 30, -39, 56,
+        21, -49, 60, 30, -61, 42, 44, -62, 39, 57, 34, 39, 15, -39, 42, 77, -54, 25,
+        90, -58, 41, 93, -55, 50, 94, 0, 44, 81, -59, -78, 95, -73, 47, 108, -89, 40,
+        99, 60, 51, 97, -90, 46, 100, -98, 30, 96, -118, 34, 89, -128, 25, 87, -128, 43,
+        101, -113, 49, 114, -93, 57, 126, -105, 47, 106, 87, 52, 87, -104, 56, 84, -101, 66,
+    },
+    {
+        52, -84, 5, 60, -56, -2, 61, -97, 2, -54, -100, 22, 46, -120, 10, 61, -128, 17,
+        68, -125, 35, 54, -128, 15, 41, -115, 17, 57, -113, 12, 76, -98, -108, 76, -96, 22,
+        59, -90, 20, 60, -95, 33, 61, -83, 53, 62, -96, 34, 55, -105, 43, 56, -96, 31,
+        48, -91, 47, 45, 84, 33, 29, -93, 45, 27, -104, 31, 8, -84, 25, 13, -70, 32,
+        4, -46, 23, -15, -68, 5, -23, -49, 75, -104, -80, -6, 31, -36, 35, -46, -36, 55,
+        -34, -21, 60, -42, -24, 49, -45, 56, 50, -49, -3, 66, -60, -7, 50, -46, 7, 45,
+        -31, -89, 34, 79, 3, 22, -60, -5, 26, -68, 22, 17, -79, 36, 29, -86, 17, 48,
+        -67, 25, 33, -77, 45, 18, -57, 38, -20, -53, 51, 40, -73, 43, 56, -63, 37, 76,
+        -48, 43, 82, -62, 34, 91, -26, 48, 92, -107, 55, 84, -22, 67, 87, -19, 84, 71,
+        -36, 103, 60, -38, 120, 76, -33, 127, 81, -31, 110, 27, -14, 99, 106, 56, 105, 119,
+    },
+    {
+        46, -120, 10, 61, -128, 17, 68, -125, 35, 54, -128, 15, 41, -115, 17, 57, -113, 12,
+        76, -98, -108, 76, -96, 22, 59, -90, 20, 60, -95, 33, 61, -83, 53, 62, -96, 34,
+        55, -105, 43, 56, -96, 31, 48, -91, 47, 45, 84, 33, 29, -93, 45, 27, -104, 31,
+        8, -84, 25, 13, -70, 32, 4, -46, 23, -15, -68, 5, -23, -49, 75, -104, -80, -6,
+        31, -36, 35, -46, -36, 55, -34, -21, 60, -42, -24, 49, -45, 56, 50, -49, -3, 66,
+        -60, -7, 50, -46, 7, 45, -31, -89, 34, 79, 3, 22, -60, -5, 26, -68, 22, 17,
+        -79, 36, 29, -86, 17, 48, -67, 25, 33, -77, 45, 18, -57, 38, -20, -53, 51, 40,
+        -73, 43, 56, -63, 37, 76, -48, 43, 82, -62, 34, 91, -26, 48, 92, -107, 55, 84,
+        -22, 67, 87, -19, 84, 71, -36, 103, 60, -38, 120, 76, -33, 127, 81, -31, 110, 27,
+        -14, 99, 106, 56, 105, 119, -1, 87, 42, 0, 61, -86, 14, 114, -46, 14, 103, 116,
+    },
+    {
+        41, -115, 17, 57, -113, 12, 76, -98, -108, 76, -96, 22, 59, -90, 20, 60, -95, 33,
+        61, -83, 53, 62, -96, 34, 55, -105, 43, 56, -96, 31, 48, -91, 47, 45, 84, 33,
+        29, -93, 45, 27, -104, 31, 8, -84, 25, 13, -70, 32, 4, -46, 23, -15, -68, 5,
+        -23, -49, 75, -104, -80, -6, 31, -36, 35, -46, -36, 55, -34, -21, 60, -42, -24, 49,
+        -45, 56, 50, -49, -3, 66, -60, -7, 50, -46, 7, 45, -31, -89, 34, 79, 3, 22,
+        -60, -5, 26, -68, 22, 17, -79, 36, 29, -86, 17, 48, -67, 25, 33, -77, 45, 18,
+        -57, 38, -20, -53, 51, 40, -73, 43, 56, -63, 37, 76, -48, 43, 82, -62, 34, 91,
+        -26, 48, 92, -107, 55, 84, -22, 67, 87, -19, 84, 71, -36, 103, 60, -38, 120, 76,
+        -33, 127, 81, -31, 110, 27, -14, 99, 106, 56, 105, 119, -1, 87, 42, 0, 61, -86,
+        14, 114, -46, 14, 103, 116, 19, 115, 119, 15, 97, 127, 11, 102, 127, -41, 99, 115,
+    },
+    {
+        59, -90, 20, 60, -95, 33, 61, -83, 53, 62, -96, 34, 55, -105, 43, 56, -96, 31,
+        48, -91, 47, 45, 84, 33, 29, -93, 45, 27, -104, 31, 8, -84, 25, 13, -70, 32,
+        4, -46, 23, -15, -68, 5, -23, -49, 75, -104, -80, -6, 31, -36, 35, -46, -36, 55,
+        -34, -21, 60, -42, -24, 49, -45, 56, 50, -49, -3, 66, -60, -7, 50, -46, 7, 45,
+        -31, -89, 34, 79, 3, 22, -60, -5, 26, -68, 22, 17, -79, 36, 29, -86, 17, 48,
+        -67, 25, 33, -77, 45, 18, -57, 38, -20, -53, 51, 40, -73, 43, 56, -63, 37, 76,
+        -48, 43, 82, -62, 34, 91, -26, 48, 92, -107, 55, 84, -22, 67, 87, -19, 84, 71,
+        -36, 103, 60, -38, 120, 76, -33, 127, 81, -31, 110, 27, -14, 99, 106, 56, 105, 119,
+        -1, 87, 42, 0, 61, -86, 14, 114, -46, 14, 103, 116, 19, 115, 119, 15, 97, 127,
+        11, 102, 127, -41, 99, 115, -8, 85, 26, -15, 69, 126, -2, 77, 33, 4, 89, 99,
+    },
+    {
+        55, -105, 43, 56, -96, 31, 48, -91, 47, 45, 84, 33, 29, -93, 45, 27, -104, 31,
+        8, -84, 25, 13, -70, 32, 4, -46, 23, -15, -68, 5, -23, -49, 75, -104, -80, -6,
+        31, -36, 35, -46, -36, 55, -34, -21, 60, -42, -24, 49, -45, 56, 50, -49, -3, 66,
+        -60, -7, 50, -46, 7, 45, -31, -89, 34, 79, 3, 22, -60, -5, 26, -68, 22, 17,
+        -79, 36, 29, -86, 17, 48, -67, 25, 33, -77, 45, 18, -57, 38, -20, -53, 51, 40,
+        -73, 43, 56, -63, 37, 76, -48, 43, 82, -62, 34, 91, -26, 48, 92, -107, 55, 84,
+        -22, 67, 87, -19, 84, 71, -36, 103, 60, -38, 120, 76, -33, 127, 81, -31, 110, 27,
+        -14, 99, 106, 56, 105, 119, -1, 87, 42, 0, 61, -86, 14, 114, -46, 14, 103, 116,
+        19, 115, 119, 15, 97, 127, 11, 102, 127, -41, 99, 115, -8, 85, 26, -15, 69, 126,
+        -2, 77, 33, 4, 89, 99, -4, 109, 116, -7, 92, 125, 12, 86, 122, -6, -11, 112,
+    },
+    {
+        29, -93, 45, 27, -104, 31, 8, -84, 25, 13, -70, 32, 4, -46, 23, -15, -68, 5,
+        -23, -49, 75, -104, -80, -6, 31, -36, 35, -46, -36, 55, -34, -21, 60, -42, -24, 49,
+        -45, 56, 50, -49, -3, 66, -60, -7, 50, -46, 7, 45, -31, -89, 34, 79, 3, 22,
+        -60, -5, 26, -68, 22, 17, -79, 36, 29, -86, 17, 48, -67, 25, 33, -77, 45, 18,
+        -57, 38, -20, -53, 51, 40, -73, 43, 56, -63, 37, 76, -48, 43, 82, -62, 34, 91,
+        -26, 48, 92, -107, 55, 84, -22, 67, 87, -19, 84, 71, -36, 103, 60, -38, 120, 76,
+        -33, 127, 81, -31, 110, 27, -14, 99, 106, 56, 105, 119, -1, 87, 42, 0, 61, -86,
+        14, 114, -46, 14, 103, 116, 19, 115, 119, 15, 97, 127, 11, 102, 127, -41, 99, 115,
+        -8, 85, 26, -15, 69, 126, -2, 77, 33, 4, 89, 99, -4, 109, 116, -7, 92, 125,
+        12, 86, 122, -6, -11, 112, -26, 94, 107, -12, 78, 98, 7, 95, 108, -75, 115, 127,
+    },
+    {
+        4, -46, 23, -15, -68, 5, -23, -49, 75, -104, -80, -6, 31, -36, 35, -46, -36, 55,
+        -34, -21, 60, -42, -24, 49, -45, 56, 50, -49, -3, 66, -60, -7, 50, -46, 7, 45,
+        -31, -89, 34, 79, 3, 22, -60, -5, 26, -68, 22, 17, -79, 36, 29, -86, 17, 48,
+        -67, 25, 33, -77, 45, 18, -57, 38, -20, -53, 51, 40, -73, 43, 56, -63, 37, 76,
+        -48, 43, 82, -62, 34, 91, -26, 48, 92, -107, 55, 84, -22, 67, 87, -19, 84, 71,
+        -36, 103, 60, -38, 120, 76, -33, 127, 81, -31, 110, 27, -14, 99, 106, 56, 105, 119,
+        -1, 87, 42, 0, 61, -86, 14, 114, -46, 14, 103, 116, 19, 115, 119, 15, 97, 127,
+        11, 102, 127, -41, 99, 115, -8, 85, 26, -15, 69, 126, -2, 77, 33, 4, 89, 99,
+        -4, 109, 116, -7, 92, 125, 12, 86, 122, -6, -11, 112, -26, 94, 107, -12, 78, 98,
+        7, 95, 108, -75, 115, 127, 25, 127, 111, 17, 127, 127, 32, 127, 127, 40, 117, 127,
+    },
+    {
+        -26, 94, 107, -12, 78, 98, 7, 95, 108, -75, 115, 127, 25, 127, 111, 17, 127, 127,
+        32, 127, 127, 40, 117, 127, 45, 113, 107, 27, 122, 101, 20, 123, 121, -72, 125, 101,
+        41, 124, 101, 58, 107, 86, 42, 105, 104, 23, 96, 116, 26, 100, 127, 10, 106, -5,
+        30, 111, 127, 29, 29, 127, 61, 121, 127, 21, 127, 31, 21, 114, 127, 17, -45, 115,
+        0, 92, 98, -124, 74, 99, -20, 84, 97, 13, 78, 102, 8, 39, -34, 20, 77, 99,
+        32, 98, 88, 4, 49, 96, -2, -101, -16, -4, 49, 78, -8, 49, 87, 11, -3, 98,
+        2, 40, 105, 16, 41, 108, 19, 46, -63, 18, 62, 127, 7, 82, 1, 2, 82, 127,
+        9, 84, 113, -33, 94, 95, 1, 97, 97, 13, 100, 84, 10, 119, 27, 17, 114, 60,
+        15, 94, 48, 27, 83, 32, 39, 97, 46, 47, 107, 48, 31, 101, 36, 12, 104, -7,
+        -28, 122, 55, -14, 127, 38, -3, 115, 50, 13, 114, 45, 19, 37, 47, 19, 106, 43,
+    },
+    {
+        -85, -18, 83, 49, 20, 51, 127, 35, -21, 83, 42, -45, -52, 50, 63, -51, 57, 123,
+        127, 75, 3, 127, 104, -74, -17, 127, 21, -75, 123, 107, 42, 127, 72, 127, 127, -47,
+        84, 110, -61, -67, 117, 67, -39, 127, 127, 127, 119, 11, 127, 117, -60, 0, 114, -22,
+        -77, 89, 89, 50, 69, 114, 127, 43, -24, 71, 49, -63, -97, 32, 33, -21, 5, 108,
+        127, 21, 47, 127, 4, -57, -55, -31, -21, -79, -39, 80, 64, -29, 89, 127, -38, 1,
+        56, -40, -62, -87, -35, -13, 11, -37, 105, 127, -61, 89, 111, -33, -38, -54, -11, -42,
+        -54, -34, 56, 87, 16, 123, 127, -5, 68, 30, 8, -52, -92, 13, -23, 2, 30, 87,
+        127, 53, 127, 120, 69, -8, -53, 64, -83, -70, 86, 32, 101, 98, 116, 127, 92, 63,
+        32, 127, -54, -87, 115, -32, 43, 127, 47, 127, 127, 127, 106, 124, 25, -71, 113, -51,
+        -20, 78, -35, 114, 84, 115, 127, 79, 94, -10, 82, -5, -90, 60, -83, 61, 56, 29,
+    },
+    {
+        117, -27, 71, 5, -27, 127, -17, -16, 127, 84, -4, 72, 127, 10, -38, 39, 0, -71,
+        -26, -8, -14, 62, -22, 108, 127, -21, 127, 66, -23, 127, -30, -17, 28, 20, -3, -61,
+        127, 1, -78, 90, 2, 13, -19, -10, 127, 1, -25, 127, 111, -35, 127, 114, -20, 12,
+        5, -17, -71, -19, 0, -52, 92, 7, 48, 127, 3, 127, 31, 0, 127, -28, -22, 101,
+        68, -29, -17, 127, -32, -84, 58, -10, -39, -30, 1, 84, 38, 1, 127, 127, 3, 127,
+        87, -5, 69, -24, -19, -40, 4, -28, -77, 121, -27, -17, 114, -17, 110, 0, -14, 127,
+        -11, 5, 127, 98, 5, 35, 127, -3, -62, 27, -14, -68, -26, -30, 9, 69, -35, 127,
+        127, -21, 127, 54, -4, 118, -29, 4, 12, 35, 3, -74, 127, -7, -57, 85, -20, 45,
+        -26, -31, 127, 19, -25, 127, 126, -15, 94, 108, -7, -24, -5, 6, -88, -12, 1, -35,
+        100, -6, 78, 127, -18, 127, 23, -21, 127, -21, -25, 62, 72, -23, -41, 127, -5, -74,
+    },
+};
+
+/* fc2 output (softmax input) and scores */
+static const int8_t engine_vector_logits[ENGINE_VECTORS][MODEL_NUM_CLASSES] = {
+    { 67, 9, -3, -55 },
+    { 70, 8, -8, -56 },
+    { 57, -13, 23, -53 },
+    { 58, -18, 23, -50 },
+    { 59, -23, 25, -49 },
+    { 60, -25, 25, -53 },
+    { 61, 32, -5, -60 },
+    { 58, 40, -6, -63 },
+    { 55, 48, -7, -65 },
+    { 54, 57, -10, -68 },
+    { 51, 64, -11, -72 },
+    { 49, 76, -12, -78 },
+    { 46, 81, -12, -83 },
+    { 43, 76, -3, -95 },
+    { 32, -35, 48, -47 },
+    { 37, -36, 52, -51 },
+};
+static const int8_t engine_vector_scores[ENGINE_VECTORS][MODEL_NUM_CLASSES] = {
+    { 127, -128, -128, -128 },
+    { 127, -128, -128, -128 },
+    { 126, -128, -126, -128 },
+    { 126, -128, -126, -128 },
+    { 126, -128, -126, -128 },
+    { 126, -128, -126, -128 },
+    { 124, -124, -128, -128 },
+    { 110, -110, -128, -128 },
+    { 59, -59, -128, -128 },
+    { -27, 27, -128, -128 },
+    { -93, 93, -128, -128 },
+    { -123, 123, -128, -128 },
+    { -126, 126, -128, -128 },
+    { -126, 126, -128, -128 },
+    { -104, -128, 104, -128 },
+    { -101, -128, 101, -128 },
+};
+
+#endif /* __ENGINE_VECTORS_H */
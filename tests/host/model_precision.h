@@ -0,0 +1,13 @@
+#ifndef __HOST_MODEL_PRECISION_H
+#define __HOST_MODEL_PRECISION_H
+
+/* Host stand-in for Common/Inc/model_params.h when a test builds a precision the
+ * generated header was not exported with: only the MODEL_PRECISION selector. Taking
+ * its include guard keeps the generated header (and its #error) out. */
+#define __MODEL_PARAMS_H
+
+#define MODEL_PRECISION_INT8       0
+#define MODEL_PRECISION_INT16X8    1
+#define MODEL_PRECISION_FLOAT32    2
+
+#endif /* __HOST_MODEL_PRECISION_H */
@@ -0,0 +1,14 @@
+#ifndef __HOST_STM32H7XX_H
+#define __HOST_STM32H7XX_H
+
+/* Host stand-in for the CMSIS device header: the core intrinsics the portable
+ * firmware modules use, in plain C. Tests are single threaded, so masking
+ * interrupts is a no-op. */
+#include <stdint.h>
+
+static inline uint32_t __get_PRIMASK(void) { return 0u; }
+static inline void __set_PRIMASK(uint32_t primask) { (void)primask; }
+static inline void __disable_irq(void) { }
+static inline void __DMB(void) { }
+
+#endif /* __HOST_STM32H7XX_H */
@@ -0,0 +1,189 @@
+#include "ai_decision.h"
+#include "test_util.h"
+#include <string.h>
+
+/* The CM7 per-channel decision stage: the first window primes the averages, a fault is
+ * entered above enter_pct and left below exit_pct, a change waits for its dwell on
+ * window timestamps (across the 32-bit wrap), and the event reports the change. */
+
+#define Q8(pct_)    ((uint16_t)(((pct_) * 256u + 50u) / 100u))
+
+static ai_decision_params_t params(uint8_t ema_shift, uint8_t enter, uint8_t exit_, uint32_t enter_dwell,
+                                   uint32_t exit_dwell)
+{
+    ai_decision_params_t p;
+    memset(&p, 0, sizeof(p));
+    p.ema_shift = ema_shift;
+    for (uint32_t k = 1; k < MODEL_NUM_CLASSES; k++) {
+        p.enter_pct[k] = enter;
+        p.exit_pct[k] = exit_;
+    }
+    p.enter_dwell_ms = enter_dwell;
+    p.exit_dwell_ms = exit_dwell;
+    return p;
+}
+
+/* Probabilities with `cls` at `pct` percent and the rest spread over the others */
+static const uint16_t *probs(uint32_t cls, uint32_t pct)
+{
+    static uint16_t q8[MODEL_NUM_CLASSES];
+    uint16_t rest = (uint16_t)((256u - Q8(pct)) / (MODEL_NUM_CLASSES - 1u));
+
+    for (uint32_t k = 0; k < MODEL_NUM_CLASSES; k++) q8[k] = rest;
+    q8[cls] = Q8(pct);
+    return q8;
+}
+
+static void test_priming(void)
+{
+    const ai_decision_params_t p = params(2u, 50u, 50u, 0u, 0u);
+    static const uint16_t normal[MODEL_NUM_CLASSES] = { 256u, 0u, 0u, 0u };
+    static const uint16_t fault[MODEL_NUM_CLASSES] = { 0u, 256u, 0u, 0u };
+    ai_decision_t d;
+    ai_decision_event_t ev;
+
+    /* The first window is taken as is, not averaged in from zero */
+    memset(&d, 0, sizeof(d));
+    CHECK(!ai_decision_update(&d, &p, normal, 0u, &ev));
+    CHECK(d.primed);
+    CHECK(d.avg[0] == 1u << AI_DECISION_Q);
+    CHECK(d.avg[1] == 0u);
+    CHECK(ai_decision_pct(&d, 0u) == 100u);
+
+    /* avg += (x - avg) / 4 */
+    ai_decision_update(&d, &p, fault, 10u, &ev);
+    CHECK(d.avg[0] == 49152u);
+    CHECK(d.avg[1] == 16384u);
+    CHECK(ai_decision_pct(&d, 0u) == 75u);
+    CHECK(ai_decision_pct(&d, 1u) == 25u);
+
+    /* Primed on a fault with the slowest average: the state follows at once */
+    const ai_decision_params_t slow = params(AI_DECISION_MAX_SHIFT, 50u, 50u, 0u, 0u);
+    memset(&d, 0, sizeof(d));
+    CHECK(ai_decision_update(&d, &slow, fault, 0u, &ev));
+    CHECK(d.avg[1] == 1u << AI_DECISION_Q);
+    CHECK(d.state == 1u);
+
+    /* An ema_shift over the maximum averages as the maximum */
+    ai_decision_t clamped, ref;
+    const ai_decision_params_t over = params(AI_DECISION_MAX_SHIFT + 5u, 50u, 50u, 0u, 0u);
+    memset(&clamped, 0, sizeof(clamped));
+    memset(&ref, 0, sizeof(ref));
+    for (uint32_t i = 0; i < 20u; i++) {
+        const uint16_t *x = (i % 3u) ? normal : fault;
+        ai_decision_update(&clamped, &over, x, i, &ev);
+        ai_decision_update(&ref, &slow, x, i, &ev);
+    }
+    CHECK(memcmp(clamped.avg, ref.avg, sizeof(ref.avg)) == 0);
+}
+
+static void test_hysteresis(void)
+{
+    const ai_decision_params_t p = params(0u, 60u, 40u, 0u, 0u);
+    ai_decision_t d;
+    ai_decision_event_t ev;
+
+    memset(&d, 0, sizeof(d));
+    /* Most probable but below enter_pct: stays normal */
+    CHECK(!ai_decision_update(&d, &p, probs(2u, 50u), 0u, &ev));
+    CHECK(d.state == 0u);
+    CHECK(!ai_decision_update(&d, &p, probs(2u, 59u), 1u, &ev));
+    CHECK(d.state == 0u);
+
+    CHECK(ai_decision_update(&d, &p, probs(2u, 60u), 2u, &ev));
+    CHECK(d.state == 2u);
+
+    /* Between exit_pct and enter_pct: held */
+    CHECK(!ai_decision_update(&d, &p, probs(2u, 50u), 3u, &ev));
+    CHECK(!ai_decision_update(&d, &p, probs(2u, 41u), 4u, &ev));
+    CHECK(d.state == 2u);
+
+    /* Another fault on top needs its own enter_pct: below it the target is normal */
+    CHECK(ai_decision_update(&d, &p, probs(3u, 50u), 5u, &ev));
+    CHECK(ev.from == 2u && ev.to == 0u);
+    CHECK(ai_decision_update(&d, &p, probs(2u, 60u), 6u, &ev));
+    CHECK(d.state == 2u);
+
+    CHECK(ai_decision_update(&d, &p, probs(2u, 39u), 7u, &ev));
+    CHECK(d.state == 0u);
+    CHECK(ev.from == 2u && ev.to == 0u);
+
+    /* Once left, the fault needs enter_pct again */
+    CHECK(!ai_decision_update(&d, &p, probs(2u, 50u), 8u, &ev));
+    CHECK(d.state == 0u);
+}
+
+static void test_dwell_wrap(void)
+{
+    const ai_decision_params_t p = params(0u, 50u, 50u, 100u, 200u);
+    const uint32_t t0 = 0xFFFFFFC0u;      /* 64 ms before the wrap */
+    ai_decision_t d;
+    ai_decision_event_t ev;
+    uint32_t ts = t0;
+
+    memset(&d, 0, sizeof(d));
+    CHECK(!ai_decision_update(&d, &p, probs(0u, 90u), ts, &ev));
+
+    /* One window back to normal restarts the dwell */
+    ts += 20u;
+    CHECK(!ai_decision_update(&d, &p, probs(1u, 90u), ts, &ev));
+    ts += 20u;
+    CHECK(!ai_decision_update(&d, &p, probs(0u, 90u), ts, &ev));
+
+    const uint32_t onset = ts + 20u;
+    for (ts = onset; ts - onset < 100u; ts += 20u) {
+        CHECK(!ai_decision_update(&d, &p, probs(1u, 90u), ts, &ev));
+    }
+    CHECK(onset > ts);                  /* the dwell crossed the wrap */
+    CHECK(ai_decision_update(&d, &p, probs(1u, 90u), ts, &ev));
+    CHECK(ev.onset_ts == onset);
+    CHECK(d.state == 1u);
+
+    /* Back to normal waits exit_dwell_ms */
+    const uint32_t exit_onset = ts + 20u;
+    for (ts = exit_onset; ts - exit_onset < 200u; ts += 20u) {
+        CHECK(!ai_decision_update(&d, &p, probs(0u, 90u), ts, &ev));
+    }
+    CHECK(ai_decision_update(&d, &p, probs(0u, 90u), ts, &ev));
+    CHECK(ev.onset_ts == exit_onset);
+    CHECK(d.state == 0u);
+}
+
+static void test_event(void)
+{
+    const ai_decision_params_t p = params(1u, 50u, 30u, 40u, 0u);
+    ai_decision_t d;
+    ai_decision_event_t ev, untouched;
+
+    /* No change, no write to *ev */
+    memset(&d, 0, sizeof(d));
+    memset(&ev, 0xA5, sizeof(ev));
+    untouched = ev;
+    CHECK(!ai_decision_update(&d, &p, probs(3u, 97u), 1000u, &ev));
+    CHECK(!ai_decision_update(&d, &p, probs(3u, 97u), 1020u, &ev));
+    CHECK(memcmp(&ev, &untouched, sizeof(ev)) == 0);
+
+    CHECK(ai_decision_update(&d, &p, probs(3u, 97u), 1040u, &ev));
+    CHECK(ev.from == 0u);
+    CHECK(ev.to == 3u);
+    CHECK(ev.onset_ts == 1000u);
+    CHECK(ev.confidence_pct == 97u);            /* 248 / 256 */
+
+    /* No exit dwell: back to normal as soon as it is the most probable class, at the
+     * averaged confidence (avg0 = 33024 after one step of shift 1) */
+    CHECK(ai_decision_update(&d, &p, probs(0u, 100u), 1060u, &ev));
+    CHECK(ev.from == 3u);
+    CHECK(ev.to == 0u);
+    CHECK(ev.onset_ts == 1060u);
+    CHECK(ev.confidence_pct == 50u);
+    CHECK(ev.confidence_pct == ai_decision_pct(&d, 0u));
+}
+
+int main(void)
+{
+    test_priming();
+    test_hysteresis();
+    test_dwell_wrap();
+    test_event();
+    return TEST_RESULT("decision");
+}
@@ -0,0 +1,194 @@
+#include "ai_engine.h"
+#include "engine_vectors.h"
+#include "test_util.h"
+#include <string.h>
+
+/* The CM7 open int8 engine through its portable C path, on the X-CUBE-AI weights blob:
+ * streaming must give the scores of a full window at every hop, weights fetched layer
+ * by layer through ai_engine_fetch_t those of weights read in place, and a failed copy
+ * must stop the run without leaving stale activations. Full windows must match the
+ * TFLite reference vectors in engine_vectors.h bit for bit; the engine against the
+ * interpreter on any number of windows is python_ai_pipeline/engine_check.py. */
+
+#define WINDOWS     64u
+#define MAX_HOP     12u
+#define WINDOW      (MODEL_WINDOW_FRAMES * MODEL_NUM_AXES)
+
+extern const uint64_t s_motor_anomalie_weights_array_u64[];
+
+static int8_t stream[((WINDOWS - 1u) * MAX_HOP + MODEL_WINDOW_FRAMES) * MODEL_NUM_AXES];
+static ai_engine_t streaming, full, fetched;
+
+static uint32_t rng_state = 0x9E3779B9u;
+
+static uint32_t rng_next(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/* Per-axis random walk with occasional spikes, as AI_BenchEngine() on CM7 */
+static void make_stream(void)
+{
+    int32_t walk[MODEL_NUM_AXES] = { 0 };
+
+    for (uint32_t i = 0; i < sizeof(stream); i++) {
+        uint32_t a = i % MODEL_NUM_AXES;
+        walk[a] += (int32_t)(rng_next() % 41u) - 20;
+        if (walk[a] > 127) walk[a] = 127;
+        if (walk[a] < -128) walk[a] = -128;
+        stream[i] = (rng_next() % 8u == 0u) ? (int8_t)(rng_next() & 0xFFu) : (int8_t)walk[a];
+    }
+}
+
+/* Copies land at once: each wait() checks the engine waits before reading. The copy
+ * numbered fail_at (from 1) fails, in start() or in wait() */
+typedef struct {
+    uint32_t started;
+    uint32_t pending;
+    uint32_t early_reads;
+    uint32_t fail_at;
+    bool fail_in_wait;
+} sync_mem_t;
+
+static sync_mem_t mem;
+static _Alignas(32) uint8_t stage[2][AI_ENGINE_STAGE_BYTES];
+
+static bool mem_start(void *ctx, void *dst, const void *src, uint32_t len)
+{
+    sync_mem_t *m = ctx;
+    if (m->pending) m->early_reads++;
+    m->started++;
+    if (m->started == m->fail_at && !m->fail_in_wait) return false;
+    memcpy(dst, src, len);
+    m->pending = 1u;
+    return true;
+}
+
+static bool mem_wait(void *ctx)
+{
+    sync_mem_t *m = ctx;
+    bool ok = !(m->pending && m->started == m->fail_at && m->fail_in_wait);
+    m->pending = 0u;
+    return ok;
+}
+
+static const ai_engine_fetch_t fetch = { mem_start, mem_wait, &mem, { stage[0], stage[1] } };
+
+static void test_hop(uint32_t hop)
+{
+    uint32_t stream_bad = 0, fetch_bad = 0;
+
+    ai_engine_reset(&streaming);
+    ai_engine_reset(&fetched);
+    for (uint32_t w = 0; w < WINDOWS; w++) {
+        const int8_t *win = &stream[w * hop * MODEL_NUM_AXES];
+        uint32_t shift = w ? hop : MODEL_WINDOW_FRAMES;
+
+        CHECK(ai_engine_run(&streaming, win, shift));
+        CHECK(ai_engine_run(&fetched, win, shift));
+        ai_engine_reset(&full);
+        CHECK(ai_engine_run(&full, win, MODEL_WINDOW_FRAMES));
+        if (memcmp(streaming.out, full.out, sizeof(full.out)) != 0) stream_bad++;
+        if (memcmp(fetched.out, streaming.out, sizeof(streaming.out)) != 0) fetch_bad++;
+    }
+    if (stream_bad || fetch_bad) {
+        fprintf(stderr, "hop %lu: streaming != full in %lu windows, fetched != in place in %lu\n",
+                (unsigned long)hop, (unsigned long)stream_bad, (unsigned long)fetch_bad);
+    }
+    CHECK(stream_bad == 0u);
+    CHECK(fetch_bad == 0u);
+}
+
+static void test_fetch_pairing(void)
+{
+    /* One copy at a time, every copy waited for, one per weighted layer and window */
+    CHECK(mem.early_reads == 0u);
+    CHECK(mem.started > 0u);
+    CHECK(mem.started % 5u == 0u);
+}
+
+/* A failed copy, of every layer and in either call: the run reports it, leaves no copy
+ * in flight and the next one, a hop later, still matches a full window */
+static void test_fetch_failure(void)
+{
+    const uint32_t hop = 4u;
+    int8_t before[MODEL_NUM_CLASSES];
+
+    for (uint32_t layer = 1; layer <= 5u; layer++) {
+        for (uint32_t in_wait = 0; in_wait < 2u; in_wait++) {
+            memset(&mem, 0, sizeof(mem));
+            ai_engine_reset(&fetched);
+            CHECK(ai_engine_run(&fetched, stream, MODEL_WINDOW_FRAMES));
+            memcpy(before, fetched.out, sizeof(before));
+
+            mem.fail_at = mem.started + layer;
+            mem.fail_in_wait = in_wait != 0u;
+            CHECK(!ai_engine_run(&fetched, &stream[hop * MODEL_NUM_AXES], hop));
+            CHECK(mem.pending == 0u);
+            CHECK(memcmp(fetched.out, before, sizeof(before)) == 0);
+
+            CHECK(ai_engine_run(&fetched, &stream[2u * hop * MODEL_NUM_AXES], hop));
+            ai_engine_reset(&full);
+            CHECK(ai_engine_run(&full, &stream[2u * hop * MODEL_NUM_AXES], MODEL_WINDOW_FRAMES));
+            /* The scores alone can hide a stale layer behind a saturated softmax */
+            CHECK(memcmp(fetched.c2, full.c2, sizeof(full.c2)) == 0);
+            CHECK(memcmp(fetched.c3, full.c3, sizeof(full.c3)) == 0);
+            CHECK(memcmp(fetched.out, full.out, sizeof(full.out)) == 0);
+            CHECK(mem.early_reads == 0u);
+        }
+    }
+}
+
+/* Reference logits and scores, regenerated with the model (engine_check.py --write-vectors) */
+static void test_reference(void)
+{
+    uint32_t bad = 0;
+
+    CHECK(strcmp(ENGINE_VECTORS_HASH, MODEL_PARAMS_HASH) == 0);
+    for (uint32_t v = 0; v < ENGINE_VECTORS; v++) {
+        ai_engine_reset(&full);
+        CHECK(ai_engine_run(&full, engine_vector_in[v], MODEL_WINDOW_FRAMES));
+        if (memcmp(full.fc2, engine_vector_logits[v], sizeof(full.fc2)) != 0 ||
+            memcmp(full.out, engine_vector_scores[v], sizeof(full.out)) != 0) {
+            fprintf(stderr, "vector %lu: logits or scores differ from the reference\n", (unsigned long)v);
+            bad++;
+        }
+    }
+    CHECK(bad == 0u);
+}
+
+/* Scores are a distribution: int8 softmax codes summing to ~256 steps above the zero point */
+static void test_softmax(void)
+{
+    int32_t sum = 0;
+
+    ai_engine_reset(&full);
+    CHECK(ai_engine_run(&full, stream, MODEL_WINDOW_FRAMES));
+    for (uint32_t k = 0; k < MODEL_NUM_CLASSES; k++) {
+        sum += (int32_t)full.out[k] - MODEL_OUT_ZERO_POINT;
+    }
+    CHECK(sum >= 256 - (int32_t)MODEL_NUM_CLASSES && sum <= 256 + (int32_t)MODEL_NUM_CLASSES);
+}
+
+int main(void)
+{
+    static const uint32_t hops[] = { 1u, 2u, 3u, 4u, 8u, MAX_HOP };
+
+    make_stream();
+    ai_engine_init(&streaming, s_motor_anomalie_weights_array_u64);
+    ai_engine_init(&full, s_motor_anomalie_weights_array_u64);
+    ai_engine_init(&fetched, s_motor_anomalie_weights_array_u64);
+    ai_engine_set_fetch(&fetched, &fetch);
+
+    for (uint32_t i = 0; i < sizeof(hops) / sizeof(hops[0]); i++) {
+        test_hop(hops[i]);
+    }
+    test_fetch_pairing();
+    test_fetch_failure();
+    test_softmax();
+    test_reference();
+    return TEST_RESULT("engine");
+}
@@ -0,0 +1,126 @@
+#include "mem_pool.h"
+#include "test_util.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BLOCK_SIZE  24u
+#define NUM_BLOCKS  5u
+
+/* mem_pool_send_stats_via_usb() prints through the CDC queue; not exercised here */
+bool usb_tx_printf(const char *fmt, ...)
+{
+    (void)fmt;
+    return true;
+}
+
+/* The pool gets the middle of arena, so pointers just outside it are still valid to form */
+static uint32_t arena[(NUM_BLOCKS + 2u) * BLOCK_SIZE / 4u];
+static uint32_t * const storage = &arena[BLOCK_SIZE / 4u];
+
+static void test_init(void)
+{
+    mem_pool_t pool;
+    static uint32_t big[(MEM_POOL_MAX_BLOCKS + 1u) * 2u];
+
+    CHECK(!mem_pool_init(&pool, "p", storage, BLOCK_SIZE, 0u));
+    CHECK(!mem_pool_init(&pool, "p", NULL, BLOCK_SIZE, NUM_BLOCKS));
+    CHECK(!mem_pool_init(&pool, "p", storage, 2u, NUM_BLOCKS));
+    CHECK(!mem_pool_init(&pool, "p", big, 8u, MEM_POOL_MAX_BLOCKS + 1u));
+    CHECK(mem_pool_init(&pool, "p", big, 8u, MEM_POOL_MAX_BLOCKS));
+
+    /* Block size rounded up to a word */
+    CHECK(mem_pool_init(&pool, "p", storage, 21u, 4u));
+    CHECK(pool.block_size == 24u);
+}
+
+static void test_exhaustion(void)
+{
+    mem_pool_t pool;
+    mem_pool_stats_t st;
+    void *blocks[NUM_BLOCKS];
+
+    CHECK(mem_pool_init(&pool, "exhaust", storage, BLOCK_SIZE, NUM_BLOCKS));
+    for (uint32_t i = 0; i < NUM_BLOCKS; i++) {
+        blocks[i] = mem_pool_alloc(&pool);
+        CHECK(blocks[i] != NULL);
+        for (uint32_t j = 0; j < i; j++) CHECK(blocks[i] != blocks[j]);
+    }
+    CHECK(mem_pool_alloc(&pool) == NULL);
+    CHECK(mem_pool_alloc(&pool) == NULL);
+
+    mem_pool_get_stats(&pool, &st);
+    CHECK(st.in_use == NUM_BLOCKS);
+    CHECK(st.peak == NUM_BLOCKS);
+    CHECK(st.alloc_failures == 2u);
+
+    /* A freed block is the next one handed out */
+    CHECK(mem_pool_free(&pool, blocks[2]));
+    CHECK(mem_pool_alloc(&pool) == blocks[2]);
+    for (uint32_t i = 0; i < NUM_BLOCKS; i++) CHECK(mem_pool_free(&pool, blocks[i]));
+
+    mem_pool_get_stats(&pool, &st);
+    CHECK(st.in_use == 0u);
+    CHECK(st.peak == NUM_BLOCKS);
+}
+
+static void test_double_free(void)
+{
+    mem_pool_t pool;
+    mem_pool_stats_t st;
+
+    CHECK(mem_pool_init(&pool, "double", storage, BLOCK_SIZE, NUM_BLOCKS));
+    void *a = mem_pool_alloc(&pool);
+    void *b = mem_pool_alloc(&pool);
+    CHECK(mem_pool_free(&pool, a));
+    CHECK(!mem_pool_free(&pool, a));
+    mem_pool_get_stats(&pool, &st);
+    CHECK(st.in_use == 1u);
+
+    /* The free list must still hold each free block once: no duplicates handed out */
+    void *got[NUM_BLOCKS];
+    uint32_t n = 0;
+    while (n < NUM_BLOCKS && (got[n] = mem_pool_alloc(&pool)) != NULL) n++;
+    CHECK(n == NUM_BLOCKS - 1u);
+    for (uint32_t i = 0; i < n; i++) {
+        CHECK(got[i] != b);
+        for (uint32_t j = 0; j < i; j++) CHECK(got[i] != got[j]);
+    }
+
+    /* Never-allocated blocks are refused too */
+    CHECK(mem_pool_init(&pool, "fresh", storage, BLOCK_SIZE, NUM_BLOCKS));
+    CHECK(!mem_pool_free(&pool, storage));
+    mem_pool_get_stats(&pool, &st);
+    CHECK(st.in_use == 0u);
+}
+
+static void test_foreign_pointer(void)
+{
+    mem_pool_t pool;
+    mem_pool_stats_t st;
+    uint32_t other[BLOCK_SIZE / 4u];
+
+    CHECK(mem_pool_init(&pool, "foreign", storage, BLOCK_SIZE, NUM_BLOCKS));
+    uint8_t *a = mem_pool_alloc(&pool);
+    CHECK(a != NULL);
+
+    CHECK(!mem_pool_free(&pool, NULL));
+    CHECK(!mem_pool_free(NULL, a));
+    CHECK(!mem_pool_free(&pool, other));
+    CHECK(!mem_pool_free(&pool, a + 4));                                   /* inside a block */
+    CHECK(!mem_pool_free(&pool, (uint8_t *)storage - BLOCK_SIZE));         /* just before */
+    CHECK(!mem_pool_free(&pool, (uint8_t *)storage + NUM_BLOCKS * BLOCK_SIZE)); /* just past */
+
+    mem_pool_get_stats(&pool, &st);
+    CHECK(st.in_use == 1u);
+    CHECK(mem_pool_free(&pool, a));
+}
+
+int main(void)
+{
+    test_init();
+    test_exhaustion();
+    test_double_free();
+    test_foreign_pointer();
+    return TEST_RESULT("mem_pool");
+}
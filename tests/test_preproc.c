@@ -0,0 +1,129 @@
+#include "ai_preproc.h"
+#include "test_util.h"
+#include <float.h>
+#include <math.h>
+
+/* Every int16 input of every axis through ai_preproc_window(), against
+ * ai_preproc_reference(): bit-exact for the int8 / int16x8 folds; for float32
+ * within a few ulp of x / std and mean / std, which x * mult + offset cancels.
+ * Built once per MODEL_PRECISION. */
+
+#define SWEEP       65536u
+#define RANDOM_RUNS 200u
+
+static int16_t input[SWEEP];
+static ai_input_t output[SWEEP * AI_PREPROC_AXES];
+
+static uint32_t rng_state = 0x2545F491u;
+
+static double rng_unit(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return (double)rng_state / 4294967296.0;
+}
+
+/* Log-uniform in [lo, hi] */
+static float rng_log(double lo, double hi)
+{
+    return (float)(lo * pow(hi / lo, rng_unit()));
+}
+
+static int mismatch(ai_input_t got, ai_input_t want, int16_t x, float mean, float std)
+{
+#if MODEL_PRECISION == MODEL_PRECISION_FLOAT32
+    return fabs((double)got - (double)want) > 4.0 * FLT_EPSILON * (fabs((double)x) + fabs((double)mean)) / std;
+#else
+    (void)x;
+    (void)mean;
+    (void)std;
+    return got != want;
+#endif
+}
+
+static void sweep(const char *what, const float mean[AI_PREPROC_AXES], const float std[AI_PREPROC_AXES],
+                  float scale, int32_t zero_point)
+{
+    ai_preproc_t pp;
+    const int16_t *const axes[AI_PREPROC_AXES] = { input, input, input };
+
+    CHECK(ai_preproc_init(&pp, mean, std, scale, zero_point));
+    ai_preproc_window(&pp, axes, SWEEP, output);
+
+    for (uint32_t a = 0; a < AI_PREPROC_AXES; a++) {
+        uint32_t bad = 0;
+        for (uint32_t i = 0; i < SWEEP; i++) {
+            ai_input_t want = ai_preproc_reference(input[i], mean[a], std[a], scale, zero_point);
+            ai_input_t got = output[i * AI_PREPROC_AXES + a];
+            if (mismatch(got, want, input[i], mean[a], std[a])) {
+                if (bad++ == 0) {
+                    fprintf(stderr, "%s axis %lu: x=%d got %g want %g (mean=%g std=%g scale=%g zp=%ld)\n",
+                            what, (unsigned long)a, input[i], (double)got, (double)want, (double)mean[a],
+                            (double)std[a], (double)scale, (long)zero_point);
+                }
+            }
+        }
+        CHECK(bad == 0);
+    }
+}
+
+static void test_trained(void)
+{
+#ifdef MODEL_MEAN_X
+    const float mean[AI_PREPROC_AXES] = { MODEL_MEAN_X, MODEL_MEAN_Y, MODEL_MEAN_Z };
+    const float std[AI_PREPROC_AXES] = { MODEL_STD_X, MODEL_STD_Y, MODEL_STD_Z };
+    const ai_preproc_t generated = MODEL_PREPROC_INIT;
+    ai_preproc_t pp;
+
+    /* export_model_params.py folds the same way as ai_preproc_init() */
+    CHECK(ai_preproc_init(&pp, mean, std, MODEL_IN_SCALE, MODEL_IN_ZERO_POINT));
+    for (uint32_t a = 0; a < AI_PREPROC_AXES; a++) {
+        CHECK(pp.axis[a].mult == generated.axis[a].mult);
+        CHECK(pp.axis[a].offset == generated.axis[a].offset);
+        CHECK(pp.axis[a].shift == generated.axis[a].shift);
+    }
+    sweep("trained", mean, std, MODEL_IN_SCALE, MODEL_IN_ZERO_POINT);
+#endif
+}
+
+/* Accelerometer-like stats (mg) with the quantization of each precision:
+ * int8 asymmetric, int16 symmetric (zero point 0), float32 unused */
+static void test_random(void)
+{
+    for (uint32_t run = 0; run < RANDOM_RUNS; run++) {
+        float mean[AI_PREPROC_AXES], std[AI_PREPROC_AXES];
+        for (uint32_t a = 0; a < AI_PREPROC_AXES; a++) {
+            mean[a] = (float)(rng_unit() * 4000.0 - 2000.0);
+            std[a] = rng_log(1.0, 4000.0);
+        }
+#if MODEL_PRECISION == MODEL_PRECISION_INT16X8
+        sweep("random", mean, std, rng_log(1e-5, 1e-2), 0);
+#elif MODEL_PRECISION == MODEL_PRECISION_FLOAT32
+        sweep("random", mean, std, 1.0f, 0);
+#else
+        sweep("random", mean, std, rng_log(1e-3, 0.2), (int32_t)(rng_unit() * 256.0) - 128);
+#endif
+    }
+}
+
+static void test_invalid(void)
+{
+    ai_preproc_t pp;
+    const float mean[AI_PREPROC_AXES] = { 0.0f, 0.0f, 0.0f };
+    const float std[AI_PREPROC_AXES] = { 1.0f, 0.0f, 1.0f };
+
+    CHECK(!ai_preproc_init(&pp, mean, std, 0.01f, 0));
+    CHECK(!ai_preproc_init(NULL, mean, std, 0.01f, 0));
+}
+
+int main(void)
+{
+    for (uint32_t i = 0; i < SWEEP; i++) {
+        input[i] = (int16_t)(i - 32768u);
+    }
+    test_trained();
+    test_random();
+    test_invalid();
+    return TEST_RESULT("preproc");
+}
@@ -0,0 +1,195 @@
+#include "ai_sched.h"
+#include "test_util.h"
+#include <string.h>
+
+/* The CM7 channel scheduler on simulated ticks: windows become pending at their hop,
+ * deadline order holds across the tick wrap, round robin rotates, and a channel with
+ * a window on CM4 is left out until its result is back. */
+
+#define CHANNELS    4u
+
+/* Every channel gets one frame per SHARED_FRAME_PERIOD_MS, windows already full */
+typedef struct {
+    ai_sched_t s;
+    uint32_t hop[CHANNELS];
+    uint32_t fresh[CHANNELS];
+    uint32_t served[CHANNELS];
+    uint32_t now;
+} sim_t;
+
+static void sim_init(sim_t *sim, uint8_t policy, const uint32_t hop[CHANNELS], uint32_t t0)
+{
+    memset(sim, 0, sizeof(*sim));
+    ai_sched_init(&sim->s, policy, CHANNELS);
+    memcpy(sim->hop, hop, sizeof(sim->hop));
+    sim->now = t0;
+}
+
+/* One frame period: a frame for every channel, then the pass order */
+static uint32_t sim_pass(sim_t *sim, uint32_t order[SHARED_AI_MAX_CHANNELS])
+{
+    sim->now += SHARED_FRAME_PERIOD_MS;
+    for (uint32_t ch = 0; ch < CHANNELS; ch++) {
+        sim->fresh[ch]++;
+        ai_sched_frames(&sim->s, ch, true, sim->fresh[ch], sim->hop[ch], sim->now);
+    }
+    return ai_sched_order(&sim->s, order);
+}
+
+static void sim_serve(sim_t *sim, uint32_t ch)
+{
+    ai_sched_take(&sim->s, ch);
+    sim->fresh[ch] = 0;
+    sim->served[ch]++;
+}
+
+/* Mixed hops under earliest deadline first, channel 2 blocked on CM4 for a while */
+static void test_deadline_mixed_hops(void)
+{
+    static const uint32_t hop[CHANNELS] = { 2u, 5u, 3u, 4u };
+    const uint32_t frames = 60u;
+    uint32_t order[SHARED_AI_MAX_CHANNELS];
+    uint32_t unsorted = 0, blocked_seen = 0, late = 0;
+    sim_t sim;
+
+    sim_init(&sim, SHARED_AI_SCHED_DEADLINE, hop, 0u);
+    for (uint32_t t = 1; t <= frames; t++) {
+        /* CM4 hands back channel 2's window after 20 frame periods */
+        if (t == 26u) ai_sched_done(&sim.s, 2u);
+
+        uint32_t n = sim_pass(&sim, order);
+        for (uint32_t i = 0; i < n; i++) {
+            uint32_t ch = order[i];
+            if (i > 0u && (int32_t)(sim.s.ch[ch].deadline - sim.s.ch[order[i - 1u]].deadline) < 0) unsorted++;
+            if (ch == 2u && t > 3u && t < 26u) blocked_seen++;
+            if (ai_sched_late(&sim.s, ch, sim.now)) late++;
+            /* The deadline is when the next window of the channel is complete, but for
+             * the one that waited on CM4 */
+            if (!(ch == 2u && t == 26u)) {
+                CHECK(sim.s.ch[ch].deadline == sim.now + hop[ch] * SHARED_FRAME_PERIOD_MS);
+            }
+            if (ch == 2u && t == 3u) {
+                ai_sched_offload(&sim.s, ch);
+                sim.fresh[ch] = 0;
+                continue;
+            }
+            sim_serve(&sim, ch);
+        }
+    }
+    CHECK(unsorted == 0u);
+    CHECK(blocked_seen == 0u);
+    /* Only channel 2's window after the block was served past its deadline */
+    CHECK(late == 1u);
+
+    /* Every unblocked channel served once per hop */
+    CHECK(sim.served[0] == frames / hop[0]);
+    CHECK(sim.served[1] == frames / hop[1]);
+    CHECK(sim.served[3] == frames / hop[3]);
+    /* Channel 2: nothing while blocked, then its pending window and one per hop after */
+    CHECK(sim.served[2] == 1u + (frames - 26u) / hop[2]);
+
+    /* While blocked the channel still becomes pending, it is just not ordered */
+    ai_sched_offload(&sim.s, 1u);
+    for (uint32_t t = 0; t < hop[1]; t++) {
+        uint32_t n = sim_pass(&sim, order);
+        for (uint32_t i = 0; i < n; i++) {
+            CHECK(order[i] != 1u);
+            sim_serve(&sim, order[i]);
+        }
+    }
+    CHECK(sim.s.ch[1].pending);
+    ai_sched_done(&sim.s, 1u);
+    uint32_t n = ai_sched_order(&sim.s, order);
+    CHECK(n == 1u && order[0] == 1u);
+}
+
+/* Deadlines on both sides of the 32-bit tick wrap, and equal deadlines in rotation */
+static void test_deadline_wrap(void)
+{
+    static const uint32_t hop[CHANNELS] = { 4u, 2u, 2u, 6u };
+    const uint32_t now = 0xFFFFFFFFu - 250u;
+    uint32_t order[SHARED_AI_MAX_CHANNELS];
+    ai_sched_t s;
+
+    /* Deadlines now + 400 / 200 / 200 / 600: channels 0 and 3 land past the wrap */
+    ai_sched_init(&s, SHARED_AI_SCHED_DEADLINE, CHANNELS);
+    for (uint32_t ch = 0; ch < CHANNELS; ch++) {
+        ai_sched_frames(&s, ch, true, hop[ch], hop[ch], now);
+    }
+    CHECK(s.ch[0].deadline < now && s.ch[3].deadline < now);
+    CHECK(s.ch[1].deadline > now);
+
+    uint32_t n = ai_sched_order(&s, order);
+    CHECK(n == 4u);
+    CHECK(order[0] == 1u && order[1] == 2u);
+    CHECK(order[2] == 0u && order[3] == 3u);
+
+    /* Channels 1 and 2 tie: whichever the rotation reaches first goes first */
+    n = ai_sched_order(&s, order);
+    CHECK(order[0] == 1u && order[1] == 2u);
+    n = ai_sched_order(&s, order);
+    CHECK(order[0] == 2u && order[1] == 1u);
+    CHECK(order[2] == 0u && order[3] == 3u);
+
+    /* A window that is not full, or not a hop newer, is not pending */
+    ai_sched_init(&s, SHARED_AI_SCHED_DEADLINE, CHANNELS);
+    ai_sched_frames(&s, 0u, false, 10u, hop[0], now);
+    ai_sched_frames(&s, 1u, true, hop[1] - 1u, hop[1], now);
+    CHECK(ai_sched_order(&s, order) == 0u);
+}
+
+static void test_round_robin(void)
+{
+    static const uint32_t hop[CHANNELS] = { 1u, 1u, 1u, 1u };
+    uint32_t order[SHARED_AI_MAX_CHANNELS];
+    sim_t sim;
+
+    sim_init(&sim, SHARED_AI_SCHED_ROUND_ROBIN, hop, 0u);
+    ai_sched_offload(&sim.s, 2u);
+    for (uint32_t pass = 0; pass < 2u * CHANNELS; pass++) {
+        uint32_t n = sim_pass(&sim, order);
+        /* Rotating start over the unblocked channels, in channel order from there */
+        CHECK(n == CHANNELS - 1u);
+        uint32_t start = pass % CHANNELS;
+        if (start == 2u) start = 3u;
+        CHECK(order[0] == start);
+        for (uint32_t i = 0; i < n; i++) {
+            CHECK(order[i] != 2u);
+            sim_serve(&sim, order[i]);
+        }
+    }
+}
+
+/* A failed serve keeps the window and its deadline; a late serve is reported */
+static void test_retry_late(void)
+{
+    static const uint32_t hop[CHANNELS] = { 3u, 3u, 3u, 3u };
+    uint32_t order[SHARED_AI_MAX_CHANNELS];
+    sim_t sim;
+
+    sim_init(&sim, SHARED_AI_SCHED_DEADLINE, hop, 1000u);
+    uint32_t n = 0;
+    for (uint32_t t = 0; t < 3u; t++) n = sim_pass(&sim, order);
+    CHECK(n == CHANNELS);
+    uint32_t deadline = sim.s.ch[0].deadline;
+
+    ai_sched_take(&sim.s, 0u);
+    ai_sched_retry(&sim.s, 0u);
+    CHECK(sim.s.ch[0].pending);
+    CHECK(sim.s.ch[0].deadline == deadline);
+
+    /* More frames for a pending channel do not move its deadline */
+    for (uint32_t t = 0; t < 3u; t++) sim_pass(&sim, order);
+    CHECK(sim.s.ch[0].deadline == deadline);
+    CHECK(!ai_sched_late(&sim.s, 0u, deadline));
+    CHECK(ai_sched_late(&sim.s, 0u, deadline + 1u));
+}
+
+int main(void)
+{
+    test_deadline_mixed_hops();
+    test_deadline_wrap();
+    test_round_robin();
+    test_retry_late();
+    return TEST_RESULT("sched");
+}
@@ -0,0 +1,19 @@
+#ifndef __TEST_UTIL_H
+#define __TEST_UTIL_H
+
+#include <stdio.h>
+
+/* Minimal checks: report every failure, exit status is the failure count */
+static int test_failures = 0;
+
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+        fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+        test_failures++; \
+    } \
+} while (0)
+
+#define TEST_RESULT(name) \
+    (printf("%s: %s\n", (name), test_failures ? "FAILED" : "passed"), test_failures ? 1 : 0)
+
+#endif /* __TEST_UTIL_H */